@@ -8,7 +8,7 @@
     flake-utils.lib.eachDefaultSystem (system: {
         devShells.default = with nixpkgs.legacyPackages.${system}; mkShell {
           nativeBuildInputs = [ cmake pkg-config ];
-          buildInputs = [ glm glfw glew zlib libpng libvorbis openal luajit curl ]; # libglvnd
+          buildInputs = [ glm glfw glew zlib zstd lz4 libpng libvorbis openal luajit curl ]; # libglvnd
           packages = [ glfw mesa freeglut entt ];
           LD_LIBRARY_PATH = "${wayland}/lib:$LD_LIBRARY_PATH";
         };
@@ -304,6 +304,84 @@ console.add_command(
     end
 )
 
+console.add_command(
+    "pregen x1:int z1:int x2:int z2:int",
+    "Generate and save chunks of the area (chunk coords)",
+    function(args, kwargs)
+        local x1, z1, x2, z2 = unpack(args)
+        world.pregenerate(x1, z1, x2, z2)
+        local w = math.abs(x2 - x1) + 1
+        local d = math.abs(z2 - z1) + 1
+        return "pregenerating " .. tostring(w * d) .. " chunks"
+    end
+)
+
+console.add_command(
+    "pregen.radius radius:int x:num~pos.x z:num~pos.z",
+    "Generate and save chunks in radius (chunks) around position",
+    function(args, kwargs)
+        local radius, x, z = unpack(args)
+        local cx = math.floor(x / 16)
+        local cz = math.floor(z / 16)
+        world.pregenerate(cx - radius, cz - radius, cx + radius, cz + radius)
+        local size = radius * 2 + 1
+        return "pregenerating " .. tostring(size * size) .. " chunks"
+    end
+)
+
+console.add_command(
+    "regions.train-dictionary samples:int=1000",
+    "Train zstd dictionary for voxels regions on saved chunks",
+    function(args, kwargs)
+        local size = world.train_compression_dictionary(args[1])
+        return "dictionary of " .. tostring(size) .. " bytes has been "..
+               "saved and will be used after the world reopening"
+    end
+)
+
+console.add_command(
+    "pregen.status",
+    "Show pregeneration progress and stats",
+    function(args, kwargs)
+        local info = world.get_pregeneration_info()
+        if info == nil then
+            return "pregeneration is not started"
+        end
+        return string.format(
+            "%s/%s chunks (%s generated), %.1f chunks/s\n"..
+            "generation: %.2fs, lighting: %.2fs, saving: %.2fs\n"..
+            "%s bytes written%s",
+            info.done, info.total, info.generated, info.chunks_per_second,
+            info.generation_time, info.lighting_time, info.saving_time,
+            info.bytes_written, info.finished and ", finished" or ""
+        )
+    end
+)
+
+console.add_command(
+    "save",
+    "Save the world in background",
+    function(args, kwargs)
+        core.save_world(true)
+        return "saving the world"
+    end
+)
+
+console.add_command(
+    "save.status",
+    "Show background world saving progress",
+    function(args, kwargs)
+        local info = world.get_saving_info()
+        if info == nil then
+            return "world saving is not in progress"
+        end
+        return string.format(
+            "%s: %s/%s", info.writing and "writing regions" or "storing chunks",
+            info.done, info.total
+        )
+    end
+)
+
 console.cheats = {
     "blocks.fill",
     "tp",
@@ -313,4 +391,6 @@ console.cheats = {
     "entity.despawn",
     "player.respawn",
     "weather.set",
+    "pregen",
+    "pregen.radius",
 }
@@ -0,0 +1,75 @@
+#ifndef CHUNK_VERTEX_GLSL_
+#define CHUNK_VERTEX_GLSL_
+
+// Chunk mesh vertex attributes (see ChunkVertex and CompactChunkVertex)
+
+#ifdef COMPACT_CHUNK_VERTICES
+#define POSITION_SCALE 64.0
+#define NORMAL_MAX 126.0
+
+layout (location = 0) in vec3 v_position;
+layout (location = 1) in float v_normal;
+layout (location = 2) in vec2 v_texCoord;
+layout (location = 3) in vec4 v_light;
+layout (location = 4) in vec2 v_regionEnd;
+
+vec3 chunk_vertex_position() {
+    return v_position / POSITION_SCALE;
+}
+
+vec3 chunk_vertex_normal() {
+    vec2 p = vec2(mod(v_normal, 128.0), mod(floor(v_normal / 128.0), 128.0));
+    p = p / NORMAL_MAX * 2.0 - 1.0;
+    vec3 normal = vec3(p, 1.0 - abs(p.x) - abs(p.y));
+    if (normal.z < 0.0) {
+        vec2 signs = vec2(p.x >= 0.0 ? 1.0 : -1.0, p.y >= 0.0 ? 1.0 : -1.0);
+        normal.xy = (1.0 - abs(p.yx)) * signs;
+    }
+    return normalize(normal);
+}
+
+float chunk_vertex_emission() {
+    return step(32768.0, v_normal);
+}
+#else
+layout (location = 0) in vec3 v_position;
+layout (location = 1) in vec2 v_texCoord;
+layout (location = 2) in vec4 v_light;
+layout (location = 3) in vec4 v_normal;
+layout (location = 4) in vec2 v_regionEnd;
+
+vec3 chunk_vertex_position() {
+    return v_position;
+}
+
+vec3 chunk_vertex_normal() {
+    return v_normal.xyz * 2.0 - 1.0;
+}
+
+float chunk_vertex_emission() {
+    return v_normal.w;
+}
+#endif
+
+vec4 chunk_vertex_region() {
+    if (v_regionEnd == vec2(0.0)) {
+        return vec4(0.0);
+    }
+    return vec4(v_texCoord, v_regionEnd);
+}
+
+// Merged faces texture coord in voxels is restored from position
+vec2 chunk_vertex_uv(vec3 position, vec3 normal) {
+    if (v_regionEnd == vec2(0.0)) {
+        return v_texCoord;
+    }
+    vec3 axisX = abs(normal.x) > 0.5
+        ? vec3(0.0, 0.0, -sign(normal.x))
+        : vec3(round(abs(normal.y) + normal.z), 0.0, 0.0);
+    vec3 axisY = abs(normal.y) > 0.5
+        ? vec3(0.0, 0.0, -sign(normal.y))
+        : vec3(0.0, 1.0, 0.0);
+    return vec2(dot(position, axisX), dot(position, axisY)) + 0.5;
+}
+
+#endif // CHUNK_VERTEX_GLSL_
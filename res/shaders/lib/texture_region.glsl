@@ -0,0 +1,16 @@
+#ifndef TEXTURE_REGION_GLSL_
+#define TEXTURE_REGION_GLSL_
+
+// Sample texture region repeated over merged faces quad where uv is in
+// voxels. Region is (u1, v1, u2, v2), zero if uv is a texture coord
+vec4 sample_region(sampler2D tex, vec2 uv, vec4 region) {
+    if (region == vec4(0.0)) {
+        return texture(tex, uv);
+    }
+    vec2 size = region.zw - region.xy;
+    return textureGrad(
+        tex, region.xy + fract(uv) * size, dFdx(uv) * size, dFdy(uv) * size
+    );
+}
+
+#endif // TEXTURE_REGION_GLSL_
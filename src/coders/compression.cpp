@@ -6,6 +6,8 @@
 
 #include "rle.hpp"
 #include "gzip.hpp"
+#include "lz4.hpp"
+#include "zstd.hpp"
 #include "util/BufferPool.hpp"
 
 using namespace compression;
@@ -55,8 +57,29 @@ static auto compress_rle(
     return data;
 }
 
+static std::unique_ptr<ubyte[]> to_unique(
+    const std::vector<ubyte>& buffer, size_t& len
+) {
+    auto data = std::make_unique<ubyte[]>(buffer.size());
+    std::memcpy(data.get(), buffer.data(), buffer.size());
+    len = buffer.size();
+    return data;
+}
+
+static void check_decompressed_size(size_t expected, size_t size) {
+    if (size != expected) {
+        throw std::runtime_error(
+            "expected decompressed size " + std::to_string(expected) +
+            " got " + std::to_string(size));
+    }
+}
+
 std::unique_ptr<ubyte[]> compression::compress(
-    const ubyte* src, size_t srclen, size_t& len, Method method
+    const ubyte* src,
+    size_t srclen,
+    size_t& len,
+    Method method,
+    const zstd::Dictionary* dictionary
 ) {
     switch (method) {
         case Method::NONE:
@@ -65,20 +88,26 @@ std::unique_ptr<ubyte[]> compression::compress(
             return compress_rle(src, srclen, len, extrle::encode);
         case Method::EXTRLE16:
             return compress_rle(src, srclen, len, extrle::encode16);
-        case Method::GZIP: {
-            auto buffer = gzip::compress(src, srclen);
-            auto data = std::make_unique<ubyte[]>(buffer.size());
-            std::memcpy(data.get(), buffer.data(), buffer.size());
-            len = buffer.size();
-            return data;
-        }
+        case Method::GZIP:
+            return to_unique(gzip::compress(src, srclen), len);
+        case Method::LZ4:
+            return to_unique(lz4::compress(src, srclen), len);
+        case Method::ZSTD:
+            return to_unique(
+                zstd::compress(src, srclen, zstd::DEFAULT_LEVEL, dictionary),
+                len
+            );
         default:
             throw std::runtime_error("not implemented");
     }
 }
 
 std::unique_ptr<ubyte[]> compression::decompress(
-    const ubyte* src, size_t srclen, size_t dstlen, Method method
+    const ubyte* src,
+    size_t srclen,
+    size_t dstlen,
+    Method method,
+    const zstd::Dictionary* dictionary
 ) {
     switch (method) {
         case Method::NONE:
@@ -91,24 +120,32 @@ std::unique_ptr<ubyte[]> compression::decompress(
         case Method::EXTRLE16: {
             auto decompressed = std::make_unique<ubyte[]>(dstlen);
             size_t decoded = extrle::decode16(src, srclen, decompressed.get());
-            if (decoded != dstlen) {
-                throw std::runtime_error(
-                    "expected decompressed size " + std::to_string(dstlen) +
-                    " got " + std::to_string(decoded));
-            }
+            check_decompressed_size(dstlen, decoded);
             return decompressed;
         }
         case Method::GZIP: {
             auto buffer = gzip::decompress(src, srclen);
-            if (buffer.size() != dstlen) {
-                throw std::runtime_error(
-                    "expected decompressed size " + std::to_string(dstlen) +
-                    " got " + std::to_string(buffer.size()));
-            }
+            check_decompressed_size(dstlen, buffer.size());
             auto decompressed = std::make_unique<ubyte[]>(buffer.size());
             std::memcpy(decompressed.get(), buffer.data(), buffer.size());
             return decompressed;
         }
+        case Method::LZ4: {
+            auto decompressed = std::make_unique<ubyte[]>(dstlen);
+            size_t decoded = lz4::decompress(
+                src, srclen, decompressed.get(), dstlen
+            );
+            check_decompressed_size(dstlen, decoded);
+            return decompressed;
+        }
+        case Method::ZSTD: {
+            auto decompressed = std::make_unique<ubyte[]>(dstlen);
+            size_t decoded = zstd::decompress(
+                src, srclen, decompressed.get(), dstlen, dictionary
+            );
+            check_decompressed_size(dstlen, decoded);
+            return decompressed;
+        }
         default:
             throw std::runtime_error("not implemented");
     }
@@ -3,28 +3,54 @@
 #include <memory>
 
 #include "typedefs.hpp"
+#include "util/EnumMetadata.hpp"
+
+namespace zstd {
+    class Dictionary;
+}
 
 namespace compression {
+    /// @brief Compression method. Values are stored in region files
     enum class Method {
-        NONE, EXTRLE8, EXTRLE16, GZIP
+        NONE, EXTRLE8, EXTRLE16, GZIP, LZ4, ZSTD
     };
 
+    VC_ENUM_METADATA(Method)
+        {"none", Method::NONE},
+        {"extrle8", Method::EXTRLE8},
+        {"extrle16", Method::EXTRLE16},
+        {"gzip", Method::GZIP},
+        {"lz4", Method::LZ4},
+        {"zstd", Method::ZSTD},
+    VC_ENUM_END
+
     /// @brief Compress buffer
     /// @param src source buffer
     /// @param srclen length of the source buffer
     /// @param len (out argument) length of result buffer
     /// @param method compression method
+    /// @param dictionary optional dictionary (used by ZSTD only)
     /// @return compressed bytes array
     /// @throws std::invalid_argument if compression method is NONE
     std::unique_ptr<ubyte[]> compress(
-        const ubyte* src, size_t srclen, size_t& len, Method method
+        const ubyte* src,
+        size_t srclen,
+        size_t& len,
+        Method method,
+        const zstd::Dictionary* dictionary = nullptr
     );
 
     /// @brief Decompress buffer
     /// @param src compressed buffer
     /// @param srclen length of compressed buffer
     /// @param dstlen max expected length of source buffer
+    /// @param dictionary dictionary used to compress the buffer
     /// @return decompressed bytes array
     std::unique_ptr<ubyte[]> decompress(
-        const ubyte* src, size_t srclen, size_t dstlen, Method method);
+        const ubyte* src,
+        size_t srclen,
+        size_t dstlen,
+        Method method,
+        const zstd::Dictionary* dictionary = nullptr
+    );
 }
@@ -0,0 +1,38 @@
+#include "lz4.hpp"
+
+#include <lz4.h>
+
+#include <stdexcept>
+
+std::vector<ubyte> lz4::compress(const ubyte* src, size_t size) {
+    if (size > LZ4_MAX_INPUT_SIZE) {
+        throw std::runtime_error("too large data for lz4 compression");
+    }
+    std::vector<ubyte> buffer(LZ4_compressBound(static_cast<int>(size)));
+    int compressedSize = LZ4_compress_default(
+        reinterpret_cast<const char*>(src),
+        reinterpret_cast<char*>(buffer.data()),
+        static_cast<int>(size),
+        static_cast<int>(buffer.size())
+    );
+    if (compressedSize <= 0) {
+        throw std::runtime_error("lz4 compression failed");
+    }
+    buffer.resize(compressedSize);
+    return buffer;
+}
+
+size_t lz4::decompress(
+    const ubyte* src, size_t size, ubyte* dst, size_t dstSize
+) {
+    int decompressedSize = LZ4_decompress_safe(
+        reinterpret_cast<const char*>(src),
+        reinterpret_cast<char*>(dst),
+        static_cast<int>(size),
+        static_cast<int>(dstSize)
+    );
+    if (decompressedSize < 0) {
+        throw std::runtime_error("corrupted lz4 data");
+    }
+    return decompressedSize;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+
+#include "typedefs.hpp"
+
+namespace lz4 {
+    /// Compress bytes array to LZ4 block format
+    /// @param src source bytes array
+    /// @param size length of source bytes array
+    std::vector<ubyte> compress(const ubyte* src, size_t size);
+
+    /// Decompress LZ4 block. Block does not store decompressed data length,
+    /// so it must be known by the caller
+    /// @param src LZ4 data
+    /// @param size length of LZ4 data
+    /// @param dst destination buffer
+    /// @param dstSize destination buffer length
+    /// @return decompressed data length
+    /// @throws std::runtime_error if data is corrupted or does not fit
+    size_t decompress(const ubyte* src, size_t size, ubyte* dst, size_t dstSize);
+}
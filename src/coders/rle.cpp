@@ -1,39 +1,152 @@
 #include "rle.hpp"
 
+#include <algorithm>
+
 #include "util/data_io.hpp"
+#include "util/platform.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RLE_SIMD
+#include <immintrin.h>
+#endif
+
+#if defined(RLE_SIMD) && defined(__GNUC__)
+#define RLE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define RLE_TARGET_AVX2
+#endif
+
+// Run scanners return index of the first element in [i, n) range
+// not equal to c, or n. Wide lanes are compared at once, so runs of
+// chunk voxels (mostly air and stone) are skipped quickly.
+
+template <typename T>
+static size_t find_run_end_scalar(const T* src, size_t i, size_t n, T c) {
+    while (i < n && src[i] == c) {
+        i++;
+    }
+    return i;
+}
+
+#ifdef RLE_SIMD
+static inline uint count_trailing_zeros(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+static size_t find_run_end8_sse2(const ubyte* src, size_t i, size_t n, ubyte c) {
+    const __m128i value = _mm_set1_epi8(static_cast<char>(c));
+    for (; i + 16 <= n; i += 16) {
+        __m128i block =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, value));
+        if (mask != 0xFFFF) {
+            return i + count_trailing_zeros(~mask);
+        }
+    }
+    return find_run_end_scalar(src, i, n, c);
+}
+
+static size_t find_run_end16_sse2(
+    const uint16_t* src, size_t i, size_t n, uint16_t c
+) {
+    const __m128i value = _mm_set1_epi16(static_cast<short>(c));
+    for (; i + 8 <= n; i += 8) {
+        __m128i block =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi16(block, value));
+        if (mask != 0xFFFF) {
+            return i + count_trailing_zeros(~mask) / 2;
+        }
+    }
+    return find_run_end_scalar(src, i, n, c);
+}
+
+RLE_TARGET_AVX2 static size_t find_run_end8_avx2(
+    const ubyte* src, size_t i, size_t n, ubyte c
+) {
+    const __m256i value = _mm256_set1_epi8(static_cast<char>(c));
+    for (; i + 32 <= n; i += 32) {
+        __m256i block =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, value));
+        if (mask != 0xFFFFFFFF) {
+            return i + count_trailing_zeros(~mask);
+        }
+    }
+    return find_run_end8_sse2(src, i, n, c);
+}
+
+RLE_TARGET_AVX2 static size_t find_run_end16_avx2(
+    const uint16_t* src, size_t i, size_t n, uint16_t c
+) {
+    const __m256i value = _mm256_set1_epi16(static_cast<short>(c));
+    for (; i + 16 <= n; i += 16) {
+        __m256i block =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        uint32_t mask =
+            _mm256_movemask_epi8(_mm256_cmpeq_epi16(block, value));
+        if (mask != 0xFFFFFFFF) {
+            return i + count_trailing_zeros(~mask) / 2;
+        }
+    }
+    return find_run_end16_sse2(src, i, n, c);
+}
+
+static const auto find_run_end8_wide =
+    platform::has_avx2() ? find_run_end8_avx2 : find_run_end8_sse2;
+static const auto find_run_end16_wide =
+    platform::has_avx2() ? find_run_end16_avx2 : find_run_end16_sse2;
+#else
+static const auto find_run_end8_wide = find_run_end_scalar<ubyte>;
+static const auto find_run_end16_wide = find_run_end_scalar<uint16_t>;
+#endif
+
+static inline size_t find_run_end(const ubyte* src, size_t i, size_t n) {
+    // short runs are not worth of wide scan call
+    ubyte c = src[i++];
+    if (i == n || src[i] != c) {
+        return i;
+    }
+    return find_run_end8_wide(src, i + 1, n, c);
+}
+
+static inline size_t find_run_end(const uint16_t* src, size_t i, size_t n) {
+    uint16_t c = src[i++];
+    if (i == n || src[i] != c) {
+        return i;
+    }
+    return find_run_end16_wide(src, i + 1, n, c);
+}
 
 size_t rle::decode(const ubyte* src, size_t srclen, ubyte* dst) {
     size_t offset = 0;
     for (size_t i = 0; i < srclen;) {
         ubyte len = src[i++];
         ubyte c = src[i++];
-        for (size_t j = 0; j <= len; j++) {
-            dst[offset++] = c;
-        }
+        std::fill_n(dst + offset, len + 1, c);
+        offset += len + 1;
     }
     return offset;
 }
 
 size_t rle::encode(const ubyte* src, size_t srclen, ubyte* dst) {
-    if (srclen == 0) {
-        return 0;
-    }
     size_t offset = 0;
-    ubyte counter = 0;
-    ubyte c = src[0];
-    for (size_t i = 1; i < srclen; i++) {
-        ubyte cnext = src[i];
-        if (cnext != c || counter == 255) {
-            dst[offset++] = counter;
+    for (size_t i = 0; i < srclen;) {
+        size_t end = find_run_end(src, i, srclen);
+        ubyte c = src[i];
+        for (; i < end; i += 0x100) {
+            dst[offset++] = std::min<size_t>(end - i, 0x100) - 1;
             dst[offset++] = c;
-            c = cnext;
-            counter = 0;
-        } else {
-            counter++;
         }
+        i = end;
     }
-    dst[offset++] = counter;
-    dst[offset++] = c;
     return offset;
 }
 
@@ -44,35 +157,27 @@ size_t rle::decode16(const ubyte* src, size_t srclen, ubyte* dst) {
     for (size_t i = 0; i < srclen / 2;) {
         uint16_t len = dataio::le2h(src16[i++]);
         uint16_t c = dataio::le2h(src16[i++]);
-        for (size_t j = 0; j <= len; j++) {
-            dst16[offset++] = c;
-        }
+        std::fill_n(dst16 + offset, len + 1, c);
+        offset += len + 1;
     }
     return offset * 2;
 }
 
 size_t rle::encode16(const ubyte* src, size_t srclen, ubyte* dst) {
-    if (srclen == 0) {
-        return 0;
-    }
     auto src16 = reinterpret_cast<const uint16_t*>(src);
     auto dst16 = reinterpret_cast<uint16_t*>(dst);
+    size_t length = srclen / 2;
     size_t offset = 0;
-    uint16_t counter = 0;
-    uint16_t c = src16[0];
-    for (size_t i = 1; i < srclen / 2; i++) {
-        uint16_t cnext = src16[i];
-        if (cnext != c || counter == 0xFFFF) {
+    for (size_t i = 0; i < length;) {
+        size_t end = find_run_end(src16, i, length);
+        uint16_t c = src16[i];
+        for (; i < end; i += 0x10000) {
+            uint16_t counter = std::min<size_t>(end - i, 0x10000) - 1;
             dst16[offset++] = dataio::h2le(counter);
             dst16[offset++] = dataio::h2le(c);
-            c = cnext;
-            counter = 0;
-        } else {
-            counter++;
         }
+        i = end;
     }
-    dst16[offset++] = dataio::h2le(counter);
-    dst16[offset++] = dataio::h2le(c);
     return offset * 2;
 }
 
@@ -85,36 +190,13 @@ size_t extrle::decode(const ubyte* src, size_t srclen, ubyte* dst) {
             len |= (static_cast<uint>(src[i++])) << 7;
         }
         ubyte c = src[i++];
-        for (size_t j = 0; j <= len; j++) {
-            dst[offset++] = c;
-        }
+        std::fill_n(dst + offset, len + 1, c);
+        offset += len + 1;
     }
     return offset;
 }
 
-size_t extrle::encode(const ubyte* src, size_t srclen, ubyte* dst) {
-    if (srclen == 0) {
-        return 0;
-    }
-    size_t offset = 0;
-    uint counter = 0;
-    ubyte c = src[0];
-    for (size_t i = 1; i < srclen; i++) {
-        ubyte cnext = src[i];
-        if (cnext != c || counter == max_sequence) {
-            if (counter >= 0x80) {
-                dst[offset++] = 0x80 | (counter & 0x7F);
-                dst[offset++] = counter >> 7;
-            } else {
-                dst[offset++] = counter;
-            }
-            dst[offset++] = c;
-            c = cnext;
-            counter = 0;
-        } else {
-            counter++;
-        }
-    }
+static inline void put_run(ubyte* dst, size_t& offset, uint counter, ubyte c) {
     if (counter >= 0x80) {
         dst[offset++] = 0x80 | (counter & 0x7F);
         dst[offset++] = counter >> 7;
@@ -122,6 +204,19 @@ size_t extrle::encode(const ubyte* src, size_t srclen, ubyte* dst) {
         dst[offset++] = counter;
     }
     dst[offset++] = c;
+}
+
+size_t extrle::encode(const ubyte* src, size_t srclen, ubyte* dst) {
+    constexpr size_t max_run = max_sequence + 1;
+    size_t offset = 0;
+    for (size_t i = 0; i < srclen;) {
+        size_t end = find_run_end(src, i, srclen);
+        ubyte c = src[i];
+        for (; i < end; i += max_run) {
+            put_run(dst, offset, std::min(end - i, max_run) - 1, c);
+        }
+        i = end;
+    }
     return offset;
 }
 
@@ -141,42 +236,15 @@ size_t extrle::decode16(const ubyte* src, size_t srclen, ubyte* dst8) {
         if (widechar) {
             c |= ((static_cast<uint>(src[i++])) << 8);
         }
-        for (size_t j = 0; j <= len; j++) {
-            dst[offset++] = c;
-        }
+        std::fill_n(dst + offset, len + 1, c);
+        offset += len + 1;
     }
     return offset * 2;
 }
 
-size_t extrle::encode16(const ubyte* src8, size_t srclen, ubyte* dst) {
-    if (srclen == 0) {
-        return 0;
-    }
-    auto src = reinterpret_cast<const uint16_t*>(src8);
-    size_t offset = 0;
-    uint counter = 0;
-    uint16_t c = src[0];
-    for (size_t i = 1; i < srclen/2; i++) {
-        uint16_t cnext = src[i];
-        if (cnext != c || counter == max_sequence16) {
-            if (counter >= 0x40) {
-                dst[offset++] = 0x80 | ((c > 255) << 6) | (counter & 0x3F);
-                dst[offset++] = counter >> 6;
-            } else {
-                dst[offset++] = counter | ((c > 255) << 6);
-            }
-            if (c > 255) {
-                dst[offset++] = c & 0xFF;
-                dst[offset++] = c >> 8;
-            } else {
-                dst[offset++] = c;
-            }
-            c = cnext;
-            counter = 0;
-        } else {
-            counter++;
-        }
-    }
+static inline void put_run16(
+    ubyte* dst, size_t& offset, uint counter, uint16_t c
+) {
     if (counter >= 0x40) {
         dst[offset++] = 0x80 | ((c > 255) << 6) | (counter & 0x3F);
         dst[offset++] = counter >> 6;
@@ -189,5 +257,20 @@ size_t extrle::encode16(const ubyte* src8, size_t srclen, ubyte* dst) {
     } else {
         dst[offset++] = c;
     }
+}
+
+size_t extrle::encode16(const ubyte* src8, size_t srclen, ubyte* dst) {
+    constexpr size_t max_run = max_sequence16 + 1;
+    auto src = reinterpret_cast<const uint16_t*>(src8);
+    size_t length = srclen / 2;
+    size_t offset = 0;
+    for (size_t i = 0; i < length;) {
+        size_t end = find_run_end(src, i, length);
+        uint16_t c = src[i];
+        for (; i < end; i += max_run) {
+            put_run16(dst, offset, std::min(end - i, max_run) - 1, c);
+        }
+        i = end;
+    }
     return offset;
 }
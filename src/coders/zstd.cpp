@@ -0,0 +1,128 @@
+#include "zstd.hpp"
+
+#include <zstd.h>
+#include <zdict.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+static size_t check_result(size_t result) {
+    if (ZSTD_isError(result)) {
+        throw std::runtime_error(
+            std::string("zstd error: ") + ZSTD_getErrorName(result)
+        );
+    }
+    return result;
+}
+
+/// Contexts are reused to avoid reallocating zstd internal state
+static ZSTD_CCtx* get_compression_context() {
+    thread_local std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> context(
+        ZSTD_createCCtx(), ZSTD_freeCCtx
+    );
+    return context.get();
+}
+
+static ZSTD_DCtx* get_decompression_context() {
+    thread_local std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> context(
+        ZSTD_createDCtx(), ZSTD_freeDCtx
+    );
+    return context.get();
+}
+
+zstd::Dictionary::Dictionary(std::vector<ubyte> bytes, int level)
+    : bytes(std::move(bytes)) {
+    id = ZSTD_getDictID_fromDict(this->bytes.data(), this->bytes.size());
+    if (id == 0) {
+        // frames compressed with raw content dictionary have no id, so
+        // they could not be told from frames compressed without dictionary
+        throw std::runtime_error("raw content zstd dictionary is not supported");
+    }
+    cdict = ZSTD_createCDict(this->bytes.data(), this->bytes.size(), level);
+    ddict = ZSTD_createDDict(this->bytes.data(), this->bytes.size());
+    if (cdict == nullptr || ddict == nullptr) {
+        ZSTD_freeCDict(cdict);
+        ZSTD_freeDDict(ddict);
+        throw std::runtime_error("invalid zstd dictionary");
+    }
+}
+
+zstd::Dictionary::~Dictionary() {
+    ZSTD_freeCDict(cdict);
+    ZSTD_freeDDict(ddict);
+}
+
+std::vector<ubyte> zstd::compress(
+    const ubyte* src, size_t size, int level, const Dictionary* dictionary
+) {
+    std::vector<ubyte> buffer(ZSTD_compressBound(size));
+    auto context = get_compression_context();
+    size_t compressedSize;
+    if (dictionary) {
+        compressedSize = ZSTD_compress_usingCDict(
+            context,
+            buffer.data(),
+            buffer.size(),
+            src,
+            size,
+            dictionary->getCDict()
+        );
+    } else {
+        compressedSize = ZSTD_compressCCtx(
+            context, buffer.data(), buffer.size(), src, size, level
+        );
+    }
+    buffer.resize(check_result(compressedSize));
+    return buffer;
+}
+
+size_t zstd::decompress(
+    const ubyte* src,
+    size_t size,
+    ubyte* dst,
+    size_t dstSize,
+    const Dictionary* dictionary
+) {
+    auto context = get_decompression_context();
+    uint dictId = ZSTD_getDictID_fromFrame(src, size);
+    if (dictId == 0) {
+        return check_result(ZSTD_decompressDCtx(context, dst, dstSize, src, size));
+    }
+    if (dictionary == nullptr || dictionary->getId() != dictId) {
+        throw std::runtime_error(
+            "zstd dictionary " + std::to_string(dictId) + " required"
+        );
+    }
+    return check_result(ZSTD_decompress_usingDDict(
+        context, dst, dstSize, src, size, dictionary->getDDict()
+    ));
+}
+
+std::vector<ubyte> zstd::train_dictionary(
+    const std::vector<std::vector<ubyte>>& samples, size_t capacity
+) {
+    std::vector<ubyte> samplesBuffer;
+    std::vector<size_t> samplesSizes;
+    samplesSizes.reserve(samples.size());
+    for (const auto& sample : samples) {
+        samplesBuffer.insert(samplesBuffer.end(), sample.begin(), sample.end());
+        samplesSizes.push_back(sample.size());
+    }
+    std::vector<ubyte> buffer(capacity);
+    size_t size = ZDICT_trainFromBuffer(
+        buffer.data(),
+        buffer.size(),
+        samplesBuffer.data(),
+        samplesSizes.data(),
+        static_cast<unsigned>(samplesSizes.size())
+    );
+    if (ZDICT_isError(size)) {
+        throw std::runtime_error(
+            std::string("could not train zstd dictionary: ") +
+            ZDICT_getErrorName(size)
+        );
+    }
+    buffer.resize(size);
+    return buffer;
+}
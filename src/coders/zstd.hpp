@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+
+#include "typedefs.hpp"
+
+struct ZSTD_CDict_s;
+struct ZSTD_DDict_s;
+
+namespace zstd {
+    inline constexpr int DEFAULT_LEVEL = 3;
+    inline constexpr size_t DEFAULT_DICTIONARY_SIZE = 64 * 1024;
+
+    /// @brief Prepared compression dictionary. Small similar inputs (like
+    /// chunks data) are compressed much better using a dictionary trained
+    /// on samples of such data.
+    class Dictionary {
+        std::vector<ubyte> bytes;
+        uint id;
+        ZSTD_CDict_s* cdict;
+        ZSTD_DDict_s* ddict;
+    public:
+        /// @param bytes dictionary bytes (see train_dictionary)
+        /// @param level compression level used with the dictionary
+        /// @throws std::runtime_error if dictionary is invalid
+        Dictionary(std::vector<ubyte> bytes, int level = DEFAULT_LEVEL);
+        Dictionary(const Dictionary&) = delete;
+        ~Dictionary();
+
+        /// @brief Get dictionary id written to frames compressed with it
+        uint getId() const {
+            return id;
+        }
+
+        const std::vector<ubyte>& getBytes() const {
+            return bytes;
+        }
+
+        ZSTD_CDict_s* getCDict() const {
+            return cdict;
+        }
+
+        ZSTD_DDict_s* getDDict() const {
+            return ddict;
+        }
+    };
+
+    /// Compress bytes array to zstd frame
+    /// @param src source bytes array
+    /// @param size length of source bytes array
+    /// @param level compression level (ignored if dictionary is used)
+    /// @param dictionary optional compression dictionary
+    std::vector<ubyte> compress(
+        const ubyte* src,
+        size_t size,
+        int level = DEFAULT_LEVEL,
+        const Dictionary* dictionary = nullptr
+    );
+
+    /// Decompress zstd frame
+    /// @param src zstd data
+    /// @param size length of zstd data
+    /// @param dst destination buffer
+    /// @param dstSize destination buffer length
+    /// @param dictionary dictionary used to compress the frame (ignored if
+    /// the frame was compressed without dictionary)
+    /// @return decompressed data length
+    /// @throws std::runtime_error if data is corrupted, does not fit or
+    /// required dictionary is not provided
+    size_t decompress(
+        const ubyte* src,
+        size_t size,
+        ubyte* dst,
+        size_t dstSize,
+        const Dictionary* dictionary = nullptr
+    );
+
+    /// Train dictionary for compression of data similar to the samples
+    /// @param samples data samples (few thousands recommended)
+    /// @param capacity max dictionary size
+    /// @return dictionary bytes
+    std::vector<ubyte> train_dictionary(
+        const std::vector<std::vector<ubyte>>& samples,
+        size_t capacity = DEFAULT_DICTIONARY_SIZE
+    );
+}
@@ -22,6 +22,9 @@ inline constexpr uint REGION_FORMAT_VERSION = 3;
 /// @brief max simultaneously open world region files
 inline constexpr uint MAX_OPEN_REGION_FILES = 32;
 
+/// @brief region file dead space fraction scheduling it for compaction
+inline constexpr float DEFAULT_COMPACTION_THRESHOLD = 0.5f;
+
 inline constexpr blockid_t BLOCK_AIR = 0;
 inline constexpr blockid_t BLOCK_OBSTACLE = 1;
 inline constexpr blockid_t BLOCK_STRUCT_AIR = 2;
@@ -44,6 +47,13 @@ inline constexpr float CHUNKS_MAP_MAX_LOAD_FACTOR = 0.1f;
 /// @brief chunk volume (count of voxels per Chunk)
 inline constexpr int CHUNK_VOL = (CHUNK_W * CHUNK_H * CHUNK_D);
 
+/// @brief height of chunk vertical section
+inline constexpr int CHUNK_SECTION_H = 16;
+/// @brief count of vertical sections per Chunk
+inline constexpr int CHUNK_SECTIONS = CHUNK_H / CHUNK_SECTION_H;
+/// @brief section volume (count of voxels per section)
+inline constexpr int CHUNK_SECTION_VOL = CHUNK_W * CHUNK_SECTION_H * CHUNK_D;
+
 /// @brief block id used to mark non-existing voxel (voxel of missing chunk)
 inline constexpr blockid_t BLOCK_VOID = std::numeric_limits<blockid_t>::max();
 /// @brief item id used to mark non-existing item (error)
@@ -206,6 +206,7 @@ void ContentLoader::loadGenerator(
     }
     auto map = io::read_toml(generatorsDir / (name + ".toml"));
     map.at("caption").get(def.caption);
+    map.at("version").get(def.version);
     map.at("biome-parameters").get(def.biomeParameters);
     map.at("biome-bpd").get(def.biomesBPD);
     map.at("heights-bpd").get(def.heightsBPD);
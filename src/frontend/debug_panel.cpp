@@ -26,6 +26,7 @@
 #include "voxels/GlobalChunks.hpp"
 #include "world/Level.hpp"
 #include "world/World.hpp"
+#include "world/files/WorldFiles.hpp"
 
 #include <string>
 #include <memory>
@@ -123,6 +124,12 @@ std::shared_ptr<UINode> create_debug_panel(
         return L"chunks: "+std::to_wstring(level.chunks->size())+
                L" visible: "+std::to_wstring(ChunksRenderer::visibleChunks);
     }));
+    panel->add(create_label(gui, [&]() {
+        auto stats = level.getWorld()->wfile->getRegions().getOpenFilesStats();
+        return L"region-files hits: " + std::to_wstring(stats.hits) +
+               L" misses: " + std::to_wstring(stats.misses) +
+               L" evictions: " + std::to_wstring(stats.evictions);
+    }));
     panel->add(create_label(gui, [&]() {
         return L"entities: "+std::to_wstring(level.entities->size())+L" next: "+
                std::to_wstring(level.entities->peekNextID());
@@ -273,7 +273,7 @@ void Hud::updateWorldGenDebug() {
     uint padding = engine.getSettings().chunks.padding.get();
     auto generator =
         frontend.getController()->getChunksController()->getGenerator();
-    auto debugInfo = generator->createDebugInfo();
+    auto debugInfo = generator->createDebugInfo(player.getId());
     
     int width = debugImgWorldGen->getWidth();
     int height = debugImgWorldGen->getHeight();
@@ -12,6 +12,16 @@
 const glm::vec3 BlocksRenderer::SUN_VECTOR(0.528265f, 0.833149f, -0.163704f);
 const float DIRECTIONAL_LIGHT_FACTOR = 0.3f;
 
+/// @brief Non-rotated cube face X and Y axes by face index (see blockCube)
+static const glm::ivec3 CUBE_FACE_AXES[6][2] {
+    {{0, 0, 1}, {0, 1, 0}},
+    {{0, 0, -1}, {0, 1, 0}},
+    {{1, 0, 0}, {0, 0, 1}},
+    {{1, 0, 0}, {0, 0, -1}},
+    {{-1, 0, 0}, {0, 1, 0}},
+    {{1, 0, 0}, {0, 1, 0}},
+};
+
 BlocksRenderer::BlocksRenderer(
     size_t capacity,
     const Content& content,
@@ -33,11 +43,21 @@ BlocksRenderer::BlocksRenderer(
         CHUNK_H,
         CHUNK_D + voxelBufferPadding*2);
     blockDefsCache = content.getIndices()->blocks.getDefs();
+    compactVertices = settings.graphics.compactVertices.get();
+    if (compactVertices) {
+        compactVertexBuffer = std::make_unique<CompactChunkVertex[]>(capacity);
+    }
 }
 
 BlocksRenderer::~BlocksRenderer() {
 }
 
+static inline uint16_t quantize_uv(float value) {
+    return static_cast<uint16_t>(
+        std::round(glm::clamp(value, 0.0f, 1.0f) * 0xFFFF)
+    );
+}
+
 /// Basic vertex add method
 void BlocksRenderer::vertex(
     const glm::vec3& coord,
@@ -49,7 +69,7 @@ void BlocksRenderer::vertex(
 ) {
     vertexBuffer[vertexCount].position = coord;
 
-    vertexBuffer[vertexCount].uv = {u,v};
+    vertexBuffer[vertexCount].uv = {quantize_uv(u), quantize_uv(v)};
 
     vertexBuffer[vertexCount].normal[0] = static_cast<uint8_t>(normal.r * 127 + 128);
     vertexBuffer[vertexCount].normal[1] = static_cast<uint8_t>(normal.g * 127 + 128);
@@ -61,6 +81,8 @@ void BlocksRenderer::vertex(
     vertexBuffer[vertexCount].color[2] = static_cast<uint8_t>(light.b * 255);
     vertexBuffer[vertexCount].color[3] = static_cast<uint8_t>(light.a * 255);
 
+    vertexBuffer[vertexCount].regionEnd = {};
+
     vertexCount++;
 }
 
@@ -425,6 +447,133 @@ void BlocksRenderer::blockCube(
     }
 }
 
+static inline uint32_t pack_color(const glm::vec4& light) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(light.r * 255)) |
+           static_cast<uint32_t>(static_cast<uint8_t>(light.g * 255)) << 8 |
+           static_cast<uint32_t>(static_cast<uint8_t>(light.b * 255)) << 16 |
+           static_cast<uint32_t>(static_cast<uint8_t>(light.a * 255)) << 24;
+}
+
+static inline int axis_length(const glm::ivec3& axis, const glm::ivec3& size) {
+    return std::abs(axis.x * size.x + axis.y * size.y + axis.z * size.z);
+}
+
+void BlocksRenderer::greedyCube(
+    const glm::ivec3& coord,
+    const Block& block,
+    uint8_t variantId,
+    bool lights,
+    bool ao
+) {
+    const auto& variant = block.getVariant(variantId);
+    for (uint8_t side = 0; side < 6; side++) {
+        const auto& normal = GreedyMesher::NORMALS[side];
+        if (!isOpen(coord + normal, block, variant)) {
+            continue;
+        }
+        glm::vec3 X(CUBE_FACE_AXES[side][0]);
+        glm::vec3 Y(CUBE_FACE_AXES[side][1]);
+        glm::vec3 Z(normal);
+        const glm::vec3 corners[4] {-X - Y + Z, X - Y + Z, X + Y + Z, -X + Y + Z};
+
+        // same lights as calculated by faceAO and face
+        float d = 1.0f;
+        if (lights) {
+            d = glm::dot(Z, SUN_VECTOR);
+            d = (1.0f - DIRECTIONAL_LIGHT_FACTOR) + d * DIRECTIONAL_LIGHT_FACTOR;
+        }
+        glm::vec4 colors[4];
+        if (ao && lights) {
+            for (int i = 0; i < 4; i++) {
+                auto pos = glm::vec3(coord) + corners[i] * 0.5f + Z * 0.5f +
+                           (X + Y) * 0.5f;
+                colors[i] = pickSoftLight(
+                    glm::ivec3(
+                        std::round(pos.x), std::round(pos.y), std::round(pos.z)
+                    ),
+                    CUBE_FACE_AXES[side][0],
+                    CUBE_FACE_AXES[side][1]
+                ) * d;
+            }
+        } else {
+            auto tint = ao ? glm::vec4(1.0f) : pickLight(coord + normal) * d;
+            std::fill_n(colors, 4, tint);
+        }
+        uint32_t color = pack_color(colors[0]);
+        if (pack_color(colors[1]) == color && pack_color(colors[2]) == color &&
+            pack_color(colors[3]) == color) {
+            greedyMesher.add(
+                coord,
+                side,
+                static_cast<uint64_t>(block.rt.id) << 40 |
+                    static_cast<uint64_t>(variantId) << 32 | color
+            );
+            continue;
+        }
+        // unevenly lit faces are not merged
+        if (vertexCount + 4 >= capacity) {
+            overflow = true;
+            return;
+        }
+        const auto& region =
+            cache.getRegion(block.rt.id, variantId, side, densePass);
+        float emission = lights ? 0.0f : 1.0f;
+        glm::vec3 center(coord);
+        vertex(center + corners[0] * 0.5f, region.u1, region.v1, colors[0], Z, emission);
+        vertex(center + corners[1] * 0.5f, region.u2, region.v1, colors[1], Z, emission);
+        vertex(center + corners[2] * 0.5f, region.u2, region.v2, colors[2], Z, emission);
+        vertex(center + corners[3] * 0.5f, region.u1, region.v2, colors[3], Z, emission);
+        index(0, 1, 2, 0, 2, 3);
+    }
+}
+
+void BlocksRenderer::flushGreedyFaces() {
+    if (greedyMesher.size() == 0) {
+        return;
+    }
+    greedyQuads.clear();
+    greedyMesher.merge(greedyQuads);
+    for (const auto& quad : greedyQuads) {
+        if (vertexCount + 4 >= capacity) {
+            overflow = true;
+            return;
+        }
+        blockid_t id = quad.key >> 40;
+        uint8_t variantId = (quad.key >> 32) & 0xFF;
+        uint32_t color = quad.key & 0xFFFFFFFF;
+        const auto& region = cache.getRegion(id, variantId, quad.direction, densePass);
+        float emission = blockDefsCache[id]->shadeless ? 1.0f : 0.0f;
+
+        const auto& axisX = CUBE_FACE_AXES[quad.direction][0];
+        const auto& axisY = CUBE_FACE_AXES[quad.direction][1];
+        float w = axis_length(axisX, quad.size);
+        float h = axis_length(axisY, quad.size);
+        glm::vec3 Z(GreedyMesher::NORMALS[quad.direction]);
+        auto X = glm::vec3(axisX) * w;
+        auto Y = glm::vec3(axisY) * h;
+        auto center =
+            glm::vec3(quad.position) + glm::vec3(quad.size - 1) * 0.5f;
+
+        // texture region is repeated by shader, uv in voxels is restored
+        // from position
+        glm::vec4 light(0.0f);
+        float u = region.u1;
+        float v = region.v1;
+        vertex(center + (-X - Y + Z) * 0.5f, u, v, light, Z, emission);
+        vertex(center + ( X - Y + Z) * 0.5f, u, v, light, Z, emission);
+        vertex(center + ( X + Y + Z) * 0.5f, u, v, light, Z, emission);
+        vertex(center + (-X + Y + Z) * 0.5f, u, v, light, Z, emission);
+        for (size_t i = vertexCount - 4; i < vertexCount; i++) {
+            auto& vertex = vertexBuffer[i];
+            for (int c = 0; c < 4; c++) {
+                vertex.color[c] = (color >> (c * 8)) & 0xFF;
+            }
+            vertex.regionEnd = {quantize_uv(region.u2), quantize_uv(region.v2)};
+        }
+        index(0, 1, 2, 0, 2, 3);
+    }
+}
+
 bool BlocksRenderer::isOpenForLight(int x, int y, int z) const {
     blockid_t id = voxelsBuffer->pickBlockId(chunk->x * CHUNK_W + x,
                                              y,
@@ -475,18 +624,36 @@ glm::vec4 BlocksRenderer::pickSoftLight(
         right, up);
 }
 
+/// @brief Move voxel index to the last voxel of the section if the
+/// section is empty
+/// @return true if section is skipped
+static inline bool skip_empty_section(const Chunk& chunk, int& index) {
+    if (index % CHUNK_SECTION_VOL == 0 &&
+        chunk.sections[index / CHUNK_SECTION_VOL].isEmpty()) {
+        index += CHUNK_SECTION_VOL - 1;
+        return true;
+    }
+    return false;
+}
+
 void BlocksRenderer::render(
     const voxel* voxels, const int beginEnds[256][2]
 ) {
     bool denseRender = this->denseRender;
     bool densePass = this->densePass;
+    uint8_t order = 0;
     for (const auto drawGroup : *content.drawGroups) {
+        uint8_t groupOrder = order++;
         int begin = beginEnds[drawGroup][0];
         if (begin == 0) {
             continue;
         }
         int end = beginEnds[drawGroup][1];
+        size_t firstIndex = indexCount;
         for (int i = begin-1; i <= end; i++) {
+            if (skip_empty_section(*chunk, i)) {
+                continue;
+            }
             const voxel& vox = voxels[i];
             blockid_t id = vox.id;
             blockstate state = vox.state;
@@ -515,6 +682,11 @@ void BlocksRenderer::render(
             int z = (i / CHUNK_D) % CHUNK_W;
             switch (def.getModel(state.userbits).type) {
                 case BlockModelType::BLOCK:
+                    if (greedyMeshing && !def.rotatable) {
+                        greedyCube({x, y, z}, def, variantId, !def.shadeless,
+                                   def.ambientOcclusion);
+                        break;
+                    }
                     blockCube({x, y, z}, texfaces, def, vox.state, !def.shadeless,
                               def.ambientOcclusion);
                     break;
@@ -545,21 +717,29 @@ void BlocksRenderer::render(
                     break;
             }
             if (overflow) {
-                return;
+                greedyMesher.clear();
+                break;
             }
         }
+        flushGreedyFaces();
+        if (indexCount > firstIndex) {
+            indexRuns.push_back(SectionIndicesRun {
+                pass,
+                groupOrder,
+                static_cast<uint32_t>(firstIndex),
+                static_cast<uint32_t>(indexCount - firstIndex)});
+        }
+        if (overflow) {
+            return;
+        }
     }
 }
 
-SortingMeshData BlocksRenderer::renderTranslucent(
-    const voxel* voxels, int beginEnds[256][2]
+void BlocksRenderer::renderTranslucent(
+    const voxel* voxels,
+    const int beginEnds[256][2],
+    std::vector<SortingMeshEntry>& entries
 ) {
-    SortingMeshData sortingMesh {{}};
-
-    AABB aabb {};
-    bool aabbInit = false;
-    size_t totalSize = 0;
-
     bool densePass = this->densePass;
     for (const auto drawGroup : *content.drawGroups) {
         int begin = beginEnds[drawGroup][0];
@@ -568,6 +748,9 @@ SortingMeshData BlocksRenderer::renderTranslucent(
         }
         int end = beginEnds[drawGroup][1];
         for (int i = begin-1; i <= end; i++) {
+            if (skip_empty_section(*chunk, i)) {
+                continue;
+            }
             const voxel& vox = voxels[i];
             blockid_t id = vox.id;
             blockstate state = vox.state;
@@ -625,8 +808,6 @@ SortingMeshData BlocksRenderer::renderTranslucent(
                 ),
                 util::Buffer<ChunkVertex>(indexCount), 0};
 
-            totalSize += entry.vertexData.size();
-
             for (int j = 0; j < indexCount; j++) {
                 std::memcpy(
                     entry.vertexData.data() + j,
@@ -634,21 +815,42 @@ SortingMeshData BlocksRenderer::renderTranslucent(
                     sizeof(ChunkVertex)
                 );
                 ChunkVertex& vertex = entry.vertexData[j];
+                vertex.position.x += chunk->x * CHUNK_W + 0.5f;
+                vertex.position.y += 0.5f;
+                vertex.position.z += chunk->z * CHUNK_D + 0.5f;
+            }
+            entries.push_back(std::move(entry));
+            vertexCount = 0;
+            vertexOffset = indexCount = 0;
+        }
+    }
+}
 
+/// @brief Copy sections translucent entries merging them into single
+/// entry if all vertices are in a plane
+static SortingMeshData stitch_sorting_entries(
+    const ChunkSectionsMesh& sectionsMesh
+) {
+    SortingMeshData sortingMesh {{}};
+    AABB aabb {};
+    bool aabbInit = false;
+    size_t totalSize = 0;
+    for (const auto& section : sectionsMesh.sections) {
+        if (section == nullptr) {
+            continue;
+        }
+        for (const auto& entry : section->sortingEntries) {
+            for (const auto& vertex : entry.vertexData) {
                 if (!aabbInit) {
                     aabbInit = true;
                     aabb.a = aabb.b = vertex.position;
                 } else {
                     aabb.addPoint(vertex.position);
                 }
-
-                vertex.position.x += chunk->x * CHUNK_W + 0.5f;
-                vertex.position.y += 0.5f;
-                vertex.position.z += chunk->z * CHUNK_D + 0.5f;
             }
-            sortingMesh.entries.push_back(std::move(entry));
-            vertexCount = 0;
-            vertexOffset = indexCount = 0;
+            totalSize += entry.vertexData.size();
+            sortingMesh.entries.push_back(SortingMeshEntry {
+                entry.position, entry.vertexData.clone(), entry.distance});
         }
     }
 
@@ -675,23 +877,28 @@ SortingMeshData BlocksRenderer::renderTranslucent(
     return sortingMesh;
 }
 
-void BlocksRenderer::build(const Chunk* chunk, const Chunks* chunks) {
-    this->chunk = chunk;
-    voxelsBuffer->setPosition(
-        chunk->x * CHUNK_W - voxelBufferPadding, 0,
-        chunk->z * CHUNK_D - voxelBufferPadding);
-    chunks->getVoxels(*voxelsBuffer, settings.graphics.backlight.get());
-
-    if (voxelsBuffer->pickBlockId(
-        chunk->x * CHUNK_W, 0, chunk->z * CHUNK_D
-    ) == BLOCK_VOID) {
-        cancelled = true;
-        return;
+/// @return mask of available neighbour chunks (-X, +X, -Z, +Z)
+static uint8_t get_neighbours_mask(const Chunk& chunk, const Chunks& chunks) {
+    const glm::ivec2 offsets[] {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+    uint8_t mask = 0;
+    for (int i = 0; i < 4; i++) {
+        if (chunks.getChunk(chunk.x + offsets[i].x, chunk.z + offsets[i].y)) {
+            mask |= 1 << i;
+        }
     }
-    const voxel* voxels = chunk->voxels;
+    return mask;
+}
 
-    int totalBegin = chunk->bottom * (CHUNK_W * CHUNK_D);
-    int totalEnd = chunk->top * (CHUNK_W * CHUNK_D);
+std::shared_ptr<ChunkSectionMesh> BlocksRenderer::buildSection(
+    const voxel* voxels, int section
+) {
+    int sectionBegin = std::max(chunk->bottom, section * CHUNK_SECTION_H);
+    int sectionEnd = std::min(chunk->top, (section + 1) * CHUNK_SECTION_H);
+    if (sectionBegin >= sectionEnd || chunk->sections[section].isEmpty()) {
+        return nullptr;
+    }
+    int totalBegin = sectionBegin * (CHUNK_W * CHUNK_D);
+    int totalEnd = sectionEnd * (CHUNK_W * CHUNK_D);
 
     int beginEnds[256][2] {};
     for (int i = totalBegin; i < totalEnd; i++) {
@@ -705,7 +912,7 @@ void BlocksRenderer::build(const Chunk* chunk, const Chunks* chunks) {
         }
         beginEnds[variant.drawGroup][1] = i;
     }
-    cancelled = false;
+    auto mesh = std::make_shared<ChunkSectionMesh>();
 
     overflow = false;
     vertexCount = 0;
@@ -714,60 +921,152 @@ void BlocksRenderer::build(const Chunk* chunk, const Chunks* chunks) {
     denseRender = false;
     densePass = false;
 
-    sortingMesh = renderTranslucent(voxels, beginEnds);
+    renderTranslucent(voxels, beginEnds, mesh->sortingEntries);
 
     overflow = false;
     vertexCount = 0;
     vertexOffset = 0;
     indexCount = 0;
-    denseIndexCount = 0;
+    indexRuns.clear();
 
-    denseRender = false; //settings.graphics.denseRender.get();
-    densePass = false;
+    pass = SectionIndicesRun::REGULAR;
     render(voxels, beginEnds);
 
-    size_t endIndex = indexCount;
-    
+    pass = SectionIndicesRun::OPTIONAL_DENSE;
     denseRender = true;
     densePass = true;
     render(voxels, beginEnds);
 
-    denseIndexCount = indexCount;
-    for (size_t i = 0; i < denseIndexCount; i++) {
-        denseIndexBuffer[i] = indexBuffer[i];
-    }
-
-    indexCount = endIndex;
+    pass = SectionIndicesRun::OPTIONAL_CULLED;
     densePass = false;
     render(voxels, beginEnds);
+
+    mesh->vertices.assign(vertexBuffer.get(), vertexBuffer.get() + vertexCount);
+    mesh->indices.assign(indexBuffer.get(), indexBuffer.get() + indexCount);
+    mesh->runs = indexRuns;
+    if (mesh->vertices.empty() && mesh->sortingEntries.empty()) {
+        return nullptr;
+    }
+    return mesh;
+}
+
+void BlocksRenderer::stitchSections(const ChunkSectionsMesh& sectionsMesh) {
+    ChunkMeshBuffers buffers {
+        vertexBuffer.get(),
+        indexBuffer.get(),
+        denseIndexBuffer.get(),
+        capacity};
+    overflow = !sectionsMesh.stitch(content.drawGroups->size(), buffers);
+    vertexCount = buffers.vertexCount;
+    indexCount = buffers.indexCount;
+    denseIndexCount = buffers.denseIndexCount;
+
+    sortingMesh = stitch_sorting_entries(sectionsMesh);
+}
+
+void BlocksRenderer::build(
+    const Chunk* chunk,
+    const Chunks* chunks,
+    const ChunkSectionsMesh* prevSections,
+    uint16_t modifiedSections
+) {
+    this->chunk = chunk;
+    voxelsBuffer->setPosition(
+        chunk->x * CHUNK_W - voxelBufferPadding, 0,
+        chunk->z * CHUNK_D - voxelBufferPadding);
+    chunks->getVoxels(*voxelsBuffer, settings.graphics.backlight.get());
+
+    if (voxelsBuffer->pickBlockId(
+        chunk->x * CHUNK_W, 0, chunk->z * CHUNK_D
+    ) == BLOCK_VOID) {
+        cancelled = true;
+        vertexCount = indexCount = denseIndexCount = 0;
+        sortingMesh = {};
+        sectionsMesh = nullptr;
+        return;
+    }
+    cancelled = false;
+    auto voxelsView = chunk->voxels.view();
+    const voxel* voxels = voxelsView.data();
+
+    greedyMeshing = settings.graphics.greedyMeshing.get();
+    auto sectionsMesh = ChunkSectionsMesh::rebuild(
+        prevSections,
+        get_neighbours_mask(*chunk, *chunks),
+        modifiedSections,
+        [this, voxels](int section) { return buildSection(voxels, section); }
+    );
+    stitchSections(*sectionsMesh);
+    this->sectionsMesh = std::move(sectionsMesh);
+}
+
+void BlocksRenderer::encodeCompactVertices() {
+    for (size_t i = 0; i < vertexCount; i++) {
+        compactVertexBuffer[i] = CompactChunkVertex::encode(vertexBuffer[i]);
+    }
 }
 
 ChunkMeshData BlocksRenderer::createMesh() {
+    std::vector<util::Buffer<uint32_t>> indices {
+        util::Buffer(indexBuffer.get(), indexCount),
+        util::Buffer(denseIndexBuffer.get(), denseIndexCount),
+    };
+    if (compactVertices) {
+        encodeCompactVertices();
+        return ChunkMeshData {
+            {},
+            std::move(sortingMesh),
+            MeshData(
+                util::Buffer(compactVertexBuffer.get(), vertexCount),
+                std::move(indices),
+                util::Buffer(
+                    CompactChunkVertex::ATTRIBUTES,
+                    sizeof(CompactChunkVertex::ATTRIBUTES) / sizeof(VertexAttribute)
+                )
+            ),
+            std::move(sectionsMesh)
+        };
+    }
     return ChunkMeshData {
         MeshData(
             util::Buffer(vertexBuffer.get(), vertexCount),
-            std::vector<util::Buffer<uint32_t>> {
-                util::Buffer(indexBuffer.get(), indexCount),
-                util::Buffer(denseIndexBuffer.get(), denseIndexCount),
-            },
+            std::move(indices),
             util::Buffer(
                 ChunkVertex::ATTRIBUTES, sizeof(ChunkVertex::ATTRIBUTES) / sizeof(VertexAttribute)
             )
         ),
-        std::move(sortingMesh)
+        std::move(sortingMesh),
+        {},
+        std::move(sectionsMesh)
     };
 }
 
-ChunkMesh BlocksRenderer::render(const Chunk *chunk, const Chunks *chunks) {
-    build(chunk, chunks);
+ChunkMesh BlocksRenderer::render(
+    const Chunk* chunk,
+    const Chunks* chunks,
+    const ChunkSectionsMesh* prevSections,
+    uint16_t modifiedSections
+) {
+    build(chunk, chunks, prevSections, modifiedSections);
 
-    return ChunkMesh{std::make_unique<Mesh<ChunkVertex>>(
-        vertexBuffer.get(), vertexCount, 
-        std::vector<IndexBufferData> {
-            IndexBufferData {indexBuffer.get(), indexCount},
-            IndexBufferData {denseIndexBuffer.get(), denseIndexCount},
-        }
+    std::vector<IndexBufferData> indices {
+        IndexBufferData {indexBuffer.get(), indexCount},
+        IndexBufferData {denseIndexBuffer.get(), denseIndexCount},
+    };
+    if (compactVertices) {
+        encodeCompactVertices();
+        ChunkMesh mesh {nullptr, std::move(sortingMesh)};
+        mesh.compactMesh = std::make_unique<Mesh<CompactChunkVertex>>(
+            compactVertexBuffer.get(), vertexCount, std::move(indices)
+        );
+        mesh.sections = std::move(sectionsMesh);
+        return mesh;
+    }
+    ChunkMesh mesh {std::make_unique<Mesh<ChunkVertex>>(
+        vertexBuffer.get(), vertexCount, std::move(indices)
     ), std::move(sortingMesh)};
+    mesh.sections = std::move(sectionsMesh);
+    return mesh;
 }
 
 VoxelsVolume* BlocksRenderer::getVoxelsBuffer() const {
@@ -776,5 +1075,9 @@ VoxelsVolume* BlocksRenderer::getVoxelsBuffer() const {
 
 size_t BlocksRenderer::getMemoryConsumption() const {
     size_t volume = voxelsBuffer->getW() * voxelsBuffer->getH() * voxelsBuffer->getD();
-    return capacity * (sizeof(ChunkVertex) + sizeof(uint32_t) * 2) + volume * (sizeof(voxel) + sizeof(light_t));
+    size_t vertexSize = sizeof(ChunkVertex);
+    if (compactVertices) {
+        vertexSize += sizeof(CompactChunkVertex);
+    }
+    return capacity * (vertexSize + sizeof(uint32_t) * 2) + volume * (sizeof(voxel) + sizeof(light_t));
 }
@@ -10,6 +10,7 @@
 #include "voxels/VoxelsVolume.hpp"
 #include "maths/util.hpp"
 #include "commons.hpp"
+#include "GreedyMesher.hpp"
 #include "settings.hpp"
 
 template<typename VertexStructure> class Mesh;
@@ -25,6 +26,8 @@ class BlocksRenderer {
     static const glm::vec3 SUN_VECTOR;
     const Content& content;
     std::unique_ptr<ChunkVertex[]> vertexBuffer;
+    /// @brief Encoded opaque mesh vertices if compact vertices are enabled
+    std::unique_ptr<CompactChunkVertex[]> compactVertexBuffer;
     std::unique_ptr<uint32_t[]> indexBuffer;
     std::unique_ptr<uint32_t[]> denseIndexBuffer;
     size_t vertexCount;
@@ -37,6 +40,10 @@ class BlocksRenderer {
     bool cancelled = false;
     bool densePass = false;
     bool denseRender = false;
+    /// @brief Merge coplanar full-cube faces (see greedyCube)
+    bool greedyMeshing = false;
+    /// @brief Produce CompactChunkVertex opaque meshes
+    bool compactVertices = false;
     const Chunk* chunk = nullptr;
     std::unique_ptr<VoxelsVolume> voxelsBuffer;
 
@@ -47,6 +54,15 @@ class BlocksRenderer {
     util::PseudoRandom randomizer;
 
     SortingMeshData sortingMesh;
+    /// @brief Sections meshes of the last build
+    std::shared_ptr<ChunkSectionsMesh> sectionsMesh;
+    /// @brief Current render pass
+    SectionIndicesRun::Pass pass = SectionIndicesRun::REGULAR;
+    /// @brief Index runs of the section being built
+    std::vector<SectionIndicesRun> indexRuns;
+
+    GreedyMesher greedyMesher;
+    std::vector<GreedyQuad> greedyQuads;
 
     void vertex(
         const glm::vec3& coord,
@@ -100,6 +116,17 @@ class BlocksRenderer {
         bool lights,
         bool ao
     );
+    /// @brief Full-cube block render method adding evenly lit faces
+    /// to the greedy mesher instead of direct rendering
+    void greedyCube(
+        const glm::ivec3& coord,
+        const Block& block,
+        uint8_t variantId,
+        bool lights,
+        bool ao
+    );
+    /// @brief Merge faces added by greedyCube and render resulting quads
+    void flushGreedyFaces();
     void blockAABB(
         const glm::ivec3& coord,
         const UVRegion(&faces)[6], 
@@ -156,7 +183,20 @@ class BlocksRenderer {
     glm::vec4 pickSoftLight(float x, float y, float z, const glm::ivec3& right, const glm::ivec3& up) const;
     
     void render(const voxel* voxels, const int beginEnds[256][2]);
-    SortingMeshData renderTranslucent(const voxel* voxels, int beginEnds[256][2]);
+    void renderTranslucent(
+        const voxel* voxels,
+        const int beginEnds[256][2],
+        std::vector<SortingMeshEntry>& entries
+    );
+    /// @brief Render all passes of the vertical section
+    /// @return section mesh or nullptr if section has no geometry
+    std::shared_ptr<ChunkSectionMesh> buildSection(
+        const voxel* voxels, int section
+    );
+    /// @brief Fill vertex, index buffers and sorting mesh from sections
+    void stitchSections(const ChunkSectionsMesh& sectionsMesh);
+    /// @brief Encode vertex buffer to the compact vertex buffer
+    void encodeCompactVertices();
 public:
     BlocksRenderer(
         size_t capacity,
@@ -166,8 +206,23 @@ public:
     );
     virtual ~BlocksRenderer();
 
-    void build(const Chunk* chunk, const Chunks* chunks);
-    ChunkMesh render(const Chunk* chunk, const Chunks* chunks);
+    /// @brief Build chunk mesh
+    /// @param prevSections sections meshes of the previous chunk mesh build.
+    /// If nullptr, all sections are rebuilt
+    /// @param modifiedSections mask of sections to rebuild, other sections
+    /// are taken from prevSections
+    void build(
+        const Chunk* chunk,
+        const Chunks* chunks,
+        const ChunkSectionsMesh* prevSections = nullptr,
+        uint16_t modifiedSections = ALL_SECTIONS_MASK
+    );
+    ChunkMesh render(
+        const Chunk* chunk,
+        const Chunks* chunks,
+        const ChunkSectionsMesh* prevSections = nullptr,
+        uint16_t modifiedSections = ALL_SECTIONS_MASK
+    );
     ChunkMeshData createMesh();
     VoxelsVolume* getVoxelsBuffer() const;
 
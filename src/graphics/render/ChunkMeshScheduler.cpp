@@ -0,0 +1,101 @@
+#include "ChunkMeshScheduler.hpp"
+
+#include <algorithm>
+
+#include "voxels/Chunk.hpp"
+
+bool ChunkMeshScheduler::request(std::shared_ptr<Chunk> chunk) {
+    glm::ivec2 key(chunk->x, chunk->z);
+    auto found = requests.find(key);
+    if (found != requests.end()) {
+        // chunk at the same position may be reloaded
+        found->second = std::move(chunk);
+        return false;
+    }
+    requests[key] = std::move(chunk);
+    return true;
+}
+
+bool ChunkMeshScheduler::cancel(int x, int z) {
+    return requests.erase(glm::ivec2(x, z)) > 0;
+}
+
+bool ChunkMeshScheduler::isRequested(int x, int z) const {
+    return requests.find(glm::ivec2(x, z)) != requests.end();
+}
+
+uint64_t ChunkMeshScheduler::start(int x, int z, uint16_t modifiedSections) {
+    uint64_t id = nextJobId++;
+    inwork[glm::ivec2(x, z)] = Job {id, modifiedSections};
+    return id;
+}
+
+bool ChunkMeshScheduler::finish(int x, int z, uint64_t id) {
+    auto found = inwork.find(glm::ivec2(x, z));
+    if (found == inwork.end() || found->second.id != id) {
+        return false;
+    }
+    inwork.erase(found);
+    return true;
+}
+
+uint16_t ChunkMeshScheduler::drop(int x, int z) {
+    auto found = inwork.find(glm::ivec2(x, z));
+    if (found == inwork.end()) {
+        return 0;
+    }
+    uint16_t modifiedSections = found->second.modifiedSections;
+    inwork.erase(found);
+    return modifiedSections;
+}
+
+bool ChunkMeshScheduler::isInWork(int x, int z) const {
+    return inwork.find(glm::ivec2(x, z)) != inwork.end();
+}
+
+void ChunkMeshScheduler::clear() {
+    requests.clear();
+    inwork.clear();
+}
+
+float ChunkMeshScheduler::getPriority(
+    const Chunk& chunk, const glm::vec3& cameraPosition, bool visible
+) {
+    float dx = (chunk.x + 0.5f) * CHUNK_W - cameraPosition.x;
+    float dz = (chunk.z + 0.5f) * CHUNK_D - cameraPosition.z;
+    float priority = dx * dx + dz * dz;
+    return visible ? priority : priority * INVISIBLE_PRIORITY_FACTOR;
+}
+
+void ChunkMeshScheduler::pop(
+    const glm::vec3& cameraPosition,
+    const VisibilityFunc& isVisible,
+    size_t count,
+    std::vector<std::shared_ptr<Chunk>>& dst
+) {
+    count = std::min(count, requests.size());
+    if (count == 0) {
+        return;
+    }
+    priorities.clear();
+    for (const auto& [key, chunk] : requests) {
+        bool visible = isVisible == nullptr || isVisible(*chunk);
+        priorities.emplace_back(getPriority(*chunk, cameraPosition, visible), key);
+    }
+    auto compare = [](const auto& a, const auto& b) {
+        if (a.first != b.first) {
+            return a.first < b.first;
+        }
+        // deterministic order of equally distant chunks
+        return a.second.x < b.second.x ||
+               (a.second.x == b.second.x && a.second.y < b.second.y);
+    };
+    std::partial_sort(
+        priorities.begin(), priorities.begin() + count, priorities.end(), compare
+    );
+    for (size_t i = 0; i < count; i++) {
+        auto found = requests.find(priorities[i].second);
+        dst.push_back(std::move(found->second));
+        requests.erase(found);
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+class Chunk;
+
+/// @brief Pending chunk mesh requests taken in order of distance to the
+/// camera and visibility. Repeated requests of a chunk are coalesced.
+/// Jobs given to workers are tracked until finished or dropped
+class ChunkMeshScheduler {
+public:
+    using VisibilityFunc = std::function<bool(const Chunk&)>;
+
+    /// @brief Invisible chunks priority is equal to priority of visible
+    /// chunks at twice the distance
+    static inline constexpr float INVISIBLE_PRIORITY_FACTOR = 4.0f;
+private:
+    /// @brief Job given to a worker
+    struct Job {
+        uint64_t id;
+        /// @brief Mask of sections rebuilt by the job
+        uint16_t modifiedSections;
+    };
+
+    std::unordered_map<glm::ivec2, std::shared_ptr<Chunk>> requests;
+    std::vector<std::pair<float, glm::ivec2>> priorities;
+    /// @brief Jobs being run by workers. Results of jobs missing here are
+    /// outdated and will be discarded
+    std::unordered_map<glm::ivec2, Job> inwork;
+    uint64_t nextJobId = 1;
+public:
+    /// @return false if the chunk is already requested
+    bool request(std::shared_ptr<Chunk> chunk);
+
+    /// @brief Drop chunk request if it's not taken yet
+    /// @return false if chunk is not requested
+    bool cancel(int x, int z);
+
+    bool isRequested(int x, int z) const;
+
+    /// @brief Register job given to a worker, replacing the running one
+    /// @param modifiedSections mask of sections rebuilt by the job
+    /// @return job id
+    uint64_t start(int x, int z, uint16_t modifiedSections);
+
+    /// @brief Unregister finished job
+    /// @return false if the job is outdated: dropped or replaced
+    bool finish(int x, int z, uint64_t id);
+
+    /// @brief Unregister running job, so its result will be discarded
+    /// @return mask of sections the job was rebuilding, to be rebuilt
+    /// again, or 0 if no job is running
+    uint16_t drop(int x, int z);
+
+    bool isInWork(int x, int z) const;
+
+    /// @brief Drop all requests and running jobs
+    void clear();
+
+    size_t size() const {
+        return requests.size();
+    }
+
+    /// @return number of jobs being run by workers
+    size_t inWorkCount() const {
+        return inwork.size();
+    }
+
+    /// @return chunk priority, lesser values are taken first
+    static float getPriority(
+        const Chunk& chunk, const glm::vec3& cameraPosition, bool visible
+    );
+
+    /// @brief Take requests of the highest priority.
+    /// Priorities are calculated on every call as the camera moves
+    /// @param cameraPosition camera position
+    /// @param isVisible chunk visibility check, may be nullptr
+    /// @param count max number of requests to take
+    /// @param dst destination vector (not cleared), taken requests are
+    /// added in order of priority
+    void pop(
+        const glm::vec3& cameraPosition,
+        const VisibilityFunc& isVisible,
+        size_t count,
+        std::vector<std::shared_ptr<Chunk>>& dst
+    );
+};
@@ -0,0 +1,57 @@
+#include "ChunkSectionsCache.hpp"
+
+#include "commons.hpp"
+#include "graphics/core/Mesh.hpp"
+
+ChunkSectionsCache::ChunkSectionsCache(size_t capacity) : capacity(capacity) {
+}
+
+std::shared_ptr<const ChunkSectionsMesh> ChunkSectionsCache::get(int x, int z) {
+    const auto& found = entries.find({x, z});
+    if (found == entries.end()) {
+        return nullptr;
+    }
+    auto& entry = found->second;
+    order.splice(order.begin(), order, entry.position);
+    return entry.sections;
+}
+
+void ChunkSectionsCache::put(
+    int x, int z, std::shared_ptr<const ChunkSectionsMesh> sections
+) {
+    remove(x, z);
+    if (sections == nullptr) {
+        return;
+    }
+    size_t size = sections->getMemoryUsage();
+    if (size > capacity) {
+        return;
+    }
+    while (memoryUsage + size > capacity) {
+        const auto& found = entries.find(order.back());
+        memoryUsage -= found->second.memoryUsage;
+        entries.erase(found);
+        order.pop_back();
+    }
+    glm::ivec2 coord {x, z};
+    order.push_front(coord);
+    entries[coord] = Entry {std::move(sections), order.begin(), size};
+    memoryUsage += size;
+}
+
+bool ChunkSectionsCache::remove(int x, int z) {
+    const auto& found = entries.find({x, z});
+    if (found == entries.end()) {
+        return false;
+    }
+    memoryUsage -= found->second.memoryUsage;
+    order.erase(found->second.position);
+    entries.erase(found);
+    return true;
+}
+
+void ChunkSectionsCache::clear() {
+    entries.clear();
+    order.clear();
+    memoryUsage = 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+struct ChunkSectionsMesh;
+
+/// @brief Memory bounded LRU cache of chunk sections meshes kept for
+/// incremental chunk mesh rebuilds
+class ChunkSectionsCache {
+    struct Entry {
+        std::shared_ptr<const ChunkSectionsMesh> sections;
+        std::list<glm::ivec2>::iterator position;
+        size_t memoryUsage;
+    };
+
+    size_t capacity;
+    size_t memoryUsage = 0;
+    /// @brief Cached sections chunks coords, most recently used first
+    std::list<glm::ivec2> order;
+    std::unordered_map<glm::ivec2, Entry> entries;
+public:
+    /// @param capacity max memory used by cached sections meshes in bytes
+    ChunkSectionsCache(size_t capacity);
+
+    /// @return cached chunk sections meshes or nullptr
+    std::shared_ptr<const ChunkSectionsMesh> get(int x, int z);
+
+    /// @brief Add or replace chunk sections meshes, evicting least recently
+    /// used ones if capacity exceeded. Sections larger than the capacity
+    /// are not kept
+    /// @param sections sections meshes, nullptr removes the entry
+    void put(int x, int z, std::shared_ptr<const ChunkSectionsMesh> sections);
+
+    /// @return false if chunk sections are not cached
+    bool remove(int x, int z);
+
+    void clear();
+
+    size_t size() const {
+        return entries.size();
+    }
+
+    /// @return approximate memory used by cached sections in bytes
+    size_t getMemoryUsage() const {
+        return memoryUsage;
+    }
+
+    size_t getCapacity() const {
+        return capacity;
+    }
+};
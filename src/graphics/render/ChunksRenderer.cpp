@@ -18,7 +18,15 @@ static debug::Logger logger("chunks-render");
 
 size_t ChunksRenderer::visibleChunks = 0;
 
-class RendererWorker : public util::Worker<std::shared_ptr<Chunk>, RendererResult> {
+static inline void draw_chunk_mesh(const ChunkMesh& mesh, bool dense) {
+    if (mesh.compactMesh) {
+        mesh.compactMesh->draw(GL_TRIANGLES, dense);
+    } else if (mesh.mesh) {
+        mesh.mesh->draw(GL_TRIANGLES, dense);
+    }
+}
+
+class RendererWorker : public util::Worker<RendererJob, RendererResult> {
     const Chunks& chunks;
     BlocksRenderer renderer;
 public:
@@ -39,15 +47,18 @@ public:
           ) {
     }
 
-    RendererResult operator()(const std::shared_ptr<Chunk>& chunk) override {
-        renderer.build(chunk.get(), &chunks);
+    RendererResult operator()(const RendererJob& job) override {
+        const auto& chunk = job.chunk;
+        renderer.build(
+            chunk.get(), &chunks, job.sections.get(), job.modifiedSections
+        );
         if (renderer.isCancelled()) {
             return RendererResult {
-                glm::ivec2(chunk->x, chunk->z), true, ChunkMeshData {}};
+                glm::ivec2(chunk->x, chunk->z), job.id, true, ChunkMeshData {}};
         }
         auto meshData = renderer.createMesh();
         return RendererResult {
-            glm::ivec2(chunk->x, chunk->z), false, std::move(meshData)};
+            glm::ivec2(chunk->x, chunk->z), job.id, false, std::move(meshData)};
     }
 };
 
@@ -63,6 +74,10 @@ ChunksRenderer::ChunksRenderer(
       assets(assets),
       frustum(frustum),
       settings(settings),
+      sectionsCache(
+          static_cast<size_t>(settings.graphics.chunkSectionsCache.get()) *
+          1024 * 1024
+      ),
       threadPool(
           "chunks-render-pool",
           [&]() {
@@ -71,17 +86,34 @@ ChunksRenderer::ChunksRenderer(
               );
           },
           [&](RendererResult& result) {
+              if (!scheduler.finish(result.key.x, result.key.y, result.id)) {
+                  // outdated result
+                  return;
+              }
               if (!result.cancelled) {
                   auto meshData = std::move(result.meshData);
-                  meshes[result.key] = ChunkMesh {
-                      std::make_unique<Mesh<ChunkVertex>>(meshData.mesh),
-                      std::move(meshData.sortingMesh)};
+                  auto& mesh = meshes[result.key];
+                  mesh = ChunkMesh {nullptr, std::move(meshData.sortingMesh)};
+                  if (compactVertices) {
+                      mesh.compactMesh = std::make_unique<Mesh<CompactChunkVertex>>(
+                          meshData.compactMesh
+                      );
+                  } else {
+                      mesh.mesh = std::make_unique<Mesh<ChunkVertex>>(meshData.mesh);
+                  }
+                  sectionsCache.put(
+                      result.key.x, result.key.y, std::move(meshData.sections)
+                  );
+              } else {
+                  // modified sections were not rebuilt
+                  sectionsCache.remove(result.key.x, result.key.y);
               }
-              inwork.erase(result.key);
           },
           settings.graphics.chunkMaxRenderers.get()
-      ) {
+      ),
+      compactVertices(settings.graphics.compactVertices.get()) {
     threadPool.setStopOnFail(false);
+    maxJobsInWork = threadPool.getWorkersCount() * 2;
     renderer = std::make_unique<BlocksRenderer>(
         settings.graphics.chunkMaxVertices.get(), 
         level->content, cache, settings
@@ -94,28 +126,86 @@ ChunksRenderer::ChunksRenderer(
 
 ChunksRenderer::~ChunksRenderer() = default;
 
-const Mesh<ChunkVertex>* ChunksRenderer::render(
+const ChunkMesh* ChunksRenderer::render(
     const std::shared_ptr<Chunk>& chunk, bool important
 ) {
-    chunk->flags.modified = false;
-    if (important) {
-        auto mesh = renderer->render(chunk.get(), &chunks);
-        meshes[glm::ivec2(chunk->x, chunk->z)] = ChunkMesh {
-            std::move(mesh.mesh), std::move(mesh.sortingMeshData)
-        };
-        return meshes[glm::ivec2(chunk->x, chunk->z)].mesh.get();
+    if (!important) {
+        scheduler.request(chunk);
+        return nullptr;
     }
     glm::ivec2 key(chunk->x, chunk->z);
-    if (inwork.find(key) != inwork.end()) {
-        return nullptr;
+    scheduler.cancel(key.x, key.y);
+    // running job result will be discarded, so sections it was rebuilding
+    // are missing in the cached sections
+    chunk->modifiedSections |= scheduler.drop(key.x, key.y);
+
+    uint16_t modifiedSections = chunk->modifiedSections;
+    if (modifiedSections == 0) {
+        modifiedSections = ALL_SECTIONS_MASK;
     }
-    inwork[key] = true;
-    threadPool.enqueueJob(chunk);
-    return nullptr;
+    chunk->flags.modified = false;
+    chunk->modifiedSections = 0;
+
+    auto sections = sectionsCache.get(key.x, key.y);
+    auto& mesh = meshes[key];
+    mesh = renderer->render(
+        chunk.get(), &chunks, sections.get(), modifiedSections
+    );
+    sectionsCache.put(key.x, key.y, std::move(mesh.sections));
+    return &mesh;
+}
+
+void ChunksRenderer::dispatch() {
+    if (scheduler.inWorkCount() >= maxJobsInWork || scheduler.size() == 0) {
+        return;
+    }
+    scheduled.clear();
+    scheduler.pop(
+        cameraPosition,
+        [this](const Chunk& chunk) {
+            glm::vec3 min(chunk.x * CHUNK_W, chunk.bottom, chunk.z * CHUNK_D);
+            glm::vec3 max(
+                chunk.x * CHUNK_W + CHUNK_W,
+                chunk.top,
+                chunk.z * CHUNK_D + CHUNK_D
+            );
+            return frustum.isBoxVisible(min, max);
+        },
+        maxJobsInWork - scheduler.inWorkCount(),
+        scheduled
+    );
+    for (auto& chunk : scheduled) {
+        if (chunks.getChunk(chunk->x, chunk->z) != chunk.get()) {
+            // unloaded while waiting
+            continue;
+        }
+        glm::ivec2 key(chunk->x, chunk->z);
+        if (scheduler.isInWork(key.x, key.y)) {
+            // modified sections are kept until the running job is finished
+            scheduler.request(std::move(chunk));
+            continue;
+        }
+        uint16_t modifiedSections = chunk->modifiedSections;
+        if (modifiedSections == 0) {
+            modifiedSections = ALL_SECTIONS_MASK;
+        }
+        chunk->flags.modified = false;
+        chunk->modifiedSections = 0;
+
+        auto sections = sectionsCache.get(key.x, key.y);
+        uint64_t id = scheduler.start(key.x, key.y, modifiedSections);
+        threadPool.enqueueJob(RendererJob {
+            id, std::move(chunk), std::move(sections), modifiedSections});
+    }
+    scheduled.clear();
 }
 
 void ChunksRenderer::unload(const Chunk* chunk) {
-    auto found = meshes.find(glm::ivec2(chunk->x, chunk->z));
+    glm::ivec2 key(chunk->x, chunk->z);
+    scheduler.cancel(key.x, key.y);
+    scheduler.drop(key.x, key.y);
+    sectionsCache.remove(key.x, key.y);
+    auto found = meshes.find(key);
     if (found != meshes.end()) {
         meshes.erase(found);
     }
@@ -123,11 +213,12 @@ void ChunksRenderer::unload(const Chunk* chunk) {
 
 void ChunksRenderer::clear() {
     meshes.clear();
-    inwork.clear();
+    sectionsCache.clear();
+    scheduler.clear();
     threadPool.clearQueue();
 }
 
-const Mesh<ChunkVertex>* ChunksRenderer::getOrRender(
+const ChunkMesh* ChunksRenderer::getOrRender(
     const std::shared_ptr<Chunk>& chunk, bool important
 ) {
     auto found = meshes.find(glm::ivec2(chunk->x, chunk->z));
@@ -137,14 +228,15 @@ const Mesh<ChunkVertex>* ChunksRenderer::getOrRender(
     if (chunk->flags.modified && chunk->flags.lighted) {
         render(chunk, important);
     }
-    return found->second.mesh.get();
+    return &found->second;
 }
 
 void ChunksRenderer::update() {
     threadPool.update();
+    dispatch();
 }
 
-const Mesh<ChunkVertex>* ChunksRenderer::retrieveChunk(
+const ChunkMesh* ChunksRenderer::retrieveChunk(
     size_t index, const Camera& camera, bool culling
 ) {
     auto chunk = chunks.getChunks()[index];
@@ -156,7 +248,7 @@ const Mesh<ChunkVertex>* ChunksRenderer::retrieveChunk(
         if (found == meshes.end()) {
             return nullptr;
         } else {
-            return found->second.mesh.get();
+            return &found->second;
         }
     }
     float distance = glm::distance(
@@ -223,7 +315,7 @@ void ChunksRenderer::drawChunksShadowsPass(
         }
         glm::mat4 model = glm::translate(glm::mat4(1.0f), coord);
         shader.uniformMatrix("u_model", model);
-        found->second.mesh->draw(GL_TRIANGLES, 
+        draw_chunk_mesh(found->second,
             glm::distance2(playerCamera.position * glm::vec3(1, 0, 1), 
                            (min + max) * 0.5f * glm::vec3(1, 0, 1)) < denseDistance2);
     }
@@ -238,6 +330,8 @@ void ChunksRenderer::drawChunks(
 
     // [warning] this whole method is not thread-safe for chunks
 
+    cameraPosition = camera.position;
+
     int chunksWidth = chunks.getWidth();
     int chunksOffsetX = chunks.getOffsetX();
     int chunksOffsetY = chunks.getOffsetY();
@@ -276,7 +370,7 @@ void ChunksRenderer::drawChunks(
             );
             glm::mat4 model = glm::translate(glm::mat4(1.0f), coord);
             shader.uniformMatrix("u_model", model);
-            mesh->draw(GL_TRIANGLES, glm::distance2(camera.position * glm::vec3(1, 0, 1), 
+            draw_chunk_mesh(*mesh, glm::distance2(camera.position * glm::vec3(1, 0, 1), 
                 (coord + glm::vec3(CHUNK_W * 0.5f, 0.0f, CHUNK_D * 0.5f))) < denseDistance2);
             visibleChunks++;
         }
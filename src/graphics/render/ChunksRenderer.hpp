@@ -10,6 +10,8 @@
 
 #include "util/ThreadPool.hpp"
 #include "commons.hpp"
+#include "ChunkMeshScheduler.hpp"
+#include "ChunkSectionsCache.hpp"
 
 template<typename VertexStructure> class Mesh;
 class Chunk;
@@ -32,8 +34,18 @@ struct ChunksSortEntry {
     }
 };
 
+struct RendererJob {
+    uint64_t id;
+    std::shared_ptr<Chunk> chunk;
+    /// @brief Sections meshes of the current chunk mesh or nullptr
+    std::shared_ptr<const ChunkSectionsMesh> sections;
+    /// @brief Mask of sections to rebuild
+    uint16_t modifiedSections;
+};
+
 struct RendererResult {
     glm::ivec2 key;
+    uint64_t id;
     bool cancelled;
     ChunkMeshData meshData;
 };
@@ -46,12 +58,28 @@ class ChunksRenderer {
 
     std::unique_ptr<BlocksRenderer> renderer;
     std::unordered_map<glm::ivec2, ChunkMesh> meshes;
-    std::unordered_map<glm::ivec2, bool> inwork;
+    /// @brief Sections meshes of synchronous and asynchronous builds
+    /// used for incremental rebuilds
+    ChunkSectionsCache sectionsCache;
     std::vector<ChunksSortEntry> indices;
-    util::ThreadPool<std::shared_ptr<Chunk>, RendererResult> threadPool;
-    const Mesh<ChunkVertex>* retrieveChunk(
+    util::ThreadPool<RendererJob, RendererResult> threadPool;
+    /// @brief Chunks waiting for asynchronous rendering and jobs being
+    /// run by workers
+    ChunkMeshScheduler scheduler;
+    std::vector<std::shared_ptr<Chunk>> scheduled;
+    glm::vec3 cameraPosition {};
+    /// @brief Max number of jobs given to workers at once, so requests
+    /// are prioritized for the current camera position
+    size_t maxJobsInWork;
+    /// @brief Opaque meshes use CompactChunkVertex format
+    bool compactVertices;
+
+    const ChunkMesh* retrieveChunk(
         size_t index, const Camera& camera, bool culling
     );
+
+    /// @brief Give requests of the highest priority to workers
+    void dispatch();
 public:
     ChunksRenderer(
         const Level* level,
@@ -63,13 +91,17 @@ public:
     );
     virtual ~ChunksRenderer();
 
-    const Mesh<ChunkVertex>* render(
+    /// @brief Rebuild modified sections of the chunk mesh
+    /// @param important render synchronously, otherwise the chunk is
+    /// scheduled
+    /// @return chunk mesh or nullptr if rendered asynchronously
+    const ChunkMesh* render(
         const std::shared_ptr<Chunk>& chunk, bool important
     );
     void unload(const Chunk* chunk);
     void clear();
 
-    const Mesh<ChunkVertex>* getOrRender(
+    const ChunkMesh* getOrRender(
         const std::shared_ptr<Chunk>& chunk, bool important
     );
 
@@ -83,5 +115,9 @@ public:
 
     void update();
 
+    bool isCompactVertices() const {
+        return compactVertices;
+    }
+
     static size_t visibleChunks;
 };
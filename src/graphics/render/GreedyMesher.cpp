@@ -0,0 +1,119 @@
+#include "GreedyMesher.hpp"
+
+#include <algorithm>
+
+/// @return normal axis index of the face
+static inline int normal_axis(uint8_t direction) {
+    return direction / 2;
+}
+
+/// @return face plane axes indices
+static inline glm::ivec2 plane_axes(int axis) {
+    switch (axis) {
+        case 0: return {2, 1};
+        case 1: return {0, 2};
+        default: return {0, 1};
+    }
+}
+
+void GreedyMesher::merge(std::vector<GreedyQuad>& dst) {
+    std::sort(faces.begin(), faces.end(), [](const auto& a, const auto& b) {
+        if (a.direction != b.direction) {
+            return a.direction < b.direction;
+        }
+        int axis = normal_axis(a.direction);
+        auto axes = plane_axes(axis);
+        if (a.position[axis] != b.position[axis]) {
+            return a.position[axis] < b.position[axis];
+        }
+        if (a.position[axes.y] != b.position[axes.y]) {
+            return a.position[axes.y] < b.position[axes.y];
+        }
+        return a.position[axes.x] < b.position[axes.x];
+    });
+    const GreedyFace* begin = faces.data();
+    const GreedyFace* end = faces.data() + faces.size();
+    while (begin < end) {
+        int axis = normal_axis(begin->direction);
+        const GreedyFace* layerEnd = begin + 1;
+        while (layerEnd < end && layerEnd->direction == begin->direction &&
+               layerEnd->position[axis] == begin->position[axis]) {
+            layerEnd++;
+        }
+        mergeLayer(begin, layerEnd, dst);
+        begin = layerEnd;
+    }
+    faces.clear();
+}
+
+void GreedyMesher::mergeLayer(
+    const GreedyFace* begin, const GreedyFace* end, std::vector<GreedyQuad>& dst
+) {
+    uint8_t direction = begin->direction;
+    int axis = normal_axis(direction);
+    auto axes = plane_axes(axis);
+    int u = axes.x;
+    int v = axes.y;
+
+    if (end - begin == 1) {
+        glm::ivec3 size(1);
+        dst.push_back(GreedyQuad {begin->position, size, direction, begin->key});
+        return;
+    }
+    // faces are sorted by v, then by u
+    int minV = begin->position[v];
+    int maxV = (end - 1)->position[v];
+    int minU = begin->position[u];
+    int maxU = minU;
+    for (auto face = begin; face < end; face++) {
+        minU = std::min(minU, face->position[u]);
+        maxU = std::max(maxU, face->position[u]);
+    }
+    int width = maxU - minU + 1;
+    int height = maxV - minV + 1;
+    grid.resize(width * height);
+    filled.assign(width * height, false);
+    for (auto face = begin; face < end; face++) {
+        int index = (face->position[v] - minV) * width +
+                    (face->position[u] - minU);
+        grid[index] = face->key;
+        filled[index] = true;
+    }
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int index = y * width + x;
+            if (!filled[index]) {
+                continue;
+            }
+            uint64_t key = grid[index];
+            int w = 1;
+            while (x + w < width && filled[index + w] &&
+                   grid[index + w] == key) {
+                w++;
+            }
+            int h = 1;
+            for (; y + h < height; h++) {
+                int row = (y + h) * width + x;
+                int i = 0;
+                while (i < w && filled[row + i] && grid[row + i] == key) {
+                    i++;
+                }
+                if (i < w) {
+                    break;
+                }
+            }
+            for (int dy = 0; dy < h; dy++) {
+                int row = (y + dy) * width + x;
+                std::fill_n(filled.begin() + row, w, false);
+            }
+            glm::ivec3 position = begin->position;
+            position[u] = minU + x;
+            position[v] = minV + y;
+            glm::ivec3 size(1);
+            size[u] = w;
+            size[v] = h;
+            dst.push_back(GreedyQuad {position, size, direction, key});
+            x += w - 1;
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "typedefs.hpp"
+
+/// @brief Voxel face which may be merged with coplanar neighbour faces
+struct GreedyFace {
+    /// @brief Voxel coords in chunk
+    glm::ivec3 position;
+    /// @brief Face index (FACE_MX, FACE_PX, FACE_MY, FACE_PY, FACE_MZ, FACE_PZ)
+    uint8_t direction;
+    /// @brief Faces of the same direction are merged only if keys are equal
+    uint64_t key;
+};
+
+/// @brief Rectangle of merged faces
+struct GreedyQuad {
+    /// @brief Min voxel coords
+    glm::ivec3 position;
+    /// @brief Size in voxels, equal to 1 on the face normal axis
+    glm::ivec3 size;
+    uint8_t direction;
+    uint64_t key;
+};
+
+/// @brief Merges coplanar voxel faces with equal keys into rectangles
+class GreedyMesher {
+    std::vector<GreedyFace> faces;
+    /// @brief Keys of the current layer faces
+    std::vector<uint64_t> grid;
+    std::vector<bool> filled;
+
+    void mergeLayer(
+        const GreedyFace* begin,
+        const GreedyFace* end,
+        std::vector<GreedyQuad>& dst
+    );
+public:
+    /// @brief Face normal by face index
+    static inline const glm::ivec3 NORMALS[6] {
+        {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}
+    };
+
+    void add(const glm::ivec3& position, uint8_t direction, uint64_t key) {
+        faces.push_back(GreedyFace {position, direction, key});
+    }
+
+    size_t size() const {
+        return faces.size();
+    }
+
+    void clear() {
+        faces.clear();
+    }
+
+    /// @brief Merge added faces into rectangles and clear faces
+    /// @param dst destination quads vector (not cleared)
+    void merge(std::vector<GreedyQuad>& dst);
+};
@@ -41,7 +41,7 @@ int PrecipitationRenderer::getHeightAt(int x, int z) {
     x -= cx * CHUNK_W;
     z -= cz * CHUNK_D;
     while (y > 0) {
-        const auto& vox = chunk->voxels[vox_index(x, y, z)];
+        voxel vox = chunk->voxels.get(vox_index(x, y, z));
         if (vox.id == 0) {
             y--;
             continue;
@@ -430,6 +430,7 @@ void WorldRenderer::draw(
     auto& mainShader = assets.require<Shader>("main");
     auto& entityShader = assets.require<Shader>("entity");
     auto& translucentShader = assets.require<Shader>("translucent");
+    auto& shadowsShader = assets.require<Shader>("shadows");
     auto& deferredShader = assets.require<PostEffect>("deferred_lighting").getShader();
     const auto& settings = engine.getSettings();
 
@@ -449,20 +450,26 @@ void WorldRenderer::draw(
     CompileTimeShaderSettings currentSettings {
         gbufferPipeline,
         shadows,
-        settings.graphics.ssao.get() && gbufferPipeline
+        settings.graphics.ssao.get() && gbufferPipeline,
+        chunks->isCompactVertices()
     };
     if (
         prevCTShaderSettings.advancedRender != currentSettings.advancedRender ||
         prevCTShaderSettings.shadows != currentSettings.shadows ||
-        prevCTShaderSettings.ssao != currentSettings.ssao
+        prevCTShaderSettings.ssao != currentSettings.ssao ||
+        prevCTShaderSettings.compactVertices != currentSettings.compactVertices
     ) {
         Shader::preprocessor->setDefined("ENABLE_SHADOWS", currentSettings.shadows);
         Shader::preprocessor->setDefined("ENABLE_SSAO", currentSettings.ssao);
         Shader::preprocessor->setDefined("ADVANCED_RENDER", currentSettings.advancedRender);
+        Shader::preprocessor->setDefined(
+            "COMPACT_CHUNK_VERTICES", currentSettings.compactVertices
+        );
         mainShader.recompile();
         entityShader.recompile();
         deferredShader.recompile();
         translucentShader.recompile();
+        shadowsShader.recompile();
         prevCTShaderSettings = currentSettings;
     }
 
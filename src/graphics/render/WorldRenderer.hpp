@@ -39,6 +39,7 @@ struct CompileTimeShaderSettings {
     bool advancedRender = false;
     bool shadows = false;
     bool ssao = false;
+    bool compactVertices = false;
 };
 
 class WorldRenderer {
@@ -0,0 +1,198 @@
+#include "commons.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/glm.hpp>
+
+#include "graphics/core/Mesh.hpp"
+#include "voxels/Chunk.hpp"
+
+static inline glm::vec2 sign_not_zero(const glm::vec2& v) {
+    return {v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f};
+}
+
+static inline int16_t encode_position(float x) {
+    float value = std::round(x * CompactChunkVertex::POSITION_SCALE);
+    return static_cast<int16_t>(std::clamp(value, -32768.0f, 32767.0f));
+}
+
+static inline uint16_t encode_normal(const glm::vec3& normal) {
+    float sum = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (sum == 0.0f) {
+        return encode_normal({0.0f, 1.0f, 0.0f});
+    }
+    glm::vec2 p = glm::vec2(normal.x, normal.y) / sum;
+    if (normal.z < 0.0f) {
+        p = (1.0f - glm::abs(glm::vec2(p.y, p.x))) * sign_not_zero(p);
+    }
+    const int max = CompactChunkVertex::NORMAL_MAX;
+    int x = std::clamp(static_cast<int>(std::round((p.x + 1.0f) * max / 2)), 0, max);
+    int y = std::clamp(static_cast<int>(std::round((p.y + 1.0f) * max / 2)), 0, max);
+    return static_cast<uint16_t>(x | (y << 7));
+}
+
+static inline glm::vec3 decode_normal(uint16_t packed) {
+    const float max = CompactChunkVertex::NORMAL_MAX;
+    glm::vec2 p(
+        (packed & 0x7F) / max * 2.0f - 1.0f,
+        ((packed >> 7) & 0x7F) / max * 2.0f - 1.0f
+    );
+    glm::vec3 normal(p, 1.0f - std::abs(p.x) - std::abs(p.y));
+    if (normal.z < 0.0f) {
+        p = (1.0f - glm::abs(glm::vec2(p.y, p.x))) * sign_not_zero(p);
+        normal.x = p.x;
+        normal.y = p.y;
+    }
+    return glm::normalize(normal);
+}
+
+CompactChunkVertex CompactChunkVertex::encode(const ChunkVertex& vertex) {
+    CompactChunkVertex compact {};
+    for (int i = 0; i < 3; i++) {
+        compact.position[i] = encode_position(vertex.position[i]);
+    }
+    glm::vec3 normal(
+        (vertex.normal[0] - 128) / 127.0f,
+        (vertex.normal[1] - 128) / 127.0f,
+        (vertex.normal[2] - 128) / 127.0f
+    );
+    compact.normal = encode_normal(normal);
+    if (vertex.normal[3] >= 128) {
+        compact.normal |= EMISSION_BIT;
+    }
+    compact.uv = vertex.uv;
+    compact.regionEnd = vertex.regionEnd;
+    compact.color = vertex.color;
+    return compact;
+}
+
+ChunkVertex CompactChunkVertex::decode() const {
+    ChunkVertex vertex {};
+    vertex.position = glm::vec3(position[0], position[1], position[2]) /
+                      POSITION_SCALE;
+    glm::vec3 n = decode_normal(normal);
+    for (int i = 0; i < 3; i++) {
+        vertex.normal[i] = static_cast<uint8_t>(std::round(n[i] * 127 + 128));
+    }
+    vertex.normal[3] = (normal & EMISSION_BIT) ? 255 : 0;
+    vertex.color = color;
+    vertex.uv = uv;
+    vertex.regionEnd = regionEnd;
+    return vertex;
+}
+
+glm::vec2 ChunkVertex::getMergedFacesUV() const {
+    glm::vec3 n(
+        (normal[0] - 128) / 127.0f,
+        (normal[1] - 128) / 127.0f,
+        (normal[2] - 128) / 127.0f
+    );
+    // merged faces are axis-aligned, texture axes are defined by the normal
+    glm::vec3 axisX = std::abs(n.x) > 0.5f
+                          ? glm::vec3(0.0f, 0.0f, n.x > 0.0f ? -1.0f : 1.0f)
+                          : glm::vec3(std::round(std::abs(n.y) + n.z), 0.0f, 0.0f);
+    glm::vec3 axisY = std::abs(n.y) > 0.5f
+                          ? glm::vec3(0.0f, 0.0f, n.y > 0.0f ? -1.0f : 1.0f)
+                          : glm::vec3(0.0f, 1.0f, 0.0f);
+    return {
+        glm::dot(position, axisX) + 0.5f,
+        glm::dot(position, axisY) + 0.5f
+    };
+}
+
+std::shared_ptr<ChunkSectionsMesh> ChunkSectionsMesh::rebuild(
+    const ChunkSectionsMesh* prev,
+    uint8_t neighbours,
+    uint16_t modifiedSections,
+    const SectionBuilder& buildSection
+) {
+    auto mesh = std::make_shared<ChunkSectionsMesh>();
+    mesh->neighbours = neighbours;
+    if (prev == nullptr || prev->neighbours != neighbours) {
+        modifiedSections = ALL_SECTIONS_MASK;
+    }
+    for (int i = 0; i < CHUNK_SECTIONS; i++) {
+        if (modifiedSections & (1 << i)) {
+            mesh->sections[i] = buildSection(i);
+        } else {
+            mesh->sections[i] = prev->sections[i];
+        }
+    }
+    return mesh;
+}
+
+bool ChunkSectionsMesh::stitch(size_t groupsCount, ChunkMeshBuffers& dst) const {
+    dst.vertexCount = 0;
+    dst.indexCount = 0;
+    dst.denseIndexCount = 0;
+    bool complete = true;
+
+    uint32_t bases[CHUNK_SECTIONS] {};
+    bool stitched[CHUNK_SECTIONS] {};
+    for (int i = 0; i < CHUNK_SECTIONS; i++) {
+        const auto& section = sections[i];
+        if (section == nullptr) {
+            continue;
+        }
+        if (dst.vertexCount + section->vertices.size() >= dst.capacity) {
+            complete = false;
+            break;
+        }
+        bases[i] = dst.vertexCount;
+        stitched[i] = true;
+        std::copy(
+            section->vertices.begin(),
+            section->vertices.end(),
+            dst.vertices + dst.vertexCount
+        );
+        dst.vertexCount += section->vertices.size();
+    }
+    auto stitchPass = [&](
+        SectionIndicesRun::Pass pass, uint32_t* indices, size_t& count
+    ) {
+        for (size_t order = 0; order < groupsCount; order++) {
+            for (int i = 0; i < CHUNK_SECTIONS; i++) {
+                if (!stitched[i]) {
+                    continue;
+                }
+                const auto& section = *sections[i];
+                for (const auto& run : section.runs) {
+                    if (run.pass != pass || run.order != order) {
+                        continue;
+                    }
+                    if (count + run.count > dst.capacity) {
+                        complete = false;
+                        return;
+                    }
+                    const uint32_t* src = section.indices.data() + run.offset;
+                    for (uint32_t j = 0; j < run.count; j++) {
+                        indices[count++] = bases[i] + src[j];
+                    }
+                }
+            }
+        }
+    };
+    stitchPass(SectionIndicesRun::REGULAR, dst.indices, dst.indexCount);
+    stitchPass(SectionIndicesRun::OPTIONAL_CULLED, dst.indices, dst.indexCount);
+    stitchPass(SectionIndicesRun::REGULAR, dst.denseIndices, dst.denseIndexCount);
+    stitchPass(SectionIndicesRun::OPTIONAL_DENSE, dst.denseIndices, dst.denseIndexCount);
+    return complete;
+}
+
+size_t ChunkSectionsMesh::getMemoryUsage() const {
+    size_t size = sizeof(ChunkSectionsMesh);
+    for (const auto& section : sections) {
+        if (section == nullptr) {
+            continue;
+        }
+        size += sizeof(ChunkSectionMesh) +
+                section->vertices.capacity() * sizeof(ChunkVertex) +
+                section->indices.capacity() * sizeof(uint32_t) +
+                section->runs.capacity() * sizeof(SectionIndicesRun);
+        for (const auto& entry : section->sortingEntries) {
+            size += sizeof(SortingMeshEntry) +
+                    entry.vertexData.size() * sizeof(ChunkVertex);
+        }
+    }
+    return size;
+}
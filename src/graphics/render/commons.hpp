@@ -3,25 +3,69 @@
 #include <vector>
 #include <array>
 #include <memory>
+#include <functional>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 
+#include "constants.hpp"
 #include "graphics/core/MeshData.hpp"
 #include "util/Buffer.hpp"
 
 /// @brief Chunk mesh vertex format
 struct ChunkVertex {
     glm::vec3 position;
-    glm::vec2 uv;
+    /// @brief Texture coord or merged faces texture region start (u1, v1)
+    std::array<uint16_t, 2> uv;
     std::array<uint8_t, 4> color;
     std::array<uint8_t, 4> normal;
+    /// @brief Merged faces texture region end (u2, v2). Zero if uv is
+    /// a texture coord. Texture coord in voxels is restored from position
+    std::array<uint16_t, 2> regionEnd;
 
     static constexpr VertexAttribute ATTRIBUTES[] = {
         {VertexAttribute::Type::FLOAT, false, 3},
-        {VertexAttribute::Type::FLOAT, false, 2},
+        {VertexAttribute::Type::UNSIGNED_SHORT, true, 2},
         {VertexAttribute::Type::UNSIGNED_BYTE, true, 4},
         {VertexAttribute::Type::UNSIGNED_BYTE, true, 4},
+        {VertexAttribute::Type::UNSIGNED_SHORT, true, 2},
         {{}, 0}};
+
+    /// @return merged faces texture coord in voxels restored from position
+    /// and normal the same way as by chunk_vertex shader lib.
+    /// Coord is valid up to an integer offset
+    glm::vec2 getMergedFacesUV() const;
+};
+
+/// @brief Packed opaque chunk mesh vertex format (20 bytes instead of 28)
+struct CompactChunkVertex {
+    /// @brief Position units per voxel
+    static constexpr float POSITION_SCALE = 64.0f;
+    /// @brief Normal octahedral coords max value
+    static constexpr int NORMAL_MAX = 126;
+    /// @brief Emission flag bit in the packed normal
+    static constexpr uint16_t EMISSION_BIT = 0x8000;
+
+    /// @brief Chunk-relative fixed-point position
+    std::array<int16_t, 3> position;
+    /// @brief Octahedral normal (7 + 7 bits) and emission flag
+    uint16_t normal;
+    /// @brief Texture coord or merged faces texture region start (u1, v1)
+    std::array<uint16_t, 2> uv;
+    std::array<uint8_t, 4> color;
+    /// @brief Merged faces texture region end (see ChunkVertex::regionEnd)
+    std::array<uint16_t, 2> regionEnd;
+
+    static constexpr VertexAttribute ATTRIBUTES[] = {
+        {VertexAttribute::Type::SHORT, false, 3},
+        {VertexAttribute::Type::UNSIGNED_SHORT, false, 1},
+        {VertexAttribute::Type::UNSIGNED_SHORT, true, 2},
+        {VertexAttribute::Type::UNSIGNED_BYTE, true, 4},
+        {VertexAttribute::Type::UNSIGNED_SHORT, true, 2},
+        {{}, 0}};
+
+    static CompactChunkVertex encode(const ChunkVertex& vertex);
+
+    ChunkVertex decode() const;
 };
 
 template<typename VertexStructure>
@@ -41,13 +85,105 @@ struct SortingMeshData {
     std::vector<SortingMeshEntry> entries;
 };
 
+/// @brief Range of chunk section mesh indices produced by a render pass
+/// for a draw group
+struct SectionIndicesRun {
+    enum Pass : uint8_t {
+        /// @brief Blocks without optional culling (both index buffers)
+        REGULAR,
+        /// @brief Optional culling blocks in dense mode (dense index buffer)
+        OPTIONAL_DENSE,
+        /// @brief Optional culling blocks with culling (main index buffer)
+        OPTIONAL_CULLED,
+    };
+    Pass pass;
+    /// @brief Draw group index in the content draw groups order
+    uint8_t order;
+    uint32_t offset;
+    uint32_t count;
+};
+
+/// @brief Mesh of a vertical chunk section
+struct ChunkSectionMesh {
+    std::vector<ChunkVertex> vertices;
+    /// @brief Indices of the section vertices
+    std::vector<uint32_t> indices;
+    std::vector<SectionIndicesRun> runs;
+    /// @brief Translucent blocks entries
+    std::vector<SortingMeshEntry> sortingEntries;
+};
+
+/// @brief Chunk mesh vertex and index buffers of fixed capacity
+struct ChunkMeshBuffers {
+    ChunkVertex* vertices;
+    /// @brief Main indices (regular and culled optional blocks)
+    uint32_t* indices;
+    /// @brief Dense render indices (regular and dense optional blocks)
+    uint32_t* denseIndices;
+    /// @brief Capacity of each buffer
+    size_t capacity;
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    size_t denseIndexCount = 0;
+};
+
+/// @brief Per-section meshes the chunk mesh is stitched from, kept to
+/// rebuild modified sections only
+struct ChunkSectionsMesh {
+    using SectionBuilder =
+        std::function<std::shared_ptr<const ChunkSectionMesh>(int)>;
+
+    /// @brief Immutable section meshes shared between builds,
+    /// nullptr if section has no geometry
+    std::array<std::shared_ptr<const ChunkSectionMesh>, CHUNK_SECTIONS> sections;
+    /// @brief Mask of neighbour chunks available on build.
+    /// Change of the mask requires full rebuild
+    uint8_t neighbours = 0;
+
+    /// @brief Build sections meshes taking unmodified sections from the
+    /// previous build. All sections are rebuilt if there is no previous
+    /// build or neighbours mask is changed, as faces on borders with
+    /// appeared or removed neighbours are changed
+    /// @param prev sections meshes of the previous build or nullptr
+    /// @param neighbours mask of neighbour chunks available
+    /// @param modifiedSections mask of sections to rebuild
+    /// @param buildSection section mesh builder taking section index
+    static std::shared_ptr<ChunkSectionsMesh> rebuild(
+        const ChunkSectionsMesh* prev,
+        uint8_t neighbours,
+        uint16_t modifiedSections,
+        const SectionBuilder& buildSection
+    );
+
+    /// @brief Copy sections vertices and indices to chunk mesh buffers.
+    /// Indices of each pass are ordered by draw group, then by section,
+    /// to keep the render order
+    /// @param groupsCount number of content draw groups
+    /// @param dst destination buffers, counters are reset
+    /// @return false if buffers capacity is exceeded and the mesh is
+    /// incomplete
+    bool stitch(size_t groupsCount, ChunkMeshBuffers& dst) const;
+
+    /// @return approximate memory used by sections meshes in bytes
+    size_t getMemoryUsage() const;
+};
+
 struct ChunkMeshData {
     MeshData<ChunkVertex> mesh;
     SortingMeshData sortingMesh;
+    /// @brief Used instead of mesh if compact vertices are enabled
+    MeshData<CompactChunkVertex> compactMesh;
+    /// @brief Sections meshes of the build for incremental rebuilds
+    std::shared_ptr<const ChunkSectionsMesh> sections = nullptr;
 };
 
 struct ChunkMesh {
     std::unique_ptr<Mesh<ChunkVertex>> mesh;
     SortingMeshData sortingMeshData;
     std::unique_ptr<Mesh<ChunkVertex> > sortedMesh = nullptr;
+    /// @brief Used instead of mesh if compact vertices are enabled
+    std::unique_ptr<Mesh<CompactChunkVertex>> compactMesh = nullptr;
+    /// @brief Sections meshes of the build, moved to ChunkSectionsCache
+    /// by ChunksRenderer
+    std::shared_ptr<const ChunkSectionsMesh> sections = nullptr;
 };
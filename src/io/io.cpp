@@ -320,6 +320,12 @@ io::file_time_type io::last_write_time(const io::path& file) {
     return device.lastWriteTime(file.pathPart());
 }
 
+bool io::rename(const io::path& src, const io::path& dst) {
+    std::error_code ec;
+    fs::rename(io::resolve(src), io::resolve(dst), ec);
+    return !ec;
+}
+
 std::filesystem::path io::resolve(const io::path& file) {
     auto device = io::get_device(file.entryPoint());
     if (device == nullptr) {
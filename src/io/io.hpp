@@ -48,6 +48,27 @@ namespace io {
         size_t length() const;
     };
 
+    /// @brief Read-only memory-mapped file
+    class mmapfile {
+        const ubyte* bytes = nullptr;
+        size_t filelength = 0;
+        /// @brief platform-specific mapping handle
+        void* handle = nullptr;
+    public:
+        /// @throw std::runtime_error if file could not be mapped
+        mmapfile(const path& filename);
+        mmapfile(const mmapfile&) = delete;
+        ~mmapfile();
+
+        const ubyte* data() const {
+            return bytes;
+        }
+
+        size_t length() const {
+            return filelength;
+        }
+    };
+
     class directory_iterator_impl {
     public:
         using iterator_category = std::input_iterator_tag;
@@ -200,6 +221,15 @@ namespace io {
     /// @brief Copy all files and directories in the folder recursively
     uint64_t copy_all(const io::path& src, const io::path& dst);
 
+    /// @brief Rename file replacing existing dst file. Replacement is atomic
+    /// if both paths are on the same file system
+    /// @return true if success
+    bool rename(const io::path& src, const io::path& dst);
+
+    /// @brief Flush file or directory changes to the storage device
+    /// @return true if success
+    bool sync(const io::path& file);
+
     /// @brief Remove all files and directories in the folder recursively
     uint64_t remove_all(const io::path& file);
 
@@ -0,0 +1,81 @@
+#include "io.hpp"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+
+io::mmapfile::mmapfile(const io::path& filename) {
+    auto resolved = io::resolve(filename);
+    HANDLE file = CreateFileW(
+        resolved.wstring().c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("could not to open file " + filename.string());
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        throw std::runtime_error("could not map file " + filename.string());
+    }
+    HANDLE mapping =
+        CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    // mapping keeps the file open
+    CloseHandle(file);
+    if (mapping == nullptr) {
+        throw std::runtime_error("could not map file " + filename.string());
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        throw std::runtime_error("could not map file " + filename.string());
+    }
+    bytes = static_cast<const ubyte*>(view);
+    filelength = static_cast<size_t>(size.QuadPart);
+    handle = mapping;
+}
+
+io::mmapfile::~mmapfile() {
+    UnmapViewOfFile(bytes);
+    CloseHandle(static_cast<HANDLE>(handle));
+}
+
+#else // _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+io::mmapfile::mmapfile(const io::path& filename) {
+    auto resolved = io::resolve(filename);
+    int fd = open(resolved.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("could not to open file " + filename.string());
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size == 0) {
+        close(fd);
+        throw std::runtime_error("could not map file " + filename.string());
+    }
+    void* view = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // mapping keeps the file open
+    close(fd);
+    if (view == MAP_FAILED) {
+        throw std::runtime_error("could not map file " + filename.string());
+    }
+    bytes = static_cast<const ubyte*>(view);
+    filelength = static_cast<size_t>(st.st_size);
+}
+
+io::mmapfile::~mmapfile() {
+    munmap(const_cast<ubyte*>(bytes), filelength);
+}
+
+#endif // _WIN32
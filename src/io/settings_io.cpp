@@ -63,6 +63,8 @@ SettingsHandler::SettingsHandler(EngineSettings& settings) {
     builder.add("load-distance", &settings.chunks.loadDistance);
     builder.add("load-speed", &settings.chunks.loadSpeed);
     builder.add("padding", &settings.chunks.padding);
+    builder.add("compact-voxels", &settings.chunks.compactVoxels);
+    builder.add("prototypes-cache", &settings.chunks.prototypesCache);
 
     builder.section("graphics");
     builder.add("fog-curve", &settings.graphics.fogCurve);
@@ -70,10 +72,13 @@ SettingsHandler::SettingsHandler(EngineSettings& settings) {
     builder.add("dense-render", &settings.graphics.denseRender);
     builder.add("gamma", &settings.graphics.gamma);
     builder.add("frustum-culling", &settings.graphics.frustumCulling);
+    builder.add("greedy-meshing", &settings.graphics.greedyMeshing);
+    builder.add("compact-vertices", &settings.graphics.compactVertices);
     builder.add("skybox-resolution", &settings.graphics.skyboxResolution);
     builder.add("chunk-max-vertices", &settings.graphics.chunkMaxVertices);
     builder.add("chunk-max-vertices-dense", &settings.graphics.chunkMaxVerticesDense);
     builder.add("chunk-max-renderers", &settings.graphics.chunkMaxRenderers);
+    builder.add("chunk-sections-cache", &settings.graphics.chunkSectionsCache);
     builder.add("advanced-render", &settings.graphics.advancedRender);
     builder.add("ssao", &settings.graphics.ssao);
     builder.add("shadows-quality", &settings.graphics.shadowsQuality);
@@ -86,6 +91,18 @@ SettingsHandler::SettingsHandler(EngineSettings& settings) {
     builder.section("debug");
     builder.add("generator-test-mode", &settings.debug.generatorTestMode);
     builder.add("do-write-lights", &settings.debug.doWriteLights);
+    builder.add("voxels-compression", &settings.debug.voxelsCompression);
+    builder.add("open-region-files", &settings.debug.openRegionFiles);
+    builder.add(
+        "incremental-region-writes", &settings.debug.incrementalRegionWrites
+    );
+    builder.add(
+        "durable-region-writes", &settings.debug.durableRegionWrites
+    );
+    builder.add(
+        "region-compaction-threshold",
+        &settings.debug.regionCompactionThreshold
+    );
 }
 
 dv::value SettingsHandler::getValue(const std::string& name) const {
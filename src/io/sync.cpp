@@ -0,0 +1,45 @@
+#include "io.hpp"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+
+bool io::sync(const io::path& file) {
+    auto resolved = io::resolve(file);
+    if (std::filesystem::is_directory(resolved)) {
+        // directory entries are flushed with the files on NTFS
+        return true;
+    }
+    HANDLE handle = CreateFileW(
+        resolved.wstring().c_str(),
+        GENERIC_WRITE,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    bool success = FlushFileBuffers(handle);
+    CloseHandle(handle);
+    return success;
+}
+
+#else // _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+
+bool io::sync(const io::path& file) {
+    auto resolved = io::resolve(file);
+    int fd = open(resolved.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    bool success = fsync(fd) == 0;
+    close(fd);
+    return success;
+}
+
+#endif // _WIN32
@@ -1,126 +1,270 @@
-#include <iostream>
-#include <assert.h>
-
 #include "LightSolver.hpp"
+
 #include "Lightmap.hpp"
 #include "content/Content.hpp"
+#include "maths/voxmaths.hpp"
 #include "voxels/Chunks.hpp"
 #include "voxels/Chunk.hpp"
 #include "voxels/voxel.hpp"
 #include "voxels/Block.hpp"
 
-LightSolver::LightSolver(const ContentIndices& contentIds, Chunks& chunks, int channel) 
+// packed entry: 7 bits x, 7 bits z, 8 bits y, light value in the rest
+static inline uint32_t pack_entry(int x, int y, int z, int light) {
+    return x | (z << 7) | (y << 14) | (light << 22);
+}
+
+LightSolver::LightSolver(const ContentIndices& contentIds, Chunks& chunks, int channel)
     : blockDefs(contentIds.blocks.getDefs()),
-      chunks(chunks), 
+      chunks(chunks),
       channel(channel) {
+    size_t count = contentIds.blocks.count();
+    lightPassing.resize((count + 63) / 64);
+    for (size_t id = 0; id < count; id++) {
+        if (blockDefs[id]->lightPassing) {
+            lightPassing[id >> 6] |= 1ULL << (id & 63);
+        }
+    }
+}
+
+bool LightSolver::isEmpty() const {
+    return addqueue.empty() && remqueue.empty() && addOverflow.empty() &&
+           remOverflow.empty();
+}
+
+void LightSolver::setWindow(int cx, int cz) {
+    int ox = cx - WINDOW / 2;
+    int oz = cz - WINDOW / 2;
+    windowX = ox * CHUNK_W;
+    windowZ = oz * CHUNK_D;
+    for (int z = 0; z < WINDOW; z++) {
+        for (int x = 0; x < WINDOW; x++) {
+            window[z * WINDOW + x] = chunks.getChunk(ox + x, oz + z);
+        }
+    }
+}
+
+void LightSolver::moveWindow() {
+    lightentry first =
+        remOverflow.empty() ? addOverflow.front() : remOverflow.front();
+    std::vector<lightentry> adds = std::move(addOverflow);
+    std::vector<lightentry> removes = std::move(remOverflow);
+    addOverflow.clear();
+    remOverflow.clear();
+
+    auto unpack = [this](uint32_t entry) {
+        return lightentry {
+            windowX + static_cast<int>(entry & 0x7F),
+            static_cast<int>((entry >> 14) & 0xFF),
+            windowZ + static_cast<int>((entry >> 7) & 0x7F),
+            static_cast<unsigned char>(entry >> 22)};
+    };
+    while (!addqueue.empty()) {
+        adds.push_back(unpack(addqueue.pop()));
+    }
+    while (!remqueue.empty()) {
+        removes.push_back(unpack(remqueue.pop()));
+    }
+    setWindow(floordiv<CHUNK_W>(first.x), floordiv<CHUNK_D>(first.z));
+    for (const auto& entry : removes) {
+        pushRemove(entry.x, entry.y, entry.z, entry.light);
+    }
+    for (const auto& entry : adds) {
+        pushAdd(entry.x, entry.y, entry.z, entry.light);
+    }
+}
+
+Chunk* LightSolver::getChunk(int cx, int cz) const {
+    int wx = cx - windowX / CHUNK_W;
+    int wz = cz - windowZ / CHUNK_D;
+    if (wx >= 0 && wx < WINDOW && wz >= 0 && wz < WINDOW) {
+        return window[wz * WINDOW + wx];
+    }
+    return chunks.getChunk(cx, cz);
+}
+
+void LightSolver::pushAdd(int x, int y, int z, int light) {
+    int wx = x - windowX;
+    int wz = z - windowZ;
+    // entries on the window border are deferred, so neighbours of
+    // queued entries are always inside of the window
+    if (wx > 0 && wx < WINDOW_W - 1 && wz > 0 && wz < WINDOW_D - 1) {
+        addqueue.push(pack_entry(wx, y, wz, light));
+    } else {
+        addOverflow.push_back(lightentry {x, y, z, ubyte(light)});
+    }
+}
+
+void LightSolver::pushRemove(int x, int y, int z, int light) {
+    int wx = x - windowX;
+    int wz = z - windowZ;
+    if (wx > 0 && wx < WINDOW_W - 1 && wz > 0 && wz < WINDOW_D - 1) {
+        remqueue.push(pack_entry(wx, y, wz, light));
+    } else {
+        remOverflow.push_back(lightentry {x, y, z, ubyte(light)});
+    }
 }
 
 void LightSolver::add(int x, int y, int z, int emission) {
-    if (emission <= 1)
+    if (emission <= 1 || y < 0 || y >= CHUNK_H)
         return;
-    Chunk* chunk = chunks.getChunkByVoxel(x, y, z);
+    int cx = floordiv<CHUNK_W>(x);
+    int cz = floordiv<CHUNK_D>(z);
+    if (isEmpty()) {
+        setWindow(cx, cz);
+    }
+    Chunk* chunk = getChunk(cx, cz);
     if (chunk == nullptr)
         return;
-    ubyte light = chunk->lightmap.get(x-chunk->x*CHUNK_W, y, z-chunk->z*CHUNK_D, channel);
+    uint index = vox_index(x - cx * CHUNK_W, y, z - cz * CHUNK_D);
+    ubyte light = chunk->lightmap.get(index, channel);
     if (emission < light) return;
 
-    addqueue.push(lightentry {x, y, z, ubyte(emission)});
+    pushAdd(x, y, z, emission);
 
-    chunk->flags.modified = true;
-    chunk->lightmap.set(x-chunk->x*CHUNK_W, y, z-chunk->z*CHUNK_D, channel, emission);
+    chunk->setModified(y);
+    chunk->lightmap.set(index, channel, emission);
 }
 
 void LightSolver::add(int x, int y, int z) {
-    add(x,y,z, chunks.getLight(x,y,z, channel));
+    if (y < 0 || y >= CHUNK_H)
+        return;
+    int cx = floordiv<CHUNK_W>(x);
+    int cz = floordiv<CHUNK_D>(z);
+    if (isEmpty()) {
+        setWindow(cx, cz);
+    }
+    if (Chunk* chunk = getChunk(cx, cz)) {
+        uint index = vox_index(x - cx * CHUNK_W, y, z - cz * CHUNK_D);
+        add(x, y, z, chunk->lightmap.get(index, channel));
+    }
 }
 
 void LightSolver::remove(int x, int y, int z) {
-    Chunk* chunk = chunks.getChunkByVoxel(x, y, z);
+    if (y < 0 || y >= CHUNK_H)
+        return;
+    int cx = floordiv<CHUNK_W>(x);
+    int cz = floordiv<CHUNK_D>(z);
+    if (isEmpty()) {
+        setWindow(cx, cz);
+    }
+    Chunk* chunk = getChunk(cx, cz);
     if (chunk == nullptr)
         return;
 
-    ubyte light = chunk->lightmap.get(x-chunk->x*CHUNK_W, y, z-chunk->z*CHUNK_D, channel);
+    uint index = vox_index(x - cx * CHUNK_W, y, z - cz * CHUNK_D);
+    ubyte light = chunk->lightmap.get(index, channel);
     if (light == 0){
         return;
     }
-    remqueue.push(lightentry {x, y, z, light});
-    chunk->lightmap.set(x-chunk->x*CHUNK_W, y, z-chunk->z*CHUNK_D, channel, 0);
+    pushRemove(x, y, z, light);
+    chunk->lightmap.set(index, channel, 0);
 }
 
-void LightSolver::solve(){
-    const int coords[] = {
-            0, 0, 1,
-            0, 0,-1,
-            0, 1, 0,
-            0,-1, 0,
-            1, 0, 0,
-           -1, 0, 0
-    };
+static const int coords[] = {
+        0, 0, 1,
+        0, 0,-1,
+        0, 1, 0,
+        0,-1, 0,
+        1, 0, 0,
+       -1, 0, 0
+};
 
+void LightSolver::solveRemove() {
     while (!remqueue.empty()){
-        const lightentry entry = remqueue.front();
-        remqueue.pop();
+        const uint32_t entry = remqueue.pop();
+        const int ex = entry & 0x7F;
+        const int ez = (entry >> 7) & 0x7F;
+        const int ey = (entry >> 14) & 0xFF;
+        const int elight = entry >> 22;
 
         for (int i = 0; i < 6; i++) {
             int imul3 = i*3;
-            int x = entry.x+coords[imul3];
-            int y = entry.y+coords[imul3+1];
-            int z = entry.z+coords[imul3+2];
-            
-            Chunk* chunk = chunks.getChunkByVoxel(x,y,z);
-            if (chunk) {
-                int lx = x - chunk->x * CHUNK_W;
-                int lz = z - chunk->z * CHUNK_D;
-                chunk->flags.modified = true;
-
-                ubyte light = chunk->lightmap.get(lx,y,lz, channel);
-                if (light != 0 && light == entry.light-1){
-                    voxel* vox = chunks.get(x, y, z);
-                    if (vox && vox->id != 0) {
-                        const Block* block = blockDefs[vox->id];
-                        if (uint8_t emission = block->emission[channel]) {
-                            addqueue.push(lightentry {x, y, z, emission});
-                            chunk->lightmap.set(lx, y, lz, channel, emission);
-                        }
-                        else chunk->lightmap.set(lx, y, lz, channel, 0);
-                    }
-                    else chunk->lightmap.set(lx, y, lz, channel, 0);
-                    remqueue.push(lightentry {x, y, z, light});
-                }
-                else if (light >= entry.light){
-                    addqueue.push(lightentry {x, y, z, light});
+            int x = ex+coords[imul3];
+            int y = ey+coords[imul3+1];
+            int z = ez+coords[imul3+2];
+            if (y < 0 || y >= CHUNK_H) {
+                continue;
+            }
+            Chunk* chunk = window[(z / CHUNK_D) * WINDOW + x / CHUNK_W];
+            if (chunk == nullptr) {
+                continue;
+            }
+            uint index = vox_index(x % CHUNK_W, y, z % CHUNK_D);
+            chunk->setModified(y);
+
+            ubyte light = chunk->lightmap.get(index, channel);
+            if (light != 0 && light == elight-1){
+                blockid_t id = chunk->voxels.get(index).id;
+                uint8_t emission = id ? blockDefs[id]->emission[channel] : 0;
+                if (emission) {
+                    pushAdd(windowX + x, y, windowZ + z, emission);
                 }
+                chunk->lightmap.set(index, channel, emission);
+                pushRemove(windowX + x, y, windowZ + z, light);
+            }
+            else if (light >= elight){
+                pushAdd(windowX + x, y, windowZ + z, light);
             }
         }
     }
+}
 
+void LightSolver::solveAdd() {
     while (!addqueue.empty()){
-        const lightentry entry = addqueue.front();
-        addqueue.pop();
+        const uint32_t entry = addqueue.pop();
+        const int ex = entry & 0x7F;
+        const int ez = (entry >> 7) & 0x7F;
+        const int ey = (entry >> 14) & 0xFF;
+        const int elight = entry >> 22;
+        // light of the entry may be removed after it was queued
+        Chunk* echunk = window[(ez / CHUNK_D) * WINDOW + ex / CHUNK_W];
+        if (echunk->lightmap.get(
+                vox_index(ex % CHUNK_W, ey, ez % CHUNK_D), channel
+            ) < elight) {
+            continue;
+        }
 
         for (int i = 0; i < 6; i++) {
             int imul3 = i*3;
-            int x = entry.x+coords[imul3];
-            int y = entry.y+coords[imul3+1];
-            int z = entry.z+coords[imul3+2];
-
-            Chunk* chunk = chunks.getChunkByVoxel(x,y,z);
-            if (chunk) {
-                int lx = x - chunk->x * CHUNK_W;
-                int lz = z - chunk->z * CHUNK_D;
-                chunk->flags.modified = true;
-
-                ubyte light = chunk->lightmap.get(lx, y, lz, channel);
-                voxel& v = chunk->voxels[vox_index(lx, y, lz)];
-                const Block* block = blockDefs[v.id];
-                if (block->lightPassing && light+2 <= entry.light){
-                    chunk->lightmap.set(
-                        x-chunk->x*CHUNK_W, y, z-chunk->z*CHUNK_D, 
-                        channel, 
-                        entry.light-1);
-                    addqueue.push(lightentry {x, y, z, ubyte(entry.light-1)});
-                }
+            int x = ex+coords[imul3];
+            int y = ey+coords[imul3+1];
+            int z = ez+coords[imul3+2];
+            if (y < 0 || y >= CHUNK_H) {
+                continue;
+            }
+            Chunk* chunk = window[(z / CHUNK_D) * WINDOW + x / CHUNK_W];
+            if (chunk == nullptr) {
+                continue;
+            }
+            chunk->setModified(y);
+            if (chunk->sections[y / CHUNK_SECTION_H].isOpaque()) {
+                continue;
+            }
+            uint index = vox_index(x % CHUNK_W, y, z % CHUNK_D);
+            ubyte light = chunk->lightmap.get(index, channel);
+            // voxels are read without expanding compact chunk voxels
+            if (light+2 <= elight &&
+                isLightPassing(chunk->voxels.get(index).id)) {
+                chunk->lightmap.set(index, channel, elight-1);
+                pushAdd(windowX + x, y, windowZ + z, elight-1);
             }
         }
     }
 }
+
+void LightSolver::solve(){
+    while (true) {
+        // all removals are done before light is spread again
+        solveRemove();
+        if (!remOverflow.empty()) {
+            moveWindow();
+            continue;
+        }
+        solveAdd();
+        if (!addOverflow.empty()) {
+            moveWindow();
+            continue;
+        }
+        break;
+    }
+}
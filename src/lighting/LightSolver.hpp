@@ -1,7 +1,12 @@
 #pragma once
 
-#include <queue>
+#include <vector>
 
+#include "constants.hpp"
+#include "typedefs.hpp"
+#include "util/RingBuffer.hpp"
+
+class Chunk;
 class Chunks;
 class ContentIndices;
 class Block;
@@ -13,12 +18,48 @@ struct lightentry {
     unsigned char light;
 };
 
+/// @brief Single channel light flood-fill solver.
+///
+/// Queued voxels are packed to 32 bit entries with coordinates relative
+/// to a window of WINDOW x WINDOW chunks cached on first add/remove,
+/// centered on the chunk of that voxel. Light does not spread further
+/// than two chunks from a voxel, so entries rarely leave the window.
+/// Those are kept in overflow lists and processed after the window
+/// is moved to them.
 class LightSolver {
-    std::queue<lightentry> addqueue;
-    std::queue<lightentry> remqueue;
+    static constexpr int WINDOW = 7;
+    static constexpr int WINDOW_W = WINDOW * CHUNK_W;
+    static constexpr int WINDOW_D = WINDOW * CHUNK_D;
+    static_assert(WINDOW_W <= 128 && WINDOW_D <= 128 && CHUNK_H <= 256);
+
+    util::RingBuffer<uint32_t> addqueue;
+    util::RingBuffer<uint32_t> remqueue;
+    std::vector<lightentry> addOverflow;
+    std::vector<lightentry> remOverflow;
+    Chunk* window[WINDOW * WINDOW] {};
+    /// @brief Window origin in global voxel coordinates
+    int windowX = 0;
+    int windowZ = 0;
     const Block* const* blockDefs;
+    /// @brief Block::lightPassing bit per block id
+    std::vector<uint64_t> lightPassing;
     Chunks& chunks;
     int channel;
+
+    bool isEmpty() const;
+    void setWindow(int cx, int cz);
+    /// @brief Move window to the first overflow entry
+    void moveWindow();
+    /// @brief Get chunk at global chunk coordinates using window if possible
+    Chunk* getChunk(int cx, int cz) const;
+    void pushAdd(int x, int y, int z, int light);
+    void pushRemove(int x, int y, int z, int light);
+    void solveRemove();
+    void solveAdd();
+
+    bool isLightPassing(blockid_t id) const {
+        return (lightPassing[id >> 6] >> (id & 63)) & 1;
+    }
 public:
     LightSolver(const ContentIndices& contentIds, Chunks& chunks, int channel);
 
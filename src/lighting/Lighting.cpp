@@ -2,67 +2,94 @@
 #include "LightSolver.hpp"
 #include "Lightmap.hpp"
 #include "content/Content.hpp"
+#include "voxels/blocks_agent.hpp"
 #include "voxels/Chunks.hpp"
 #include "voxels/Chunk.hpp"
 #include "voxels/voxel.hpp"
 #include "voxels/Block.hpp"
 #include "constants.hpp"
 #include "util/timeutil.hpp"
+#include "util/ThreadPool.hpp"
 #include "debug/Logger.hpp"
 
+#include <algorithm>
 #include <memory>
+#include <thread>
+#include <tuple>
 
 static debug::Logger logger("lighting");
 
-Lighting::Lighting(const Content& content, Chunks& chunks) 
+class Lighting::Worker : public util::Worker<Chunk*, Chunk*> {
+    Lighting& lighting;
+    Solvers solvers;
+public:
+    Worker(Lighting& lighting)
+        : lighting(lighting), solvers(lighting.createSolvers()) {
+    }
+
+    Chunk* operator()(Chunk* const& chunk) override {
+        lighting.buildLights(*chunk, solvers);
+        return chunk;
+    }
+};
+
+Lighting::Lighting(const Content& content, Chunks& chunks, uint threads)
   : content(content), chunks(chunks) {
-    auto& indices = *content.getIndices();
-    solverR = std::make_unique<LightSolver>(indices, chunks, 0);
-    solverG = std::make_unique<LightSolver>(indices, chunks, 1);
-    solverB = std::make_unique<LightSolver>(indices, chunks, 2);
-    solverS = std::make_unique<LightSolver>(indices, chunks, 3);
+    solvers = createSolvers();
+    if (threads == 0) {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    if (threads > 1) {
+        pool = std::make_unique<util::ThreadPool<Chunk*, Chunk*>>(
+            "lighting",
+            [this]() { return std::make_shared<Worker>(*this); },
+            [this](Chunk*&) { passDone++; },
+            threads - 1
+        );
+    }
 }
 
 Lighting::~Lighting() = default;
 
+size_t Lighting::getThreadsCount() const {
+    return pool ? pool->getWorkersCount() + 1 : 1;
+}
+
+Lighting::Solvers Lighting::createSolvers() const {
+    auto& indices = *content.getIndices();
+    return Solvers {
+        std::make_unique<LightSolver>(indices, chunks, 0),
+        std::make_unique<LightSolver>(indices, chunks, 1),
+        std::make_unique<LightSolver>(indices, chunks, 2),
+        std::make_unique<LightSolver>(indices, chunks, 3)};
+}
+
 void Lighting::clear(){
     const auto& chunks = this->chunks.getChunks();
     for (size_t index = 0; index < chunks.size(); index++){
         auto chunk = chunks[index];
         if (chunk == nullptr)
             continue;
-        Lightmap& lightmap = chunk->lightmap;
-        for (int i = 0; i < CHUNK_VOL; i++){
-            lightmap.map[i] = 0;
-        }
+        chunk->lightmap.clear();
     }
 }
 
-void Lighting::prebuildSkyLight(Chunk& chunk, const ContentIndices& indices){
-    const auto* blockDefs = indices.blocks.getDefs();
+void Lighting::prebuildSkyLight(Chunk& chunk, const ContentIndices&){
+    // column heights are maintained by chunk, so voxels are not visited
+    chunk.lightmap.fillColumns(chunk.skyHeights, 3, 15);
 
-    int highestPoint = 0;
-    for (int z = 0; z < CHUNK_D; z++){
-        for (int x = 0; x < CHUNK_W; x++){
-            for (int y = CHUNK_H-1; y >= 0; y--){
-                int index = (y * CHUNK_D + z) * CHUNK_W + x;
-                voxel& vox = chunk.voxels[index];
-                const Block* block = blockDefs[vox.id];
-                if (!block->skyLightPassing) {
-                    if (highestPoint < y)
-                        highestPoint = y;
-                    break;
-                }
-                chunk.lightmap.setS(x,y,z, 15);
-            }
-        }
-    }
-    if (highestPoint < CHUNK_H-1)
-        highestPoint++;
-    chunk.lightmap.highestPoint = highestPoint;
+    int highestPoint = *std::max_element(
+        chunk.skyHeights, chunk.skyHeights + CHUNK_W * CHUNK_D
+    );
+    chunk.lightmap.highestPoint = std::min(highestPoint, CHUNK_H-1);
+}
+
+void Lighting::buildSkyLight(int cx, int cz) {
+    buildSkyLight(cx, cz, solvers);
 }
 
-void Lighting::buildSkyLight(int cx, int cz){
+void Lighting::buildSkyLight(int cx, int cz, Solvers& solvers){
+    auto& solverS = *solvers.s;
     const auto blockDefs = content.getIndices()->blocks.getDefs();
 
     Chunk* chunk = chunks.getChunk(cx, cz);
@@ -70,35 +97,45 @@ void Lighting::buildSkyLight(int cx, int cz){
         logger.error() << "attempted to build sky lights to chunk missing in local matrix";
         return;
     }
+    // worker threads must not expand compact voxels
+    auto voxels = chunk->voxels.view();
     for (int z = 0; z < CHUNK_D; z++){
         for (int x = 0; x < CHUNK_W; x++){
             int gx = x + cx * CHUNK_W;
             int gz = z + cz * CHUNK_D;
-            for (int y = chunk->lightmap.highestPoint; y >= 0; y--){
-                while (y > 0 && !blockDefs[chunk->voxels[vox_index(x, y, z)].id]->lightPassing) {
+            // voxels above the column height are lit by open sky
+            int height = chunk->skyHeights[z * CHUNK_W + x];
+            for (int y = std::min(chunk->lightmap.highestPoint, height); y >= 0; y--){
+                while (y > 0 && !blockDefs[voxels[vox_index(x, y, z)].id]->lightPassing) {
                     y--;
                 }
                 if (chunk->lightmap.getS(x, y, z) != 15) {
-                    solverS->add(gx,y+1,gz);
+                    solverS.add(gx,y+1,gz);
                     for (; y >= 0; y--){
-                        solverS->add(gx+1,y,gz);
-                        solverS->add(gx-1,y,gz);
-                        solverS->add(gx,y,gz+1);
-                        solverS->add(gx,y,gz-1);
+                        solverS.add(gx+1,y,gz);
+                        solverS.add(gx-1,y,gz);
+                        solverS.add(gx,y,gz+1);
+                        solverS.add(gx,y,gz-1);
                     }
                 }
             }
         }
     }
-    solverS->solve();
+    solverS.solve();
 }
 
 
 void Lighting::onChunkLoaded(int cx, int cz, bool expand) {
-    auto& solverR = *this->solverR;
-    auto& solverG = *this->solverG;
-    auto& solverB = *this->solverB;
-    auto& solverS = *this->solverS;
+    onChunkLoaded(cx, cz, expand, solvers);
+}
+
+void Lighting::onChunkLoaded(
+    int cx, int cz, bool expand, Solvers& solvers
+) {
+    auto& solverR = *solvers.r;
+    auto& solverG = *solvers.g;
+    auto& solverB = *solvers.b;
+    auto& solverS = *solvers.s;
 
     auto blockDefs = content.getIndices()->blocks.getDefs();
     auto chunk = chunks.getChunk(cx, cz);
@@ -106,10 +143,17 @@ void Lighting::onChunkLoaded(int cx, int cz, bool expand) {
         logger.error() << "attempted to build lights to chunk missing in local matrix";
         return;
     }
+    auto voxels = chunk->voxels.view();
     for (uint y = 0; y < CHUNK_H; y++){
+        // air is not emissive
+        if (y % CHUNK_SECTION_H == 0 &&
+            chunk->sections[y / CHUNK_SECTION_H].isEmpty()) {
+            y += CHUNK_SECTION_H - 1;
+            continue;
+        }
         for (uint z = 0; z < CHUNK_D; z++){
             for (uint x = 0; x < CHUNK_W; x++){
-                const voxel& vox = chunk->voxels[(y * CHUNK_D + z) * CHUNK_W + x];
+                const voxel& vox = voxels[(y * CHUNK_D + z) * CHUNK_W + x];
                 const Block* block = blockDefs[vox.id];
                 int gx = x + cx * CHUNK_W;
                 int gz = z + cz * CHUNK_D;
@@ -160,56 +204,142 @@ void Lighting::onChunkLoaded(int cx, int cz, bool expand) {
     solverS.solve();
 }
 
-void Lighting::onBlockSet(int x, int y, int z, blockid_t id){
-    const auto& block = content.getIndices()->blocks.require(id);
-    solverR->remove(x,y,z);
-    solverG->remove(x,y,z);
-    solverB->remove(x,y,z);
+void Lighting::buildLights(Chunk& chunk, Solvers& solvers) {
+    bool lightsCache = chunk.flags.loadedLights;
+    if (!lightsCache) {
+        buildSkyLight(chunk.x, chunk.z, solvers);
+    }
+    onChunkLoaded(chunk.x, chunk.z, !lightsCache, solvers);
+}
 
-    if (id == 0){
-        solverR->solve();
-        solverG->solve();
-        solverB->solve();
-        if (chunks.getLight(x,y+1,z, 3) == 0xF){
-            for (int i = y; i >= 0; i--){
-                voxel* vox = chunks.get(x,i,z);
-                if ((vox == nullptr || vox->id != 0) && block.skyLightPassing)
-                    break;
-                solverS->add(x,i,z, 0xF);
-            }
+void Lighting::buildLights(const std::vector<Chunk*>& pass) {
+    passDone = 0;
+    for (size_t i = 1; i < pass.size(); i++) {
+        pool->enqueueJob(pass[i]);
+    }
+    if (!pass.empty()) {
+        buildLights(*pass[0], solvers);
+    }
+    // chunks of the next pass may share neighbours with this pass chunks
+    while (passDone + 1 < pass.size()) {
+        std::this_thread::yield();
+        pool->update();
+    }
+}
+
+void Lighting::onChunksLoaded(const std::vector<Chunk*>& loaded) {
+    std::vector<Chunk*> pending = loaded;
+    std::vector<Chunk*> postponed;
+    std::vector<Chunk*> pass;
+    while (!pending.empty()) {
+        // light spreads from a chunk to its neighbours only, so chunks
+        // at distance of 3 or more do not share modified chunks
+        for (Chunk* chunk : pending) {
+            bool independent = pass.size() < getThreadsCount() &&
+                std::all_of(pass.begin(), pass.end(), [chunk](Chunk* other) {
+                    return std::abs(other->x - chunk->x) >= 3 ||
+                           std::abs(other->z - chunk->z) >= 3;
+                });
+            (independent ? pass : postponed).push_back(chunk);
+        }
+        buildLights(pass);
+        pass.clear();
+        std::swap(pending, postponed);
+        postponed.clear();
+    }
+}
+
+void Lighting::onBlockSet(int x, int y, int z, blockid_t){
+    beginBatch();
+    batchChanges.emplace_back(x, y, z);
+    endBatch();
+}
+
+void Lighting::beginBatch() {
+    batchDepth++;
+}
+
+void Lighting::endBatch() {
+    if (batchDepth == 0 || --batchDepth > 0) {
+        return;
+    }
+    auto changes = std::move(batchChanges);
+    batchChanges.clear();
+    // from top to bottom, so sky light columns are restored from above
+    std::sort(changes.begin(), changes.end(), [](const auto& a, const auto& b) {
+        return std::tie(b.y, a.z, a.x) < std::tie(a.y, b.z, b.x);
+    });
+    changes.erase(std::unique(changes.begin(), changes.end()), changes.end());
+    solveChanges(changes);
+}
+
+void Lighting::solveChanges(const std::vector<glm::ivec3>& changes) {
+    auto& solverR = *solvers.r;
+    auto& solverG = *solvers.g;
+    auto& solverB = *solvers.b;
+    auto& solverS = *solvers.s;
+    const auto& indices = content.getIndices()->blocks;
+
+    // light of changed blocks is removed first, so it is spread again
+    // from the remaining sources only once for all changes
+    for (const auto& pos : changes) {
+        int x = pos.x, y = pos.y, z = pos.z;
+        auto vox = blocks_agent::peek(chunks, x, y, z);
+        if (!vox) {
+            continue;
         }
-        solverR->add(x,y+1,z); solverG->add(x,y+1,z); solverB->add(x,y+1,z); solverS->add(x,y+1,z);
-        solverR->add(x,y-1,z); solverG->add(x,y-1,z); solverB->add(x,y-1,z); solverS->add(x,y-1,z);
-        solverR->add(x+1,y,z); solverG->add(x+1,y,z); solverB->add(x+1,y,z); solverS->add(x+1,y,z);
-        solverR->add(x-1,y,z); solverG->add(x-1,y,z); solverB->add(x-1,y,z); solverS->add(x-1,y,z);
-        solverR->add(x,y,z+1); solverG->add(x,y,z+1); solverB->add(x,y,z+1); solverS->add(x,y,z+1);
-        solverR->add(x,y,z-1); solverG->add(x,y,z-1); solverB->add(x,y,z-1); solverS->add(x,y,z-1);
-        solverR->solve();
-        solverG->solve();
-        solverB->solve();
-        solverS->solve();
-    } else {
-        if (!block.skyLightPassing){
-            solverS->remove(x,y,z);
+        solverR.remove(x,y,z);
+        solverG.remove(x,y,z);
+        solverB.remove(x,y,z);
+
+        if (!indices.require(vox->id).skyLightPassing){
+            solverS.remove(x,y,z);
             for (int i = y-1; i >= 0; i--){
-                solverS->remove(x,i,z);
-                if (i == 0 || chunks.get(x,i-1,z)->id != 0){
+                solverS.remove(x,i,z);
+                if (i == 0 || blocks_agent::peek(chunks, x, i-1, z)->id != 0){
                     break;
                 }
             }
-            solverS->solve();
         }
-        solverR->solve();
-        solverG->solve();
-        solverB->solve();
+    }
+    solverR.solve();
+    solverG.solve();
+    solverB.solve();
+    solverS.solve();
 
+    for (const auto& pos : changes) {
+        int x = pos.x, y = pos.y, z = pos.z;
+        auto vox = blocks_agent::peek(chunks, x, y, z);
+        if (!vox) {
+            continue;
+        }
+        const auto& block = indices.require(vox->id);
+        if (vox->id == 0 && chunks.getLight(x,y+1,z, 3) == 0xF){
+            for (int i = y; i >= 0; i--){
+                auto below = blocks_agent::peek(chunks, x, i, z);
+                if (!below || below->id != 0)
+                    break;
+                solverS.add(x,i,z, 0xF);
+            }
+        }
+        if (block.lightPassing) {
+            for (auto solver : {&solverR, &solverG, &solverB, &solverS}) {
+                solver->add(x,y+1,z);
+                solver->add(x,y-1,z);
+                solver->add(x+1,y,z);
+                solver->add(x-1,y,z);
+                solver->add(x,y,z+1);
+                solver->add(x,y,z-1);
+            }
+        }
         if (block.emission[0] || block.emission[1] || block.emission[2]){
-            solverR->add(x,y,z,block.emission[0]);
-            solverG->add(x,y,z,block.emission[1]);
-            solverB->add(x,y,z,block.emission[2]);
-            solverR->solve();
-            solverG->solve();
-            solverB->solve();
+            solverR.add(x,y,z,block.emission[0]);
+            solverG.add(x,y,z,block.emission[1]);
+            solverB.add(x,y,z,block.emission[2]);
         }
     }
+    solverR.solve();
+    solverG.solve();
+    solverB.solve();
+    solverS.solve();
 }
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
 #include "typedefs.hpp"
 
 class Content;
@@ -8,15 +12,45 @@ class Chunk;
 class Chunks;
 class LightSolver;
 
+namespace util {
+    template <class J, class T>
+    class ThreadPool;
+}
+
 class Lighting {
+    /// @brief R, G, B and S channels solvers used by a single thread
+    struct Solvers {
+        std::unique_ptr<LightSolver> r;
+        std::unique_ptr<LightSolver> g;
+        std::unique_ptr<LightSolver> b;
+        std::unique_ptr<LightSolver> s;
+    };
     const Content& content;
     Chunks& chunks;
-    std::unique_ptr<LightSolver> solverR;
-    std::unique_ptr<LightSolver> solverG;
-    std::unique_ptr<LightSolver> solverB;
-    std::unique_ptr<LightSolver> solverS;
+    Solvers solvers;
+    /// @brief Worker of the pool having its own solvers
+    class Worker;
+    /// @brief Persistent workers building lights of chunks passed by
+    /// onChunksLoaded along with the calling thread.
+    /// nullptr if lights are built by the calling thread only
+    std::unique_ptr<util::ThreadPool<Chunk*, Chunk*>> pool;
+    /// @brief Number of chunks of the current pass built by the pool
+    size_t passDone = 0;
+    int batchDepth = 0;
+    /// @brief Positions of blocks changed since beginBatch
+    std::vector<glm::ivec3> batchChanges;
+
+    Solvers createSolvers() const;
+    void buildSkyLight(int cx, int cz, Solvers& solvers);
+    void onChunkLoaded(int cx, int cz, bool expand, Solvers& solvers);
+    void buildLights(Chunk& chunk, Solvers& solvers);
+    void buildLights(const std::vector<Chunk*>& pass);
+    void solveChanges(const std::vector<glm::ivec3>& changes);
 public:
-    Lighting(const Content& content, Chunks& chunks);
+    /// @param threads max number of threads building lights of loaded
+    /// chunks simultaneously including the calling thread
+    /// (0 - hardware concurrency)
+    Lighting(const Content& content, Chunks& chunks, uint threads = 0);
     ~Lighting();
 
     void clear();
@@ -24,5 +58,23 @@ public:
     void onChunkLoaded(int cx, int cz, bool expand);
     void onBlockSet(int x, int y, int z, blockid_t id);
 
+    /// @brief Start recording block changes. onBlockSet calls made before
+    /// the matching endBatch call only mark blocks as changed.
+    /// Batches may be nested
+    void beginBatch();
+
+    /// @brief Update lights of all blocks changed in the batch at once
+    void endBatch();
+
+    /// @brief Build lights of loaded chunks having all neighbours loaded.
+    /// Chunks without lights cache get sky light built and expanded.
+    /// Chunks distant enough to not affect the same neighbours are
+    /// processed by multiple threads simultaneously
+    void onChunksLoaded(const std::vector<Chunk*>& loaded);
+
+    /// @return number of chunks that may be processed simultaneously
+    size_t getThreadsCount() const;
+
+    /// @brief Fill sky light of voxels above chunk columns sky heights
     static void prebuildSkyLight(Chunk& chunk, const ContentIndices& indices);
 };
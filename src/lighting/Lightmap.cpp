@@ -1,34 +1,252 @@
 #include "Lightmap.hpp"
 
-#include "util/data_io.hpp"
+#include "coders/byte_utils.hpp"
 
-#include <cassert>
-#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIGHTMAP_SIMD
+#include <emmintrin.h>
+#endif
+
+static_assert(sizeof(light_t) == 2, "replace dataio calls to new light_t");
+
+/// @brief Skylight columns encoding format marker
+static constexpr ubyte LIGHTMAP_COLUMNS_FORMAT = 1;
+static constexpr uint LIGHTMAP_COLUMNS = CHUNK_W * CHUNK_D;
+
+Lightmap::~Lightmap() {
+    for (auto& section : sections) {
+        delete[] section.lights.load();
+    }
+}
+
+light_t* Lightmap::allocate(Section& section) {
+    auto lights = new light_t[CHUNK_SECTION_VOL];
+    std::fill(lights, lights + CHUNK_SECTION_VOL, section.fill);
+    section.lights.store(lights, std::memory_order_release);
+    return lights;
+}
 
 void Lightmap::set(const Lightmap* lightmap) {
-    set(lightmap->map);
+    for (int s = 0; s < CHUNK_SECTIONS; s++) {
+        auto& section = sections[s];
+        const auto& src = lightmap->sections[s];
+        light_t* lights = section.lights.load(std::memory_order_relaxed);
+        if (const light_t* srcLights = src.lights.load()) {
+            if (lights == nullptr) {
+                lights = allocate(section);
+            }
+            std::copy(srcLights, srcLights + CHUNK_SECTION_VOL, lights);
+        } else if (lights) {
+            std::fill(lights, lights + CHUNK_SECTION_VOL, src.fill);
+        } else {
+            section.fill = src.fill;
+        }
+    }
+    highestPoint = lightmap->highestPoint;
 }
 
 void Lightmap::set(const light_t* map) {
-    std::memcpy(this->map, map, sizeof(light_t) * CHUNK_VOL);
+    for (int s = 0; s < CHUNK_SECTIONS; s++) {
+        auto& section = sections[s];
+        const light_t* src = map + s * CHUNK_SECTION_VOL;
+        light_t* lights = section.lights.load(std::memory_order_relaxed);
+        if (lights == nullptr) {
+            bool uniform = std::all_of(
+                src, src + CHUNK_SECTION_VOL, [=](auto light) {
+                    return light == src[0];
+                }
+            );
+            if (uniform) {
+                section.fill = src[0];
+                continue;
+            }
+            lights = allocate(section);
+        }
+        std::copy(src, src + CHUNK_SECTION_VOL, lights);
+    }
 }
 
-static_assert(sizeof(light_t) == 2, "replace dataio calls to new light_t");
+void Lightmap::clear() {
+    for (auto& section : sections) {
+        if (light_t* lights = section.lights.load(std::memory_order_relaxed)) {
+            std::fill(lights, lights + CHUNK_SECTION_VOL, 0);
+        } else {
+            section.fill = 0;
+        }
+    }
+}
+
+void Lightmap::fill(int y1, int y2, int channel, int value) {
+    constexpr uint LAYER_VOL = CHUNK_W * CHUNK_D;
+    for (int y = y1; y < y2;) {
+        auto& section = sections[y / CHUNK_SECTION_H];
+        int sectionEnd = (y / CHUNK_SECTION_H + 1) * CHUNK_SECTION_H;
+        if (y % CHUNK_SECTION_H == 0 && sectionEnd <= y2 &&
+            section.lights.load(std::memory_order_relaxed) == nullptr) {
+            section.fill = replace(section.fill, channel, value);
+            y = sectionEnd;
+            continue;
+        }
+        int end = std::min(sectionEnd, y2);
+        for (uint index = y * LAYER_VOL; index < end * LAYER_VOL; index++) {
+            put(index, replace(get(index), channel, value));
+        }
+        y = end;
+    }
+}
 
-std::unique_ptr<ubyte[]> Lightmap::encode() const {
-    auto buffer = std::make_unique<ubyte[]>(LIGHTMAP_DATA_LEN);
-    for (uint i = 0; i < CHUNK_VOL; i+=2) {
-        buffer[i/2] = ((map[i] >> 12) & 0xF) | ((map[i+1] >> 8) & 0xF0);
+/// @brief Replace channel bits of layer lights where column bottom <= y
+static void fill_layer(
+    light_t* lights,
+    const uint16_t* bottoms,
+    int y,
+    light_t channelMask,
+    light_t channelBits
+) {
+    uint i = 0;
+#ifdef LIGHTMAP_SIMD
+    const __m128i layer = _mm_set1_epi16(static_cast<short>(y + 1));
+    const __m128i mask = _mm_set1_epi16(static_cast<short>(channelMask));
+    const __m128i bits = _mm_set1_epi16(static_cast<short>(channelBits));
+    for (; i + 8 <= CHUNK_W * CHUNK_D; i += 8) {
+        auto dst = reinterpret_cast<__m128i*>(lights + i);
+        __m128i columns = _mm_cmplt_epi16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottoms + i)),
+            layer
+        );
+        __m128i values = _mm_loadu_si128(dst);
+        values = _mm_or_si128(
+            _mm_andnot_si128(_mm_and_si128(columns, mask), values),
+            _mm_and_si128(columns, bits)
+        );
+        _mm_storeu_si128(dst, values);
     }
+#endif
+    for (; i < CHUNK_W * CHUNK_D; i++) {
+        if (bottoms[i] <= y) {
+            lights[i] = (lights[i] & ~channelMask) | channelBits;
+        }
+    }
+}
+
+void Lightmap::fillColumns(const uint16_t* bottoms, int channel, int value) {
+    constexpr uint LAYER_VOL = CHUNK_W * CHUNK_D;
+    auto [lowest, highest] = std::minmax_element(bottoms, bottoms + LAYER_VOL);
+    fill(*highest, CHUNK_H, channel, value);
+
+    const light_t channelMask = 0xF << (channel << 2);
+    const light_t channelBits = value << (channel << 2);
+    for (int y = *lowest; y < *highest && y < CHUNK_H; y++) {
+        auto& section = sections[y / CHUNK_SECTION_H];
+        light_t* lights = section.lights.load(std::memory_order_relaxed);
+        if (lights == nullptr) {
+            if (extract(section.fill, channel) == value) {
+                continue;
+            }
+            lights = allocate(section);
+        }
+        fill_layer(
+            lights + (y % CHUNK_SECTION_H) * LAYER_VOL,
+            bottoms,
+            y,
+            channelMask,
+            channelBits
+        );
+    }
+}
+
+size_t Lightmap::getMemoryUsage() const {
+    size_t size = sizeof(Lightmap);
+    for (const auto& section : sections) {
+        if (section.lights.load() != nullptr) {
+            size += CHUNK_SECTION_VOL * sizeof(light_t);
+        }
+    }
+    return size;
+}
+
+std::unique_ptr<ubyte[]> Lightmap::encode(uint& size) const {
+    ByteBuilder builder(1 + LIGHTMAP_COLUMNS * 4);
+    builder.put(LIGHTMAP_COLUMNS_FORMAT);
+
+    std::vector<ubyte> values;
+    for (uint column = 0; column < LIGHTMAP_COLUMNS; column++) {
+        int top = CHUNK_H;
+        while (top > 0 &&
+               extract(get((top - 1) * LIGHTMAP_COLUMNS + column), 3) == 15) {
+            top--;
+        }
+        int bottom = 0;
+        while (bottom < top &&
+               extract(get(bottom * LIGHTMAP_COLUMNS + column), 3) == 0) {
+            bottom++;
+        }
+        builder.putInt16(bottom);
+        builder.putInt16(top);
+        for (int y = bottom; y < top; y++) {
+            values.push_back(extract(get(y * LIGHTMAP_COLUMNS + column), 3));
+        }
+    }
+    size_t columnsSize = builder.size() + (values.size() + 1) / 2;
+    if (columnsSize >= LIGHTMAP_DATA_LEN) {
+        // dense skylight data size is used as format marker
+        auto buffer = std::make_unique<ubyte[]>(LIGHTMAP_DATA_LEN);
+        for (uint i = 0; i < CHUNK_VOL; i+=2) {
+            buffer[i/2] = ((get(i) >> 12) & 0xF) | ((get(i+1) >> 8) & 0xF0);
+        }
+        size = LIGHTMAP_DATA_LEN;
+        return buffer;
+    }
+    for (size_t i = 0; i < values.size(); i += 2) {
+        ubyte high = i + 1 < values.size() ? values[i + 1] : 0;
+        builder.put(values[i] | (high << 4));
+    }
+    size = builder.size();
+    auto buffer = std::make_unique<ubyte[]>(size);
+    std::copy(builder.data(), builder.data() + size, buffer.get());
     return buffer;
 }
 
-std::unique_ptr<light_t[]> Lightmap::decode(const ubyte* buffer) {
+std::unique_ptr<light_t[]> Lightmap::decode(
+    const ubyte* buffer, size_t size
+) {
     auto lights = std::make_unique<light_t[]>(CHUNK_VOL);
-    for (uint i = 0; i < CHUNK_VOL; i+=2) {
-        ubyte b = buffer[i/2];
-        lights[i] = ((b & 0xF) << 12);
-        lights[i+1] = ((b & 0xF0) << 8);
-    } 
+    if (size == LIGHTMAP_DATA_LEN) {
+        for (uint i = 0; i < CHUNK_VOL; i+=2) {
+            ubyte b = buffer[i/2];
+            lights[i] = ((b & 0xF) << 12);
+            lights[i+1] = ((b & 0xF0) << 8);
+        }
+        return lights;
+    }
+    ByteReader reader(buffer, size);
+    if (reader.get() != LIGHTMAP_COLUMNS_FORMAT ||
+        reader.remaining() < LIGHTMAP_COLUMNS * 4) {
+        throw std::runtime_error("invalid lightmap data");
+    }
+    const ubyte* values = buffer + 1 + LIGHTMAP_COLUMNS * 4;
+    size_t valuesCount = (size - 1 - LIGHTMAP_COLUMNS * 4) * 2;
+    size_t valueIndex = 0;
+    for (uint column = 0; column < LIGHTMAP_COLUMNS; column++) {
+        int bottom = reader.getInt16();
+        int top = reader.getInt16();
+        if (bottom < 0 || bottom > top || top > CHUNK_H ||
+            valueIndex + (top - bottom) > valuesCount) {
+            throw std::runtime_error("invalid lightmap data");
+        }
+        for (int y = bottom; y < top; y++, valueIndex++) {
+            ubyte b = values[valueIndex / 2];
+            int value = valueIndex % 2 ? b >> 4 : b & 0xF;
+            lights[y * LIGHTMAP_COLUMNS + column] = value << 12;
+        }
+        for (int y = top; y < CHUNK_H; y++) {
+            lights[y * LIGHTMAP_COLUMNS + column] = 15 << 12;
+        }
+    }
     return lights;
 }
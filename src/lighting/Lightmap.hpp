@@ -3,81 +3,134 @@
 #include "constants.hpp"
 #include "typedefs.hpp"
 
+#include <atomic>
 #include <memory>
-#include <cstring>
 
 inline constexpr int LIGHTMAP_DATA_LEN = CHUNK_VOL/2;
 
 // Lichtkarte
+/// @brief Chunk lights. Each vertical section is stored as a single value
+/// until any of its voxels gets different light, so sections of open sky
+/// and dark underground do not allocate memory.
+///
+/// Allocated section arrays are kept until the lightmap is destroyed,
+/// so other threads may read lights while the lightmap is updated.
 class Lightmap {
+    struct Section {
+        /// @brief Section lights or nullptr if all voxels have fill value
+        std::atomic<light_t*> lights {nullptr};
+        light_t fill = 0;
+    };
+    Section sections[CHUNK_SECTIONS];
+
+    light_t* allocate(Section& section);
+
+    inline void put(uint index, light_t value) {
+        auto& section = sections[index / CHUNK_SECTION_VOL];
+        light_t* lights = section.lights.load(std::memory_order_relaxed);
+        if (lights == nullptr) {
+            if (value == section.fill) {
+                return;
+            }
+            lights = allocate(section);
+        }
+        lights[index % CHUNK_SECTION_VOL] = value;
+    }
 public:
-    light_t map[CHUNK_VOL] {};
     int highestPoint = 0;
 
+    Lightmap() = default;
+    Lightmap(const Lightmap&) = delete;
+    ~Lightmap();
+
     void set(const Lightmap* lightmap);
 
     void set(const light_t* map);
 
-    void clear() {
-        std::memset(map, 0, sizeof(map));
+    void clear();
+
+    /// @brief Set channel value for all voxels in [y1, y2) layers range.
+    /// Whole not allocated sections are filled without allocation
+    void fill(int y1, int y2, int channel, int value);
+
+    /// @brief Set channel value for voxels at or above column bottoms.
+    /// Layers between the lowest and the highest bottom are written
+    /// with SIMD, whole sections above the highest are filled as fill()
+    /// @param bottoms CHUNK_W * CHUNK_D columns bottom Y values
+    void fillColumns(const uint16_t* bottoms, int channel, int value);
+
+    inline light_t get(uint index) const {
+        const auto& section = sections[index / CHUNK_SECTION_VOL];
+        if (auto lights = section.lights.load(std::memory_order_acquire)) {
+            return lights[index % CHUNK_SECTION_VOL];
+        }
+        return section.fill;
+    }
+
+    inline unsigned char get(uint index, int channel) const {
+        return extract(get(index), channel);
+    }
+
+    inline void set(uint index, int channel, int value) {
+        put(index, replace(get(index), channel, value));
     }
 
     inline unsigned short get(int x, int y, int z) const {
-        return (map[y*CHUNK_D*CHUNK_W+z*CHUNK_W+x]);
+        return get(y*CHUNK_D*CHUNK_W+z*CHUNK_W+x);
     }
 
     inline unsigned char get(int x, int y, int z, int channel) const {
-        return (map[y*CHUNK_D*CHUNK_W+z*CHUNK_W+x] >> (channel << 2)) & 0xF;
+        return (get(x, y, z) >> (channel << 2)) & 0xF;
     }
 
     inline unsigned char getR(int x, int y, int z) const {
-        return map[y*CHUNK_D*CHUNK_W+z*CHUNK_W+x] & 0xF;
+        return get(x, y, z) & 0xF;
     }
 
     inline unsigned char getG(int x, int y, int z) const {
-        return (map[y*CHUNK_D*CHUNK_W+z*CHUNK_W+x] >> 4) & 0xF;
+        return (get(x, y, z) >> 4) & 0xF;
     }
 
     inline unsigned char getB(int x, int y, int z) const {
-        return (map[y*CHUNK_D*CHUNK_W+z*CHUNK_W+x] >> 8) & 0xF;
+        return (get(x, y, z) >> 8) & 0xF;
     }
 
     inline unsigned char getS(int x, int y, int z) const {
-        return (map[y*CHUNK_D*CHUNK_W+z*CHUNK_W+x] >> 12) & 0xF;
+        return (get(x, y, z) >> 12) & 0xF;
     }
 
     inline void setR(int x, int y, int z, int value){
         const int index = y*CHUNK_D*CHUNK_W+z*CHUNK_W+x;
-        map[index] = (map[index] & 0xFFF0) | value;
+        put(index, (get(index) & 0xFFF0) | value);
     }
 
     inline void setG(int x, int y, int z, int value){
         const int index = y*CHUNK_D*CHUNK_W+z*CHUNK_W+x;
-        map[index] = (map[index] & 0xFF0F) | (value << 4);
+        put(index, (get(index) & 0xFF0F) | (value << 4));
     }
 
     inline void setB(int x, int y, int z, int value){
         const int index = y*CHUNK_D*CHUNK_W+z*CHUNK_W+x;
-        map[index] = (map[index] & 0xF0FF) | (value << 8);
+        put(index, (get(index) & 0xF0FF) | (value << 8));
     }
 
     inline void setS(int x, int y, int z, int value){
         const int index = y*CHUNK_D*CHUNK_W+z*CHUNK_W+x;
-        map[index] = (map[index] & 0x0FFF) | (value << 12);
+        put(index, (get(index) & 0x0FFF) | (value << 12));
     }
 
     inline void set(int x, int y, int z, int channel, int value){
         const int index = y*CHUNK_D*CHUNK_W+z*CHUNK_W+x;
-        map[index] = (map[index] & (0xFFFF & (~(0xF << (channel*4))))) | (value << (channel << 2));
+        put(index, replace(get(index), channel, value));
     }
 
-    inline const light_t* getLights() const {
-        return map;
+    /// @return true if all voxels of the section have the same light
+    bool isUniform(uint section) const {
+        return sections[section].lights.load() == nullptr;
     }
 
-    inline light_t* getLightsWriteable() {
-        return map;
-    }
+    /// @return approximate heap memory used by lights
+    size_t getMemoryUsage() const;
 
     static constexpr light_t combine(int r, int g, int b, int s) {
         return r | (g << 4) | (b << 8) | (s << 12);
@@ -87,6 +140,19 @@ public:
         return (light >> (channel << 2)) & 0xF;
     }
 
-    std::unique_ptr<ubyte[]> encode() const;
-    static std::unique_ptr<light_t[]> decode(const ubyte* buffer);
+    static constexpr light_t replace(light_t light, int channel, int value) {
+        return (light & (0xFFFF & (~(0xF << (channel*4))))) |
+               (value << (channel << 2));
+    }
+
+    /// @brief Encode skylight channel. Columns are stored as range of
+    /// layers below which all voxels are dark and above which all voxels
+    /// are lit by open sky, with voxels inside of the range stored as is.
+    /// Falls back to dense LIGHTMAP_DATA_LEN bytes if not smaller
+    /// @param size encoded data size
+    std::unique_ptr<ubyte[]> encode(uint& size) const;
+
+    /// @brief Decode skylight channel encoded by encode()
+    /// @param size encoded data size, LIGHTMAP_DATA_LEN for dense data
+    static std::unique_ptr<light_t[]> decode(const ubyte* buffer, size_t size);
 };
@@ -38,7 +38,7 @@ void BlocksController::updateSides(int x, int y, int z) {
 }
 
 void BlocksController::updateSides(int x, int y, int z, int w, int h, int d) {
-    voxel* vox = blocks_agent::get(chunks, x, y, z);
+    auto vox = blocks_agent::peek(chunks, x, y, z);
     const auto& def = level.content.getIndices()->blocks.require(vox->id);
     const auto& rot = def.rotations.variants[vox->state.rotation];
     const auto& xaxis = rot.axes[0];
@@ -81,8 +81,8 @@ void BlocksController::breakBlock(
 void BlocksController::placeBlock(
     Player* player, const Block& def, blockstate state, int x, int y, int z
 ) {
-    auto voxel = blocks_agent::get(chunks, x, y, z);
-    if (voxel == nullptr) {
+    auto voxel = blocks_agent::peek(chunks, x, y, z);
+    if (!voxel) {
         return;
     }
     const auto& prevDef = level.content.getIndices()->blocks.require(voxel->id);
@@ -104,8 +104,8 @@ void BlocksController::placeBlock(
 }
 
 void BlocksController::updateBlock(int x, int y, int z) {
-    voxel* vox = blocks_agent::get(chunks, x, y, z);
-    if (vox == nullptr) return;
+    auto vox = blocks_agent::peek(chunks, x, y, z);
+    if (!vox) return;
     const auto& def = level.content.getIndices()->blocks.require(vox->id);
     if (def.grounded) {
         const auto& vec = get_ground_direction(def, vox->state.rotation);
@@ -150,11 +150,20 @@ void BlocksController::randomTick(
     const int segheight = CHUNK_H / segments;
 
     for (int s = 0; s < segments; s++) {
+        // air blocks are never updated
+        bool empty = true;
+        for (int y = s * segheight; y < (s + 1) * segheight;
+             y += CHUNK_SECTION_H) {
+            empty &= chunk.sections[y / CHUNK_SECTION_H].isEmpty();
+        }
+        if (empty) {
+            continue;
+        }
         for (int i = 0; i < 4; i++) {
             int bx = random.rand() % CHUNK_W;
             int by = random.rand() % segheight + s * segheight;
             int bz = random.rand() % CHUNK_D;
-            const voxel& vox = chunk.voxels[vox_index(bx, by, bz)];
+            voxel vox = chunk.voxels.get(vox_index(bx, by, bz));
             auto& block = indices->blocks.require(vox.id);
             if (block.rt.funcsset.randupdate) {
                 scripting::random_update_block(
@@ -219,7 +228,7 @@ int64_t BlocksController::createBlockInventory(int x, int y, int z) {
     auto inv = chunk->getBlockInventory(lx, y, lz);
     if (inv == nullptr) {
         const auto& indices = level.content.getIndices()->blocks;
-        auto& def = indices.require(chunk->voxels[vox_index(lx, y, lz)].id);
+        auto& def = indices.require(chunk->voxels.get(vox_index(lx, y, lz)).id);
         int invsize = def.inventorySize;
         if (invsize == 0) {
             return 0;
@@ -1,15 +1,22 @@
 #include "ChunksController.hpp"
 
+#include <algorithm>
 #include <limits.h>
 #include <memory>
+#include <vector>
 
 #include "content/Content.hpp"
+#include "debug/Logger.hpp"
+#include "io/io.hpp"
+#include "world/files/RegionsIOService.hpp"
 #include "world/files/WorldFiles.hpp"
 #include "graphics/core/Mesh.hpp"
 #include "lighting/Lighting.hpp"
 #include "maths/voxmaths.hpp"
 #include "util/timeutil.hpp"
 #include "objects/Player.hpp"
+#include "objects/Players.hpp"
+#include "Pregenerator.hpp"
 #include "voxels/Block.hpp"
 #include "voxels/Chunk.hpp"
 #include "voxels/Chunks.hpp"
@@ -17,33 +24,122 @@
 #include "world/Level.hpp"
 #include "world/World.hpp"
 #include "world/generator/WorldGenerator.hpp"
+#include "world/generator/GeneratorDef.hpp"
+
+static debug::Logger logger("chunks-control");
 
 const uint MAX_WORK_PER_FRAME = 128;
 const uint MIN_SURROUNDING = 9;
 
-ChunksController::ChunksController(Level& level)
+ChunksController::ChunksController(Level& level, size_t prototypesCacheSize)
     : level(level),
       generator(std::make_unique<WorldGenerator>(
           level.content.generators.require(level.getWorld()->getGenerator()),
           level.content,
           level.getWorld()->getSeed()
-      )) {}
+      )),
+      regionsIO(std::make_unique<RegionsIOService>(
+          level.getWorld()->wfile->getRegions()
+      )) {
+    if (prototypesCacheSize == 0) {
+        return;
+    }
+    const auto& def =
+        level.content.generators.require(level.getWorld()->getGenerator());
+    // cached placements refer to structures and blocks by index
+    std::vector<std::string> structures;
+    for (const auto& structure : def.structures) {
+        structures.push_back(structure->meta.name);
+    }
+    const auto& blockDefs = level.content.getIndices()->blocks;
+    std::vector<std::string> blocks;
+    for (size_t i = 0; i < blockDefs.count(); i++) {
+        blocks.push_back(blockDefs.getDefs()[i]->name);
+    }
+    auto cache = std::make_unique<PrototypeCache>(
+        prototypesCacheSize,
+        level.getWorld()->getSeed(),
+        def.name,
+        def.version,
+        def.biomes.size(),
+        structures,
+        blocks
+    );
+    auto file = level.getWorld()->wfile->getPrototypesCacheFile();
+    if (io::is_regular_file(file)) {
+        try {
+            if (!cache->deserialize(io::read_bytes(file))) {
+                logger.info() << "prototypes cache is outdated";
+            }
+        } catch (const std::runtime_error& err) {
+            logger.error() << "could not load prototypes cache: "
+                           << err.what();
+        }
+    }
+    generator->setCache(std::move(cache));
+}
 
 ChunksController::~ChunksController() = default;
 
+void ChunksController::saveGeneratorCache() const {
+    auto cache = generator->getCache();
+    if (cache == nullptr || cache->size() == 0) {
+        return;
+    }
+    auto file = level.getWorld()->wfile->getPrototypesCacheFile();
+    auto bytes = cache->serialize();
+    if (!io::write_bytes(file, bytes.data(), bytes.size())) {
+        logger.error() << "could not write prototypes cache";
+    }
+}
+
+void ChunksController::pregenerate(
+    const glm::ivec2& min, const glm::ivec2& max
+) {
+    // release chunks of the previous pregeneration first
+    pregenerator = nullptr;
+    level.getWorld()->wfile->createDirectories();
+    pregenerator =
+        std::make_unique<Pregenerator>(level, *generator, *regionsIO, min, max);
+    logger.info() << "pregenerating chunks from " << min.x << ", " << min.y
+                  << " to " << max.x << ", " << max.y;
+}
+
+void ChunksController::updatePregeneration() {
+    if (pregenerator && !pregenerator->isFinished()) {
+        regionsIO->update();
+        pregenerator->update();
+    }
+}
+
+void ChunksController::waitForPregeneration() {
+    if (pregenerator) {
+        pregenerator->waitForTile();
+    }
+}
+
 void ChunksController::update(
     int64_t maxDuration, int loadDistance, uint padding, Player& player
 ) const {
     const auto& position = player.getPosition();
     int centerX = floordiv<CHUNK_W>(glm::floor(position.x));
     int centerY = floordiv<CHUNK_D>(glm::floor(position.z));
+
+    regionsIO->update();
     
+    // generator areas of removed players
+    for (auto areaId : generator->getAreas()) {
+        if (areaId != Pregenerator::AREA_ID &&
+            level.players->get(areaId) == nullptr) {
+            generator->removeArea(areaId);
+        }
+    }
     if (player.isLoadingChunks()) {
-        /// FIXME: one generator for multiple players
-        generator->update(centerX, centerY, loadDistance);
+        generator->update(player.getId(), centerX, centerY, loadDistance);
     } else {
         return;
     }
+    prefetch(player, centerX, centerY);
 
     int64_t mcstotal = 0;
 
@@ -76,16 +172,55 @@ bool ChunksController::isInLoadingZone(
     return distance < minDistance;
 }
 
+void ChunksController::prefetch(
+    const Player& player, int centerX, int centerZ
+) const {
+    if (regionsIO->isPrefetchCenter({centerX, centerZ})) {
+        return;
+    }
+    const auto& chunks = *player.chunks;
+    int sizeX = chunks.getWidth();
+    int sizeY = chunks.getHeight();
+    int offsetX = chunks.getOffsetX();
+    int offsetY = chunks.getOffsetY();
+    int maxDistance = ((sizeX) / 2) * ((sizeY) / 2);
+
+    std::vector<std::pair<int, glm::ivec2>> missing;
+    for (int z = 0; z < sizeY; z++) {
+        for (int x = 0; x < sizeX; x++) {
+            if (chunks.getChunks()[z * sizeX + x] != nullptr) {
+                continue;
+            }
+            int lx = x - sizeX / 2;
+            int lz = z - sizeY / 2;
+            int distance = (lx * lx + lz * lz);
+            if (distance < maxDistance) {
+                missing.push_back(
+                    {distance, glm::ivec2(x + offsetX, z + offsetY)}
+                );
+            }
+        }
+    }
+    std::sort(missing.begin(), missing.end(), [](auto& a, auto& b) {
+        return a.first < b.first;
+    });
+    std::vector<glm::ivec2> coords;
+    coords.reserve(missing.size());
+    for (const auto& [_, pos] : missing) {
+        coords.push_back(pos);
+    }
+    regionsIO->prefetch({centerX, centerZ}, coords);
+}
+
 bool ChunksController::loadVisible(const Player& player, uint padding) const {
     auto& chunks = *player.chunks;
     int sizeX = chunks.getWidth();
     int sizeY = chunks.getHeight();
 
-    int nearX = 0;
-    int nearZ = 0;
-    bool assigned = false;
     int minDistance = ((sizeX - padding * 2) / 2) * ((sizeY - padding * 2) / 2);
     int maxDistance = ((sizeX) / 2) * ((sizeY) / 2);
+    std::vector<Chunk*> unlit;
+    std::vector<std::pair<int, glm::ivec2>> missing;
     for (uint z = 0; z < sizeY; z++) {
         for (uint x = 0; x < sizeX; x++) {
             int index = z * sizeX + x;
@@ -111,77 +246,103 @@ bool ChunksController::loadVisible(const Player& player, uint padding) const {
             int distance = (lx * lx + lz * lz);
             auto& chunk = chunks.getChunks()[index];
             if (chunk != nullptr) {
-                if (chunk->flags.loaded && !chunk->flags.lighted) {
-                    if (buildLights(player, chunk)) {
-                        return true;
-                    }
+                if (chunk->flags.loaded && !chunk->flags.lighted &&
+                    isSurrounded(player, *chunk)) {
+                    unlit.push_back(chunk.get());
                 }
                 continue;
             }
 
             if (distance < minDistance) {
-                minDistance = distance;
-                nearX = x;
-                nearZ = z;
-                assigned = true;
+                missing.push_back({distance, glm::ivec2(x, z)});
             }
         }
     }
 
-    const auto& chunk = chunks.getChunks()[nearZ * sizeX + nearX];
-    if (chunk != nullptr || !assigned || !player.isLoadingChunks()) {
+    bool create = !missing.empty() && player.isLoadingChunks();
+    // chunks are lit in batches to be processed by multiple threads
+    size_t batchSize = lighting ? lighting->getThreadsCount() : 1;
+    if (unlit.size() >= batchSize || (!create && !unlit.empty())) {
+        buildLights(unlit);
+        return true;
+    }
+    if (!create) {
         return false;
     }
-    int offsetX = chunks.getOffsetX();
-    int offsetY = chunks.getOffsetY();
-    createChunk(player, nearX + offsetX, nearZ + offsetY);
+    // nearest chunks are generated simultaneously
+    size_t count =
+        std::min<size_t>(missing.size(), generator->getThreadsCount());
+    std::partial_sort(
+        missing.begin(), missing.begin() + count, missing.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; }
+    );
+    glm::ivec2 offset(chunks.getOffsetX(), chunks.getOffsetY());
+    std::vector<glm::ivec2> positions;
+    for (size_t i = 0; i < count; i++) {
+        positions.push_back(missing[i].second + offset);
+    }
+    createChunks(player, positions);
     return true;
 }
 
-bool ChunksController::buildLights(
-    const Player& player, const std::shared_ptr<Chunk>& chunk
+bool ChunksController::isSurrounded(
+    const Player& player, const Chunk& chunk
 ) const {
     int surrounding = 0;
     for (int oz = -1; oz <= 1; oz++) {
         for (int ox = -1; ox <= 1; ox++) {
-            if (player.chunks->getChunk(chunk->x + ox, chunk->z + oz))
+            if (player.chunks->getChunk(chunk.x + ox, chunk.z + oz))
                 surrounding++;
         }
     }
-    if (surrounding == MIN_SURROUNDING) {
-        if (lighting) {
-            bool lightsCache = chunk->flags.loadedLights;
-            if (!lightsCache) {
-                lighting->buildSkyLight(chunk->x, chunk->z);
-            }
-            lighting->onChunkLoaded(chunk->x, chunk->z, !lightsCache);
-        }
+    return surrounding == MIN_SURROUNDING;
+}
+
+void ChunksController::buildLights(const std::vector<Chunk*>& chunks) const {
+    if (lighting) {
+        lighting->onChunksLoaded(chunks);
+    }
+    for (Chunk* chunk : chunks) {
         chunk->flags.lighted = true;
-        return true;
     }
-    return false;
 }
 
-void ChunksController::createChunk(const Player& player, int x, int z) const {
+void ChunksController::createChunks(
+    const Player& player, const std::vector<glm::ivec2>& positions
+) const {
     if (!player.isLoadingChunks()) {
-        if (auto chunk = level.chunks->fetch(x, z)) {
-            player.chunks->putChunk(chunk);
+        for (const auto& pos : positions) {
+            if (auto chunk = level.chunks->fetch(pos.x, pos.y)) {
+                player.chunks->putChunk(chunk);
+            }
         }
         return;
     }
-    auto chunk = level.chunks->create(x, z);
-    player.chunks->putChunk(chunk);
-    auto& chunkFlags = chunk->flags;
-
-    if (!chunkFlags.loaded) {
-        generator->generate(chunk->voxels, x, z);
-        chunkFlags.unsaved = true;
+    std::vector<std::shared_ptr<Chunk>> created;
+    std::vector<ChunkGenTarget> targets;
+    for (const auto& pos : positions) {
+        auto chunk = level.chunks->create(pos.x, pos.y);
+        player.chunks->putChunk(chunk);
+        if (!chunk->flags.loaded) {
+            targets.push_back(
+                ChunkGenTarget {chunk->voxels.data(), pos.x, pos.y}
+            );
+            chunk->flags.unsaved = true;
+        }
+        created.push_back(std::move(chunk));
+    }
+    if (!targets.empty()) {
+        generator->generate(player.getId(), targets);
     }
-    chunk->updateHeights();
+    for (const auto& chunk : created) {
+        auto& chunkFlags = chunk->flags;
+        chunk->updateHeights();
+        chunk->updateSections(level.content.getIndices()->blocks.getDefs());
 
-    if (!chunkFlags.loadedLights) {
-        Lighting::prebuildSkyLight(*chunk, *level.content.getIndices());
+        if (!chunkFlags.loadedLights) {
+            Lighting::prebuildSkyLight(*chunk, *level.content.getIndices());
+        }
+        chunkFlags.loaded = true;
+        chunkFlags.ready = true;
     }
-    chunkFlags.loaded = true;
-    chunkFlags.ready = true;
 }
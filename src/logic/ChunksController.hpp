@@ -1,6 +1,9 @@
 #pragma once
 
 #include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
 
 #include "typedefs.hpp"
 
@@ -10,21 +13,38 @@ class Chunks;
 class Player;
 class Lighting;
 class WorldGenerator;
+class RegionsIOService;
+class Pregenerator;
 
 /// @brief ChunksController manages chunks dynamic loading/unloading
 class ChunksController {
 private:
     Level& level;
     std::unique_ptr<WorldGenerator> generator;
+    std::unique_ptr<RegionsIOService> regionsIO;
+    std::unique_ptr<Pregenerator> pregenerator;
 
     /// @brief Process one chunk: load it or calculate lights for it
     bool loadVisible(const Player& player, uint padding) const;
-    bool buildLights(const Player& player, const std::shared_ptr<Chunk>& chunk) const;
-    void createChunk(const Player& player, int x, int y) const;
+    /// @brief Request background reading of missing chunks in the player
+    /// chunks area, including the padding ring outside of the loading zone
+    void prefetch(const Player& player, int centerX, int centerZ) const;
+    /// @brief Check if all neighbours of the chunk are loaded
+    bool isSurrounded(const Player& player, const Chunk& chunk) const;
+    /// @brief Build lights of loaded chunks having all neighbours loaded
+    void buildLights(const std::vector<Chunk*>& chunks) const;
+    /// @brief Load or generate chunks. Generated chunks are processed
+    /// by multiple threads simultaneously
+    /// @param positions chunks coords
+    void createChunks(
+        const Player& player, const std::vector<glm::ivec2>& positions
+    ) const;
 public:
     std::unique_ptr<Lighting> lighting;
 
-    ChunksController(Level& level);
+    /// @param prototypesCacheSize max number of generated chunk prototypes
+    /// kept in the cache, 0 to disable the cache
+    ChunksController(Level& level, size_t prototypesCacheSize = 0);
     ~ChunksController();
 
     /// @param maxDuration milliseconds reserved for chunks loading
@@ -37,4 +57,24 @@ public:
     const WorldGenerator* getGenerator() const {
         return generator.get();
     }
+
+    /// @brief Write generated prototypes cache to the world folder
+    void saveGeneratorCache() const;
+
+    /// @brief Start generating, lighting and saving all chunks of the area
+    /// in background of level updates, replacing the current pregeneration
+    /// @param min area min chunk coords (inclusive)
+    /// @param max area max chunk coords (inclusive)
+    void pregenerate(const glm::ivec2& min, const glm::ivec2& max);
+
+    /// @brief Advance pregeneration if it is active
+    void updatePregeneration();
+
+    /// @brief Wait for the current pregeneration tile to be stored
+    void waitForPregeneration();
+
+    /// @return active or finished pregeneration or nullptr
+    const Pregenerator* getPregenerator() const {
+        return pregenerator.get();
+    }
 };
@@ -5,12 +5,15 @@
 #include "debug/Logger.hpp"
 #include "engine/Engine.hpp"
 #include "world/files/WorldFiles.hpp"
+#include "world/files/WorldSaver.hpp"
 #include "maths/voxmaths.hpp"
 #include "objects/Entities.hpp"
 #include "objects/Players.hpp"
 #include "objects/Player.hpp"
 #include "physics/Hitbox.hpp"
+#include "voxels/Chunk.hpp"
 #include "voxels/Chunks.hpp"
+#include "voxels/GlobalChunks.hpp"
 #include "scripting/scripting.hpp"
 #include "lighting/Lighting.hpp"
 #include "settings.hpp"
@@ -20,12 +23,17 @@
 
 static debug::Logger logger("level-control");
 
+/// @brief Seconds between chunks voxels compaction passes
+static constexpr float VOXELS_COMPACTION_INTERVAL = 5.0f;
+
 LevelController::LevelController(
     Engine* engine, std::unique_ptr<Level> levelPtr, Player* clientPlayer
 )
     : settings(engine->getSettings()),
       level(std::move(levelPtr)),
-      chunks(std::make_unique<ChunksController>(*level)),
+      chunks(std::make_unique<ChunksController>(
+          *level, settings.chunks.prototypesCache.get()
+      )),
       playerTickClock(20, 3) {
     
     level->events->listen(LevelEventType::CHUNK_PRESENT, [](auto, Chunk* chunk) {
@@ -68,7 +76,19 @@ LevelController::LevelController(
     } while (confirmed < level->players->size());
 }
 
+LevelController::~LevelController() {
+    if (saver) {
+        saver->waitForEnd();
+    }
+}
+
 void LevelController::update(float delta, bool pause) {
+    if (saver) {
+        saver->update();
+        if (!saver->isActive()) {
+            saver = nullptr;
+        }
+    }
     for (const auto& [_, player] : *level->players) {
         if (player->isSuspended()) {
             continue;
@@ -88,6 +108,10 @@ void LevelController::update(float delta, bool pause) {
             *player
         );
     }
+    // region files are not written by pregeneration while saving
+    if (saver == nullptr) {
+        chunks->updatePregeneration();
+    }
     if (!pause) {
         // update all objects that needed
         blocks->update(delta, settings.chunks.padding.get());
@@ -116,6 +140,26 @@ void LevelController::update(float delta, bool pause) {
         }
     }
     level->entities->clean();
+    updateVoxelsCompaction(delta);
+}
+
+void LevelController::updateVoxelsCompaction(float delta) {
+    if (!settings.chunks.compactVoxels.get()) {
+        if (voxelsCompacted) {
+            level->chunks->expandVoxels();
+            voxelsCompacted = false;
+        }
+        return;
+    }
+    compactionTimer += delta;
+    if (compactionTimer < VOXELS_COMPACTION_INTERVAL) {
+        return;
+    }
+    compactionTimer = 0.0f;
+    voxelsCompacted = true;
+    size_t count = level->chunks->compactVoxels();
+    logger.debug() << count << " of " << level->chunks->size()
+                   << " chunks have compact voxels";
 }
 
 void LevelController::saveWorld() {
@@ -124,11 +168,59 @@ void LevelController::saveWorld() {
         logger.info() << "nameless world will not be saved";
         return;
     }
+    if (saver) {
+        saver->waitForEnd();
+        saver = nullptr;
+    }
     logger.info() << "writing world '" << world->getName() << "'";
+    chunks->waitForPregeneration();
     world->wfile->createDirectories();
     scripting::on_world_save();
     level->onSave();
     level->getWorld()->write(level.get());
+    chunks->saveGeneratorCache();
+}
+
+void LevelController::saveWorldAsync() {
+    auto world = level->getWorld();
+    if (world->isNameless()) {
+        logger.info() << "nameless world will not be saved";
+        return;
+    }
+    if (saver) {
+        logger.info() << "world saving is already in progress";
+        return;
+    }
+    logger.info() << "saving world '" << world->getName() << "' in background";
+    chunks->waitForPregeneration();
+    world->wfile->createDirectories();
+    scripting::on_world_save();
+    level->onSave();
+    auto snapshots = level->chunks->snapshotAll();
+    world->writeMetadata(level.get());
+    chunks->saveGeneratorCache();
+    saver = std::make_unique<WorldSaver>(
+        world->wfile->getRegions(),
+        std::move(snapshots),
+        [this](ChunkSnapshot& snapshot) {
+            // chunk changes will be saved next time
+            if (auto chunk = level->chunks->getChunk(snapshot.x, snapshot.z)) {
+                chunk->flags.unsaved = true;
+                return;
+            }
+            // chunk is unloaded already, so the snapshot is the only copy
+            try {
+                level->getWorld()->wfile->getRegions().put(snapshot);
+            } catch (const std::exception& err) {
+                logger.error() << "could not store chunk " << snapshot.x
+                               << "_" << snapshot.z << ": " << err.what();
+            }
+        }
+    );
+}
+
+const WorldSaver* LevelController::getWorldSaver() const {
+    return saver.get();
 }
 
 void LevelController::onWorldQuit() {
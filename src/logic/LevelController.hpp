@@ -9,6 +9,7 @@
 class Engine;
 class Level;
 class Player;
+class WorldSaver;
 struct EngineSettings;
 
 /// @brief LevelController manages other controllers
@@ -18,17 +19,35 @@ class LevelController {
     // Sub-controllers
     std::unique_ptr<BlocksController> blocks;
     std::unique_ptr<ChunksController> chunks;
+    /// @brief Background world saving task (see saveWorldAsync)
+    std::unique_ptr<WorldSaver> saver;
 
     util::Clock playerTickClock;
+    /// @brief Time elapsed since the last chunks voxels compaction
+    float compactionTimer = 0.0f;
+    bool voxelsCompacted = false;
+
+    void updateVoxelsCompaction(float delta);
 public:
     LevelController(Engine* engine, std::unique_ptr<Level> level, Player* clientPlayer);
+    ~LevelController();
 
     /// @param delta time elapsed since the last update
     /// @param pause is world and player simulation paused
     void update(float delta, bool pause);
 
+    /// @brief Save world waiting for all data written
     void saveWorld();
 
+    /// @brief Save world in background. Chunks data is copied in the
+    /// current thread, then compressed and written by worker threads.
+    /// Does nothing if background saving is already in progress
+    void saveWorldAsync();
+
+    /// @return background world saving task or nullptr if saving is not
+    /// in progress
+    const WorldSaver* getWorldSaver() const;
+
     void onWorldQuit();
 
     Level* getLevel();
@@ -0,0 +1,436 @@
+#include "Pregenerator.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "content/Content.hpp"
+#include "data/dv_util.hpp"
+#include "debug/Logger.hpp"
+#include "io/io.hpp"
+#include "lighting/Lighting.hpp"
+#include "util/ThreadPool.hpp"
+#include "util/timeutil.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/Chunks.hpp"
+#include "voxels/GlobalChunks.hpp"
+#include "world/files/RegionsIOService.hpp"
+#include "world/files/WorldFiles.hpp"
+#include "world/files/WorldRegions.hpp"
+#include "world/generator/WorldGenerator.hpp"
+#include "world/Level.hpp"
+#include "world/World.hpp"
+
+static debug::Logger logger("pregenerator");
+
+static inline constexpr int TILE_SIZE = PregenTiles::TILE_SIZE;
+static inline constexpr int WINDOW_SIZE = TILE_SIZE + 2;
+/// @brief Max number of chunks generated per update, so level updates
+/// are not stalled by the whole tile generation
+static inline constexpr size_t GENERATE_BATCH = WINDOW_SIZE;
+
+PregenTiles::PregenTiles(const glm::ivec2& a, const glm::ivec2& b)
+    : areaMin(glm::min(a, b)), areaMax(glm::max(a, b)) {
+    glm::ivec2 size = areaMax - areaMin + 1;
+    tilesX = (size.x + TILE_SIZE - 1) / TILE_SIZE;
+    tilesZ = (size.y + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+void PregenTiles::getTile(int index, glm::ivec2& min, glm::ivec2& max) const {
+    min = areaMin + glm::ivec2(index % tilesX, index / tilesX) * TILE_SIZE;
+    max = glm::min(min + TILE_SIZE - 1, areaMax);
+}
+
+size_t PregenTiles::countChunks(int tiles) const {
+    size_t count = 0;
+    for (int i = 0; i < tiles; i++) {
+        glm::ivec2 min, max;
+        getTile(i, min, max);
+        glm::ivec2 size = max - min + 1;
+        count += size.x * size.y;
+    }
+    return count;
+}
+
+struct Pregenerator::Tile {
+    enum class Stage {
+        /// @brief Waiting for stored window chunks reading (main thread)
+        READ,
+        /// @brief Generation of missing window chunks (main thread)
+        GENERATE,
+        /// @brief Lighting (worker)
+        LIGHT,
+        /// @brief Storing snapshots and writing regions (worker)
+        STORE,
+    };
+    Stage stage = Stage::READ;
+    int index = 0;
+    glm::ivec2 min {};
+    glm::ivec2 max {};
+    /// @brief Window chunks not kept from the previous tile. Only missing
+    /// chunks are left when the tile is prepared
+    std::vector<glm::ivec2> positions;
+    /// @brief Window chunks existing in the world: stored in regions or
+    /// loaded by players. They are used by lighting only
+    std::vector<std::shared_ptr<Chunk>> existing;
+    /// @brief Generated window chunks, in order of positions
+    std::vector<std::shared_ptr<Chunk>> generated;
+    /// @brief Generated tile chunks to be stored
+    std::vector<std::unique_ptr<ChunkSnapshot>> snapshots;
+    timeutil::Timer timer;
+    size_t chunksGenerated = 0;
+    double generationTime = 0.0;
+    double lightingTime = 0.0;
+    double savingTime = 0.0;
+    uint64_t bytesWritten = 0;
+};
+
+class Pregenerator::Worker : public util::Worker<TilePtr, TilePtr> {
+    Pregenerator& pregenerator;
+public:
+    Worker(Pregenerator& pregenerator) : pregenerator(pregenerator) {
+    }
+
+    TilePtr operator()(const TilePtr& tile) override {
+        if (tile->stage == Tile::Stage::LIGHT) {
+            pregenerator.lightTile(*tile);
+        } else {
+            pregenerator.storeTile(*tile);
+        }
+        return tile;
+    }
+};
+
+Pregenerator::Pregenerator(
+    Level& level,
+    WorldGenerator& generator,
+    RegionsIOService& regionsIO,
+    const glm::ivec2& a,
+    const glm::ivec2& b
+)
+    : level(level), generator(generator), regionsIO(regionsIO), tiles(a, b) {
+    glm::ivec2 size = tiles.getAreaMax() - tiles.getAreaMin() + 1;
+    stats.chunksTotal = static_cast<size_t>(size.x) * size.y;
+
+    // window chunks are not shared with the level
+    window = std::make_unique<Chunks>(
+        WINDOW_SIZE, WINDOW_SIZE, 0, 0, nullptr, *level.content.getIndices()
+    );
+    lighting = std::make_unique<Lighting>(level.content, *window);
+    pool = std::make_unique<util::ThreadPool<TilePtr, TilePtr>>(
+        "pregenerator",
+        [this]() { return std::make_shared<Worker>(*this); },
+        [this](TilePtr& tile) {
+            if (tile->stage == Tile::Stage::LIGHT) {
+                onTileLit(*tile);
+            } else {
+                onTileStored(*tile);
+            }
+        },
+        1
+    );
+    loadProgress();
+}
+
+Pregenerator::~Pregenerator() {
+    generator.removeArea(AREA_ID);
+}
+
+void Pregenerator::loadProgress() {
+    auto file = level.getWorld()->wfile->getPregenerationFile();
+    if (!io::is_regular_file(file)) {
+        return;
+    }
+    auto root = io::read_json(file);
+    glm::ivec2 min {}, max {};
+    dv::get_vec(root, "min", min);
+    dv::get_vec(root, "max", max);
+    if (min != tiles.getAreaMin() || max != tiles.getAreaMax()) {
+        return;
+    }
+    int tile = 0;
+    root.at("tile").get(tile);
+    nextTile = std::clamp(tile, 0, tiles.count());
+    stats.chunksDone = tiles.countChunks(nextTile);
+    logger.info() << "resuming pregeneration at " << stats.chunksDone << "/"
+                  << stats.chunksTotal << " chunks";
+}
+
+void Pregenerator::saveProgress() const {
+    auto file = level.getWorld()->wfile->getPregenerationFile();
+    if (isFinished()) {
+        io::remove(file);
+        return;
+    }
+    auto root = dv::object();
+    root["min"] = dv::to_value(tiles.getAreaMin());
+    root["max"] = dv::to_value(tiles.getAreaMax());
+    root["tile"] = nextTile;
+    io::write_json(file, root);
+}
+
+void Pregenerator::startTile() {
+    current = std::make_shared<Tile>();
+    auto& tile = *current;
+    tile.index = nextTile;
+    tiles.getTile(nextTile, tile.min, tile.max);
+
+    glm::ivec2 windowMin = tile.min - 1;
+    glm::ivec2 windowMax = tile.max + 1;
+    for (int z = windowMin.y; z <= windowMax.y; z++) {
+        for (int x = windowMin.x; x <= windowMax.x; x++) {
+            if (windowArea && x >= windowArea->first.x &&
+                z >= windowArea->first.y && x <= windowArea->second.x &&
+                z <= windowArea->second.y) {
+                continue;
+            }
+            tile.positions.emplace_back(x, z);
+            if (level.chunks->fetch(x, z) == nullptr) {
+                // chunks data is read from disk in background
+                regionsIO.request(x, z);
+            }
+        }
+    }
+}
+
+/// @brief Load stored chunk voxels and lights from in-memory regions
+static std::shared_ptr<Chunk> load_chunk(
+    WorldRegions& regions, const ContentIndices& indices, int x, int z
+) {
+    auto data = regions.getVoxels(x, z);
+    if (data == nullptr) {
+        return nullptr;
+    }
+    auto chunk = std::make_shared<Chunk>(x, z);
+    chunk->decode(data.get());
+    blockid_t defsCount = indices.blocks.count();
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        if (chunk->voxels.get(i).id >= defsCount) {
+            chunk->voxels[i].id = BLOCK_AIR;
+        }
+    }
+    if (auto lights = regions.getLights(x, z)) {
+        chunk->lightmap.set(lights.get());
+        chunk->flags.loadedLights = true;
+    }
+    return chunk;
+}
+
+void Pregenerator::prepareTile() {
+    auto& tile = *current;
+    const auto& indices = *level.content.getIndices();
+    auto& regions = level.getWorld()->wfile->getRegions();
+    std::vector<glm::ivec2> missing;
+    for (const auto& pos : tile.positions) {
+        std::shared_ptr<Chunk> chunk;
+        auto levelChunk = level.chunks->fetch(pos.x, pos.y);
+        if (levelChunk && levelChunk->flags.loaded) {
+            // copy of the chunk used by players
+            chunk = std::make_shared<Chunk>(pos.x, pos.y);
+            chunk->decode(levelChunk->encode().get());
+            chunk->lightmap.set(&levelChunk->lightmap);
+        } else if (levelChunk == nullptr) {
+            chunk = load_chunk(regions, indices, pos.x, pos.y);
+        }
+        if (chunk) {
+            // existing chunks are not lit and stored again
+            chunk->flags.loaded = true;
+            chunk->flags.lighted = true;
+            tile.existing.push_back(std::move(chunk));
+        } else {
+            missing.push_back(pos);
+        }
+    }
+    tile.positions = std::move(missing);
+    windowArea = {tile.min - 1, tile.max + 1};
+
+    glm::ivec2 center = tile.min - 1 + WINDOW_SIZE / 2;
+    generator.update(AREA_ID, center.x, center.y, WINDOW_SIZE / 2 + 1);
+    tile.stage = Tile::Stage::GENERATE;
+}
+
+void Pregenerator::generateChunks() {
+    auto& tile = *current;
+    timeutil::Timer timer;
+    size_t end = std::min(
+        tile.positions.size(), tile.generated.size() + GENERATE_BATCH
+    );
+    std::vector<ChunkGenTarget> targets;
+    for (size_t i = tile.generated.size(); i < end; i++) {
+        const auto& pos = tile.positions[i];
+        auto chunk = std::make_shared<Chunk>(pos.x, pos.y);
+        targets.push_back(ChunkGenTarget {chunk->voxels.data(), pos.x, pos.y});
+        chunk->flags.unsaved = true;
+        tile.generated.push_back(std::move(chunk));
+    }
+    if (!targets.empty()) {
+        generator.generate(AREA_ID, targets);
+    }
+    tile.generationTime += timer.stop() / 1e6;
+    if (tile.generated.size() < tile.positions.size()) {
+        return;
+    }
+    tile.chunksGenerated = tile.generated.size();
+    tile.positions.clear();
+    tile.stage = Tile::Stage::LIGHT;
+    pool->enqueueJob(current);
+}
+
+void Pregenerator::lightTile(Tile& tile) {
+    const auto& indices = *level.content.getIndices();
+    glm::ivec2 center = tile.min - 1 + WINDOW_SIZE / 2;
+    // chunks of the previous tile out of the window are released here
+    window->setCenter(center.x * CHUNK_W, center.y * CHUNK_D);
+
+    timeutil::Timer timer;
+    std::vector<Chunk*> prepared;
+    for (auto& chunk : tile.existing) {
+        prepared.push_back(chunk.get());
+        window->putChunk(std::move(chunk));
+    }
+    tile.existing.clear();
+    for (auto& chunk : tile.generated) {
+        prepared.push_back(chunk.get());
+        window->putChunk(std::move(chunk));
+    }
+    tile.generated.clear();
+    for (auto chunk : prepared) {
+        chunk->updateHeights();
+        chunk->updateSections(indices.blocks.getDefs());
+        if (!chunk->flags.loadedLights && !chunk->flags.lighted) {
+            Lighting::prebuildSkyLight(*chunk, indices);
+        }
+        chunk->flags.loaded = true;
+        chunk->flags.ready = true;
+    }
+    tile.generationTime += timer.stop() / 1e6;
+
+    timer = {};
+    std::vector<Chunk*> unlit;
+    for (int z = tile.min.y; z <= tile.max.y; z++) {
+        for (int x = tile.min.x; x <= tile.max.x; x++) {
+            auto chunk = window->getChunk(x, z);
+            if (chunk && !chunk->flags.lighted) {
+                unlit.push_back(chunk);
+            }
+        }
+    }
+    lighting->onChunksLoaded(unlit);
+    for (auto chunk : unlit) {
+        chunk->flags.lighted = true;
+    }
+    tile.lightingTime = timer.stop() / 1e6;
+
+    timer = {};
+    auto& regions = level.getWorld()->wfile->getRegions();
+    for (auto chunk : unlit) {
+        if (auto snapshot = regions.snapshot(chunk, {})) {
+            // chunk may be loaded, changed and stored by the level until
+            // the snapshot is put
+            snapshot->replace = false;
+            tile.snapshots.push_back(std::move(snapshot));
+        }
+        // lights are stored, chunk will not be stored again
+        chunk->flags.unsaved = false;
+        chunk->flags.loadedLights = true;
+    }
+    tile.savingTime = timer.stop() / 1e6;
+}
+
+void Pregenerator::onTileLit(Tile& tile) {
+    // chunks loaded by players meanwhile are stored by the level
+    auto& snapshots = tile.snapshots;
+    snapshots.erase(
+        std::remove_if(
+            snapshots.begin(),
+            snapshots.end(),
+            [this](const auto& snapshot) {
+                return level.chunks->fetch(snapshot->x, snapshot->z) != nullptr;
+            }
+        ),
+        snapshots.end()
+    );
+    tile.stage = Tile::Stage::STORE;
+    pool->enqueueJob(current);
+}
+
+void Pregenerator::storeTile(Tile& tile) {
+    timeutil::Timer timer;
+    auto& regions = level.getWorld()->wfile->getRegions();
+    uint64_t bytesWritten = regions.getBytesWritten();
+    for (auto& snapshot : tile.snapshots) {
+        regions.put(*snapshot);
+    }
+    tile.snapshots.clear();
+    regions.writeAll();
+    tile.bytesWritten = regions.getBytesWritten() - bytesWritten;
+    tile.savingTime += timer.stop() / 1e6;
+}
+
+void Pregenerator::onTileStored(Tile& tile) {
+    nextTile = tile.index + 1;
+    saveProgress();
+
+    glm::ivec2 size = tile.max - tile.min + 1;
+    stats.chunksDone += size.x * size.y;
+    stats.chunksProcessed += size.x * size.y;
+    stats.chunksGenerated += tile.chunksGenerated;
+    stats.generationTime += tile.generationTime;
+    stats.lightingTime += tile.lightingTime;
+    stats.savingTime += tile.savingTime;
+    stats.bytesWritten += tile.bytesWritten;
+    stats.elapsedTime += tile.timer.stop() / 1e6;
+
+    logger.info() << "pregenerated " << stats.chunksDone << "/"
+                  << stats.chunksTotal << " chunks ("
+                  << stats.getChunksPerSecond() << " chunks/s)";
+    if (isFinished()) {
+        logger.info() << "pregeneration finished in " << stats.elapsedTime
+                      << " s: generation " << stats.generationTime
+                      << " s, lighting " << stats.lightingTime
+                      << " s, saving " << stats.savingTime << " s, "
+                      << stats.bytesWritten << " bytes written";
+        // worker is idle, so its data may be released here
+        window->saveAndClear();
+        generator.removeArea(AREA_ID);
+    }
+    current = nullptr;
+}
+
+bool Pregenerator::update() {
+    if (isFinished()) {
+        return false;
+    }
+    pool->update();
+    if (isFinished()) {
+        return false;
+    }
+    if (current == nullptr) {
+        startTile();
+    }
+    if (current->stage == Tile::Stage::READ) {
+        for (const auto& pos : current->positions) {
+            if (regionsIO.isPending(pos.x, pos.y)) {
+                return true;
+            }
+        }
+        prepareTile();
+    }
+    if (current->stage == Tile::Stage::GENERATE) {
+        generateChunks();
+    }
+    return true;
+}
+
+void Pregenerator::waitForTile() {
+    while (current && (current->stage == Tile::Stage::LIGHT ||
+                       current->stage == Tile::Stage::STORE)) {
+        std::this_thread::yield();
+        pool->update();
+    }
+}
+
+bool Pregenerator::isFinished() const {
+    return nextTile >= tiles.count();
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+
+#include <glm/glm.hpp>
+
+#include "typedefs.hpp"
+
+class Level;
+class Chunk;
+class Chunks;
+class Lighting;
+class WorldGenerator;
+class RegionsIOService;
+
+namespace util {
+    template <class T, class R>
+    class ThreadPool;
+}
+
+/// @brief Pregeneration progress and throughput stats
+struct PregenStats {
+    /// @brief Number of chunks in the area
+    size_t chunksTotal = 0;
+    /// @brief Number of processed chunks, including processed before resume
+    size_t chunksDone = 0;
+    /// @brief Number of chunks processed since start or resume
+    size_t chunksProcessed = 0;
+    /// @brief Number of generated (not loaded from regions) chunks
+    size_t chunksGenerated = 0;
+    /// @brief Seconds spent on chunks generation
+    double generationTime = 0.0;
+    /// @brief Seconds spent on lights building
+    double lightingTime = 0.0;
+    /// @brief Seconds spent on chunks saving and region files writing
+    double savingTime = 0.0;
+    /// @brief Total seconds spent on pregeneration
+    double elapsedTime = 0.0;
+    /// @brief Number of bytes written to region files
+    uint64_t bytesWritten = 0;
+
+    double getChunksPerSecond() const {
+        return elapsedTime > 0.0 ? chunksProcessed / elapsedTime : 0.0;
+    }
+};
+
+/// @brief Rectangular chunks area split to square tiles, indexed row by row
+class PregenTiles {
+    /// @brief Area min chunk coords (inclusive)
+    glm::ivec2 areaMin;
+    /// @brief Area max chunk coords (inclusive)
+    glm::ivec2 areaMax;
+    int tilesX;
+    int tilesZ;
+public:
+    /// @brief Tile side in chunks
+    static inline constexpr int TILE_SIZE = 16;
+
+    /// @param a area corner chunk coords (inclusive)
+    /// @param b opposite area corner chunk coords (inclusive)
+    PregenTiles(const glm::ivec2& a, const glm::ivec2& b);
+
+    /// @brief Get chunks range of the tile clipped by the area
+    /// @param index tile index
+    /// @param min tile min chunk coords (inclusive)
+    /// @param max tile max chunk coords (inclusive)
+    void getTile(int index, glm::ivec2& min, glm::ivec2& max) const;
+
+    /// @return number of chunks in the first tiles
+    /// @param tiles number of tiles
+    size_t countChunks(int tiles) const;
+
+    int count() const {
+        return tilesX * tilesZ;
+    }
+
+    const glm::ivec2& getAreaMin() const {
+        return areaMin;
+    }
+
+    const glm::ivec2& getAreaMax() const {
+        return areaMax;
+    }
+};
+
+/// @brief Generates, lights and saves all chunks of a rectangular area
+/// without players, tile by tile. The main thread requests stored chunks
+/// reading from the regions IO service, decodes chunks required around
+/// the tile, generates missing chunks with the level generator a batch per
+/// update and commits the progress. Tiles are lit and stored to regions
+/// by a background worker. Generated chunks do not replace chunks stored
+/// by the level meanwhile. Progress is written to the world folder after
+/// every stored tile, so interrupted pregeneration of the same area
+/// continues from the last stored tile
+class Pregenerator {
+    struct Tile;
+    class Worker;
+    using TilePtr = std::shared_ptr<Tile>;
+
+    Level& level;
+    /// @brief Level generator, used by the main thread only
+    WorldGenerator& generator;
+    RegionsIOService& regionsIO;
+    PregenTiles tiles;
+    int nextTile = 0;
+    PregenStats stats;
+    /// @brief Tile with a ring of neighbour chunks required to build lights.
+    /// Used by the worker thread only
+    std::unique_ptr<Chunks> window;
+    std::unique_ptr<Lighting> lighting;
+    /// @brief Chunks range of the window after the last enqueued tile.
+    /// Chunks in the range are kept by the window for the next tile
+    std::optional<std::pair<glm::ivec2, glm::ivec2>> windowArea;
+    /// @brief Tile in progress or nullptr
+    TilePtr current;
+    std::unique_ptr<util::ThreadPool<TilePtr, TilePtr>> pool;
+
+    /// @brief Request reading of window chunks stored in regions
+    void startTile();
+    /// @brief Create window chunks already existing in the world and
+    /// start generation of the missing ones
+    void prepareTile();
+    /// @brief Generate the next batch of missing window chunks, passing
+    /// the tile to the worker when all chunks are generated
+    void generateChunks();
+    /// @brief Light the tile, taking snapshots of the tile chunks
+    /// (worker thread)
+    void lightTile(Tile& tile);
+    /// @brief Put tile snapshots to regions and write regions
+    /// (worker thread)
+    void storeTile(Tile& tile);
+    /// @brief Drop snapshots of chunks loaded by players and pass the
+    /// tile to the worker to be stored
+    void onTileLit(Tile& tile);
+    /// @brief Update stats and write the progress
+    void onTileStored(Tile& tile);
+    void loadProgress();
+    void saveProgress() const;
+public:
+    /// @brief Generator loading area id used by pregeneration
+    static inline constexpr int64_t AREA_ID = -1;
+
+    /// @param generator level generator
+    /// @param areaMin area min chunk coords (inclusive)
+    /// @param areaMax area max chunk coords (inclusive)
+    Pregenerator(
+        Level& level,
+        WorldGenerator& generator,
+        RegionsIOService& regionsIO,
+        const glm::ivec2& areaMin,
+        const glm::ivec2& areaMax
+    );
+    ~Pregenerator();
+
+    /// @brief Advance the current tile processing, integrating finished
+    /// worker results. Generates a batch of chunks at most. Does not wait
+    /// for the worker
+    /// @return false if the area is complete
+    bool update();
+
+    /// @brief Wait for the worker to finish the current tile, so region
+    /// files are not written by pregeneration until the next update
+    void waitForTile();
+
+    bool isFinished() const;
+
+    const PregenStats& getStats() const {
+        return stats;
+    }
+
+    const glm::ivec2& getAreaMin() const {
+        return tiles.getAreaMin();
+    }
+
+    const glm::ivec2& getAreaMax() const {
+        return tiles.getAreaMax();
+    }
+};
@@ -76,18 +76,24 @@ static int l_is_segment(lua::State* L) {
     auto x = lua::tointeger(L, 1);
     auto y = lua::tointeger(L, 2);
     auto z = lua::tointeger(L, 3);
-    const auto& vox = blocks_agent::require(*level->chunks, x, y, z);
-    return lua::pushboolean(L, vox.state.segment);
+    auto vox = blocks_agent::peek(*level->chunks, x, y, z);
+    if (!vox) {
+        throw std::runtime_error("voxel does not exist");
+    }
+    return lua::pushboolean(L, vox->state.segment);
 }
 
 static int l_seek_origin(lua::State* L) {
     auto x = lua::tointeger(L, 1);
     auto y = lua::tointeger(L, 2);
     auto z = lua::tointeger(L, 3);
-    const auto& vox = blocks_agent::require(*level->chunks, x, y, z);
-    auto& def = indices->blocks.require(vox.id);
+    auto vox = blocks_agent::peek(*level->chunks, x, y, z);
+    if (!vox) {
+        throw std::runtime_error("voxel does not exist");
+    }
+    auto& def = indices->blocks.require(vox->id);
     return lua::pushivec_stack(
-        L, blocks_agent::seek_origin(*level->chunks, {x, y, z}, def, vox.state)
+        L, blocks_agent::seek_origin(*level->chunks, {x, y, z}, def, vox->state)
     );
 }
 
@@ -122,12 +128,35 @@ static int l_set(lua::State* L) {
     return 0;
 }
 
+static int l_batch(lua::State* L) {
+    Lighting* lighting = nullptr;
+    if (auto chunksController = controller->getChunksController()) {
+        lighting = chunksController->lighting.get();
+    }
+    if (lighting) {
+        lighting->beginBatch();
+    }
+    try {
+        lua::pushvalue(L, 1);
+        lua::call(L, 0, 0);
+    } catch (...) {
+        if (lighting) {
+            lighting->endBatch();
+        }
+        throw;
+    }
+    if (lighting) {
+        lighting->endBatch();
+    }
+    return 0;
+}
+
 static int l_get(lua::State* L) {
     auto x = lua::tointeger(L, 1);
     auto y = lua::tointeger(L, 2);
     auto z = lua::tointeger(L, 3);
-    auto vox = blocks_agent::get(*level->chunks, x, y, z);
-    int id = vox == nullptr ? -1 : vox->id;
+    auto vox = blocks_agent::peek(*level->chunks, x, y, z);
+    int id = vox ? vox->id : -1;
     return lua::pushinteger(L, id);
 }
 
@@ -150,8 +179,8 @@ static int get_axis(lua::State* L) {
     glm::ivec3 defAxis {};
     defAxis[n] = 1;
 
-    auto vox = blocks_agent::get(*level->chunks, x, y, z);
-    if (vox == nullptr) {
+    auto vox = blocks_agent::peek(*level->chunks, x, y, z);
+    if (!vox) {
         return lua::pushivec_stack(L, defAxis);
     }
     const auto& def = level->content.getIndices()->blocks.require(vox->id);
@@ -178,8 +207,8 @@ static int l_get_rotation(lua::State* L) {
     auto x = lua::tointeger(L, 1);
     auto y = lua::tointeger(L, 2);
     auto z = lua::tointeger(L, 3);
-    auto vox = blocks_agent::get(*level->chunks, x, y, z);
-    int rotation = vox == nullptr ? 0 : vox->state.rotation;
+    auto vox = blocks_agent::peek(*level->chunks, x, y, z);
+    int rotation = vox ? vox->state.rotation : 0;
     return lua::pushinteger(L, rotation);
 }
 
@@ -196,8 +225,8 @@ static int l_get_states(lua::State* L) {
     auto x = lua::tointeger(L, 1);
     auto y = lua::tointeger(L, 2);
     auto z = lua::tointeger(L, 3);
-    auto vox = blocks_agent::get(*level->chunks, x, y, z);
-    int states = vox == nullptr ? 0 : blockstate2int(vox->state);
+    auto vox = blocks_agent::peek(*level->chunks, x, y, z);
+    int states = vox ? blockstate2int(vox->state) : 0;
     return lua::pushinteger(L, states);
 }
 
@@ -218,7 +247,7 @@ static int l_set_states(lua::State* L) {
     int lx = x - cx * CHUNK_W;
     int lz = z - cz * CHUNK_D;
     chunk->voxels[vox_index(lx, y, lz)].state = int2blockstate(states);
-    chunk->setModifiedAndUnsaved();
+    chunk->setModifiedAndUnsaved(y);
     return 0;
 }
 
@@ -230,8 +259,8 @@ static int l_get_user_bits(lua::State* L) {
     auto offset = lua::tointeger(L, 4) + VOXEL_USER_BITS_OFFSET;
     auto bits = lua::tointeger(L, 5);
 
-    auto vox = blocks_agent::get(*level->chunks, x, y, z);
-    if (vox == nullptr) {
+    auto vox = blocks_agent::peek(*level->chunks, x, y, z);
+    if (!vox) {
         return lua::pushinteger(L, 0);
     }
     const auto& def = content->getIndices()->blocks.require(vox->id);
@@ -239,8 +268,8 @@ static int l_get_user_bits(lua::State* L) {
         auto origin = blocks_agent::seek_origin(
             *level->chunks, {x, y, z}, def, vox->state
         );
-        vox = blocks_agent::get(*level->chunks, origin.x, origin.y, origin.z);
-        if (vox == nullptr) {
+        vox = blocks_agent::peek(*level->chunks, origin.x, origin.y, origin.z);
+        if (!vox) {
             return lua::pushinteger(L, 0);
         }
     }
@@ -253,8 +282,8 @@ static int l_get_variant(lua::State* L) {
     auto y = lua::tointeger(L, 2);
     auto z = lua::tointeger(L, 3);
 
-    auto vox = blocks_agent::get(*level->chunks, x, y, z);
-    if (vox == nullptr) {
+    auto vox = blocks_agent::peek(*level->chunks, x, y, z);
+    if (!vox) {
         return lua::pushinteger(L, 0);
     }
     const auto& def = content->getIndices()->blocks.require(vox->id);
@@ -417,7 +446,7 @@ static int l_place(lua::State* L) {
     if (static_cast<size_t>(id) >= indices->blocks.count()) {
         return 0;
     }
-    if (!blocks_agent::get(*level->chunks, x, y, z)) {
+    if (!blocks_agent::peek(*level->chunks, x, y, z)) {
         return 0;
     }
     const auto def = level->content.getIndices()->blocks.get(id);
@@ -438,8 +467,8 @@ static int l_destruct(lua::State* L) {
     auto y = lua::tointeger(L, 2);
     auto z = lua::tointeger(L, 3);
     auto playerid = lua::gettop(L) >= 4 ? lua::tointeger(L, 4) : -1;
-    auto vox = blocks_agent::get(*level->chunks, x, y, z);
-    if (vox == nullptr) {
+    auto vox = blocks_agent::peek(*level->chunks, x, y, z);
+    if (!vox) {
         return 0;
     }
     auto& def = level->content.getIndices()->blocks.require(vox->id);
@@ -584,7 +613,7 @@ static int l_get_field(lua::State* L) {
     auto lz = z - cz * CHUNK_W;
     size_t voxelIndex = vox_index(lx, y, lz);
 
-    const auto& vox = chunk->voxels[voxelIndex];
+    voxel vox = chunk->voxels.get(voxelIndex);
     const auto& def = content->getIndices()->blocks.require(vox.id);
     if (def.dataStruct == nullptr) {
         return 0;
@@ -653,7 +682,7 @@ static int l_set_field(lua::State* L) {
         return 0;
     }
     size_t voxelIndex = vox_index(lx, y, lz);
-    const auto& vox = chunk->voxels[voxelIndex];
+    voxel vox = chunk->voxels.get(voxelIndex);
 
     const auto& def = content->getIndices()->blocks.require(vox.id);
     if (def.dataStruct == nullptr) {
@@ -697,6 +726,7 @@ const luaL_Reg blocklib[] = {
     {"is_solid_at", lua::wrap<l_is_solid_at>},
     {"is_replaceable_at", lua::wrap<l_is_replaceable_at>},
     {"set", lua::wrap<l_set>},
+    {"batch", lua::wrap<l_batch>},
     {"get", lua::wrap<l_get>},
     {"get_X", lua::wrap<l_get_x>},
     {"get_Y", lua::wrap<l_get_y>},
@@ -91,11 +91,16 @@ static int l_reopen_world(lua::State*) {
 }
 
 /// @brief Save world
+/// @param async Save world in background (bool)
 static int l_save_world(lua::State* L) {
     if (controller == nullptr) {
         throw std::runtime_error("no world open");
     }
-    controller->saveWorld();
+    if (lua::toboolean(L, 1)) {
+        controller->saveWorldAsync();
+    } else {
+        controller->saveWorld();
+    }
     return 0;
 }
 
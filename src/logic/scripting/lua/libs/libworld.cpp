@@ -1,3 +1,4 @@
+#define VC_ENABLE_REFLECTION
 #include <cmath>
 #include <filesystem>
 #include <stdexcept>
@@ -21,10 +22,15 @@
 #include "world/World.hpp"
 #include "logic/LevelController.hpp"
 #include "logic/ChunksController.hpp"
+#include "logic/Pregenerator.hpp"
+#include "world/files/WorldSaver.hpp"
+#include "util/stringutil.hpp"
 
 using namespace scripting;
 namespace fs = std::filesystem;
 
+static constexpr size_t DEFAULT_DICTIONARY_SAMPLES = 1000;
+
 static WorldInfo& require_world_info() {
     if (level == nullptr) {
         throw std::runtime_error("no world open");
@@ -128,6 +134,15 @@ static int l_get_generator(lua::State* L) {
 static int l_get_chunk_data(lua::State* L) {
     int x = static_cast<int>(lua::tointeger(L, 1));
     int z = static_cast<int>(lua::tointeger(L, 2));
+    auto method = compression::Method::GZIP;
+    if (lua::isstring(L, 3)) {
+        auto name = lua::require_string(L, 3);
+        if (!compression::MethodMeta.getItem(name, method)) {
+            throw std::runtime_error(
+                "unknown compression method " + util::quote(name)
+            );
+        }
+    }
     const auto& chunk = level->chunks->getChunk(x, z);
 
     std::vector<ubyte> chunkData;
@@ -139,10 +154,11 @@ static int l_get_chunk_data(lua::State* L) {
         }
         static util::Buffer<ubyte> rleBuffer(CHUNK_DATA_LEN * 2);
         auto metadata = regions.getBlocksData(x, z);
-        chunkData =
-            compressed_chunks::encode(voxelData.get(), metadata, rleBuffer);
+        chunkData = compressed_chunks::encode(
+            voxelData.get(), metadata, rleBuffer, method
+        );
     } else {
-        chunkData = compressed_chunks::encode(*chunk);
+        chunkData = compressed_chunks::encode(*chunk, method);
     }
     return lua::create_bytearray(L, std::move(chunkData));
 }
@@ -162,7 +178,7 @@ static void integrate_chunk_client(Chunk& chunk) {
                 continue;
             }
             if (auto other = level->chunks->getChunk(x + lx, z + lz)) {
-                other->flags.modified = true;
+                other->setModified();
             }
         }
     }
@@ -222,6 +238,100 @@ static int l_count_chunks(lua::State* L) {
     return lua::pushinteger(L, level->chunks->size());
 }
 
+static int l_pregenerate(lua::State* L) {
+    if (level == nullptr) {
+        throw std::runtime_error("no open world");
+    }
+    glm::ivec2 min(lua::tointeger(L, 1), lua::tointeger(L, 2));
+    glm::ivec2 max(lua::tointeger(L, 3), lua::tointeger(L, 4));
+    controller->getChunksController()->pregenerate(min, max);
+    return 0;
+}
+
+static int l_get_saving_info(lua::State* L) {
+    if (controller == nullptr) {
+        return 0;
+    }
+    auto saver = controller->getWorldSaver();
+    if (saver == nullptr) {
+        return 0;
+    }
+    lua::createtable(L, 0, 3);
+
+    lua::pushboolean(L, saver->isWriting());
+    lua::setfield(L, "writing");
+
+    lua::pushinteger(L, saver->getWorkTotal());
+    lua::setfield(L, "total");
+
+    lua::pushinteger(L, saver->getWorkDone());
+    lua::setfield(L, "done");
+    return 1;
+}
+
+static int l_train_compression_dictionary(lua::State* L) {
+    if (level == nullptr) {
+        throw std::runtime_error("no open world");
+    }
+    size_t maxSamples = DEFAULT_DICTIONARY_SAMPLES;
+    if (!lua::isnoneornil(L, 1)) {
+        maxSamples = lua::tointeger(L, 1);
+    }
+    auto& regions = level->getWorld()->wfile->getRegions();
+    return lua::pushinteger(
+        L, regions.trainDictionary(REGION_LAYER_VOXELS, maxSamples)
+    );
+}
+
+static int l_get_pregeneration_info(lua::State* L) {
+    if (controller == nullptr) {
+        return 0;
+    }
+    auto pregenerator = controller->getChunksController()->getPregenerator();
+    if (pregenerator == nullptr) {
+        return 0;
+    }
+    const auto& stats = pregenerator->getStats();
+    lua::createtable(L, 0, 12);
+
+    lua::pushivec(L, pregenerator->getAreaMin());
+    lua::setfield(L, "min");
+
+    lua::pushivec(L, pregenerator->getAreaMax());
+    lua::setfield(L, "max");
+
+    lua::pushboolean(L, pregenerator->isFinished());
+    lua::setfield(L, "finished");
+
+    lua::pushinteger(L, stats.chunksTotal);
+    lua::setfield(L, "total");
+
+    lua::pushinteger(L, stats.chunksDone);
+    lua::setfield(L, "done");
+
+    lua::pushinteger(L, stats.chunksGenerated);
+    lua::setfield(L, "generated");
+
+    lua::pushnumber(L, stats.getChunksPerSecond());
+    lua::setfield(L, "chunks_per_second");
+
+    lua::pushnumber(L, stats.generationTime);
+    lua::setfield(L, "generation_time");
+
+    lua::pushnumber(L, stats.lightingTime);
+    lua::setfield(L, "lighting_time");
+
+    lua::pushnumber(L, stats.savingTime);
+    lua::setfield(L, "saving_time");
+
+    lua::pushnumber(L, stats.elapsedTime);
+    lua::setfield(L, "elapsed_time");
+
+    lua::pushinteger(L, stats.bytesWritten);
+    lua::setfield(L, "bytes_written");
+    return 1;
+}
+
 static int l_reload_script(lua::State* L) {
     auto packid = lua::require_string(L, 1);
     if (content == nullptr) {
@@ -251,5 +361,10 @@ const luaL_Reg worldlib[] = {
     {"save_chunk_data", lua::wrap<l_save_chunk_data>},
     {"count_chunks", lua::wrap<l_count_chunks>},
     {"reload_script", lua::wrap<l_reload_script>},
+    {"pregenerate", lua::wrap<l_pregenerate>},
+    {"get_pregeneration_info", lua::wrap<l_get_pregeneration_info>},
+    {"get_saving_info", lua::wrap<l_get_saving_info>},
+    {"train_compression_dictionary",
+     lua::wrap<l_train_compression_dictionary>},
     {NULL, NULL}
 };
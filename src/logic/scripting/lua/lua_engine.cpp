@@ -39,6 +39,32 @@ static void remove_lib_funcs(
     });
 }
 
+/// @brief Generator states run in generator worker threads, so functions
+/// accessing the world, writing files or reloading content are removed
+static void remove_generator_unsafe_funcs(State* L) {
+    const char* block[] {
+        "is_solid_at", "is_replaceable_at", "set", "batch", "get", "get_X",
+        "get_Y", "get_Z", "get_states", "set_states", "get_rotation",
+        "set_rotation", "get_user_bits", "set_user_bits", "get_variant",
+        "set_variant", "is_segment", "seek_origin", "place", "destruct",
+        "raycast", "get_field", "set_field", "reload_script", nullptr};
+    remove_lib_funcs(L, "block", block);
+
+    const char* file[] {
+        "mkdir", "mkdirs", "remove", "remove_tree", "write_bytes", "write",
+        "mount", "unmount", "create_zip", "__open_descriptor",
+        "__has_descriptor", "__read_descriptor", "__write_descriptor",
+        "__flush_descriptor", "__close_descriptor",
+        "__close_all_descriptors", nullptr};
+    remove_lib_funcs(L, "file", file);
+
+    const char* generation[] {"create_fragment", "save_fragment", nullptr};
+    remove_lib_funcs(L, "generation", generation);
+
+    const char* item[] {"reload_script", nullptr};
+    remove_lib_funcs(L, "item", item);
+}
+
 static void create_libs(State* L, StateType stateType) {
     openlib(L, "base64", base64lib);
     openlib(L, "bjson", bjsonlib);
@@ -85,6 +111,10 @@ static void create_libs(State* L, StateType stateType) {
         openlib(L, "__transform", transformlib);
     }
 
+    if (stateType == StateType::GENERATOR) {
+        remove_generator_unsafe_funcs(L);
+    }
+
     addfunc(L, "print", lua::wrap<l_print>);
     addfunc(L, "_crc32", lua::wrap<l_crc32>);
 }
@@ -6,8 +6,8 @@
 #include <filesystem>
 
 #include "util/functional_util.hpp"
-#define FNL_IMPL
 #include "maths/FastNoiseLite.h"
+#include "maths/noise.hpp"
 #include "coders/imageio.hpp"
 #include "io/util.hpp"
 #include "graphics/core/ImageData.hpp"
@@ -109,27 +109,18 @@ static int l_noise(lua::State* L) {
             shiftMapY = touserdata<LuaHeightmap>(L, 7);
         }
         noise->noise_type = noise_type;
-        for (uint y = 0; y < h; y++) {
-            for (uint x = 0; x < w; x++) {
-                uint i = y * w + x;
-                for (uint c = 0; c < octaves; c++) {
-                    float m = s * (1 << c);
-                    float value = heights[i];
-                    float u = (x + offset.x) * m;
-                    float v = (y + offset.y) * m;
-                    if (shiftMapX) {
-                        u += shiftMapX->getValues()[i];
-                    }
-                    if (shiftMapY) {
-                        v += shiftMapY->getValues()[i];
-                    }
-
-                    value += fnlGetNoise2D(noise, u, v) /
-                            static_cast<float>(1 << c) * multiplier;
-                    heights[i] = value;
-                }
-            }
-        }
+        noise::add_noise2d(
+            heights,
+            w,
+            h,
+            *noise,
+            offset,
+            s,
+            octaves,
+            multiplier,
+            shiftMapX ? shiftMapX->getValues() : nullptr,
+            shiftMapY ? shiftMapY->getValues() : nullptr
+        );
     }
     return 0;
 }
@@ -144,19 +135,14 @@ static int l_binop_func(lua::State* L) {
 
         if (isnumber(L, 2)) {
             float scalar = tonumber(L, 2);
-            for (uint y = 0; y < h; y++) {
-                for (uint x = 0; x < w; x++) {
-                    uint i = y * w + x;
-                    heights[i] = op(heights[i], scalar);
-                }
+            for (uint i = 0; i < w * h; i++) {
+                heights[i] = op(heights[i], scalar);
             }
         } else {
             auto map = touserdata<LuaHeightmap>(L, 2);
-            for (uint y = 0; y < h; y++) {
-                for (uint x = 0; x < w; x++) {
-                    uint i = y * w + x;
-                    heights[i] = op(heights[i], map->getValues()[i]);
-                }
+            auto mapvalues = map->getValues();
+            for (uint i = 0; i < w * h; i++) {
+                heights[i] = op(heights[i], mapvalues[i]);
             }
         }
     }
@@ -212,12 +198,30 @@ static int l_unaryop_func(lua::State* L) {
         uint w = heightmap->getWidth();
         uint h = heightmap->getHeight();
         auto heights = heightmap->getValues();
-        for (uint y = 0; y < h; y++) {
-            for (uint x = 0; x < w; x++) {
-                uint i = y * w + x;
-                heights[i] = op(heights[i]);
-            }
+        for (uint i = 0; i < w * h; i++) {
+            heights[i] = op(heights[i]);
+        }
+    }
+    return 0;
+}
+
+static int l_remap(lua::State* L) {
+    if (auto heightmap = touserdata<LuaHeightmap>(L, 1)) {
+        float srcLow = tonumber(L, 2);
+        float srcHigh = tonumber(L, 3);
+        float dstLow = tonumber(L, 4);
+        float dstHigh = tonumber(L, 5);
+        if (srcLow == srcHigh) {
+            throw std::runtime_error("source range is empty");
         }
+        noise::remap(
+            heightmap->getValues(),
+            heightmap->getWidth() * heightmap->getHeight(),
+            srcLow,
+            srcHigh,
+            dstLow,
+            dstHigh
+        );
     }
     return 0;
 }
@@ -262,6 +266,7 @@ static std::unordered_map<std::string, lua_CFunction> methods {
     {"min", lua::wrap<l_binop_func<util::min>>},
     {"max", lua::wrap<l_binop_func<util::max>>},
     {"abs", lua::wrap<l_unaryop_func<util::abs>>},
+    {"remap", lua::wrap<l_remap>},
     {"resize", lua::wrap<l_resize>},
     {"crop", lua::wrap<l_crop>},
     {"at", lua::wrap<l_at>},
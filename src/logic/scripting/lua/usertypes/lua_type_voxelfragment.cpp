@@ -2,6 +2,9 @@
 
 #include "../lua_util.hpp"
 
+#include "lighting/Lighting.hpp"
+#include "logic/ChunksController.hpp"
+#include "logic/LevelController.hpp"
 #include "world/generator/VoxelFragment.hpp"
 #include "util/stringutil.hpp"
 #include "world/Level.hpp"
@@ -14,6 +17,28 @@ LuaVoxelFragment::LuaVoxelFragment(std::shared_ptr<VoxelFragment> fragment)
 LuaVoxelFragment::~LuaVoxelFragment() {
 }
 
+/// @brief Update lights of placed fragment blocks at once
+static void update_lights(
+    Lighting& lighting, VoxelFragment& fragment, const glm::ivec3& offset
+) {
+    const auto& size = fragment.getSize();
+    const auto& voxels = fragment.getRuntimeVoxels();
+    lighting.beginBatch();
+    for (int y = 0; y < size.y; y++) {
+        for (int z = 0; z < size.z; z++) {
+            for (int x = 0; x < size.x; x++) {
+                const auto& vox = voxels[vox_index(x, y, z, size.x, size.z)];
+                if (vox.id) {
+                    lighting.onBlockSet(
+                        offset.x + x, offset.y + y, offset.z + z, vox.id
+                    );
+                }
+            }
+        }
+    }
+    lighting.endBatch();
+}
+
 static int l_crop(lua::State* L) {
     if (auto fragment = touserdata<LuaVoxelFragment>(L, 1)) {
         fragment->getFragment()->crop();
@@ -28,6 +53,12 @@ static int l_place(lua::State* L) {
         fragment->getFragment()->place(
             *scripting::level->chunks, offset, rotation 
         );
+        auto chunksController = scripting::controller->getChunksController();
+        if (chunksController && chunksController->lighting) {
+            update_lights(
+                *chunksController->lighting, *fragment->getFragment(), offset
+            );
+        }
     }
     return 0;
 }
@@ -25,9 +25,24 @@ class LuaGeneratorScript : public GeneratorScript {
     State* L;
     const GeneratorDef& def;
     scriptenv env = nullptr;
+    uint64_t seed = 0;
 
     io::path file;
     std::string dirPath;
+
+    /// @brief Seed math.random with the area position, so results do not
+    /// depend on the order of calls and the state calls are made with
+    void seedRandom(const glm::ivec2& offset) {
+        stackguard _(L);
+        if (getglobal(L, "math") && getfield(L, "randomseed")) {
+            uint64_t value = seed ^
+                             (static_cast<uint64_t>(offset.x) * 73856093) ^
+                             (static_cast<uint64_t>(offset.y) * 19349663);
+            // keep value exact as lua number
+            pushinteger(L, static_cast<Integer>(value & 0xFFFFFFFFFFFFF));
+            call_nothrow(L, 1, 0);
+        }
+    }
 public:
     LuaGeneratorScript(
         State* L,
@@ -46,6 +61,7 @@ public:
     }
 
     void initialize(uint64_t seed) override {
+        this->seed = seed;
         env = create_environment(L);
         stackguard _(L);
 
@@ -69,12 +85,20 @@ public:
         }
     }
 
+    std::unique_ptr<GeneratorScript> clone() const override {
+        auto state = create_state(
+            Engine::getInstance().getPaths(), StateType::GENERATOR
+        );
+        return std::make_unique<LuaGeneratorScript>(state, def, file, dirPath);
+    }
+
     std::shared_ptr<Heightmap> generateHeightmap(
         const glm::ivec2& offset,
         const glm::ivec2& size,
         uint bpd,
         const std::vector<std::shared_ptr<Heightmap>>& inputs
     ) override {
+        seedRandom(offset);
         pushenv(L, *env);
         if (getfield(L, "generate_heightmap")) {
             pushivec_stack(L, offset);
@@ -104,6 +128,7 @@ public:
         std::vector<std::shared_ptr<Heightmap>> maps;
 
         uint biomeParameters = def.biomeParameters;
+        seedRandom(offset);
         pushenv(L, *env);
         if (getfield(L, "generate_biome_parameters")) {
             pushivec_stack(L, offset);
@@ -199,6 +224,7 @@ public:
     ) override {
         std::vector<Placement> placements {};
         
+        seedRandom(offset);
         stackguard _(L);
         pushenv(L, *env);
         try {
@@ -232,6 +258,7 @@ public:
     ) override {
         std::vector<Placement> placements {};
         
+        seedRandom(offset);
         stackguard _(L);
         pushenv(L, *env);
         if (getfield(L, "place_structures")) {
@@ -0,0 +1,260 @@
+#include "noise.hpp"
+
+#define FNL_IMPL
+#include "FastNoiseLite.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NOISE_SIMD
+#include <emmintrin.h>
+#endif
+
+#ifdef NOISE_SIMD
+// 4-lane OpenSimplex2 kernel. Every operation repeats the scalar
+// FastNoiseLite code in the same order, so results match fnlGetNoise2D
+// (exactly, unless the compiler contracts scalar code into FMA).
+// Branches are replaced with masks.
+
+static inline __m128i mullo_epi32(__m128i a, __m128i b) {
+    // SSE2 has no 32-bit low multiply
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(
+        _mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+        _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0))
+    );
+}
+
+static inline __m128i select_epi32(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static inline __m128 select_ps(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128i fast_floor(__m128 f) {
+    // (f >= 0 ? (int)f : (int)f - 1)
+    __m128i negative = _mm_castps_si128(_mm_cmplt_ps(f, _mm_setzero_ps()));
+    return _mm_add_epi32(_mm_cvttps_epi32(f), negative);
+}
+
+static inline __m128 grad_coord(
+    __m128i seed, __m128i xPrimed, __m128i yPrimed, __m128 xd, __m128 yd
+) {
+    __m128i hash = _mm_xor_si128(seed, _mm_xor_si128(xPrimed, yPrimed));
+    hash = mullo_epi32(hash, _mm_set1_epi32(0x27d4eb2d));
+    hash = _mm_xor_si128(hash, _mm_srai_epi32(hash, 15));
+    hash = _mm_and_si128(hash, _mm_set1_epi32(127 << 1));
+
+    alignas(16) int index[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(index), hash);
+    __m128 xg = _mm_setr_ps(
+        GRADIENTS_2D[index[0]],
+        GRADIENTS_2D[index[1]],
+        GRADIENTS_2D[index[2]],
+        GRADIENTS_2D[index[3]]
+    );
+    __m128 yg = _mm_setr_ps(
+        GRADIENTS_2D[index[0] | 1],
+        GRADIENTS_2D[index[1] | 1],
+        GRADIENTS_2D[index[2] | 1],
+        GRADIENTS_2D[index[3] | 1]
+    );
+    return _mm_add_ps(_mm_mul_ps(xd, xg), _mm_mul_ps(yd, yg));
+}
+
+static inline __m128 falloff4(__m128 a) {
+    __m128 a2 = _mm_mul_ps(a, a);
+    return _mm_mul_ps(a2, a2);
+}
+
+/// @brief _fnlSingleSimplex2D for 4 skewed points
+static __m128 simplex2d_x4(int seed, __m128 x, __m128 y) {
+    const float SQRT3 = 1.7320508075688772935274463415059f;
+    const float G2 = (3 - SQRT3) / 6;
+    const float C1 = (float)(2 * (1 - 2 * G2) * (1 / G2 - 2));
+    const float C2 = (float)(-2 * (1 - 2 * G2) * (1 - 2 * G2));
+    const float K2 = 2 * (float)G2 - 1;
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128i seedv = _mm_set1_epi32(seed);
+    const __m128i primeX = _mm_set1_epi32(PRIME_X);
+    const __m128i primeY = _mm_set1_epi32(PRIME_Y);
+
+    __m128i i = fast_floor(x);
+    __m128i j = fast_floor(y);
+    __m128 xi = _mm_sub_ps(x, _mm_cvtepi32_ps(i));
+    __m128 yi = _mm_sub_ps(y, _mm_cvtepi32_ps(j));
+
+    __m128 t = _mm_mul_ps(_mm_add_ps(xi, yi), _mm_set1_ps(G2));
+    __m128 x0 = _mm_sub_ps(xi, t);
+    __m128 y0 = _mm_sub_ps(yi, t);
+
+    i = mullo_epi32(i, primeX);
+    j = mullo_epi32(j, primeY);
+
+    __m128 a = _mm_sub_ps(
+        _mm_sub_ps(half, _mm_mul_ps(x0, x0)), _mm_mul_ps(y0, y0)
+    );
+    __m128 n0 = _mm_mul_ps(falloff4(a), grad_coord(seedv, i, j, x0, y0));
+    n0 = _mm_and_ps(_mm_cmpgt_ps(a, zero), n0);
+
+    __m128 c = _mm_add_ps(
+        _mm_mul_ps(_mm_set1_ps(C1), t), _mm_add_ps(_mm_set1_ps(C2), a)
+    );
+    __m128 x2 = _mm_add_ps(x0, _mm_set1_ps(K2));
+    __m128 y2 = _mm_add_ps(y0, _mm_set1_ps(K2));
+    __m128 n2 = _mm_mul_ps(
+        falloff4(c),
+        grad_coord(
+            seedv, _mm_add_epi32(i, primeX), _mm_add_epi32(j, primeY), x2, y2
+        )
+    );
+    n2 = _mm_and_ps(_mm_cmpgt_ps(c, zero), n2);
+
+    // y0 > x0 selects the upper triangle
+    __m128 upper = _mm_cmpgt_ps(y0, x0);
+    __m128i upperi = _mm_castps_si128(upper);
+    __m128 x1 = _mm_add_ps(
+        x0, select_ps(upper, _mm_set1_ps(G2), _mm_set1_ps(G2 - 1))
+    );
+    __m128 y1 = _mm_add_ps(
+        y0, select_ps(upper, _mm_set1_ps(G2 - 1), _mm_set1_ps(G2))
+    );
+    __m128 b = _mm_sub_ps(
+        _mm_sub_ps(half, _mm_mul_ps(x1, x1)), _mm_mul_ps(y1, y1)
+    );
+    __m128i i1 = select_epi32(upperi, i, _mm_add_epi32(i, primeX));
+    __m128i j1 = select_epi32(upperi, _mm_add_epi32(j, primeY), j);
+    __m128 n1 = _mm_mul_ps(falloff4(b), grad_coord(seedv, i1, j1, x1, y1));
+    n1 = _mm_and_ps(_mm_cmpgt_ps(b, zero), n1);
+
+    return _mm_mul_ps(
+        _mm_add_ps(_mm_add_ps(n0, n1), n2), _mm_set1_ps(99.83685446303647f)
+    );
+}
+
+/// @brief Add one OpenSimplex2 octave to the row.
+/// @return number of processed samples (multiple of 4)
+static uint add_simplex_row(
+    float* row,
+    uint width,
+    const fnl_state& state,
+    float offsetX,
+    float v,
+    float m,
+    float divisor,
+    float multiplier,
+    const float* shiftX,
+    const float* shiftY
+) {
+    const float SQRT3 = (float)1.7320508075688772935274463415059;
+    const float F2 = 0.5f * (SQRT3 - 1);
+
+    const __m128 frequency = _mm_set1_ps(state.frequency);
+    const __m128 f2 = _mm_set1_ps(F2);
+    const __m128 offx = _mm_set1_ps(offsetX);
+    const __m128 mv = _mm_set1_ps(m);
+    const __m128 vv = _mm_set1_ps(v);
+    const __m128 divisorv = _mm_set1_ps(divisor);
+    const __m128 multiplierv = _mm_set1_ps(multiplier);
+
+    uint x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m128 xs = _mm_cvtepi32_ps(_mm_setr_epi32(x, x + 1, x + 2, x + 3));
+        __m128 px = _mm_mul_ps(_mm_add_ps(xs, offx), mv);
+        __m128 py = vv;
+        if (shiftX) {
+            px = _mm_add_ps(px, _mm_loadu_ps(shiftX + x));
+        }
+        if (shiftY) {
+            py = _mm_add_ps(py, _mm_loadu_ps(shiftY + x));
+        }
+        // _fnlTransformNoiseCoordinate2D
+        px = _mm_mul_ps(px, frequency);
+        py = _mm_mul_ps(py, frequency);
+        __m128 t = _mm_mul_ps(_mm_add_ps(px, py), f2);
+        px = _mm_add_ps(px, t);
+        py = _mm_add_ps(py, t);
+
+        __m128 value = simplex2d_x4(state.seed, px, py);
+        value = _mm_mul_ps(_mm_div_ps(value, divisorv), multiplierv);
+        _mm_storeu_ps(row + x, _mm_add_ps(_mm_loadu_ps(row + x), value));
+    }
+    return x;
+}
+#endif
+
+void noise::add_noise2d(
+    float* values,
+    uint width,
+    uint height,
+    fnl_state& state,
+    const glm::vec2& offset,
+    float scale,
+    int octaves,
+    float multiplier,
+    const float* shiftX,
+    const float* shiftY
+) {
+#ifdef NOISE_SIMD
+    bool vectorized = state.noise_type == FNL_NOISE_OPENSIMPLEX2 &&
+                      state.fractal_type == FNL_FRACTAL_NONE;
+#endif
+    // octaves are the outer loop: per-sample summation order is unchanged
+    for (int c = 0; c < octaves; c++) {
+        float m = scale * (1 << c);
+        float divisor = static_cast<float>(1 << c);
+        for (uint y = 0; y < height; y++) {
+            uint rowIndex = y * width;
+            float* row = values + rowIndex;
+            const float* rowShiftX = shiftX ? shiftX + rowIndex : nullptr;
+            const float* rowShiftY = shiftY ? shiftY + rowIndex : nullptr;
+            float v = (y + offset.y) * m;
+            uint x = 0;
+#ifdef NOISE_SIMD
+            if (vectorized) {
+                x = add_simplex_row(
+                    row,
+                    width,
+                    state,
+                    offset.x,
+                    v,
+                    m,
+                    divisor,
+                    multiplier,
+                    rowShiftX,
+                    rowShiftY
+                );
+            }
+#endif
+            for (; x < width; x++) {
+                float u = (x + offset.x) * m;
+                float sv = v;
+                if (rowShiftX) {
+                    u += rowShiftX[x];
+                }
+                if (rowShiftY) {
+                    sv += rowShiftY[x];
+                }
+                row[x] += fnlGetNoise2D(&state, u, sv) / divisor * multiplier;
+            }
+        }
+    }
+}
+
+void noise::remap(
+    float* values,
+    size_t size,
+    float srcLow,
+    float srcHigh,
+    float dstLow,
+    float dstHigh
+) {
+    float k = (dstHigh - dstLow) / (srcHigh - srcLow);
+    for (size_t i = 0; i < size; i++) {
+        values[i] = dstLow + (values[i] - srcLow) * k;
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "typedefs.hpp"
+
+struct fnl_state;
+
+namespace noise {
+    /// @brief Add fractal 2D noise to the values buffer (width * height).
+    /// Octave c is sampled at scale * 2^c with amplitude multiplier / 2^c.
+    /// OpenSimplex2 without fractal is evaluated by the vectorized kernel
+    /// repeating fnlGetNoise2D operations, other types are sampled by
+    /// fnlGetNoise2D.
+    /// @param state noise state (seed, frequency and noise type)
+    /// @param offset sample coordinates offset
+    /// @param shiftX optional per-sample x coordinate shift (may be nullptr)
+    /// @param shiftY optional per-sample y coordinate shift (may be nullptr)
+    void add_noise2d(
+        float* values,
+        uint width,
+        uint height,
+        fnl_state& state,
+        const glm::vec2& offset,
+        float scale,
+        int octaves,
+        float multiplier,
+        const float* shiftX,
+        const float* shiftY
+    );
+
+    /// @brief Linearly remap values from [srcLow, srcHigh]
+    /// to [dstLow, dstHigh] range (not clamped)
+    void remap(
+        float* values,
+        size_t size,
+        float srcLow,
+        float srcHigh,
+        float dstLow,
+        float dstHigh
+    );
+}
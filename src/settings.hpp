@@ -40,6 +40,11 @@ struct ChunksSettings {
     IntegerSetting loadDistance {22, 3, 80};
     /// @brief Buffer zone where chunks are not unloading (chunk is unit)
     IntegerSetting padding {2, 1, 8};
+    /// @brief Keep voxels of idle chunks in compact paletted form
+    FlagSetting compactVoxels {false};
+    /// @brief Max number of generated chunk prototypes kept in cache
+    /// after unloading (0 - disabled)
+    IntegerSetting prototypesCache {0, 0, 65536};
 };
 
 struct CameraSettings {
@@ -65,6 +70,10 @@ struct GraphicsSettings {
     FlagSetting backlight {true};
     /// @brief Disable culling with 'optional' mode
     FlagSetting denseRender {true};
+    /// @brief Merge coplanar evenly lit full-cube block faces
+    FlagSetting greedyMeshing {false};
+    /// @brief Use packed opaque chunk mesh vertices (applied on world open)
+    FlagSetting compactVertices {false};
     /// @brief Enable chunks frustum culling
     FlagSetting frustumCulling {true};
     /// @brief Skybox texture face resolution
@@ -75,6 +84,9 @@ struct GraphicsSettings {
     IntegerSetting chunkMaxVerticesDense {800'000, 0, 8'000'000};
     /// @brief Limit of chunk renderers count
     IntegerSetting chunkMaxRenderers {6, -4, 32};
+    /// @brief Memory limit of chunk sections meshes kept for incremental
+    /// rebuilds in MiB
+    IntegerSetting chunkSectionsCache {64, 0, 1024};
     /// @brief Advanced render pipeline
     FlagSetting advancedRender {true};
     /// @brief Screen space ambient occlusion
@@ -90,6 +102,18 @@ struct DebugSettings {
     FlagSetting generatorTestMode {false};
     /// @brief Write lights cache
     FlagSetting doWriteLights {true};
+    /// @brief Voxels regions compression method (none, extrle16, lz4, zstd)
+    StringSetting voxelsCompression {"extrle16"};
+    /// @brief Max number of simultaneously open region files of each layer
+    IntegerSetting openRegionFiles {MAX_OPEN_REGION_FILES, 1, 1024};
+    /// @brief Append changed chunks to region files instead of rewriting
+    FlagSetting incrementalRegionWrites {true};
+    /// @brief Flush region files and write journals to disk before
+    /// considering them saved
+    FlagSetting durableRegionWrites {true};
+    /// @brief Region file dead space fraction scheduling it for compaction
+    NumberSetting regionCompactionThreshold {
+        DEFAULT_COMPACTION_THRESHOLD, 0.1f, 1.0f};
 };
 
 struct UiSettings {
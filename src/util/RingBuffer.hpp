@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace util {
+    /// @brief FIFO queue on contiguous power-of-two sized storage growing
+    /// twice when full. Unlike std::queue it does not allocate while being
+    /// drained and refilled
+    template <typename T>
+    class RingBuffer {
+        std::unique_ptr<T[]> buffer;
+        size_t capacity;
+        size_t head = 0;
+        size_t count = 0;
+
+        void grow() {
+            auto newBuffer = std::make_unique<T[]>(capacity * 2);
+            for (size_t i = 0; i < count; i++) {
+                newBuffer[i] = std::move(buffer[(head + i) & (capacity - 1)]);
+            }
+            buffer = std::move(newBuffer);
+            capacity *= 2;
+            head = 0;
+        }
+    public:
+        /// @param initialCapacity initial capacity, must be power of two
+        RingBuffer(size_t initialCapacity = 1024)
+            : buffer(std::make_unique<T[]>(initialCapacity)),
+              capacity(initialCapacity) {
+        }
+
+        void push(T value) {
+            if (count == capacity) {
+                grow();
+            }
+            buffer[(head + count) & (capacity - 1)] = std::move(value);
+            count++;
+        }
+
+        /// @brief Remove and return the first element.
+        /// @attention queue must not be empty
+        T pop() {
+            T value = std::move(buffer[head]);
+            head = (head + 1) & (capacity - 1);
+            count--;
+            return value;
+        }
+
+        void clear() {
+            head = 0;
+            count = 0;
+        }
+
+        bool empty() const {
+            return count == 0;
+        }
+
+        size_t size() const {
+            return count;
+        }
+    };
+}
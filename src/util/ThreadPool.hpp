@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
@@ -32,6 +33,29 @@ namespace util {
         virtual R operator()(const T&) = 0;
     };
 
+    /// @brief Get number of thread pool workers
+    /// @param maxWorkers max number of workers. Special values: 0 is
+    /// unlimited, -2 is half of auto count, -4 is quarter.
+    /// @return at least 1, as hardware concurrency may be unknown or less
+    /// than the divisor
+    inline uint get_workers_count(int maxWorkers) {
+        uint numThreads = std::thread::hardware_concurrency();
+        switch (maxWorkers) {
+            case 0:
+                break;
+            case -2:
+                numThreads /= 2;
+                break;
+            case -4:
+                numThreads /= 4;
+                break;
+            default:
+                numThreads = std::min(numThreads, static_cast<uint>(maxWorkers));
+                break;
+        }
+        return std::max(1U, numThreads);
+    }
+
     template <class T, class R>
     class ThreadPool : public Task {
         debug::Logger logger;
@@ -120,22 +144,7 @@ namespace util {
             int maxWorkers=UNLIMITED
         )
             : logger(std::move(name)), resultConsumer(resultConsumer) {
-            uint numThreads = std::thread::hardware_concurrency();
-            switch (maxWorkers) {
-                case UNLIMITED:
-                    break;
-                case HALF:
-                    numThreads = std::max(1U, numThreads);
-                    break;
-                case QUARTER:
-                    numThreads = std::max(1U, numThreads / 4);
-                    break;
-                default:
-                    numThreads = std::max(
-                        1U, std::min(numThreads, static_cast<uint>(maxWorkers))
-                    );
-                    break;
-            }
+            uint numThreads = get_workers_count(maxWorkers);
             for (uint i = 0; i < numThreads; i++) {
                 threads.emplace_back(
                     &ThreadPool<T, R>::threadLoop, this, i, workersSupplier()
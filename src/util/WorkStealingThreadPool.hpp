@@ -0,0 +1,359 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "debug/Logger.hpp"
+#include "delegates.hpp"
+#include "interfaces/Task.hpp"
+#include "util/ThreadPool.hpp"
+
+namespace util {
+
+    /// @brief Work-stealing thread pool. Every worker has its own jobs
+    /// deque. Idle workers steal jobs from deques of other workers.
+    /// Results are taken by update() as a single batch. Has the ThreadPool
+    /// interface, but is not used by default until it is shown to be
+    /// faster on multi-core machines (see ThreadPool benchmark test)
+    template <class T, class R>
+    class WorkStealingThreadPool : public Task {
+        struct Result {
+            T job;
+            int workerIndex;
+            R entry;
+        };
+
+        struct WorkerContext {
+            std::mutex jobsMutex;
+            std::deque<T> jobs;
+            /// @brief Used if standaloneResults is false
+            std::mutex resultMutex;
+            std::condition_variable resultVariable;
+            bool resultLocked = false;
+        };
+
+        debug::Logger logger;
+        std::vector<std::unique_ptr<WorkerContext>> contexts;
+        std::vector<std::thread> threads;
+        /// @brief Results pushed by workers
+        std::vector<Result> results;
+        /// @brief Results taken by update(), main thread only
+        std::vector<Result> readyResults;
+        std::mutex resultsMutex;
+        std::condition_variable jobsCondition;
+        std::mutex sleepMutex;
+        consumer<R&> resultConsumer;
+        consumer<T&> onJobFailed = nullptr;
+        runnable onComplete = nullptr;
+        /// @brief Number of jobs in deques
+        std::atomic<int> pendingJobs = 0;
+        std::atomic<int> sleepingWorkers = 0;
+        std::atomic<uint> nextWorker = 0;
+        std::atomic<int> busyWorkers = 0;
+        std::atomic<uint> jobsDone = 0;
+        std::atomic<bool> working = true;
+        std::atomic<bool> failed = false;
+        bool standaloneResults = true;
+        bool stopOnFail = true;
+
+        bool popJob(WorkerContext& context, T& job, bool steal) {
+            std::lock_guard<std::mutex> lock(context.jobsMutex);
+            if (context.jobs.empty()) {
+                return false;
+            }
+            busyWorkers++;
+            if (steal) {
+                job = std::move(context.jobs.back());
+                context.jobs.pop_back();
+            } else {
+                job = std::move(context.jobs.front());
+                context.jobs.pop_front();
+            }
+            pendingJobs--;
+            return true;
+        }
+
+        bool takeJob(int index, T& job) {
+            if (popJob(*contexts[index], job, false)) {
+                return true;
+            }
+            size_t count = contexts.size();
+            for (size_t i = 1; i < count; i++) {
+                if (popJob(*contexts[(index + i) % count], job, true)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void wakeWorker() {
+            if (sleepingWorkers == 0) {
+                return;
+            }
+            {
+                // no worker may check pendingJobs and start waiting now
+                std::lock_guard<std::mutex> lock(sleepMutex);
+            }
+            jobsCondition.notify_one();
+        }
+
+        void unlockWorker(int index) {
+            auto& context = *contexts[index];
+            {
+                std::lock_guard<std::mutex> lock(context.resultMutex);
+                context.resultLocked = false;
+            }
+            context.resultVariable.notify_all();
+        }
+
+        void threadLoop(int index, std::shared_ptr<Worker<T, R>> worker) {
+            auto& context = *contexts[index];
+            while (working && !failed) {
+                T job;
+                if (!takeJob(index, job)) {
+                    std::unique_lock<std::mutex> lock(sleepMutex);
+                    sleepingWorkers++;
+                    jobsCondition.wait(lock, [this] {
+                        return pendingJobs > 0 || !working || failed;
+                    });
+                    sleepingWorkers--;
+                    continue;
+                }
+                try {
+                    R result = (*worker)(job);
+                    if (!standaloneResults) {
+                        std::lock_guard<std::mutex> lock(context.resultMutex);
+                        context.resultLocked = true;
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock(resultsMutex);
+                        results.push_back(Result {
+                            std::move(job), index, std::move(result)});
+                        busyWorkers--;
+                    }
+                    if (!standaloneResults) {
+                        std::unique_lock<std::mutex> lock(context.resultMutex);
+                        context.resultVariable.wait(lock, [&] {
+                            return !working || !context.resultLocked;
+                        });
+                    }
+                } catch (std::exception& err) {
+                    busyWorkers--;
+                    if (onJobFailed) {
+                        onJobFailed(job);
+                    }
+                    if (stopOnFail) {
+                        failed = true;
+                        std::lock_guard<std::mutex> lock(sleepMutex);
+                        jobsCondition.notify_all();
+                    }
+                    logger.error() << "uncaught exception: " << err.what();
+                }
+                jobsDone++;
+            }
+        }
+
+        void pushJob(size_t workerIndex, T job) {
+            pendingJobs++;
+            {
+                auto& context = *contexts[workerIndex];
+                std::lock_guard<std::mutex> lock(context.jobsMutex);
+                context.jobs.push_back(std::move(job));
+            }
+            wakeWorker();
+        }
+    public:
+        static constexpr int UNLIMITED = 0;
+        static constexpr int HALF = -2;
+        static constexpr int QUARTER = -4;
+
+        /// @brief Main thread pool constructor
+        /// @param name thread pool name (used in logger)
+        /// @param workersSupplier workers factory function
+        /// @param resultConsumer workers results consumer function
+        /// @param maxWorkers max number of workers. Special values: 0 is 
+        /// unlimited, -2 is half of auto count, -4 is quarter.
+        WorkStealingThreadPool(
+            std::string name,
+            supplier<std::shared_ptr<Worker<T, R>>> workersSupplier,
+            consumer<R&> resultConsumer,
+            int maxWorkers=UNLIMITED
+        )
+            : logger(std::move(name)), resultConsumer(resultConsumer) {
+            uint numThreads = get_workers_count(maxWorkers);
+            for (uint i = 0; i < numThreads; i++) {
+                contexts.push_back(std::make_unique<WorkerContext>());
+            }
+            for (uint i = 0; i < numThreads; i++) {
+                threads.emplace_back(
+                    &WorkStealingThreadPool<T, R>::threadLoop,
+                    this,
+                    i,
+                    workersSupplier()
+                );
+            }
+        }
+        ~WorkStealingThreadPool() {
+            terminate();
+        }
+
+        bool isActive() const override {
+            return working;
+        }
+
+        void terminate() override {
+            if (!working) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                working = false;
+            }
+            jobsCondition.notify_all();
+            for (size_t i = 0; i < contexts.size(); i++) {
+                unlockWorker(i);
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            {
+                std::lock_guard<std::mutex> lock(resultsMutex);
+                results.clear();
+            }
+            readyResults.clear();
+        }
+
+        void update() override {
+            if (!working) {
+                return;
+            }
+            if (failed) {
+                throw std::runtime_error("some job failed");
+            }
+            {
+                std::lock_guard<std::mutex> lock(resultsMutex);
+                if (readyResults.empty()) {
+                    std::swap(results, readyResults);
+                } else {
+                    for (auto& entry : results) {
+                        readyResults.push_back(std::move(entry));
+                    }
+                    results.clear();
+                }
+            }
+            size_t consumed = 0;
+            while (consumed < readyResults.size()) {
+                auto& entry = readyResults[consumed++];
+                try {
+                    resultConsumer(entry.entry);
+                } catch (std::exception& err) {
+                    logger.error() << err.what();
+                    if (onJobFailed) {
+                        onJobFailed(entry.job);
+                    }
+                    if (stopOnFail) {
+                        failed = true;
+                    }
+                    if (!standaloneResults) {
+                        unlockWorker(entry.workerIndex);
+                    }
+                    break;
+                }
+                if (!standaloneResults) {
+                    unlockWorker(entry.workerIndex);
+                }
+            }
+            readyResults.erase(
+                readyResults.begin(), readyResults.begin() + consumed
+            );
+            if (failed) {
+                throw std::runtime_error("some job failed");
+            }
+
+            bool complete = false;
+            if (onComplete && readyResults.empty()) {
+                std::lock_guard<std::mutex> lock(resultsMutex);
+                // busyWorkers is decreased after the result is pushed
+                if (results.empty() && pendingJobs == 0 && busyWorkers == 0) {
+                    onComplete();
+                    complete = true;
+                }
+            }
+            if (complete) {
+                terminate();
+            }
+        }
+
+        /// @brief Add job to deque of the next worker
+        void enqueueJob(T job) {
+            pushJob(nextWorker++ % contexts.size(), std::move(job));
+        }
+
+        /// @brief Add job to deque of the specified worker.
+        /// Jobs of equal affinity are run in order of addition
+        /// by the same worker unless stolen by idle workers
+        /// @param affinity any number, e.g. hash of the job key
+        void enqueueJob(T job, size_t affinity) {
+            pushJob(affinity % contexts.size(), std::move(job));
+        }
+
+        void clearQueue() {
+            for (auto& context : contexts) {
+                std::lock_guard<std::mutex> lock(context->jobsMutex);
+                pendingJobs -= context->jobs.size();
+                context->jobs.clear();
+            }
+        }
+
+        /// @brief If false: worker will be blocked until it's result performed
+        void setStandaloneResults(bool flag) {
+            standaloneResults = flag;
+        }
+
+        void setStopOnFail(bool flag) {
+            stopOnFail = flag;
+        }
+
+        /// @brief onJobFailed called on exception thrown in worker thread.
+        /// Use engine.postRunnable when calling terminate()
+        void setOnJobFailed(consumer<T&> callback) {
+            this->onJobFailed = callback;
+        }
+
+        /// @brief onComplete called in update() when all jobs done
+        /// if the pool was not terminated
+        void setOnComplete(runnable callback) {
+            this->onComplete = callback;
+        }
+
+        uint getWorkTotal() const override {
+            return pendingJobs + jobsDone + busyWorkers;
+        }
+
+        uint getWorkDone() const override {
+            return jobsDone;
+        }
+
+        virtual void waitForEnd() override {
+            using namespace std::chrono_literals;
+            while (working) {
+                std::this_thread::sleep_for(2ms);
+                update();
+            }
+        }
+
+        uint getWorkersCount() const {
+            return threads.size();
+        }
+    };
+
+}  // namespace util
@@ -113,3 +113,36 @@ void platform::open_folder(const std::filesystem::path& folder) {
 
 #endif
 }
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+
+bool platform::has_avx2() {
+    static const bool supported = [] {
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) {
+            return false;
+        }
+        __cpuid(info, 1);
+        bool osxsave = info[2] & (1 << 27);
+        bool avx = info[2] & (1 << 28);
+        // OS must save YMM registers state
+        if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }();
+    return supported;
+}
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+bool platform::has_avx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+#else
+bool platform::has_avx2() {
+    return false;
+}
+#endif
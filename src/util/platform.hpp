@@ -13,4 +13,6 @@ namespace platform {
     /// Makes the current thread sleep for the specified amount of milliseconds.
     void sleep(size_t millis);
     int get_process_id();
+    /// @return true if AVX2 instructions are supported by CPU and OS
+    bool has_avx2();
 }
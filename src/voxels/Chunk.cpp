@@ -1,8 +1,10 @@
 #include "Chunk.hpp"
 
+#include <algorithm>
 #include <utility>
 
 #include "content/ContentReport.hpp"
+#include "Block.hpp"
 #include "items/Inventory.hpp"
 #include "lighting/Lightmap.hpp"
 #include "util/data_io.hpp"
@@ -11,9 +13,11 @@
 Chunk::Chunk(int xpos, int zpos) : x(xpos), z(zpos) {
     bottom = 0;
     top = CHUNK_H;
+    std::fill_n(skyHeights, CHUNK_W * CHUNK_D, CHUNK_H);
 }
 
 void Chunk::updateHeights() {
+    auto voxels = this->voxels.view();
     for (uint i = 0; i < CHUNK_VOL; i++) {
         if (voxels[i].id != 0) {
             bottom = i / (CHUNK_D * CHUNK_W);
@@ -28,6 +32,74 @@ void Chunk::updateHeights() {
     }
 }
 
+void Chunk::updateSections(const Block* const* blockDefs) {
+    auto voxels = this->voxels.view();
+    for (int s = 0; s < CHUNK_SECTIONS; s++) {
+        auto& section = sections[s];
+        section.blocks = 0;
+        section.opaque = 0;
+        section.counted = true;
+        for (uint i = 0; i < CHUNK_SECTION_VOL; i++) {
+            blockid_t id = voxels[s * CHUNK_SECTION_VOL + i].id;
+            section.blocks += id != BLOCK_AIR;
+            section.opaque += !blockDefs[id]->lightPassing;
+        }
+    }
+
+    // sections above terrain contain air only
+    int airBottom = CHUNK_H;
+    while (airBottom > 0 &&
+           sections[airBottom / CHUNK_SECTION_H - 1].isEmpty()) {
+        airBottom -= CHUNK_SECTION_H;
+    }
+    std::fill_n(skyHeights, CHUNK_W * CHUNK_D, 0);
+    uint found = 0;
+    for (int y = airBottom - 1; y >= 0 && found < CHUNK_W * CHUNK_D; y--) {
+        for (uint column = 0; column < CHUNK_W * CHUNK_D; column++) {
+            if (skyHeights[column] == 0 &&
+                !blockDefs[voxels[y * CHUNK_W * CHUNK_D + column].id]
+                     ->skyLightPassing) {
+                skyHeights[column] = y + 1;
+                found++;
+            }
+        }
+    }
+}
+
+void Chunk::updateSection(uint y, const Block& prev, const Block& next) {
+    // differences are not applied to unknown section, so it stays
+    // neither empty nor opaque
+    auto& section = sections[y / CHUNK_SECTION_H];
+    if (!section.counted) {
+        return;
+    }
+    section.blocks += (next.rt.id != BLOCK_AIR) - (prev.rt.id != BLOCK_AIR);
+    section.opaque += (!next.lightPassing) - (!prev.lightPassing);
+}
+
+void Chunk::updateSkyHeight(
+    uint x, uint y, uint z, const Block& next, const Block* const* blockDefs
+) {
+    auto& height = skyHeights[z * CHUNK_W + x];
+    if (!next.skyLightPassing) {
+        height = std::max<uint16_t>(height, y + 1);
+    } else if (y + 1 == height) {
+        int top = y;
+        while (top > 0 &&
+               blockDefs[voxels.get(vox_index(x, top - 1, z)).id]->skyLightPassing) {
+            top--;
+        }
+        height = top;
+    }
+}
+
+void Chunk::resetSections() {
+    for (auto& section : sections) {
+        section = {};
+    }
+    std::fill_n(skyHeights, CHUNK_W * CHUNK_D, CHUNK_H);
+}
+
 void Chunk::addBlockInventory(
     std::shared_ptr<Inventory> inventory, uint x, uint y, uint z
 ) {
@@ -57,9 +129,9 @@ std::shared_ptr<Inventory> Chunk::getBlockInventory(uint x, uint y, uint z)
 
 std::unique_ptr<Chunk> Chunk::clone() const {
     auto other = std::make_unique<Chunk>(x, z);
-    for (uint i = 0; i < CHUNK_VOL; i++) {
-        other->voxels[i] = voxels[i];
-    }
+    voxels.copyTo(other->voxels.data());
+    std::copy(sections, sections + CHUNK_SECTIONS, other->sections);
+    std::copy_n(skyHeights, CHUNK_W * CHUNK_D, other->skyHeights);
     other->lightmap.set(&lightmap);
     return other;
 }
@@ -76,23 +148,50 @@ std::unique_ptr<Chunk> Chunk::clone() const {
     Total size: (CHUNK_VOL * 4) bytes
 */
 std::unique_ptr<ubyte[]> Chunk::encode() const {
+    auto buffer = std::make_unique<ubyte[]>(CHUNK_DATA_LEN);
+    auto dst = reinterpret_cast<uint16_t*>(buffer.get());
+    for (int s = 0; s < CHUNK_SECTIONS; s++) {
+        uint begin = s * CHUNK_SECTION_VOL;
+        uint end = begin + CHUNK_SECTION_VOL;
+        if (sections[s].isEmpty()) {
+            // ids are already zeroed, air states are rarely set
+            for (uint i = begin; i < end; i++) {
+                if (auto state = blockstate2int(voxels.get(i).state)) {
+                    dst[CHUNK_VOL + i] = dataio::h2le(state);
+                }
+            }
+            continue;
+        }
+        for (uint i = begin; i < end; i++) {
+            voxel vox = voxels.get(i);
+            dst[i] = dataio::h2le(vox.id);
+            dst[CHUNK_VOL + i] = dataio::h2le(blockstate2int(vox.state));
+        }
+    }
+    return buffer;
+}
+
+std::unique_ptr<ubyte[]> Chunk::encode(const voxel* voxels) {
     auto buffer = std::make_unique<ubyte[]>(CHUNK_DATA_LEN);
     auto dst = reinterpret_cast<uint16_t*>(buffer.get());
     for (uint i = 0; i < CHUNK_VOL; i++) {
-        dst[i] = dataio::h2le(voxels[i].id);
-        dst[CHUNK_VOL + i] = dataio::h2le(blockstate2int(voxels[i].state));
+        const voxel& vox = voxels[i];
+        dst[i] = dataio::h2le(vox.id);
+        dst[CHUNK_VOL + i] = dataio::h2le(blockstate2int(vox.state));
     }
     return buffer;
 }
 
 bool Chunk::decode(const ubyte* data) {
     auto src = reinterpret_cast<const uint16_t*>(data);
+    voxel* dst = voxels.data();
     for (uint i = 0; i < CHUNK_VOL; i++) {
-        voxel& vox = voxels[i];
+        voxel& vox = dst[i];
 
         vox.id = dataio::le2h(src[i]);
         vox.state = int2blockstate(dataio::le2h(src[CHUNK_VOL + i]));
     }
+    resetSections();
     return true;
 }
 
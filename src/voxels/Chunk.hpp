@@ -2,10 +2,12 @@
 
 #include <stdlib.h>
 
+#include <algorithm>
 #include <memory>
 #include <unordered_map>
 
 #include "constants.hpp"
+#include "ChunkVoxels.hpp"
 #include "lighting/Lightmap.hpp"
 #include "util/SmallHeap.hpp"
 #include "maths/aabb.hpp"
@@ -14,6 +16,7 @@
 /// @brief Total bytes number of chunk voxel data
 inline constexpr int CHUNK_DATA_LEN = CHUNK_VOL * 4;
 
+class Block;
 class ContentReport;
 class Inventory;
 
@@ -22,12 +25,44 @@ using ChunkInventoriesMap =
 
 using BlocksMetadata = util::SmallHeap<uint16_t, uint8_t>;
 
+static_assert(CHUNK_SECTIONS <= 16, "sections mask is 16 bit");
+
+/// @brief Mask of all chunk sections
+inline constexpr uint16_t ALL_SECTIONS_MASK = (1 << CHUNK_SECTIONS) - 1;
+
+/// @brief Vertical chunk section summary used to skip whole sections.
+/// Unknown section is considered neither empty nor opaque
+struct ChunkSection {
+    /// @brief Number of non-air voxels
+    uint16_t blocks = CHUNK_SECTION_VOL;
+    /// @brief Number of voxels not passing light
+    uint16_t opaque = 0;
+    /// @brief Counts are calculated by Chunk::updateSections
+    bool counted = false;
+
+    /// @return true if all section voxels are air
+    bool isEmpty() const {
+        return blocks == 0;
+    }
+
+    /// @return true if no section voxels are passing light
+    bool isOpaque() const {
+        return opaque == CHUNK_SECTION_VOL;
+    }
+};
+
 class Chunk {
 public:
     int x, z;
     int bottom, top;
-    voxel voxels[CHUNK_VOL] {};
+    /// @brief Voxels storage, may be compacted for idle chunks
+    ChunkVoxels voxels;
     Lightmap lightmap;
+    /// @brief Vertical sections summary (see updateSections)
+    ChunkSection sections[CHUNK_SECTIONS] {};
+    /// @brief Per column Y above the highest voxel not passing sky light
+    /// (see updateSections). Indexed as z * CHUNK_W + x
+    uint16_t skyHeights[CHUNK_W * CHUNK_D];
     struct {
         bool modified : 1;
         bool ready : 1;
@@ -38,6 +73,8 @@ public:
         bool entities : 1;
         bool blocksData : 1;
     } flags {};
+    /// @brief Mask of sections requiring mesh rebuild (see setModified)
+    uint16_t modifiedSections = 0;
 
     /// @brief Block inventories map where key is index of block in voxels array
     ChunkInventoriesMap inventories;
@@ -49,6 +86,27 @@ public:
     /// @brief Refresh `bottom` and `top` values
     void updateHeights();
 
+    /// @brief Recount sections summary and columns sky heights
+    /// @param blockDefs block definitions indexed by id
+    void updateSections(const Block* const* blockDefs);
+
+    /// @brief Update section summary on voxel change
+    /// @param y changed voxel Y
+    /// @param prev previous voxel block definition
+    /// @param next new voxel block definition
+    void updateSection(uint y, const Block& prev, const Block& next);
+
+    /// @brief Update column sky height on voxel change
+    /// @param x,y,z changed voxel local position
+    /// @param next new voxel block definition
+    /// @param blockDefs block definitions indexed by id
+    void updateSkyHeight(
+        uint x, uint y, uint z, const Block& next, const Block* const* blockDefs
+    );
+
+    /// @brief Mark all sections summary and sky heights unknown
+    void resetSections();
+
     // unused
     std::unique_ptr<Chunk> clone() const;
 
@@ -63,15 +121,42 @@ public:
     /// @return inventory bound to the given block or nullptr
     std::shared_ptr<Inventory> getBlockInventory(uint x, uint y, uint z) const;
 
-    inline void setModifiedAndUnsaved() {
+    /// @brief Mark all sections for mesh rebuild
+    inline void setModified() {
+        flags.modified = true;
+        modifiedSections = ALL_SECTIONS_MASK;
+    }
+
+    /// @brief Mark sections for mesh rebuild after change of voxels or
+    /// lights at the given Y, including sections of the neighbour voxels
+    inline void setModified(int y) {
+        int minSection = std::max(y - 1, 0) / CHUNK_SECTION_H;
+        int maxSection = std::min(y + 1, CHUNK_H - 1) / CHUNK_SECTION_H;
         flags.modified = true;
+        modifiedSections |=
+            ((2u << maxSection) - 1) & ~((1u << minSection) - 1);
+    }
+
+    inline void setModifiedAndUnsaved() {
+        setModified();
         flags.unsaved = true;
+        voxels.touch();
+    }
+
+    /// @brief Mark voxels at the given Y modified and chunk unsaved
+    inline void setModifiedAndUnsaved(int y) {
+        setModified(y);
+        flags.unsaved = true;
+        voxels.touch();
     }
 
     /// @brief Encode chunk to bytes array of size CHUNK_DATA_LEN
     /// @see /doc/specs/region_voxels_chunk_spec.md
     std::unique_ptr<ubyte[]> encode() const;
 
+    /// @brief Encode voxels array of CHUNK_VOL length the same as encode()
+    static std::unique_ptr<ubyte[]> encode(const voxel* voxels);
+
     /// @return true if all is fine
     bool decode(const ubyte* data);
 
@@ -0,0 +1,70 @@
+#include "ChunkVoxels.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+#include "PalettedVoxels.hpp"
+
+ChunkVoxels::View::View(const ChunkVoxels& storage)
+    : lock(storage.mutex), voxels(storage.flat.get()) {
+    if (voxels == nullptr) {
+        decoded = std::make_unique<voxel[]>(CHUNK_VOL);
+        storage.paletted->decode(decoded.get());
+        voxels = decoded.get();
+    }
+}
+
+ChunkVoxels::ChunkVoxels() : flat(std::make_unique<voxel[]>(CHUNK_VOL)) {
+}
+
+ChunkVoxels::~ChunkVoxels() = default;
+
+voxel ChunkVoxels::getCompact(size_t index) const {
+    return paletted->get(index);
+}
+
+void ChunkVoxels::copyTo(voxel* dst) const {
+    if (flat) {
+        std::copy(flat.get(), flat.get() + CHUNK_VOL, dst);
+    } else {
+        paletted->decode(dst);
+    }
+}
+
+bool ChunkVoxels::compact() {
+    if (flat == nullptr) {
+        return true;
+    }
+    if (active) {
+        active = false;
+        return false;
+    }
+    // voxels being read by other thread are left for the next time
+    std::unique_lock lock(mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return false;
+    }
+    paletted = std::make_unique<PalettedVoxels>(flat.get());
+    flat = nullptr;
+    return true;
+}
+
+void ChunkVoxels::expand() {
+    if (flat) {
+        return;
+    }
+    // voxels are not reachable through flat pointer until decoded
+    auto flatVoxels = std::make_unique<voxel[]>(CHUNK_VOL);
+    paletted->decode(flatVoxels.get());
+    std::unique_lock lock(mutex);
+    flat = std::move(flatVoxels);
+    paletted = nullptr;
+    active = true;
+}
+
+size_t ChunkVoxels::getMemoryUsage() const {
+    if (flat) {
+        return CHUNK_VOL * sizeof(voxel);
+    }
+    return paletted->getMemoryUsage();
+}
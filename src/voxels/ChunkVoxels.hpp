@@ -0,0 +1,101 @@
+#pragma once
+
+#include <memory>
+#include <shared_mutex>
+
+#include "constants.hpp"
+#include "voxel.hpp"
+
+class PalettedVoxels;
+
+/// @brief Chunk voxels storage. Voxels of idle chunks may be compacted to
+/// PalettedVoxels and get expanded to the flat array on mutable access.
+///
+/// Compaction and expansion happen in the chunk owner (main) thread only.
+/// Other threads must access voxels through view() or, while the owner
+/// thread is waiting for them, through get().
+class ChunkVoxels {
+    std::unique_ptr<voxel[]> flat;
+    std::unique_ptr<PalettedVoxels> paletted;
+    /// @brief Protects representation change from view() readers
+    mutable std::shared_mutex mutex;
+    /// @brief Voxels were expanded or modified since last compaction attempt
+    bool active = true;
+
+    voxel getCompact(size_t index) const;
+public:
+    /// @brief Read access to voxels for other threads. Voxels could not be
+    /// compacted or expanded while a view exists
+    class View {
+        std::shared_lock<std::shared_mutex> lock;
+        std::unique_ptr<voxel[]> decoded;
+        const voxel* voxels;
+    public:
+        View(const ChunkVoxels& storage);
+
+        const voxel& operator[](size_t index) const {
+            return voxels[index];
+        }
+
+        const voxel* data() const {
+            return voxels;
+        }
+    };
+
+    ChunkVoxels();
+    ChunkVoxels(const ChunkVoxels&) = delete;
+    ~ChunkVoxels();
+
+    /// @brief Get mutable voxel reference. Expands compact voxels
+    voxel& operator[](size_t index) {
+        if (flat == nullptr) {
+            expand();
+        }
+        return flat[index];
+    }
+
+    /// @brief Get flat voxels array. Expands compact voxels
+    voxel* data() {
+        if (flat == nullptr) {
+            expand();
+        }
+        return flat.get();
+    }
+
+    /// @brief Get voxel without expanding compact voxels
+    voxel get(size_t index) const {
+        if (flat) {
+            return flat[index];
+        }
+        return getCompact(index);
+    }
+
+    /// @brief Copy voxels to the flat array of CHUNK_VOL length without
+    /// expanding compact voxels
+    void copyTo(voxel* dst) const;
+
+    View view() const {
+        return View(*this);
+    }
+
+    bool isCompact() const {
+        return flat == nullptr;
+    }
+
+    /// @brief Mark voxels as recently modified, so they will not be
+    /// compacted by the next compact() call
+    void touch() {
+        active = true;
+    }
+
+    /// @brief Convert voxels to the compact paletted representation
+    /// unless expanded or modified since the previous call
+    /// @return true if voxels are compact
+    bool compact();
+
+    /// @brief Convert compact voxels to the flat array
+    void expand();
+
+    /// @return approximate heap memory used by voxels
+    size_t getMemoryUsage() const;
+};
@@ -33,7 +33,9 @@ Chunks::Chunks(
       areaMap(w, d) {
     areaMap.setCenter(ox - w / 2, oz - d / 2);
     areaMap.setOutCallback([this](int, int, const auto& chunk) {
-        this->events->trigger(LevelEventType::CHUNK_HIDDEN, chunk.get());
+        if (this->events) {
+            this->events->trigger(LevelEventType::CHUNK_HIDDEN, chunk.get());
+        }
     });
 }
 
@@ -372,8 +374,8 @@ void Chunks::getVoxels(VoxelsVolume& volume, bool backlight) const {
                     }
                 }
             } else {
-                const voxel* cvoxels = chunk->voxels;
-                const light_t* clights = chunk->lightmap.getLights();
+                auto cvoxels = chunk->voxels.view();
+                const auto& clights = chunk->lightmap;
                 for (int ly = y; ly < y + h; ly++) {
                     for (int lz = std::max(z, cz * CHUNK_D);
                              lz < std::min(z + d, (cz + 1) * CHUNK_D);
@@ -390,7 +392,7 @@ void Chunks::getVoxels(VoxelsVolume& volume, bool backlight) const {
                                 CHUNK_D
                             );
                             voxels[vidx] = cvoxels[cidx];
-                            light_t light = clights[cidx];
+                            light_t light = clights.get(cidx);
                             if (backlight) {
                                 const auto block =
                                     indices.blocks.get(voxels[vidx].id);
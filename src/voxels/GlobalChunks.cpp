@@ -41,7 +41,7 @@ static void check_voxels(const ContentIndices& indices, Chunk& chunk) {
     bool corrupted = false;
     blockid_t defsCount = indices.blocks.count();
     for (size_t i = 0; i < CHUNK_VOL; i++) {
-        blockid_t id = chunk.voxels[i].id;
+        blockid_t id = chunk.voxels.get(i).id;
         if (id >= defsCount) {
             if (!corrupted) {
 #ifdef NDEBUG
@@ -74,7 +74,7 @@ static inline auto load_inventories(
     auto iterator = invs.begin();
     while (iterator != invs.end()) {
         uint index = iterator->first;
-        const auto& def = defs.require(chunk.voxels[index].id);
+        const auto& def = defs.require(chunk.voxels.get(index).id);
         if (def.inventorySize == 0) {
             iterator = invs.erase(iterator);
             continue;
@@ -176,21 +176,24 @@ void GlobalChunks::decref(Chunk* chunk) {
     }
 }
 
-void GlobalChunks::save(Chunk* chunk) {
-    if (chunk == nullptr) {
-        return;
-    }
-    AABB aabb = chunk->getAABB();
+std::vector<ubyte> GlobalChunks::serializeEntities(Chunk& chunk) {
+    AABB aabb = chunk.getAABB();
     auto entities = level.entities->getAllInside(aabb);
     auto root = dv::object();
     root["data"] = level.entities->serialize(entities);
     if (!entities.empty()) {
-        chunk->flags.entities = true;
+        chunk.flags.entities = true;
+    }
+    return chunk.flags.entities ? json::to_binary(root, true)
+                                : std::vector<ubyte>();
+}
+
+void GlobalChunks::save(Chunk* chunk) {
+    if (chunk == nullptr) {
+        return;
     }
     level.getWorld()->wfile->getRegions().put(
-        chunk,
-        chunk->flags.entities ? json::to_binary(root, true)
-                                : std::vector<ubyte>()
+        chunk, serializeEntities(*chunk)
     );
 }
 
@@ -200,6 +203,37 @@ void GlobalChunks::saveAll() {
     }
 }
 
+std::vector<std::shared_ptr<ChunkSnapshot>> GlobalChunks::snapshotAll() {
+    auto& regions = level.getWorld()->wfile->getRegions();
+    std::vector<std::shared_ptr<ChunkSnapshot>> snapshots;
+    for (const auto& [_, chunk] : chunksMap) {
+        if (auto snapshot = regions.snapshot(
+                chunk.get(), serializeEntities(*chunk)
+            )) {
+            snapshots.push_back(std::move(snapshot));
+        }
+    }
+    return snapshots;
+}
+
+size_t GlobalChunks::compactVoxels() {
+    size_t count = 0;
+    for (const auto& [_, chunk] : chunksMap) {
+        if (!chunk->flags.lighted || chunk->flags.modified) {
+            chunk->voxels.touch();
+            continue;
+        }
+        count += chunk->voxels.compact();
+    }
+    return count;
+}
+
+void GlobalChunks::expandVoxels() {
+    for (const auto& [_, chunk] : chunksMap) {
+        chunk->voxels.expand();
+    }
+}
+
 void GlobalChunks::putChunk(std::shared_ptr<Chunk> chunk) {
     chunksMap[keyfrom(chunk->x, chunk->z)] = std::move(chunk);
 }
@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
@@ -14,6 +15,7 @@ class Chunk;
 class Level;
 struct AABB;
 class ContentIndices;
+struct ChunkSnapshot;
 
 class GlobalChunks {
     static inline uint64_t keyfrom(int32_t x, int32_t z) {
@@ -33,6 +35,10 @@ class GlobalChunks {
     std::unordered_map<ptrdiff_t, int> refCounters;
 
     consumer<Chunk&> onUnload;
+
+    /// @brief Serialize entities inside the chunk
+    /// @return empty vector if chunk has no entities saved
+    std::vector<ubyte> serializeEntities(Chunk& chunk);
 public:
     GlobalChunks(Level& level);
     ~GlobalChunks() = default;
@@ -55,6 +61,17 @@ public:
     void save(Chunk* chunk);
     void saveAll();
 
+    /// @brief Copy unsaved data of all chunks to be stored in background
+    std::vector<std::shared_ptr<ChunkSnapshot>> snapshotAll();
+
+    /// @brief Compact voxels of chunks not modified or expanded since
+    /// the previous call
+    /// @return number of chunks having compact voxels
+    size_t compactVoxels();
+
+    /// @brief Expand compact voxels of all chunks
+    void expandVoxels();
+
     void putChunk(std::shared_ptr<Chunk> chunk);
 
     const AABB* isObstacleAt(float x, float y, float z) const;
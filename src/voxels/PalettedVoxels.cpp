@@ -0,0 +1,92 @@
+#include "PalettedVoxels.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+static inline uint32_t voxel_key(const voxel& vox) {
+    return static_cast<uint32_t>(vox.id) |
+           static_cast<uint32_t>(blockstate2int(vox.state)) << 16;
+}
+
+static uint bits_for_palette(size_t size) {
+    uint bits = 1;
+    while ((1ULL << bits) < size) {
+        bits *= 2;
+    }
+    return bits;
+}
+
+PalettedVoxels::PalettedVoxels(const voxel* voxels) {
+    std::vector<uint16_t> local(CHUNK_SECTION_VOL);
+    std::unordered_map<uint32_t, uint16_t> paletteIndices;
+
+    for (int s = 0; s < CHUNK_SECTIONS; s++) {
+        auto& section = sections[s];
+        const voxel* src = voxels + s * CHUNK_SECTION_VOL;
+        paletteIndices.clear();
+
+        // neighbour voxels are often the same, so the last match is cached
+        uint32_t prevKey = voxel_key(src[0]) + 1;
+        uint16_t prevIndex = 0;
+        for (uint i = 0; i < CHUNK_SECTION_VOL; i++) {
+            uint32_t key = voxel_key(src[i]);
+            if (key != prevKey) {
+                auto found = paletteIndices.find(key);
+                if (found == paletteIndices.end()) {
+                    prevIndex = section.palette.size();
+                    paletteIndices[key] = prevIndex;
+                    section.palette.push_back(src[i]);
+                } else {
+                    prevIndex = found->second;
+                }
+                prevKey = key;
+            }
+            local[i] = prevIndex;
+        }
+        section.palette.shrink_to_fit();
+        if (section.palette.size() == 1) {
+            section.bits = 0;
+            continue;
+        }
+        section.bits = bits_for_palette(section.palette.size());
+        uint perWord = 64 / section.bits;
+        section.indices.resize((CHUNK_SECTION_VOL + perWord - 1) / perWord);
+        for (uint i = 0; i < CHUNK_SECTION_VOL; i++) {
+            section.indices[i / perWord] |= static_cast<uint64_t>(local[i])
+                                            << ((i % perWord) * section.bits);
+        }
+    }
+}
+
+void PalettedVoxels::decode(voxel* dst) const {
+    for (int s = 0; s < CHUNK_SECTIONS; s++) {
+        const auto& section = sections[s];
+        voxel* sectionDst = dst + s * CHUNK_SECTION_VOL;
+        if (section.bits == 0) {
+            std::fill(
+                sectionDst, sectionDst + CHUNK_SECTION_VOL, section.palette[0]
+            );
+            continue;
+        }
+        uint bits = section.bits;
+        uint perWord = 64 / bits;
+        uint64_t mask = (1ULL << bits) - 1;
+        const voxel* palette = section.palette.data();
+        uint index = 0;
+        for (uint64_t word : section.indices) {
+            for (uint i = 0; i < perWord && index < CHUNK_SECTION_VOL; i++) {
+                sectionDst[index++] = palette[word & mask];
+                word >>= bits;
+            }
+        }
+    }
+}
+
+size_t PalettedVoxels::getMemoryUsage() const {
+    size_t size = sizeof(PalettedVoxels);
+    for (const auto& section : sections) {
+        size += section.palette.capacity() * sizeof(voxel);
+        size += section.indices.capacity() * sizeof(uint64_t);
+    }
+    return size;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "constants.hpp"
+#include "typedefs.hpp"
+#include "voxel.hpp"
+
+/// @brief Compact read-only representation of chunk voxels.
+/// Each vertical section has own palette of unique voxels and bit-packed
+/// palette indices. Uniform sections (like air above terrain) store
+/// the only palette entry.
+class PalettedVoxels {
+    struct Section {
+        std::vector<voxel> palette;
+        /// @brief Bits per palette index: 0 (uniform section), 1, 2, 4,
+        /// 8 or 16. Power of two, so indices never cross words bounds
+        uint bits = 0;
+        std::vector<uint64_t> indices;
+    };
+    Section sections[CHUNK_SECTIONS];
+public:
+    /// @param voxels source voxels array of CHUNK_VOL length
+    PalettedVoxels(const voxel* voxels);
+
+    /// @brief Get voxel by index in flat voxels array
+    voxel get(uint index) const {
+        const auto& section = sections[index / CHUNK_SECTION_VOL];
+        if (section.bits == 0) {
+            return section.palette[0];
+        }
+        uint local = index % CHUNK_SECTION_VOL;
+        uint perWord = 64 / section.bits;
+        uint64_t word = section.indices[local / perWord];
+        uint shift = (local % perWord) * section.bits;
+        uint64_t mask = (1ULL << section.bits) - 1;
+        return section.palette[(word >> shift) & mask];
+    }
+
+    /// @brief Decode voxels to flat array
+    /// @param dst destination voxels array of CHUNK_VOL length
+    void decode(voxel* dst) const;
+
+    /// @return true if all voxels of the section are the same
+    bool isUniform(uint section) const {
+        return sections[section].bits == 0;
+    }
+
+    /// @return approximate heap memory used by the representation
+    size_t getMemoryUsage() const;
+};
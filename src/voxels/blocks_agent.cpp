@@ -48,9 +48,11 @@ static inline void set_block(
 
     // block initialization
     const auto& newdef = indices.blocks.require(id);
+    chunk->updateSection(y, prevdef, newdef);
     vox.id = id;
     vox.state = state;
-    chunk->setModifiedAndUnsaved();
+    chunk->updateSkyHeight(lx, y, lz, newdef, indices.blocks.getDefs());
+    chunk->setModifiedAndUnsaved(y);
     if (!state.segment && newdef.rt.extended) {
         repair_segments(chunks, newdef, state, x, y, z);
     }
@@ -63,16 +65,16 @@ static inline void set_block(
         chunk->updateHeights();
 
     if (lx == 0 && (chunk = get_chunk(chunks, cx - 1, cz))) {
-        chunk->flags.modified = true;
+        chunk->setModified(y);
     }
     if (lz == 0 && (chunk = get_chunk(chunks, cx, cz - 1))) {
-        chunk->flags.modified = true;
+        chunk->setModified(y);
     }
     if (lx == CHUNK_W - 1 && (chunk = get_chunk(chunks, cx + 1, cz))) {
-        chunk->flags.modified = true;
+        chunk->setModified(y);
     }
     if (lz == CHUNK_D - 1 && (chunk = get_chunk(chunks, cx, cz + 1))) {
-        chunk->flags.modified = true;
+        chunk->setModified(y);
     }
 }
 
@@ -313,8 +315,8 @@ inline void get_voxels_impl(
                     }
                 }
             } else {
-                const voxel* cvoxels = chunk->voxels;
-                const light_t* clights = chunk->lightmap.getLights();
+                auto cvoxels = chunk->voxels.view();
+                const auto& clights = chunk->lightmap;
                 for (int ly = y; ly < y + h; ly++) {
                     for (int lz = std::max(z, cz * CHUNK_D);
                              lz < std::min(z + d, (cz + 1) * CHUNK_D);
@@ -331,7 +333,7 @@ inline void get_voxels_impl(
                                 CHUNK_D
                             );
                             voxels[vidx] = cvoxels[cidx];
-                            light_t light = clights[cidx];
+                            light_t light = clights.get(cidx);
                             if (backlight) {
                                 const auto block = blocks.get(voxels[vidx].id);
                                 if (block && block->lightPassing) {
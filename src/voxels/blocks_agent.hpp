@@ -14,6 +14,7 @@
 #include "maths/voxmaths.hpp"
 
 #include <algorithm>
+#include <optional>
 #include <set>
 #include <algorithm>
 #include <stdint.h>
@@ -59,6 +60,32 @@ inline voxel* get(const Storage& chunks, int32_t x, int32_t y, int32_t z) {
     return &chunk->voxels[(y * CHUNK_D + lz) * CHUNK_W + lx];
 }
 
+/// @brief Get voxel copy at specified position. Unlike get(...) does not
+/// expand compact chunk voxels, so use it for reading.
+/// @tparam Storage chunks storage class
+/// @param chunks chunks storage
+/// @param x position X
+/// @param y position Y
+/// @param z position Z
+/// @return voxel or std::nullopt if voxel does not exist
+template<class Storage>
+inline std::optional<voxel> peek(
+    const Storage& chunks, int32_t x, int32_t y, int32_t z
+) {
+    if (y < 0 || y >= CHUNK_H) {
+        return std::nullopt;
+    }
+    int cx = floordiv<CHUNK_W>(x);
+    int cz = floordiv<CHUNK_D>(z);
+    Chunk* chunk = get_chunk(chunks, cx, cz);
+    if (chunk == nullptr) {
+        return std::nullopt;
+    }
+    int lx = x - cx * CHUNK_W;
+    int lz = z - cz * CHUNK_D;
+    return chunk->voxels.get((y * CHUNK_D + lz) * CHUNK_W + lx);
+}
+
 /// @brief Get voxel at specified position.
 /// @throws std::runtime_error if voxel does not exists
 /// @tparam Storage chunks storage class
@@ -91,7 +118,7 @@ inline const Block& get_block_def(const Storage& chunks, blockid_t id) {
 /// @return true if block exists and solid
 template<class Storage>
 inline bool is_solid_at(const Storage& chunks, int32_t x, int32_t y, int32_t z) {
-    if (auto vox = get(chunks, x, y, z)) {
+    if (auto vox = peek(chunks, x, y, z)) {
         return get_block_def(chunks, vox->id).rt.solid;
     }
     return false;
@@ -106,7 +133,7 @@ inline bool is_solid_at(const Storage& chunks, int32_t x, int32_t y, int32_t z)
 /// @return true if block exists and replaceable
 template<class Storage>
 inline bool is_replaceable_at(const Storage& chunks, int32_t x, int32_t y, int32_t z) {
-    if (auto vox = get(chunks, x, y, z)) {
+    if (auto vox = peek(chunks, x, y, z)) {
         return get_block_def(chunks, vox->id).replaceable;
     }
     return false;
@@ -239,7 +266,7 @@ inline glm::ivec3 seek_origin(
         if (segment & 2) pos -= rotation.axes[1];
         if (segment & 4) pos -= rotation.axes[2];
 
-        if (auto* voxel = get(chunks, pos.x, pos.y, pos.z)) {
+        if (auto voxel = peek(chunks, pos.x, pos.y, pos.z)) {
             segment = voxel->state.segment;
         } else {
             return pos;
@@ -273,7 +300,7 @@ inline bool check_replaceability(
                 pos += rotation.axes[0] * sx;
                 pos += rotation.axes[1] * sy;
                 pos += rotation.axes[2] * sz;
-                if (auto vox = get(chunks, pos.x, pos.y, pos.z)) {
+                if (auto vox = peek(chunks, pos.x, pos.y, pos.z)) {
                     auto& target = blocks.require(vox->id);
                     if (!target.replaceable && vox->id != ignore) {
                         return false;
@@ -335,7 +362,7 @@ inline void set_rotation_extended(
                     int cz = floordiv<CHUNK_D>(pos.z);
                     auto chunk = get_chunk(chunks, cx, cz);
                     assert(chunk != nullptr);
-                    chunk->setModifiedAndUnsaved();
+                    chunk->setModifiedAndUnsaved(pos.y);
                     segmentBlocks.emplace_back(pos);
                 }
             }
@@ -391,7 +418,7 @@ inline void set_rotation(
         int cz = floordiv<CHUNK_D>(z);
         auto chunk = get_chunk(chunks, cx, cz);
         assert(chunk != nullptr);
-        chunk->setModifiedAndUnsaved();
+        chunk->setModifiedAndUnsaved(y);
     }
 }
 
@@ -446,8 +473,8 @@ inline const AABB* is_obstacle_at(const Storage& chunks, float x, float y, float
     int ix = std::floor(x);
     int iy = std::floor(y);
     int iz = std::floor(z);
-    voxel* v = get(chunks, ix, iy, iz);
-    if (v == nullptr) {
+    auto v = peek(chunks, ix, iy, iz);
+    if (!v) {
         if (iy >= CHUNK_H) {
             return nullptr;
         } else {
@@ -2,6 +2,8 @@
 
 #include "coders/rle.hpp"
 #include "coders/gzip.hpp"
+#include "coders/lz4.hpp"
+#include "coders/zstd.hpp"
 
 #include "world/files/WorldFiles.hpp"
 #include "content/Content.hpp"
@@ -9,44 +11,118 @@
 inline constexpr int HAS_VOXELS = 0x1;
 inline constexpr int HAS_METADATA = 0x2;
 
+/// @brief Voxels compression method written to the second byte. Zero is
+/// used for GZIP, so data is readable by versions having the byte reserved
+static ubyte method_to_byte(compression::Method method) {
+    switch (method) {
+        case compression::Method::GZIP:
+            return 0;
+        case compression::Method::LZ4:
+        case compression::Method::ZSTD:
+            return static_cast<ubyte>(method);
+        default:
+            throw std::invalid_argument(
+                "unsupported chunk data compression method"
+            );
+    }
+}
+
+static compression::Method byte_to_method(ubyte value) {
+    if (value == 0) {
+        return compression::Method::GZIP;
+    }
+    auto method = static_cast<compression::Method>(value);
+    if (method != compression::Method::LZ4 &&
+        method != compression::Method::ZSTD) {
+        throw std::runtime_error(
+            "unsupported chunk data compression method " + std::to_string(value)
+        );
+    }
+    return method;
+}
+
 std::vector<ubyte> compressed_chunks::encode(
     const ubyte* data,
     const BlocksMetadata& metadata,
-    util::Buffer<ubyte>& rleBuffer
+    util::Buffer<ubyte>& rleBuffer,
+    compression::Method method
 ) {
+    ubyte methodByte = method_to_byte(method);
     size_t rleCompressedSize =
         extrle::encode16(data, CHUNK_DATA_LEN, rleBuffer.data());
 
-    const auto gzipCompressedData = gzip::compress(
-        rleBuffer.data(), rleCompressedSize
-    );
+    std::vector<ubyte> compressedData;
+    switch (method) {
+        case compression::Method::LZ4:
+            compressedData = lz4::compress(rleBuffer.data(), rleCompressedSize);
+            break;
+        case compression::Method::ZSTD:
+            compressedData = zstd::compress(rleBuffer.data(), rleCompressedSize);
+            break;
+        default:
+            compressedData = gzip::compress(rleBuffer.data(), rleCompressedSize);
+            break;
+    }
     auto metadataBytes = metadata.serialize();
 
-    ByteBuilder builder(2 + 8 + gzipCompressedData.size() + metadataBytes.size());
+    ByteBuilder builder(2 + 12 + compressedData.size() + metadataBytes.size());
     builder.put(HAS_VOXELS | HAS_METADATA); // flags
-    builder.put(0); // reserved
-    builder.putInt32(gzipCompressedData.size());
-    builder.put(gzipCompressedData.data(), gzipCompressedData.size());
+    builder.put(methodByte);
+    if (method != compression::Method::GZIP) {
+        // gzip stores source length itself
+        builder.putInt32(rleCompressedSize);
+    }
+    builder.putInt32(compressedData.size());
+    builder.put(compressedData.data(), compressedData.size());
     builder.putInt32(metadataBytes.size());
     builder.put(metadataBytes.data(), metadataBytes.size());
     return builder.build();
 }
 
-std::vector<ubyte> compressed_chunks::encode(const Chunk& chunk) {
+std::vector<ubyte> compressed_chunks::encode(
+    const Chunk& chunk, compression::Method method
+) {
     auto data = chunk.encode();
 
     /// world.get_chunk_data is only available in the main Lua state
     static util::Buffer<ubyte> rleBuffer(CHUNK_DATA_LEN * 2);
-    return encode(data.get(), chunk.blocksMetadata, rleBuffer);
+    return encode(data.get(), chunk.blocksMetadata, rleBuffer, method);
 }
 
-static void read_voxel_data(ByteReader& reader, util::Buffer<ubyte>& dst) {
-    size_t gzipCompressedSize = reader.getInt32();
-        
-    auto rleData = gzip::decompress(reader.pointer(), gzipCompressedSize);
-    reader.skip(gzipCompressedSize);
+static void read_voxel_data(
+    ByteReader& reader, util::Buffer<ubyte>& dst, compression::Method method
+) {
+    if (method == compression::Method::GZIP) {
+        size_t gzipCompressedSize = reader.getInt32();
+
+        auto rleData = gzip::decompress(reader.pointer(), gzipCompressedSize);
+        reader.skip(gzipCompressedSize);
 
-    extrle::decode16(rleData.data(), rleData.size(), dst.data());
+        extrle::decode16(rleData.data(), rleData.size(), dst.data());
+        return;
+    }
+    size_t rleSize = reader.getInt32();
+    size_t compressedSize = reader.getInt32();
+    if (rleSize > CHUNK_DATA_LEN * 2) {
+        throw std::runtime_error("invalid chunk data length");
+    }
+    /// world.get_chunk_data is only available in the main Lua state
+    static util::Buffer<ubyte> rleData(CHUNK_DATA_LEN * 2);
+    size_t decompressedSize;
+    if (method == compression::Method::LZ4) {
+        decompressedSize = lz4::decompress(
+            reader.pointer(), compressedSize, rleData.data(), rleSize
+        );
+    } else {
+        decompressedSize = zstd::decompress(
+            reader.pointer(), compressedSize, rleData.data(), rleSize
+        );
+    }
+    reader.skip(compressedSize);
+    if (decompressedSize != rleSize) {
+        throw std::runtime_error("invalid chunk data length");
+    }
+    extrle::decode16(rleData.data(), rleSize, dst.data());
 }
 
 void compressed_chunks::decode(
@@ -55,12 +131,12 @@ void compressed_chunks::decode(
     ByteReader reader(src, size);
 
     ubyte flags = reader.get();
-    reader.skip(1); // reserved byte
+    auto method = byte_to_method(reader.get());
 
     if (flags & HAS_VOXELS) {
         /// world.get_chunk_data is only available in the main Lua state
         static util::Buffer<ubyte> voxelData (CHUNK_DATA_LEN);
-        read_voxel_data(reader, voxelData);
+        read_voxel_data(reader, voxelData, method);
         // TODO: move somewhere in Chunk
         auto src = reinterpret_cast<const uint16_t*>(voxelData.data());
         for (size_t i = 0; i < CHUNK_VOL; i++) {
@@ -75,6 +151,7 @@ void compressed_chunks::decode(
         }
         chunk.decode(voxelData.data());
         chunk.updateHeights();
+        chunk.updateSections(indices.blocks.getDefs());
     }
     if (flags & HAS_METADATA) {
         size_t metadataSize = reader.getInt32();
@@ -90,10 +167,10 @@ void compressed_chunks::save(
     ByteReader reader(bytes.data(), bytes.size());
 
     ubyte flags = reader.get();
-    reader.skip(1); // reserved byte
+    auto method = byte_to_method(reader.get());
     if (flags & HAS_VOXELS) {
         util::Buffer<ubyte> voxelData (CHUNK_DATA_LEN);
-        read_voxel_data(reader, voxelData);
+        read_voxel_data(reader, voxelData, method);
         regions.put(
             x, z, REGION_LAYER_VOXELS, voxelData.release(), CHUNK_DATA_LEN
         );
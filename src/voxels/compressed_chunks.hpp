@@ -3,6 +3,7 @@
 #include "typedefs.hpp"
 #include "Chunk.hpp"
 #include "coders/byte_utils.hpp"
+#include "coders/compression.hpp"
 
 #include <vector>
 
@@ -10,12 +11,20 @@ class ContentIndices;
 class WorldRegions;
 
 namespace compressed_chunks {
+    /// @brief Encode chunk data to send
+    /// @param method voxels data compression method applied after extrle16:
+    /// GZIP (readable by older versions), LZ4 or ZSTD
+    /// @throws std::invalid_argument if method is not supported
     std::vector<ubyte> encode(
         const ubyte* voxelData,
         const BlocksMetadata& metadata,
-        util::Buffer<ubyte>& rleBuffer
+        util::Buffer<ubyte>& rleBuffer,
+        compression::Method method = compression::Method::GZIP
+    );
+    std::vector<ubyte> encode(
+        const Chunk& chunk,
+        compression::Method method = compression::Method::GZIP
     );
-    std::vector<ubyte> encode(const Chunk& chunk);
     void decode(
         Chunk& chunk,
         const ubyte* src,
@@ -67,8 +67,13 @@ void World::writeResources(const Content& content) {
 
 void World::write(Level* level) {
     level->chunks->saveAll();
+    writeMetadata(level);
+    wfile->writeRegions();
+}
+
+void World::writeMetadata(Level* level) {
     info.nextEntityId = level->entities->peekNextID();
-    wfile->write(this, &content);
+    wfile->writeMetadata(this, &content);
 
     auto playerFile = level->players->serialize();
     io::write_json(wfile->getPlayerFile(), playerFile);
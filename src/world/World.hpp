@@ -76,6 +76,10 @@ public:
     /// @brief Write all unsaved level data to the world directory
     void write(Level* level);
 
+    /// @brief Write world info, content indices, players and resources
+    /// without chunks
+    void writeMetadata(Level* level);
+
     /// @brief Check world indices and generate ContentReport if convert required
     /// @param directory world directory
     /// @param content current Content instance
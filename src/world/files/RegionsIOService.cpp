@@ -0,0 +1,88 @@
+#include "RegionsIOService.hpp"
+
+#include "WorldRegions.hpp"
+
+class RegionsIOWorker : public util::Worker<RegionsIORequest, RegionsIORequest> {
+    WorldRegions& regions;
+public:
+    RegionsIOWorker(WorldRegions& regions) : regions(regions) {
+    }
+
+    RegionsIORequest operator()(const RegionsIORequest& request) override {
+        switch (request.type) {
+            case RegionsIORequestType::PREFETCH:
+                regions.prefetch(request.x, request.z);
+                break;
+            case RegionsIORequestType::COMPACT:
+                regions.compact();
+                break;
+        }
+        return request;
+    }
+};
+
+RegionsIOService::RegionsIOService(WorldRegions& regions, int maxWorkers)
+    : regions(regions),
+      pool(
+          "regions-io",
+          [&regions]() { return std::make_shared<RegionsIOWorker>(regions); },
+          [this](RegionsIORequest& request) {
+              if (request.type == RegionsIORequestType::COMPACT) {
+                  compacting = false;
+              } else {
+                  pending.erase({request.x, request.z});
+              }
+              if (request.callback) {
+                  request.callback();
+              }
+          },
+          maxWorkers
+      ) {
+    pool.setStopOnFail(false);
+}
+
+RegionsIOService::~RegionsIOService() = default;
+
+bool RegionsIOService::request(int x, int z, runnable callback) {
+    if (!pending.insert({x, z}).second) {
+        return false;
+    }
+    pool.enqueueJob(RegionsIORequest {
+        RegionsIORequestType::PREFETCH, x, z, std::move(callback)});
+    return true;
+}
+
+void RegionsIOService::prefetch(
+    glm::ivec2 center, const std::vector<glm::ivec2>& chunks
+) {
+    if (prefetchCenter == center) {
+        return;
+    }
+    prefetchCenter = center;
+    cancelAll();
+    for (const auto& pos : chunks) {
+        request(pos.x, pos.y);
+    }
+}
+
+void RegionsIOService::cancelAll() {
+    pool.clearQueue();
+    // requests being processed will be erased on completion
+    pending.clear();
+    compacting = false;
+}
+
+bool RegionsIOService::isPending(int x, int z) const {
+    return pending.find({x, z}) != pending.end();
+}
+
+void RegionsIOService::update() {
+    pool.update();
+
+    if (!compacting && regions.hasFragmented()) {
+        compacting = true;
+        pool.enqueueJob(
+            RegionsIORequest {RegionsIORequestType::COMPACT, 0, 0, nullptr}
+        );
+    }
+}
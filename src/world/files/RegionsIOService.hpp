@@ -0,0 +1,77 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <unordered_set>
+#include <vector>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtx/hash.hpp>
+
+#include "delegates.hpp"
+#include "typedefs.hpp"
+#include "util/ThreadPool.hpp"
+
+class WorldRegions;
+
+enum class RegionsIORequestType {
+    /// @brief read chunk data to in-memory regions
+    PREFETCH,
+    /// @brief rewrite fragmented region files
+    COMPACT,
+};
+
+struct RegionsIORequest {
+    RegionsIORequestType type;
+    /// @brief chunk coords
+    int x, z;
+    /// @brief called in the main thread when chunk data is read
+    runnable callback;
+};
+
+/// @brief Background region files reader. Reads chunks data into in-memory
+/// regions in worker threads so main thread does not wait for disk.
+/// Also compacts region files fragmented by incremental writes.
+class RegionsIOService {
+    WorldRegions& regions;
+    std::unordered_set<glm::ivec2> pending;
+    bool compacting = false;
+    std::optional<glm::ivec2> prefetchCenter;
+    util::ThreadPool<RegionsIORequest, RegionsIORequest> pool;
+public:
+    RegionsIOService(WorldRegions& regions, int maxWorkers = 1);
+    ~RegionsIOService();
+
+    /// @brief Request chunk data to be read in background
+    /// @param x chunk.x
+    /// @param z chunk.z
+    /// @param callback completion callback (called in update)
+    /// @return false if request for the chunk is already pending
+    bool request(int x, int z, runnable callback = nullptr);
+
+    /// @brief Replace all queued requests with chunks around the center.
+    /// Does nothing if center is not changed since previous call.
+    /// @param center center chunk coords
+    /// @param chunks chunks coords ordered by priority (nearest first)
+    void prefetch(glm::ivec2 center, const std::vector<glm::ivec2>& chunks);
+
+    bool isPrefetchCenter(glm::ivec2 center) const {
+        return prefetchCenter == center;
+    }
+
+    /// @brief Drop all requests not started yet.
+    /// Callbacks of dropped requests will not be called
+    void cancelAll();
+
+    bool isPending(int x, int z) const;
+
+    size_t getPendingCount() const {
+        return pending.size();
+    }
+
+    /// @brief Call completion callbacks of finished requests and schedule
+    /// compaction of fragmented region files. Must be called in the main
+    /// thread
+    void update();
+};
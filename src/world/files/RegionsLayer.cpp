@@ -1,17 +1,55 @@
 #include "WorldRegions.hpp"
 
+#include <algorithm>
 #include <cstring>
+#include <fstream>
 
+#include "coders/zstd.hpp"
+#include "debug/Logger.hpp"
 #include "util/data_io.hpp"
 
 #define REGION_FORMAT_MAGIC ".VOXREG"
 
+static debug::Logger logger("regions-layer");
+
 static io::path get_region_filename(int x, int z) {
     return std::to_string(x) + "_" + std::to_string(z) + ".bin";
 }
 
+static io::path get_journal_path(const io::path& file) {
+    return file.parent() / (file.name() + ".journal");
+}
+
+/// @brief Truncate region file to the length stored in journal left by
+/// an interrupted incremental write. Previous offsets table is kept at the
+/// end of the file until new one is written completely
+static void recover_region_file(const io::path& file) {
+    auto journal = get_journal_path(file);
+    if (!io::exists(journal)) {
+        return;
+    }
+    auto bytes = io::read_bytes(journal);
+    // incomplete journal is written before the file is modified
+    if (bytes.size() == sizeof(uint64_t) && io::exists(file)) {
+        uint64_t length;
+        std::memcpy(&length, bytes.data(), sizeof(length));
+        length = dataio::le2h(length);
+        if (length <= io::file_size(file)) {
+            logger.warning() << "restoring region file " << file.string();
+            std::filesystem::resize_file(io::resolve(file), length);
+        }
+    }
+    io::remove(journal);
+}
+
 /// @brief Read missing chunks data (null pointers) from region file
-static void fetch_chunks(WorldRegion* region, int x, int z, regfile* file) {
+static void fetch_chunks(
+    const RegionsLayer& layer,
+    WorldRegion* region,
+    int x,
+    int z,
+    regfile* file
+) {
     auto* chunks = region->getChunks();
     auto sizes = region->getSizes();
 
@@ -19,17 +57,36 @@ static void fetch_chunks(WorldRegion* region, int x, int z, regfile* file) {
         int chunk_x = (i % REGION_SIZE) + x * REGION_SIZE;
         int chunk_z = (i / REGION_SIZE) + z * REGION_SIZE;
         if (chunks[i] == nullptr) {
-            chunks[i] = RegionsLayer::readChunkData(
-                    chunk_x, chunk_z, sizes[i][0], sizes[i][1], file);
+            auto data = RegionsLayer::readChunkData(
+                chunk_x, chunk_z, sizes[i][0], sizes[i][1], file
+            );
+            chunks[i] = layer.convertChunkData(
+                std::move(data), sizes[i][0], sizes[i][1], file->compression
+            );
         }
     }
 }
 
-regfile::regfile(io::path filename) : file(std::move(filename)) {
-    if (file.length() < REGION_HEADER_SIZE)
+regfile::regfile(io::path filename, bool mapped) {
+    if (mapped) {
+        try {
+            mapping = std::make_unique<io::mmapfile>(filename);
+        } catch (const std::runtime_error&) {
+            // fallback to random access file
+        }
+    }
+    if (mapping == nullptr) {
+        file = std::make_unique<io::rafile>(std::move(filename));
+    }
+    size_t fileSize = length();
+    if (fileSize < REGION_HEADER_SIZE + REGION_CHUNKS_COUNT * 4)
         throw std::runtime_error("incomplete region file header");
     char header[REGION_HEADER_SIZE];
-    file.read(header, REGION_HEADER_SIZE);
+    if (mapping) {
+        std::memcpy(header, mapping->data(), REGION_HEADER_SIZE);
+    } else {
+        file->read(header, REGION_HEADER_SIZE);
+    }
 
     // avoid of use strcmp_s
     if (std::string(header, std::strlen(REGION_FORMAT_MAGIC)) !=
@@ -42,91 +99,246 @@ regfile::regfile(io::path filename) : file(std::move(filename)) {
             "region format " + std::to_string(version) + " is not supported"
         );
     }
+    ubyte method = header[9];
+    if (method > static_cast<ubyte>(compression::Method::ZSTD)) {
+        throw illegal_region_format(
+            "unknown compression method " + std::to_string(method)
+        );
+    }
+    compression = static_cast<compression::Method>(method);
+
+    // reading whole offsets table at once
+    size_t tableOffset = fileSize - REGION_CHUNKS_COUNT * 4;
+    if (mapping) {
+        std::memcpy(
+            offsets, mapping->data() + tableOffset, REGION_CHUNKS_COUNT * 4
+        );
+    } else {
+        file->seekg(tableOffset);
+        file->read(reinterpret_cast<char*>(offsets), REGION_CHUNKS_COUNT * 4);
+    }
+    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        offsets[i] = dataio::le2h(offsets[i]);
+        if (offsets[i] != 0 &&
+            static_cast<size_t>(offsets[i]) + 8 > tableOffset) {
+            throw illegal_region_format("chunk data offset is out of bounds");
+        }
+    }
 }
 
-std::unique_ptr<ubyte[]> regfile::read(int index, uint32_t& size, uint32_t& srcSize) {
-    size_t file_size = file.length();
-    size_t table_offset = file_size - REGION_CHUNKS_COUNT * 4;
+void regfile::checkChunkBounds(uint32_t offset, uint32_t size) const {
+    // sizes are read from file and may be corrupted, so no uint32 overflow
+    size_t end = static_cast<size_t>(offset) + 8 + size;
+    if (end > length() - REGION_CHUNKS_COUNT * 4) {
+        throw illegal_region_format("chunk data is out of bounds");
+    }
+}
+
+size_t regfile::length() const {
+    return mapping ? mapping->length() : file->length();
+}
+
+uint32_t regfile::getChunkDataSize(int index) {
+    uint32_t offset = offsets[index];
+    if (offset == 0) {
+        return 0;
+    }
+    uint32_t buff32;
+    if (mapping) {
+        std::memcpy(&buff32, mapping->data() + offset, 4);
+    } else {
+        file->seekg(offset);
+        file->read(reinterpret_cast<char*>(&buff32), 4);
+    }
+    return dataio::le2h(buff32);
+}
 
+const ubyte* regfile::view(
+    int index, uint32_t& size, uint32_t& srcSize
+) const {
+    uint32_t offset = offsets[index];
+    if (offset == 0 || mapping == nullptr) {
+        return nullptr;
+    }
+    const ubyte* bytes = mapping->data() + offset;
     uint32_t buff32;
-    file.seekg(table_offset + index * 4);
-    file.read(reinterpret_cast<char*>(&buff32), 4);
-    uint32_t offset = dataio::le2h(buff32);
+    std::memcpy(&buff32, bytes, 4);
+    size = dataio::le2h(buff32);
+    std::memcpy(&buff32, bytes + 4, 4);
+    srcSize = dataio::le2h(buff32);
+
+    checkChunkBounds(offset, size);
+    return bytes + 8;
+}
+
+std::unique_ptr<ubyte[]> regfile::read(int index, uint32_t& size, uint32_t& srcSize) {
+    uint32_t offset = offsets[index];
     if (offset == 0) {
         return nullptr;
     }
+    if (mapping) {
+        const ubyte* bytes = view(index, size, srcSize);
+        auto data = std::make_unique<ubyte[]>(size);
+        std::memcpy(data.get(), bytes, size);
+        return data;
+    }
 
-    file.seekg(offset);
-    file.read(reinterpret_cast<char*>(&buff32), 4);
+    uint32_t buff32;
+    file->seekg(offset);
+    file->read(reinterpret_cast<char*>(&buff32), 4);
     size = dataio::le2h(buff32);
-    file.read(reinterpret_cast<char*>(&buff32), 4);
+    file->read(reinterpret_cast<char*>(&buff32), 4);
     srcSize = dataio::le2h(buff32);
+    checkChunkBounds(offset, size);
 
     auto data = std::make_unique<ubyte[]>(size);
-    file.read(reinterpret_cast<char*>(data.get()), size);
+    file->read(reinterpret_cast<char*>(data.get()), size);
     return data;
 }
 
+RegionFilesCache::RegionFilesCache(size_t capacity, size_t shardsCount)
+    : shards(std::make_unique<Shard[]>(shardsCount)),
+      shardsCount(shardsCount) {
+    setCapacity(capacity);
+}
+
+RegionFilesCache::~RegionFilesCache() = default;
 
-void RegionsLayer::closeRegFile(glm::ivec2 coord) {
-    openRegFiles.erase(coord);
-    regFilesCv.notify_one();
+RegionFilesCache::Shard& RegionFilesCache::getShard(glm::ivec2 coord) {
+    return shards[std::hash<glm::ivec2>()(coord) % shardsCount];
 }
 
-regfile_ptr RegionsLayer::useRegFile(glm::ivec2 coord) {
-    auto* file = openRegFiles[coord].get();
-    file->inUse = true;
-    return regfile_ptr(file, &regFilesCv);
+bool RegionFilesCache::evict(Shard& shard) {
+    for (auto it = shard.order.rbegin(); it != shard.order.rend(); ++it) {
+        auto found = shard.files.find(*it);
+        if (found->second.first->inUse) {
+            continue;
+        }
+        shard.order.erase(found->second.second);
+        shard.files.erase(found);
+        evictions++;
+        return true;
+    }
+    return false;
 }
 
-// Marks regfile as used and unmarks when shared_ptr dies
-regfile_ptr RegionsLayer::getRegFile(glm::ivec2 coord, bool create) {
-    {
-        std::lock_guard lock(regFilesMutex);
-        const auto found = openRegFiles.find(coord);
-        if (found != openRegFiles.end()) {
-            if (found->second->inUse) {
-                throw std::runtime_error("regfile is currently in use");
+// Marks regfile as used and unmarks when regfile_ptr dies
+regfile_ptr RegionFilesCache::acquire(
+    glm::ivec2 coord, const supplier<std::unique_ptr<regfile>>& open
+) {
+    auto& shard = getShard(coord);
+    std::unique_lock lock(shard.mutex);
+    while (true) {
+        const auto found = shard.files.find(coord);
+        if (found != shard.files.end()) {
+            auto& [file, position] = found->second;
+            if (file->inUse) {
+                // notified when any regfile gets out of use or closed
+                shard.cv.wait(lock);
+                continue;
             }
-            return useRegFile(found->first);
+            shard.order.splice(shard.order.begin(), shard.order, position);
+            file->inUse = true;
+            hits++;
+            return regfile_ptr(file.get(), &shard.mutex, &shard.cv);
+        }
+        if (open == nullptr) {
+            return nullptr;
+        }
+        if (shard.files.size() < shard.capacity || evict(shard)) {
+            break;
         }
+        // all shard files are in use
+        shard.cv.wait(lock);
     }
-    if (create) {
-        return createRegFile(coord);
+    while (shard.files.size() >= shard.capacity && evict(shard));
+
+    auto file = open();
+    if (file == nullptr) {
+        return nullptr;
     }
-    return nullptr;
+    misses++;
+    file->inUse = true;
+    auto ptr = file.get();
+    shard.order.push_front(coord);
+    shard.files[coord] = {std::move(file), shard.order.begin()};
+    return regfile_ptr(ptr, &shard.mutex, &shard.cv);
 }
 
-regfile_ptr RegionsLayer::createRegFile(glm::ivec2 coord) {
-    auto file = folder / get_region_filename(coord[0], coord[1]);
-    if (!io::exists(file)) {
-        return nullptr;
+void RegionFilesCache::close(glm::ivec2 coord, regfile_ptr& file) {
+    auto& shard = getShard(coord);
+    {
+        std::lock_guard lock(shard.mutex);
+        const auto found = shard.files.find(coord);
+        if (found == shard.files.end() ||
+            found->second.first.get() != file.get()) {
+            throw std::runtime_error("region file is not acquired");
+        }
+        // keep inUse flag on until closed
+        file.release();
+        shard.order.erase(found->second.second);
+        shard.files.erase(found);
     }
-    if (openRegFiles.size() == MAX_OPEN_REGION_FILES) {
-        std::unique_lock lock(regFilesMutex);
-        while (true) {
-            bool closed = false;
-            // FIXME: bad choosing algorithm
-            for (auto& entry : openRegFiles) {
-                if (!entry.second->inUse) {
-                    closeRegFile(entry.first);
-                    closed = true;
-                    break;
-                }
-            }
-            if (closed) {
-                break;
-            }
-            // notified when any regfile gets out of use or closed
-            regFilesCv.wait(lock);
+    shard.cv.notify_all();
+}
+
+bool RegionFilesCache::closeIfUnused(glm::ivec2 coord) {
+    auto& shard = getShard(coord);
+    {
+        std::lock_guard lock(shard.mutex);
+        const auto found = shard.files.find(coord);
+        if (found == shard.files.end()) {
+            return true;
         }
-        openRegFiles[coord] = std::make_unique<regfile>(file);
-        return useRegFile(coord);
-    } else {
-        std::lock_guard lock(regFilesMutex);
-        openRegFiles[coord] = std::make_unique<regfile>(file);
-        return useRegFile(coord);
+        if (found->second.first->inUse) {
+            return false;
+        }
+        shard.order.erase(found->second.second);
+        shard.files.erase(found);
+    }
+    shard.cv.notify_all();
+    return true;
+}
+
+void RegionFilesCache::setCapacity(size_t capacity) {
+    size_t shardCapacity = std::max<size_t>(
+        1, (capacity + shardsCount - 1) / shardsCount
+    );
+    for (size_t i = 0; i < shardsCount; i++) {
+        std::lock_guard lock(shards[i].mutex);
+        shards[i].capacity = shardCapacity;
+    }
+}
+
+size_t RegionFilesCache::getCapacity() const {
+    return shards[0].capacity * shardsCount;
+}
+
+size_t RegionFilesCache::size() {
+    size_t count = 0;
+    for (size_t i = 0; i < shardsCount; i++) {
+        std::lock_guard lock(shards[i].mutex);
+        count += shards[i].files.size();
     }
+    return count;
+}
+
+RegionFilesCache::Stats RegionFilesCache::getStats() const {
+    return Stats {hits, misses, evictions};
+}
+
+regfile_ptr RegionsLayer::getRegFile(glm::ivec2 coord, bool create) {
+    if (!create) {
+        return openFiles.acquire(coord, nullptr);
+    }
+    return openFiles.acquire(coord, [this, coord]() -> std::unique_ptr<regfile> {
+        auto file = folder / get_region_filename(coord[0], coord[1]);
+        recover_region_file(file);
+        if (!io::exists(file)) {
+            return nullptr;
+        }
+        return std::make_unique<regfile>(file, mappedFiles);
+    });
 }
 
 WorldRegion* RegionsLayer::getRegion(int x, int z) {
@@ -143,10 +355,11 @@ io::path RegionsLayer::getRegionFilePath(int x, int z) const {
 }
 
 WorldRegion* RegionsLayer::getOrCreateRegion(int x, int z) {
-    if (auto region = getRegion(x, z)) {
-        return region;
-    }
     std::lock_guard lock(mapMutex);
+    auto found = regions.find({x, z});
+    if (found != regions.end()) {
+        return found->second.get();
+    }
     auto region_ptr = std::make_unique<WorldRegion>();
     auto region = region_ptr.get();
     regions[{x, z}] = std::move(region_ptr);
@@ -158,77 +371,244 @@ ubyte* RegionsLayer::getData(int x, int z, uint32_t& size, uint32_t& srcSize) {
     calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
 
     WorldRegion* region = getOrCreateRegion(regionX, regionZ);
+    {
+        std::lock_guard lock(region->getMutex());
+        if (ubyte* data = region->getChunkData(localX, localZ)) {
+            auto sizevec = region->getChunkDataSize(localX, localZ);
+            size = sizevec[0];
+            srcSize = sizevec[1];
+            return data;
+        }
+    }
+    // chunk data is read without the region lock, so other threads do not
+    // wait for the disk while accessing other chunks of the region
+    std::unique_ptr<ubyte[]> dataptr;
+    if (auto regfile = getRegFile({regionX, regionZ})) {
+        dataptr = readChunkData(x, z, size, srcSize, regfile.get());
+        dataptr = convertChunkData(
+            std::move(dataptr), size, srcSize, regfile.get()->compression
+        );
+    }
+    if (dataptr == nullptr) {
+        return nullptr;
+    }
+    std::lock_guard lock(region->getMutex());
+    // chunk data may be put or read by another thread meanwhile
     ubyte* data = region->getChunkData(localX, localZ);
     if (data == nullptr) {
-        auto regfile = getRegFile({regionX, regionZ});
-        if (regfile != nullptr) {
-            auto dataptr = readChunkData(x, z, size, srcSize, regfile.get());
-            if (dataptr) {
-                data = dataptr.get();
-                region->put(localX, localZ, std::move(dataptr), size, srcSize);
-            }
-        }
+        data = dataptr.get();
+        region->put(localX, localZ, std::move(dataptr), size, srcSize);
     }
-    if (data != nullptr) {
-        auto sizevec = region->getChunkDataSize(localX, localZ);
-        size = sizevec[0];
-        srcSize = sizevec[1];
-        return data;
+    auto sizevec = region->getChunkDataSize(localX, localZ);
+    size = sizevec[0];
+    srcSize = sizevec[1];
+    return data;
+}
+
+static void write_chunk_entry(
+    std::ostream& file, const ubyte* data, glm::u32vec2 sizevec
+) {
+    uint32_t compressedSize = sizevec[0];
+    uint32_t srcSize = sizevec[1];
+
+    uint32_t intbuf = dataio::h2le(compressedSize);
+    file.write(reinterpret_cast<const char*>(&intbuf), 4);
+
+    intbuf = dataio::h2le(srcSize);
+    file.write(reinterpret_cast<const char*>(&intbuf), 4);
+
+    file.write(reinterpret_cast<const char*>(data), compressedSize);
+}
+
+static void write_offsets_table(std::ostream& file, const uint32_t* offsets) {
+    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        uint32_t intbuf = dataio::h2le(offsets[i]);
+        file.write(reinterpret_cast<const char*>(&intbuf), 4);
     }
-    return nullptr;
 }
 
 void RegionsLayer::writeRegion(int x, int z, WorldRegion* entry) {
     io::path filename = folder / get_region_filename(x, z);
 
-    glm::ivec2 regcoord(x, z);
-    if (auto regfile = getRegFile(regcoord, false)) {
-        fetch_chunks(entry, x, z, regfile.get());
+    // region is locked until the file is rewritten, so other threads
+    // will not read it partially written
+    std::lock_guard regionLock(entry->getMutex());
 
-        std::lock_guard lock(regFilesMutex);
-        regfile.reset();
-        closeRegFile(regcoord);
+    glm::ivec2 regcoord(x, z);
+    if (auto regfile = getRegFile(regcoord)) {
+        fetch_chunks(*this, entry, x, z, regfile.get());
+        openFiles.close(regcoord, regfile);
     }
 
-    char header[REGION_HEADER_SIZE] = REGION_FORMAT_MAGIC;
-    header[8] = REGION_FORMAT_VERSION;
-    header[9] = static_cast<ubyte>(compression); // FIXME
-    std::ofstream file(io::resolve(filename), std::ios::out | std::ios::binary);
-    file.write(header, REGION_HEADER_SIZE);
+    // durable rewrite goes to a temporary file replacing the region file
+    // when written completely, so the file is never left partially written
+    io::path target = filename;
+    if (durableWrites) {
+        target = folder / (get_region_filename(x, z).string() + ".tmp");
+    }
+    {
+        char header[REGION_HEADER_SIZE] = REGION_FORMAT_MAGIC;
+        header[8] = REGION_FORMAT_VERSION;
+        header[9] = static_cast<ubyte>(compression);
+        std::ofstream file(io::resolve(target), std::ios::out | std::ios::binary);
+        file.write(header, REGION_HEADER_SIZE);
+
+        size_t offset = REGION_HEADER_SIZE;
+        uint32_t offsets[REGION_CHUNKS_COUNT] {};
+
+        auto region = entry->getChunks();
+        auto sizes = entry->getSizes();
+
+        for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+            ubyte* chunk = region[i].get();
+            if (chunk == nullptr) {
+                continue;
+            }
+            if (offset > UINT32_MAX) {
+                throw std::runtime_error(
+                    "region file exceeds 4 GiB " + target.string()
+                );
+            }
+            offsets[i] = offset;
+            write_chunk_entry(file, chunk, sizes[i]);
+            offset += 8 + sizes[i][0];
+        }
+        write_offsets_table(file, offsets);
+        if (!file) {
+            throw std::runtime_error(
+                "could not write region file " + target.string()
+            );
+        }
+        bytesWritten += offset + REGION_CHUNKS_COUNT * 4;
+    }
+    if (durableWrites) {
+        if (!io::sync(target) || !io::rename(target, filename)) {
+            throw std::runtime_error(
+                "could not replace region file " + filename.string()
+            );
+        }
+        // make the rename itself persistent
+        io::sync(folder);
+    }
+    entry->setUnsaved(false);
+}
 
-    size_t offset = REGION_HEADER_SIZE;
-    uint32_t intbuf;
-    uint offsets[REGION_CHUNKS_COUNT] {};
+float RegionsLayer::writeRegionChanges(int x, int z, WorldRegion* entry) {
+    io::path filename = folder / get_region_filename(x, z);
+    glm::ivec2 regcoord(x, z);
 
+    std::unique_lock regionLock(entry->getMutex());
+    auto regfile = getRegFile(regcoord);
+    if (regfile == nullptr || regfile.get()->compression != compression) {
+        // file written with other compression method gets converted
+        regfile.reset();
+        regionLock.unlock();
+        writeRegion(x, z, entry);
+        return 0.0f;
+    }
     auto region = entry->getChunks();
     auto sizes = entry->getSizes();
 
+    uint32_t offsets[REGION_CHUNKS_COUNT];
+    std::memcpy(offsets, regfile.get()->offsets, sizeof(offsets));
+    // calculate size of chunks data kept in the file
+    size_t liveBytes = 0;
+    bool keepsChunks = false;
     for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
-        ubyte* chunk = region[i].get();
-        if (chunk == nullptr) {
+        if (offsets[i] == 0 || entry->isChunkUnsaved(i)) {
             continue;
         }
-        offsets[i] = offset;
-
-        auto sizevec = sizes[i];
-        uint32_t compressedSize = sizevec[0];
-        uint32_t srcSize = sizevec[1];
-        
-        intbuf = dataio::h2le(compressedSize);
-        file.write(reinterpret_cast<const char*>(&intbuf), 4);
-        offset += 4;
-
-        intbuf = dataio::h2le(srcSize);
-        file.write(reinterpret_cast<const char*>(&intbuf), 4);
-        offset += 4;
-
-        file.write(reinterpret_cast<const char*>(chunk), compressedSize);
-        offset += compressedSize;
+        keepsChunks = true;
+        liveBytes += 8 + regfile.get()->getChunkDataSize(i);
     }
+    if (!keepsChunks) {
+        // nothing to keep, so rewriting is cheaper
+        regfile.reset();
+        regionLock.unlock();
+        writeRegion(x, z, entry);
+        return 0.0f;
+    }
+    size_t fileLength = regfile.get()->length();
+    size_t appendedBytes = 0;
     for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
-        intbuf = dataio::h2le(offsets[i]);
-        file.write(reinterpret_cast<const char*>(&intbuf), 4);
+        if (entry->isChunkUnsaved(i) && region[i] != nullptr) {
+            appendedBytes += 8 + sizes[i][0];
+        }
+    }
+    if (fileLength + appendedBytes > UINT32_MAX) {
+        // appended chunks offsets would not fit the offsets table
+        regfile.reset();
+        regionLock.unlock();
+        writeRegion(x, z, entry);
+        return 0.0f;
+    }
+    // mapping must be released before the file gets modified
+    openFiles.close(regcoord, regfile);
+
+    // journal keeps the current file length, so the file is truncated back
+    // to the current offsets table if the writing gets interrupted
+    auto journal = get_journal_path(filename);
+    uint64_t journalLength = dataio::h2le(static_cast<uint64_t>(fileLength));
+    if (!io::write_bytes(
+            journal,
+            reinterpret_cast<const ubyte*>(&journalLength),
+            sizeof(journalLength)
+        ) ||
+        (durableWrites && (!io::sync(journal) || !io::sync(folder)))) {
+        throw std::runtime_error(
+            "could not write region journal " + journal.string()
+        );
+    }
+    // new chunks data and offsets table are appended after the current
+    // offsets table, which is left as dead space
+    size_t offset = fileLength;
+    {
+        std::fstream file(
+            io::resolve(filename),
+            std::ios::in | std::ios::out | std::ios::binary
+        );
+        if (!file) {
+            throw std::runtime_error(
+                "could not open region file " + filename.string()
+            );
+        }
+        file.seekp(offset);
+        for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+            if (!entry->isChunkUnsaved(i)) {
+                continue;
+            }
+            ubyte* chunk = region[i].get();
+            if (chunk == nullptr) {
+                offsets[i] = 0;
+                continue;
+            }
+            offsets[i] = offset;
+            write_chunk_entry(file, chunk, sizes[i]);
+            offset += 8 + sizes[i][0];
+            liveBytes += 8 + sizes[i][0];
+        }
+        write_offsets_table(file, offsets);
+        file.flush();
+        if (!file) {
+            throw std::runtime_error(
+                "could not write region file " + filename.string()
+            );
+        }
     }
+    if (durableWrites && !io::sync(filename)) {
+        throw std::runtime_error(
+            "could not write region file " + filename.string()
+        );
+    }
+    io::remove(journal);
+    if (durableWrites) {
+        io::sync(folder);
+    }
+    entry->setUnsaved(false);
+    bytesWritten += offset - fileLength + REGION_CHUNKS_COUNT * 4;
+
+    size_t totalBytes = offset - REGION_HEADER_SIZE;
+    return 1.0f - liveBytes / static_cast<float>(totalBytes);
 }
 
 std::unique_ptr<ubyte[]> RegionsLayer::readChunkData(
@@ -239,3 +619,59 @@ std::unique_ptr<ubyte[]> RegionsLayer::readChunkData(
     int chunkIndex = localZ * REGION_SIZE + localX;
     return rfile->read(chunkIndex, size, srcSize);
 }
+
+std::unique_ptr<ubyte[]> RegionsLayer::readChunkData(
+    int x,
+    int z,
+    uint32_t& size,
+    uint32_t& srcSize,
+    regfile* rfile,
+    const zstd::Dictionary* dictionary
+) {
+    auto method = rfile->compression;
+    if (method == compression::Method::NONE) {
+        auto data = readChunkData(x, z, size, srcSize, rfile);
+        srcSize = size;
+        return data;
+    }
+    int regionX, regionZ, localX, localZ;
+    calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
+    int chunkIndex = localZ * REGION_SIZE + localX;
+    if (const ubyte* bytes = rfile->view(chunkIndex, size, srcSize)) {
+        return compression::decompress(
+            bytes, size, srcSize, method, dictionary
+        );
+    }
+    auto data = rfile->read(chunkIndex, size, srcSize);
+    if (data == nullptr) {
+        return nullptr;
+    }
+    return compression::decompress(
+        data.get(), size, srcSize, method, dictionary
+    );
+}
+
+std::unique_ptr<ubyte[]> RegionsLayer::convertChunkData(
+    std::unique_ptr<ubyte[]> data,
+    uint32_t& size,
+    uint32_t srcSize,
+    compression::Method method
+) const {
+    if (data == nullptr || method == compression) {
+        return data;
+    }
+    if (method != compression::Method::NONE) {
+        data = compression::decompress(
+            data.get(), size, srcSize, method, dictionary.get()
+        );
+        size = srcSize;
+    }
+    if (compression != compression::Method::NONE) {
+        size_t length;
+        data = compression::compress(
+            data.get(), srcSize, length, compression, dictionary.get()
+        );
+        size = length;
+    }
+    return data;
+}
@@ -43,6 +43,9 @@ void WorldConverter::addRegionsTasks(
         return;
     }
     for (const auto& file :io::directory_iterator(regionsFolder)) {
+        if (file.extension() != ".bin") {
+            continue;
+        }
         int x, z;
         std::string name = file.stem();
         if (!WorldRegions::parseRegionFilename(name, x, z)) {
@@ -223,7 +226,7 @@ void WorldConverter::convertBlocksData(int x, int z, const ContentReport& report
         BlocksMetadata newHeap;
         for (const auto& entry : *heap) {
             size_t index = entry.index;
-            const auto& def = indices.require(chunk.voxels[index].id);
+            const auto& def = indices.require(chunk.voxels.get(index).id);
             const auto& newStruct = *def.dataStruct;
             const auto& found = report.blocksDataLayouts.find(def.name);
             if (found == report.blocksDataLayouts.end()) {
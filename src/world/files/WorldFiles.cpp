@@ -47,6 +47,20 @@ WorldFiles::WorldFiles(const io::path& directory, const DebugSettings& settings)
     doWriteLights = settings.doWriteLights.get();
     regions.generatorTestMode = generatorTestMode;
     regions.doWriteLights = doWriteLights;
+    regions.setMaxOpenFiles(settings.openRegionFiles.get());
+    regions.setIncrementalWrites(settings.incrementalRegionWrites.get());
+    regions.setDurableWrites(settings.durableRegionWrites.get());
+    regions.setCompactionThreshold(
+        settings.regionCompactionThreshold.get()
+    );
+
+    const auto& methodName = settings.voxelsCompression.get();
+    compression::Method method;
+    if (compression::MethodMeta.getItem(methodName, method)) {
+        regions.setCompression(REGION_LAYER_VOXELS, method);
+    } else {
+        logger.error() << "unknown voxels compression method " << methodName;
+    }
 }
 
 WorldFiles::~WorldFiles() = default;
@@ -64,6 +78,14 @@ io::path WorldFiles::getResourcesFile() const {
     return directory / "resources.json";
 }
 
+io::path WorldFiles::getPrototypesCacheFile() const {
+    return directory / "prototypes.bin";
+}
+
+io::path WorldFiles::getPregenerationFile() const {
+    return directory / "pregen.json";
+}
+
 io::path WorldFiles::getWorldFile() const {
     return directory / WORLD_FILE;
 }
@@ -78,6 +100,20 @@ io::path WorldFiles::getPacksFile() const {
 
 void WorldFiles::write(
     const World* world, const Content* content
+) {
+    writeMetadata(world, content);
+    writeRegions();
+}
+
+void WorldFiles::writeRegions() {
+    if (generatorTestMode) {
+        return;
+    }
+    regions.writeAll();
+}
+
+void WorldFiles::writeMetadata(
+    const World* world, const Content* content
 ) {
     if (world) {
         writeWorldInfo(world->getInfo());
@@ -91,7 +127,6 @@ void WorldFiles::write(
     if (content) {
         writeIndices(content->getIndices());
     }
-    regions.writeAll();
 }
 
 void WorldFiles::writePacks(const std::vector<ContentPack>& packs) {
@@ -43,6 +43,8 @@ public:
     io::path getPlayerFile() const;
     io::path getIndicesFile() const;
     io::path getResourcesFile() const;
+    io::path getPrototypesCacheFile() const;
+    io::path getPregenerationFile() const;
     void createDirectories();
 
     std::optional<WorldInfo> readWorldInfo();
@@ -62,6 +64,15 @@ public:
     /// @param content world content
     void write(const World* world, const Content* content);
 
+    /// @brief Write world info, packs list and content indices
+    /// without regions
+    /// @param world target world
+    /// @param content world content
+    void writeMetadata(const World* world, const Content* content);
+
+    /// @brief Write all unsaved regions
+    void writeRegions();
+
     void writePacks(const std::vector<ContentPack>& packs);
 
     void removeIndices(const std::vector<std::string>& packs);
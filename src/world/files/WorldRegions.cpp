@@ -9,11 +9,19 @@
 #include "coders/byte_utils.hpp"
 #include "coders/rle.hpp"
 #include "coders/binary_json.hpp"
+#include "coders/zstd.hpp"
 #include "items/Inventory.hpp"
 #include "maths/voxmaths.hpp"
 #include "util/data_io.hpp"
 
 #define REGION_FORMAT_MAGIC ".VOXREG"
+#define REGION_DICTIONARY_FILE "zstd.dict"
+
+/// @brief Min number of chunks used to train a dictionary
+static constexpr size_t MIN_DICTIONARY_SAMPLES = 16;
+/// @brief Samples size enough to train a dictionary of the default size
+static constexpr size_t DICTIONARY_SAMPLES_BYTES =
+    zstd::DEFAULT_DICTIONARY_SIZE * 100;
 
 static debug::Logger logger("world-regions");
 
@@ -28,11 +36,23 @@ WorldRegion::~WorldRegion() = default;
 
 void WorldRegion::setUnsaved(bool unsaved) {
     this->unsaved = unsaved;
+    if (!unsaved) {
+        unsavedChunks.reset();
+    }
 }
 bool WorldRegion::isUnsaved() const {
     return unsaved;
 }
 
+void WorldRegion::setChunkUnsaved(uint x, uint z) {
+    unsavedChunks.set(z * REGION_SIZE + x);
+    unsaved = true;
+}
+
+bool WorldRegion::isChunkUnsaved(size_t index) const {
+    return unsavedChunks.test(index);
+}
+
 std::unique_ptr<ubyte[]>* WorldRegion::getChunks() const {
     return chunksData.get();
 }
@@ -75,46 +95,116 @@ WorldRegions::WorldRegions(const io::path& directory) : directory(directory) {
 
     auto& blocksData = layers[REGION_LAYER_BLOCKS_DATA];
     blocksData.folder = directory / "blocksdata";
+
+    for (auto& layer : layers) {
+        auto file = layer.folder / REGION_DICTIONARY_FILE;
+        if (!io::exists(file)) {
+            continue;
+        }
+        try {
+            layer.dictionary =
+                std::make_shared<zstd::Dictionary>(io::read_bytes(file));
+        } catch (const std::runtime_error& err) {
+            logger.error() << "could not load dictionary " << file.string()
+                           << ": " << err.what();
+        }
+    }
 }
 
 WorldRegions::~WorldRegions() = default;
 
+void RegionsLayer::write(int x, int z, WorldRegion* region) {
+    if (!incrementalWrites) {
+        writeRegion(x, z, region);
+        return;
+    }
+    float deadSpace = writeRegionChanges(x, z, region);
+    if (deadSpace > compactionThreshold) {
+        std::lock_guard fragmentedLock(fragmentedMutex);
+        fragmented.insert({x, z});
+    }
+}
+
 void RegionsLayer::writeAll() {
+    std::lock_guard lock(mapMutex);
     for (auto& it : regions) {
         WorldRegion* region = it.second.get();
         if (region->getChunks() == nullptr || !region->isUnsaved()) {
             continue;
         }
         const auto& key = it.first;
-        writeRegion(key[0], key[1], region);
+        write(key[0], key[1], region);
     }
 }
 
-void WorldRegions::put(
+std::vector<glm::ivec2> RegionsLayer::getUnsavedRegions() {
+    std::lock_guard lock(mapMutex);
+    std::vector<glm::ivec2> coords;
+    for (auto& [coord, region] : regions) {
+        if (region->isUnsaved()) {
+            coords.push_back(coord);
+        }
+    }
+    return coords;
+}
+
+void RegionsLayer::compact() {
+    std::unordered_set<glm::ivec2> coords;
+    {
+        std::lock_guard lock(fragmentedMutex);
+        std::swap(coords, fragmented);
+    }
+    for (const auto& coord : coords) {
+        auto region = getOrCreateRegion(coord.x, coord.y);
+        logger.info() << "compacting region " << folder.name() << "/"
+                      << coord.x << "_" << coord.y;
+        writeRegion(coord.x, coord.y, region);
+    }
+}
+
+std::unique_ptr<ubyte[]> WorldRegions::compress(
+    RegionLayerIndex layerid, std::unique_ptr<ubyte[]> data, size_t& size
+) const {
+    const auto& layer = layers[layerid];
+    if (data == nullptr || layer.compression == compression::Method::NONE) {
+        return data;
+    }
+    return compression::compress(
+        data.get(), size, size, layer.compression, layer.dictionary.get()
+    );
+}
+
+void WorldRegions::store(
     int x,
     int z,
     RegionLayerIndex layerid,
     std::unique_ptr<ubyte[]> data,
+    size_t size,
     size_t srcSize
 ) {
-    size_t size = srcSize;
-    auto& layer = layers[layerid];
-    int regionX, regionZ, localX, localZ;
-    calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
-
-    WorldRegion* region = layer.getOrCreateRegion(regionX, regionZ);
-    region->setUnsaved(true);
-    
     if (data == nullptr) {
-        region->put(localX, localZ, nullptr, 0, 0);
-        return;
+        srcSize = 0;
+        size = 0;
     }
+    int regionX, regionZ, localX, localZ;
+    calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
 
-    if (layer.compression != compression::Method::NONE) {
-        data = compression::compress(
-            data.get(), size, size, layer.compression);
-    }
+    WorldRegion* region = layers[layerid].getOrCreateRegion(regionX, regionZ);
+    std::lock_guard lock(region->getMutex());
     region->put(localX, localZ, std::move(data), size, srcSize);
+    region->setChunkUnsaved(localX, localZ);
+}
+
+void WorldRegions::put(
+    int x,
+    int z,
+    RegionLayerIndex layerid,
+    std::unique_ptr<ubyte[]> data,
+    size_t srcSize
+) {
+    size_t size = srcSize;
+    data = compress(layerid, std::move(data), size);
+    store(x, z, layerid, std::move(data), size, srcSize);
 }
 
 static std::unique_ptr<ubyte[]> write_inventories(
@@ -153,65 +243,164 @@ static ChunkInventoriesMap load_inventories(const ubyte* src, uint32_t size) {
 }
 
 void WorldRegions::put(Chunk* chunk, std::vector<ubyte> entitiesData) {
+    if (auto snapshot = this->snapshot(chunk, std::move(entitiesData))) {
+        put(*snapshot);
+    }
+}
+
+std::unique_ptr<ChunkSnapshot> WorldRegions::snapshot(
+    Chunk* chunk, std::vector<ubyte> entitiesData
+) {
     if (generatorTestMode) {
-        return;
+        return nullptr;
     }
     assert(chunk != nullptr);
     if (!chunk->flags.lighted) {
-        return;
+        return nullptr;
     }
     bool lightsUnsaved = !chunk->flags.loadedLights && doWriteLights;
     if (!chunk->flags.unsaved && !lightsUnsaved && !chunk->flags.entities) {
-        return;
+        return nullptr;
     }
+    auto snapshot = std::make_unique<ChunkSnapshot>();
+    snapshot->x = chunk->x;
+    snapshot->z = chunk->z;
+    snapshot->revision = nextRevision++;
 
-    int regionX, regionZ, localX, localZ;
-    calc_reg_coords(chunk->x, chunk->z, regionX, regionZ, localX, localZ);
+    auto& data = snapshot->data;
+    auto& sizes = snapshot->sizes;
 
-    put(chunk->x,
-        chunk->z,
-        REGION_LAYER_VOXELS,
-        chunk->encode(),
-        CHUNK_DATA_LEN);
+    // voxels and lights are encoded when the snapshot is put
+    snapshot->voxels = std::make_unique<voxel[]>(CHUNK_VOL);
+    chunk->voxels.copyTo(snapshot->voxels.get());
 
     // Writing lights cache
     if (doWriteLights && chunk->flags.lighted) {
-        put(chunk->x,
-            chunk->z,
-            REGION_LAYER_LIGHTS,
-            chunk->lightmap.encode(),
-            LIGHTMAP_DATA_LEN);
+        snapshot->lightmap = std::make_unique<Lightmap>();
+        snapshot->lightmap->set(&chunk->lightmap);
     }
     // Writing block inventories
     if (!chunk->inventories.empty()) {
         uint datasize;
-        auto data = write_inventories(chunk->inventories, datasize);
-        put(chunk->x,
-            chunk->z,
-            REGION_LAYER_INVENTORIES,
-            std::move(data),
-            datasize);
+        data[REGION_LAYER_INVENTORIES] =
+            write_inventories(chunk->inventories, datasize);
+        sizes[REGION_LAYER_INVENTORIES] = datasize;
     }
     // Writing entities
     if (!entitiesData.empty()) {
-        auto data = std::make_unique<ubyte[]>(entitiesData.size());
-        for (size_t i = 0; i < entitiesData.size(); i++) {
-            data[i] = entitiesData[i];
-        }
-        put(chunk->x,
-            chunk->z,
-            REGION_LAYER_ENTITIES,
-            std::move(data),
-            entitiesData.size());
+        auto bytes = std::make_unique<ubyte[]>(entitiesData.size());
+        std::memcpy(bytes.get(), entitiesData.data(), entitiesData.size());
+        data[REGION_LAYER_ENTITIES] = std::move(bytes);
+        sizes[REGION_LAYER_ENTITIES] = entitiesData.size();
     }
     // Writing blocks data
     if (chunk->flags.blocksData) {
         auto bytes = chunk->blocksMetadata.serialize();
-        put(chunk->x,
-            chunk->z,
-            REGION_LAYER_BLOCKS_DATA,
-            bytes.release(),
-            bytes.size());
+        sizes[REGION_LAYER_BLOCKS_DATA] = bytes.size();
+        data[REGION_LAYER_BLOCKS_DATA] = bytes.release();
+    }
+    chunk->flags.unsaved = false;
+    return snapshot;
+}
+
+static void encode_snapshot(ChunkSnapshot& snapshot) {
+    if (snapshot.voxels) {
+        snapshot.data[REGION_LAYER_VOXELS] = Chunk::encode(snapshot.voxels.get());
+        snapshot.sizes[REGION_LAYER_VOXELS] = CHUNK_DATA_LEN;
+        snapshot.voxels = nullptr;
+    }
+    if (snapshot.lightmap) {
+        uint datasize;
+        snapshot.data[REGION_LAYER_LIGHTS] = snapshot.lightmap->encode(datasize);
+        snapshot.sizes[REGION_LAYER_LIGHTS] = datasize;
+        snapshot.lightmap = nullptr;
+    }
+}
+
+void WorldRegions::put(ChunkSnapshot& snapshot) {
+    encode_snapshot(snapshot);
+    // snapshot data is kept untouched until all layers are compressed,
+    // so a failed snapshot may be put again
+    std::unique_ptr<ubyte[]> data[REGION_LAYERS_COUNT] {};
+    size_t sizes[REGION_LAYERS_COUNT] {};
+    for (size_t i = 0; i < REGION_LAYERS_COUNT; i++) {
+        const auto& layer = layers[i];
+        if (snapshot.data[i] == nullptr ||
+            layer.compression == compression::Method::NONE) {
+            continue;
+        }
+        sizes[i] = snapshot.sizes[i];
+        data[i] = compression::compress(
+            snapshot.data[i].get(),
+            snapshot.sizes[i],
+            sizes[i],
+            layer.compression,
+            layer.dictionary.get()
+        );
+    }
+    for (size_t i = 0; i < REGION_LAYERS_COUNT; i++) {
+        if (data[i] == nullptr && snapshot.data[i] != nullptr) {
+            data[i] = std::move(snapshot.data[i]);
+            sizes[i] = snapshot.sizes[i];
+        }
+    }
+    glm::ivec2 coord(snapshot.x, snapshot.z);
+    std::lock_guard lock(revisionsMutex);
+    if (!snapshot.replace) {
+        // checked under the lock, so concurrent snapshots of the chunk
+        // are not overwritten
+        if (storedRevisions.find(coord) != storedRevisions.end() ||
+            hasVoxels(snapshot.x, snapshot.z)) {
+            snapshot.stored = true;
+            return;
+        }
+    } else {
+        auto& revision = storedRevisions[coord];
+        if (revision > snapshot.revision) {
+            // newer chunk data is stored already
+            snapshot.stored = true;
+            return;
+        }
+        revision = snapshot.revision;
+    }
+    for (size_t i = 0; i < REGION_LAYERS_COUNT; i++) {
+        if (data[i] == nullptr) {
+            continue;
+        }
+        store(
+            snapshot.x,
+            snapshot.z,
+            static_cast<RegionLayerIndex>(i),
+            std::move(data[i]),
+            sizes[i],
+            snapshot.sizes[i]
+        );
+    }
+    snapshot.stored = true;
+}
+
+bool WorldRegions::hasVoxels(int x, int z) {
+    uint32_t size;
+    uint32_t srcSize;
+    return layers[REGION_LAYER_VOXELS].getData(x, z, size, srcSize) != nullptr;
+}
+
+void WorldRegions::prefetch(int x, int z) {
+    if (generatorTestMode) {
+        return;
+    }
+    uint32_t size;
+    uint32_t srcSize;
+    for (auto& layer : layers) {
+        if (layer.layer == REGION_LAYER_LIGHTS && !doWriteLights) {
+            continue;
+        }
+        try {
+            static_cast<void>(layer.getData(x, z, size, srcSize));
+        } catch (const std::exception& err) {
+            logger.error() << "could not prefetch chunk (" << x << ", " << z
+                           << ") data: " << err.what();
+        }
     }
 }
 
@@ -224,7 +413,14 @@ std::unique_ptr<ubyte[]> WorldRegions::getVoxels(int x, int z) {
         return nullptr;
     }
     assert(srcSize == CHUNK_DATA_LEN);
-    return compression::decompress(data, size, srcSize, layer.compression);
+    if (layer.compression == compression::Method::NONE) {
+        auto voxels = std::make_unique<ubyte[]>(size);
+        std::memcpy(voxels.get(), data, size);
+        return voxels;
+    }
+    return compression::decompress(
+        data, size, srcSize, layer.compression, layer.dictionary.get()
+    );
 }
 
 std::unique_ptr<light_t[]> WorldRegions::getLights(int x, int z) {
@@ -236,10 +432,9 @@ std::unique_ptr<light_t[]> WorldRegions::getLights(int x, int z) {
         return nullptr;
     }
     auto data = compression::decompress(
-        bytes, size, srcSize, layer.compression
+        bytes, size, srcSize, layer.compression, layer.dictionary.get()
     );
-    assert(srcSize == LIGHTMAP_DATA_LEN);
-    return Lightmap::decode(data.get());
+    return Lightmap::decode(data.get(), srcSize);
 }
 
 ChunkInventoriesMap WorldRegions::fetchInventories(int x, int z) {
@@ -281,12 +476,10 @@ void WorldRegions::processBlocksData(int x, int z, const BlockDataProc& func) {
     if (voxLayer.getRegion(x, z) || datLayer.getRegion(x, z)) {
         throw std::runtime_error("not implemented for in-memory regions");
     }
-    auto datRegfile = datLayer.getRegFile({x, z});
-    if (datRegfile == nullptr) {
+    if (datLayer.getRegFile({x, z}) == nullptr) {
         throw std::runtime_error("could not open region file");
     }
-    auto voxRegfile = voxLayer.getRegFile({x, z});
-    if (voxRegfile == nullptr) {
+    if (voxLayer.getRegFile({x, z}) == nullptr) {
         logger.warning() << "missing voxels region - discard blocks data for "
             << x << "_" << z;
         deleteRegion(REGION_LAYER_BLOCKS_DATA, x, z);
@@ -299,29 +492,43 @@ void WorldRegions::processBlocksData(int x, int z, const BlockDataProc& func) {
 
             uint32_t datLength;
             uint32_t datSrcSize;
-            auto datData = RegionsLayer::readChunkData(
-                gx, gz, datLength, datSrcSize, datRegfile.get()
-            );
+            uint32_t voxLength;
+            uint32_t voxSrcSize;
+            std::unique_ptr<ubyte[]> datData;
+            std::unique_ptr<ubyte[]> voxData;
+            // region files are released before put locks the region
+            if (auto datRegfile = datLayer.getRegFile({x, z})) {
+                datData = RegionsLayer::readChunkData(
+                    gx,
+                    gz,
+                    datLength,
+                    datSrcSize,
+                    datRegfile.get(),
+                    datLayer.dictionary.get()
+                );
+            }
             if (datData == nullptr) {
                 continue;
             }
-            uint32_t voxLength;
-            uint32_t voxSrcSize;
-            auto voxData = RegionsLayer::readChunkData(
-                gx, gz, voxLength, voxSrcSize, voxRegfile.get()
-            );
+            if (auto voxRegfile = voxLayer.getRegFile({x, z})) {
+                voxData = RegionsLayer::readChunkData(
+                    gx,
+                    gz,
+                    voxLength,
+                    voxSrcSize,
+                    voxRegfile.get(),
+                    voxLayer.dictionary.get()
+                );
+            }
             if (voxData == nullptr) {
                 logger.warning()
                     << "missing voxels for chunk (" << gx << ", " << gz << ")";
                 put(gx, gz, REGION_LAYER_BLOCKS_DATA, nullptr, 0);
                 continue;
             }
-            voxData = compression::decompress(
-                voxData.get(), voxLength, voxSrcSize, voxLayer.compression
-            );
 
             BlocksMetadata blocksData;
-            blocksData.deserialize(datData.get(), datLength);
+            blocksData.deserialize(datData.get(), datSrcSize);
             try {
                 func(&blocksData, std::move(voxData));
             } catch (const std::exception& err) {
@@ -359,8 +566,7 @@ void WorldRegions::processRegion(
     if (layer.getRegion(x, z)) {
         throw std::runtime_error("not implemented for in-memory regions");
     }
-    auto regfile = layer.getRegFile({x, z});
-    if (regfile == nullptr) {
+    if (layer.getRegFile({x, z}) == nullptr) {
         throw std::runtime_error("could not open region file");
     }
     for (uint cz = 0; cz < REGION_SIZE; cz++) {
@@ -369,18 +575,17 @@ void WorldRegions::processRegion(
             int gz = cz + z * REGION_SIZE;
             uint32_t length;
             uint32_t srcSize;
-            auto data =
-                RegionsLayer::readChunkData(gx, gz, length, srcSize, regfile.get());
+            std::unique_ptr<ubyte[]> data;
+            // region file is released before put locks the region
+            if (auto regfile = layer.getRegFile({x, z})) {
+                data = RegionsLayer::readChunkData(
+                    gx, gz, length, srcSize, regfile.get(),
+                    layer.dictionary.get()
+                );
+            }
             if (data == nullptr) {
                 continue;
             }
-            if (layer.compression != compression::Method::NONE) {
-                data = compression::decompress(
-                    data.get(), length, srcSize, layer.compression
-                );
-            } else {
-                srcSize = length;
-            }
             if (auto writeData = func(std::move(data), &srcSize)) {
                 put(gx, gz, layerid, std::move(writeData), srcSize);
             }
@@ -401,11 +606,183 @@ void WorldRegions::writeAll() {
         io::create_directories(layer.folder);
         layer.writeAll();
     }
+    std::lock_guard lock(revisionsMutex);
+    storedRevisions.clear();
+}
+
+void WorldRegions::eraseStoredRevisions(int regionX, int regionZ) {
+    std::lock_guard lock(revisionsMutex);
+    if (storedRevisions.empty()) {
+        return;
+    }
+    const int size = REGION_SIZE;
+    for (int z = 0; z < size; z++) {
+        for (int x = 0; x < size; x++) {
+            storedRevisions.erase({regionX * size + x, regionZ * size + z});
+        }
+    }
+}
+
+uint64_t WorldRegions::getBytesWritten() const {
+    uint64_t bytes = 0;
+    for (const auto& layer : layers) {
+        bytes += layer.bytesWritten;
+    }
+    return bytes;
+}
+
+std::vector<glm::ivec3> WorldRegions::getUnsavedRegions() {
+    std::vector<glm::ivec3> unsaved;
+    for (auto& layer : layers) {
+        for (const auto& coord : layer.getUnsavedRegions()) {
+            unsaved.emplace_back(layer.layer, coord.x, coord.y);
+        }
+    }
+    return unsaved;
+}
+
+void WorldRegions::writeRegion(RegionLayerIndex layerid, int x, int z) {
+    auto& layer = layers[layerid];
+    WorldRegion* region = layer.getRegion(x, z);
+    if (region == nullptr || region->getChunks() == nullptr ||
+        !region->isUnsaved()) {
+        return;
+    }
+    io::create_directories(layer.folder);
+    layer.write(x, z, region);
+    if (layerid == REGION_LAYER_VOXELS) {
+        eraseStoredRevisions(x, z);
+    }
+}
+
+void WorldRegions::compact() {
+    for (auto& layer : layers) {
+        try {
+            layer.compact();
+        } catch (const std::exception& err) {
+            logger.error() << "could not compact regions: " << err.what();
+        }
+    }
+}
+
+bool WorldRegions::hasFragmented() {
+    for (auto& layer : layers) {
+        std::lock_guard lock(layer.fragmentedMutex);
+        if (!layer.fragmented.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorldRegions::setIncrementalWrites(bool flag) {
+    for (auto& layer : layers) {
+        layer.incrementalWrites = flag;
+    }
+}
+
+void WorldRegions::setCompactionThreshold(float threshold) {
+    for (auto& layer : layers) {
+        layer.compactionThreshold = threshold;
+    }
+}
+
+void WorldRegions::setDurableWrites(bool flag) {
+    for (auto& layer : layers) {
+        layer.durableWrites = flag;
+    }
+}
+
+void WorldRegions::setCompression(
+    RegionLayerIndex layerid, compression::Method method
+) {
+    layers[layerid].compression = method;
+}
+
+compression::Method WorldRegions::getCompression(
+    RegionLayerIndex layerid
+) const {
+    return layers[layerid].compression;
+}
+
+size_t WorldRegions::trainDictionary(
+    RegionLayerIndex layerid, size_t maxSamples
+) {
+    auto& layer = layers[layerid];
+    auto dictionaryFile = layer.folder / REGION_DICTIONARY_FILE;
+    if (layer.dictionary || io::exists(dictionaryFile)) {
+        throw std::runtime_error("regions layer already has a dictionary");
+    }
+    std::vector<std::vector<ubyte>> samples;
+    size_t samplesBytes = 0;
+    auto isEnough = [&]() {
+        return samples.size() >= maxSamples ||
+               samplesBytes >= DICTIONARY_SAMPLES_BYTES;
+    };
+    if (io::is_directory(layer.folder)) {
+        for (const auto& file : io::directory_iterator(layer.folder)) {
+            int x, z;
+            if (file.extension() != ".bin" ||
+                !parseRegionFilename(file.stem(), x, z)) {
+                continue;
+            }
+            auto regfile = layer.getRegFile({x, z});
+            if (regfile == nullptr) {
+                continue;
+            }
+            for (size_t i = 0; i < REGION_CHUNKS_COUNT && !isEnough(); i++) {
+                int chunkX = x * REGION_SIZE + i % REGION_SIZE;
+                int chunkZ = z * REGION_SIZE + i / REGION_SIZE;
+                uint32_t size, srcSize;
+                auto data = RegionsLayer::readChunkData(
+                    chunkX, chunkZ, size, srcSize, regfile.get(), nullptr
+                );
+                if (data == nullptr) {
+                    continue;
+                }
+                samples.emplace_back(data.get(), data.get() + srcSize);
+                samplesBytes += srcSize;
+            }
+            if (isEnough()) {
+                break;
+            }
+        }
+    }
+    if (samples.size() < MIN_DICTIONARY_SAMPLES) {
+        throw std::runtime_error("not enough saved chunks to train dictionary");
+    }
+    auto bytes = zstd::train_dictionary(samples);
+    io::create_directories(layer.folder);
+    if (!io::write_bytes(dictionaryFile, bytes.data(), bytes.size())) {
+        throw std::runtime_error(
+            "could not write dictionary " + dictionaryFile.string()
+        );
+    }
+    logger.info() << "trained dictionary " << dictionaryFile.string()
+                  << " on " << samples.size() << " chunks";
+    return bytes.size();
+}
+
+void WorldRegions::setMaxOpenFiles(size_t count) {
+    for (auto& layer : layers) {
+        layer.openFiles.setCapacity(count);
+    }
+}
+
+RegionFilesCache::Stats WorldRegions::getOpenFilesStats() const {
+    RegionFilesCache::Stats stats {};
+    for (const auto& layer : layers) {
+        auto layerStats = layer.openFiles.getStats();
+        stats.hits += layerStats.hits;
+        stats.misses += layerStats.misses;
+        stats.evictions += layerStats.evictions;
+    }
+    return stats;
 }
 
 void WorldRegions::deleteRegion(RegionLayerIndex layerid, int x, int z) {
     auto& layer = layers[layerid];
-    if (layer.getRegFile({x, z}, false)) {
+    if (!layer.openFiles.closeIfUnused({x, z})) {
         throw std::runtime_error("region file is currently in use");
     }
     auto file = layer.getRegionFilePath(x, z);
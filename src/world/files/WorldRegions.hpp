@@ -1,13 +1,19 @@
 #pragma once
 
+#include <atomic>
+#include <bitset>
 #include <condition_variable>
 #include <functional>
 #include <glm/glm.hpp>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "typedefs.hpp"
+#include "delegates.hpp"
 #include "util/BufferPool.hpp"
 #include "voxels/Chunk.hpp"
 #include "maths/voxmaths.hpp"
@@ -34,7 +40,9 @@ public:
 class WorldRegion {
     std::unique_ptr<std::unique_ptr<ubyte[]>[]> chunksData;
     std::unique_ptr<glm::u32vec2[]> sizes;
+    std::bitset<REGION_CHUNKS_COUNT> unsavedChunks;
     bool unsaved = false;
+    std::mutex mutex;
 public:
     WorldRegion();
     ~WorldRegion();
@@ -43,22 +51,63 @@ public:
     ubyte* getChunkData(uint x, uint z);
     glm::u32vec2 getChunkDataSize(uint x, uint z);
 
+    /// @brief Set region unsaved flag. Resets chunks unsaved flags if false
     void setUnsaved(bool unsaved);
     bool isUnsaved() const;
 
+    /// @brief Mark chunk data as changed since the region file was written
+    void setChunkUnsaved(uint x, uint z);
+    bool isChunkUnsaved(size_t index) const;
+
     std::unique_ptr<ubyte[]>* getChunks() const;
     glm::u32vec2* getSizes() const;
+
+    /// @brief Region chunks data mutex. Must be locked when region is
+    /// accessed from multiple threads. Lock order: region mutex, then the
+    /// region file (acquired by writes). Region file must not be held while
+    /// locking the region mutex, and disk reads are done without the lock
+    std::mutex& getMutex() {
+        return mutex;
+    }
 };
 
 struct regfile {
-    io::rafile file;
+    /// @brief memory-mapped region file, nullptr if mapping is not used
+    std::unique_ptr<io::mmapfile> mapping;
+    /// @brief random access file used if mapping is not available
+    std::unique_ptr<io::rafile> file;
     int version;
+    /// @brief chunks data compression method
+    compression::Method compression;
     bool inUse = false;
+    /// @brief chunks data offsets table (0 - chunk is not present)
+    uint32_t offsets[REGION_CHUNKS_COUNT] {};
 
-    regfile(io::path filename);
+    /// @param filename region file path
+    /// @param mapped try to use memory-mapping
+    regfile(io::path filename, bool mapped = true);
     regfile(const regfile&) = delete;
 
+    size_t length() const;
+
+    /// @brief Get compressed chunk data length without reading the data
+    /// @param index chunk index in region
+    /// @return 0 if chunk is not present
+    uint32_t getChunkDataSize(int index);
+
+    /// @brief Get chunk data without copying. Available for memory-mapped
+    /// files only. Pointer is valid until the region file is closed.
+    /// @param index chunk index in region
+    /// @param size [out] compressed chunk data length
+    /// @param srcSize [out] source chunk data length
+    /// @return nullptr if chunk is not present or file is not mapped
+    const ubyte* view(int index, uint32_t& size, uint32_t& srcSize) const;
+
     std::unique_ptr<ubyte[]> read(int index, uint32_t& size, uint32_t& srcSize);
+
+    /// @throws illegal_region_format if chunk data overlaps offsets table
+    /// or the file end
+    void checkChunkBounds(uint32_t offset, uint32_t size) const;
 };
 
 using RegionsMap = std::unordered_map<glm::ivec2, std::unique_ptr<WorldRegion>>;
@@ -69,15 +118,16 @@ using BlockDataProc = std::function<void(BlocksMetadata*, std::unique_ptr<ubyte[
 /// @brief Region file pointer keeping inUse flag on until destroyed
 class regfile_ptr {
     regfile* file;
+    std::mutex* mutex;
     std::condition_variable* cv;
 public:
-    regfile_ptr(regfile* file, std::condition_variable* cv)
-        : file(file), cv(cv) {
+    regfile_ptr(regfile* file, std::mutex* mutex, std::condition_variable* cv)
+        : file(file), mutex(mutex), cv(cv) {
     }
 
     regfile_ptr(const regfile_ptr&) = delete;
 
-    regfile_ptr(std::nullptr_t) : file(nullptr), cv(nullptr) {
+    regfile_ptr(std::nullptr_t) : file(nullptr), mutex(nullptr), cv(nullptr) {
     }
 
     bool operator==(std::nullptr_t) const {
@@ -95,15 +145,98 @@ public:
     regfile* get() {
         return file;
     }
+    /// @brief Release file pointer keeping inUse flag on
+    regfile* release() {
+        auto ptr = file;
+        file = nullptr;
+        return ptr;
+    }
     void reset() {
         if (file) {
-            file->inUse = false;
-            cv->notify_one();
+            {
+                std::lock_guard lock(*mutex);
+                file->inUse = false;
+            }
+            cv->notify_all();
             file = nullptr;
         }
     }
 };
 
+/// @brief LRU cache of open region files. Files are distributed between
+/// independently locked shards, so threads reading different regions
+/// rarely wait for each other.
+class RegionFilesCache {
+public:
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+    };
+
+    static constexpr size_t DEFAULT_SHARDS = 8;
+private:
+    struct Shard {
+        std::mutex mutex;
+        std::condition_variable cv;
+        /// @brief Open files coords, most recently used first
+        std::list<glm::ivec2> order;
+        std::unordered_map<
+            glm::ivec2,
+            std::pair<std::unique_ptr<regfile>, std::list<glm::ivec2>::iterator>>
+            files;
+        size_t capacity;
+    };
+    std::unique_ptr<Shard[]> shards;
+    size_t shardsCount;
+    std::atomic<uint64_t> hits = 0;
+    std::atomic<uint64_t> misses = 0;
+    std::atomic<uint64_t> evictions = 0;
+
+    Shard& getShard(glm::ivec2 coord);
+
+    /// @brief Close least recently used file not in use
+    /// @return false if all shard files are in use
+    bool evict(Shard& shard);
+public:
+    /// @param capacity max number of simultaneously open files
+    /// @param shardsCount number of independently locked shards
+    RegionFilesCache(
+        size_t capacity = MAX_OPEN_REGION_FILES,
+        size_t shardsCount = DEFAULT_SHARDS
+    );
+    ~RegionFilesCache();
+
+    /// @brief Get open region file or open it. Waits until the file gets
+    /// out of use by other threads.
+    /// @param coord region coords
+    /// @param open opens region file if not open yet (called with shard
+    /// locked), returns nullptr if file does not exist. 
+    /// If nullptr, only already open file may be returned
+    /// @return nullptr if region file not found or not open
+    [[nodiscard]] regfile_ptr acquire(
+        glm::ivec2 coord, const supplier<std::unique_ptr<regfile>>& open
+    );
+
+    /// @brief Close region file acquired by the caller
+    void close(glm::ivec2 coord, regfile_ptr& file);
+
+    /// @brief Close region file if it is open and not in use
+    /// @return false if file is currently in use
+    bool closeIfUnused(glm::ivec2 coord);
+
+    /// @brief Set max number of simultaneously open files. Extra files will
+    /// be closed when next files are opened
+    void setCapacity(size_t capacity);
+
+    size_t getCapacity() const;
+
+    /// @return number of currently open files
+    size_t size();
+
+    Stats getStats() const;
+};
+
 inline void calc_reg_coords(
     int x, int z, int& regionX, int& regionZ, int& localX, int& localZ
 ) {
@@ -120,25 +253,52 @@ struct RegionsLayer {
     /// @brief Regions layer folder
     io::path folder;
 
+    /// @brief Compression method of in-memory chunks data and written
+    /// region files. Files written with other methods are converted on read
     compression::Method compression = compression::Method::NONE;
 
+    /// @brief Optional dictionary used by ZSTD compression. Must stay the
+    /// same while the layer has data compressed with it
+    std::shared_ptr<zstd::Dictionary> dictionary;
+
+    /// @brief Use memory-mapped region files if available
+    bool mappedFiles = true;
+
+    /// @brief Append changed chunks to existing region files instead of
+    /// rewriting whole regions
+    bool incrementalWrites = true;
+
+    /// @brief Rewrite region files through temporary files flushed to disk,
+    /// and flush incremental writes journals, so a crash never leaves
+    /// a partially written region
+    bool durableWrites = true;
+
+    /// @brief Dead space fraction of a region file making it to be
+    /// scheduled for compaction
+    float compactionThreshold = DEFAULT_COMPACTION_THRESHOLD;
+
+    /// @brief Total number of bytes written to region files
+    std::atomic<uint64_t> bytesWritten = 0;
+
+    /// @brief Regions having files with dead space above threshold
+    std::unordered_set<glm::ivec2> fragmented;
+    std::mutex fragmentedMutex;
+
     /// @brief In-memory regions data
     RegionsMap regions;
 
     /// @brief In-memory regions map mutex
     std::mutex mapMutex;
 
-    /// @brief Open region files map
-    std::unordered_map<glm::ivec2, std::unique_ptr<regfile>> openRegFiles;
-
-    /// @brief Open region files map mutex
-    std::mutex regFilesMutex;
-    std::condition_variable regFilesCv;
+    /// @brief Open region files
+    RegionFilesCache openFiles;
 
+    /// @brief Get open region file or open it. Waits until the file gets
+    /// out of use by other threads.
+    /// @param coord region coords
+    /// @param create open region file if not open yet
+    /// @return nullptr if region file not found or not open
     [[nodiscard]] regfile_ptr getRegFile(glm::ivec2 coord, bool create = true);
-    [[nodiscard]] regfile_ptr useRegFile(glm::ivec2 coord);
-    regfile_ptr createRegFile(glm::ivec2 coord);
-    void closeRegFile(glm::ivec2 coord);
 
     WorldRegion* getRegion(int x, int z);
     WorldRegion* getOrCreateRegion(int x, int z);
@@ -146,6 +306,7 @@ struct RegionsLayer {
     io::path getRegionFilePath(int x, int z) const;
 
     /// @brief Get chunk data. Read from file if not loaded yet.
+    /// Thread-safe.
     /// @param x chunk x coord
     /// @param z chunk z coord
     /// @param size [out] compressed chunk data length
@@ -158,9 +319,30 @@ struct RegionsLayer {
     /// @param z region Z
     void writeRegion(int x, int y, WorldRegion* entry);
 
+    /// @brief Append unsaved chunks data and updated offsets table to the
+    /// region file. Region file gets rewritten if not exists yet or all its
+    /// chunks are unsaved. Previous file length is kept in a journal file
+    /// until the write is complete, so an interrupted write is rolled back
+    /// when the file is opened next time
+    /// @param x region X
+    /// @param z region Z
+    /// @return fraction of dead space in the region file 
+    float writeRegionChanges(int x, int z, WorldRegion* entry);
+
+    /// @brief Write unsaved region to file using the layer write mode
+    /// @param x region X
+    /// @param z region Z
+    void write(int x, int z, WorldRegion* region);
+
     /// @brief Write all unsaved regions to files
     void writeAll();
 
+    /// @return coords of regions having unsaved chunks
+    std::vector<glm::ivec2> getUnsavedRegions();
+
+    /// @brief Rewrite fragmented region files. Thread-safe
+    void compact();
+
     /// @brief Read chunk data from region file
     /// @param x chunk x coord
     /// @param z chunk z coord
@@ -171,6 +353,64 @@ struct RegionsLayer {
     [[nodiscard]] static std::unique_ptr<ubyte[]> readChunkData(
         int x, int z, uint32_t& size, uint32_t& srcSize, regfile* rfile
     );
+
+    /// @brief Read and decompress chunk data from region file using the
+    /// file compression method. Compressed data is not copied if region
+    /// file is memory-mapped.
+    /// @param x chunk x coord
+    /// @param z chunk z coord
+    /// @param size [out] compressed chunk data length
+    /// @param srcSize [out] source chunk data length
+    /// @param rfile region file
+    /// @param dictionary dictionary used to compress the data
+    /// @return nullptr if chunk is not present in region file
+    [[nodiscard]] static std::unique_ptr<ubyte[]> readChunkData(
+        int x,
+        int z,
+        uint32_t& size,
+        uint32_t& srcSize,
+        regfile* rfile,
+        const zstd::Dictionary* dictionary
+    );
+
+    /// @brief Recompress chunk data read from region file with the layer
+    /// compression method
+    /// @param data chunk data compressed with the region file method
+    /// @param size [in, out] compressed chunk data length
+    /// @param srcSize source chunk data length
+    /// @param method region file compression method
+    [[nodiscard]] std::unique_ptr<ubyte[]> convertChunkData(
+        std::unique_ptr<ubyte[]> data,
+        uint32_t& size,
+        uint32_t srcSize,
+        compression::Method method
+    ) const;
+};
+
+/// @brief Chunk data copied to be compressed and stored outside of the
+/// main thread
+struct ChunkSnapshot {
+    int x;
+    int z;
+    /// @brief Snapshot order number. Snapshot is not stored if a newer one
+    /// of the same chunk has been stored already
+    uint64_t revision;
+    /// @brief Uncompressed data of layers (nullptr if layer is not changed)
+    std::unique_ptr<ubyte[]> data[REGION_LAYERS_COUNT] {};
+    size_t sizes[REGION_LAYERS_COUNT] {};
+    /// @brief Copy of chunk voxels encoded to the voxels layer data
+    /// when put, or nullptr
+    std::unique_ptr<voxel[]> voxels;
+    /// @brief Copy of chunk lights encoded to the lights layer data
+    /// when put, or nullptr
+    std::unique_ptr<Lightmap> lightmap;
+    /// @brief Snapshot is put to regions or superseded by a newer one.
+    /// Chunk must be marked unsaved again if snapshot was not stored
+    bool stored = false;
+    /// @brief Replace chunk data stored already. If false, the snapshot
+    /// is dropped if any data or snapshot of the chunk has been stored,
+    /// and does not supersede snapshots put after it
+    bool replace = true;
 };
 
 class WorldRegions {
@@ -178,6 +418,32 @@ class WorldRegions {
     io::path directory;
 
     RegionsLayer layers[REGION_LAYERS_COUNT] {};
+
+    std::atomic<uint64_t> nextRevision = 1;
+    /// @brief Revisions of the last stored chunks snapshots. Erased when
+    /// the chunk voxels region is written, as snapshots are not put after
+    /// newer ones get written
+    std::unordered_map<glm::ivec2, uint64_t> storedRevisions;
+    std::mutex revisionsMutex;
+
+    /// @brief Erase stored snapshots revisions of the region chunks
+    void eraseStoredRevisions(int regionX, int regionZ);
+
+    /// @brief Compress data with the layer compression method
+    /// @param size [in, out] data length
+    std::unique_ptr<ubyte[]> compress(
+        RegionLayerIndex layerid, std::unique_ptr<ubyte[]> data, size_t& size
+    ) const;
+
+    /// @brief Store already compressed data in specified region
+    void store(
+        int x,
+        int z,
+        RegionLayerIndex layerid,
+        std::unique_ptr<ubyte[]> data,
+        size_t size,
+        size_t srcSize
+    );
 public:
     bool generatorTestMode = false;
     bool doWriteLights = true;
@@ -189,6 +455,23 @@ public:
     /// @brief Put all chunk data to regions
     void put(Chunk* chunk, std::vector<ubyte> entitiesData);
 
+    /// @brief Copy chunk data to be encoded and stored later. Marks chunk
+    /// as saved. Must be called in the chunk owner thread
+    /// @param entitiesData serialized chunk entities
+    /// @return nullptr if chunk has nothing to save
+    std::unique_ptr<ChunkSnapshot> snapshot(
+        Chunk* chunk, std::vector<ubyte> entitiesData
+    );
+
+    /// @brief Encode, compress and put chunk snapshot data to regions.
+    /// Thread-safe, may be called in background. Snapshot data is left
+    /// encoded but not compressed if compression fails
+    void put(ChunkSnapshot& snapshot);
+
+    /// @brief Check if chunk voxels are stored in memory or region file.
+    /// Thread-safe
+    bool hasVoxels(int x, int z);
+
     /// @brief Store data in specified region
     /// @param x chunk.x
     /// @param z chunk.z
@@ -203,6 +486,12 @@ public:
         size_t size
     );
 
+    /// @brief Read all layers data of the chunk to in-memory regions
+    /// without decoding. Used to move disk reads out of the main thread.
+    /// @param x chunk.x
+    /// @param z chunk.z
+    void prefetch(int x, int z);
+
     /// @brief Get chunk voxels data
     /// @param x chunk.x
     /// @param z chunk.z
@@ -245,6 +534,58 @@ public:
     /// @brief Write all region layers
     void writeAll();
 
+    /// @return total number of bytes written to region files of all layers
+    uint64_t getBytesWritten() const;
+
+    /// @return regions having unsaved chunks as (layer, x, z) sets
+    std::vector<glm::ivec3> getUnsavedRegions();
+
+    /// @brief Write region file if the region has unsaved chunks.
+    /// Thread-safe, may be called in background
+    /// @param layerid regions layer index
+    /// @param x region X
+    /// @param z region Z
+    void writeRegion(RegionLayerIndex layerid, int x, int z);
+
+    /// @brief Rewrite region files with dead space left by incremental
+    /// writes. Thread-safe, may be called in background
+    void compact();
+
+    /// @return true if some region files are waiting for compaction
+    bool hasFragmented();
+
+    /// @brief Enable or disable incremental region files writing
+    void setIncrementalWrites(bool flag);
+
+    /// @brief Set dead space fraction of a region file making it to be
+    /// scheduled for compaction
+    void setCompactionThreshold(float threshold);
+
+    /// @brief Enable or disable atomic flushed region files rewriting
+    void setDurableWrites(bool flag);
+
+    /// @brief Set layer compression method. Existing region files are
+    /// converted when rewritten. Must be called before the layer regions
+    /// are accessed
+    void setCompression(RegionLayerIndex layerid, compression::Method method);
+
+    compression::Method getCompression(RegionLayerIndex layerid) const;
+
+    /// @brief Train ZSTD dictionary on chunks data of the layer region
+    /// files and save it to the layer folder. The dictionary is used since
+    /// the world is loaded next time, as region files may be in use now
+    /// @param maxSamples max number of chunks used as samples
+    /// @return dictionary size
+    /// @throws std::runtime_error if the layer already has a dictionary
+    /// or there is not enough saved chunks
+    size_t trainDictionary(RegionLayerIndex layerid, size_t maxSamples);
+
+    /// @brief Set max number of simultaneously open files of each layer
+    void setMaxOpenFiles(size_t count);
+
+    /// @return open region files cache stats summed over all layers
+    RegionFilesCache::Stats getOpenFilesStats() const;
+
     void deleteRegion(RegionLayerIndex layerid, int x, int z);
 
     /// @brief Extract X and Z from 'X_Z.bin' region file name.
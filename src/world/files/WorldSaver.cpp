@@ -0,0 +1,153 @@
+#include "WorldSaver.hpp"
+
+#include <algorithm>
+#include <thread>
+
+#include "debug/Logger.hpp"
+#include "WorldRegions.hpp"
+
+static debug::Logger logger("world-saver");
+
+class WorldSaveWorker : public util::Worker<WorldSaveJob, int> {
+    WorldRegions& regions;
+public:
+    WorldSaveWorker(WorldRegions& regions) : regions(regions) {
+    }
+
+    int operator()(const WorldSaveJob& job) override {
+        switch (job.type) {
+            case WorldSaveJobType::STORE:
+                regions.put(*job.snapshot);
+                break;
+            case WorldSaveJobType::WRITE:
+                regions.writeRegion(job.layer, job.x, job.z);
+                break;
+        }
+        return 0;
+    }
+};
+
+static std::unique_ptr<util::ThreadPool<WorldSaveJob, int>> create_pool(
+    WorldRegions& regions
+) {
+    auto pool = std::make_unique<util::ThreadPool<WorldSaveJob, int>>(
+        "world-saver",
+        [&regions]() { return std::make_shared<WorldSaveWorker>(regions); },
+        [](int&) {},
+        std::max(1U, std::thread::hardware_concurrency() / 2)
+    );
+    // failed region stays unsaved and will be written next time
+    pool->setStopOnFail(false);
+    pool->setOnComplete([]() {});
+    return pool;
+}
+
+WorldSaver::WorldSaver(
+    WorldRegions& regions,
+    std::vector<std::shared_ptr<ChunkSnapshot>> snapshots,
+    consumer<ChunkSnapshot&> onNotStored
+)
+    : regions(regions),
+      snapshots(std::move(snapshots)),
+      onNotStored(std::move(onNotStored)),
+      startTime(std::chrono::steady_clock::now()) {
+    pool = create_pool(regions);
+    for (const auto& snapshot : this->snapshots) {
+        pool->enqueueJob(
+            WorldSaveJob {WorldSaveJobType::STORE, snapshot, 0, 0, {}}
+        );
+    }
+    workTotal = this->snapshots.size();
+    logger.info() << "storing " << this->snapshots.size() << " chunks";
+}
+
+WorldSaver::~WorldSaver() {
+    terminate();
+}
+
+void WorldSaver::handleNotStored() {
+    size_t count = 0;
+    for (const auto& snapshot : snapshots) {
+        if (!snapshot->stored) {
+            onNotStored(*snapshot);
+            count++;
+        }
+    }
+    snapshots.clear();
+    if (count) {
+        logger.warning() << count << " chunks snapshots were not stored";
+    }
+}
+
+void WorldSaver::startWriting() {
+    auto unsaved = regions.getUnsavedRegions();
+    stage = Stage::WRITE;
+    pool = create_pool(regions);
+    for (const auto& region : unsaved) {
+        pool->enqueueJob(WorldSaveJob {
+            WorldSaveJobType::WRITE,
+            nullptr,
+            region.y,
+            region.z,
+            static_cast<RegionLayerIndex>(region.x)});
+    }
+    workTotal += unsaved.size();
+    logger.info() << "writing " << unsaved.size() << " regions";
+}
+
+bool WorldSaver::isActive() const {
+    return stage != Stage::DONE;
+}
+
+uint WorldSaver::getWorkTotal() const {
+    return workTotal;
+}
+
+uint WorldSaver::getWorkDone() const {
+    return workDone + (pool ? pool->getWorkDone() : 0);
+}
+
+void WorldSaver::update() {
+    if (pool == nullptr) {
+        return;
+    }
+    pool->update();
+    if (pool->isActive()) {
+        return;
+    }
+    workDone += pool->getWorkDone();
+    pool = nullptr;
+
+    if (stage == Stage::STORE) {
+        handleNotStored();
+        startWriting();
+        return;
+    }
+    stage = Stage::DONE;
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - startTime
+    );
+    logger.info() << "world saved in " << elapsed.count() << " ms";
+}
+
+void WorldSaver::waitForEnd() {
+    using namespace std::chrono_literals;
+    while (isActive()) {
+        std::this_thread::sleep_for(2ms);
+        update();
+    }
+}
+
+void WorldSaver::terminate() {
+    if (pool) {
+        pool->terminate();
+        pool = nullptr;
+    }
+    if (stage == Stage::STORE) {
+        handleNotStored();
+    }
+    if (stage != Stage::DONE) {
+        logger.warning() << "world saving interrupted";
+        stage = Stage::DONE;
+    }
+}
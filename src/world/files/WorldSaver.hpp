@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "delegates.hpp"
+#include "interfaces/Task.hpp"
+#include "typedefs.hpp"
+#include "util/ThreadPool.hpp"
+#include "world_regions_fwd.hpp"
+
+class WorldRegions;
+struct ChunkSnapshot;
+
+enum class WorldSaveJobType {
+    /// @brief encode, compress and put chunk snapshot to in-memory regions
+    STORE,
+    /// @brief write region file
+    WRITE,
+};
+
+struct WorldSaveJob {
+    WorldSaveJobType type;
+    std::shared_ptr<ChunkSnapshot> snapshot;
+
+    /// @brief region coords
+    int x, z;
+    RegionLayerIndex layer;
+};
+
+/// @brief Background world saving task. Chunks data is copied in the main
+/// thread (see WorldRegions::snapshot), then encoded, compressed and
+/// written to region files by worker threads while the game keeps running.
+/// Region files are written after all snapshots are stored.
+/// Snapshots failed to be stored are passed back to the main thread,
+/// so the chunks changes are not lost.
+class WorldSaver : public Task {
+    enum class Stage { STORE, WRITE, DONE };
+
+    WorldRegions& regions;
+    std::vector<std::shared_ptr<ChunkSnapshot>> snapshots;
+    consumer<ChunkSnapshot&> onNotStored;
+    std::unique_ptr<util::ThreadPool<WorldSaveJob, int>> pool;
+    Stage stage = Stage::STORE;
+    uint workTotal = 0;
+    uint workDone = 0;
+    std::chrono::steady_clock::time_point startTime;
+
+    void startWriting();
+
+    /// @brief Pass not stored snapshots to the callback.
+    /// Called when no store jobs are running
+    void handleNotStored();
+public:
+    /// @param regions target world regions
+    /// @param snapshots chunks snapshots to save
+    /// @param onNotStored called in the main thread for every snapshot
+    /// that failed to be stored or was cancelled
+    WorldSaver(
+        WorldRegions& regions,
+        std::vector<std::shared_ptr<ChunkSnapshot>> snapshots,
+        consumer<ChunkSnapshot&> onNotStored
+    );
+    ~WorldSaver();
+
+    bool isActive() const override;
+
+    /// @return true if all snapshots are stored and region files are
+    /// being written
+    bool isWriting() const {
+        return stage == Stage::WRITE;
+    }
+
+    uint getWorkTotal() const override;
+    uint getWorkDone() const override;
+    void update() override;
+    void waitForEnd() override;
+
+    /// @brief Stop saving. Data not written yet stays in in-memory
+    /// regions and will be written by the next save
+    void terminate() override;
+};
@@ -34,4 +34,12 @@ void GeneratorDef::prepare(const Content* content) {
             structure.rt.id = found->second;
         }
     }
+    for (auto& structure : structures) {
+        // pre-calculate rotated structure variants
+        structure->fragments[0]->prepare(*content);
+        for (int j = 1; j < 4; j++) {
+            structure->fragments[j] =
+                structure->fragments[j - 1]->rotated(*content);
+        }
+    }
 }
@@ -128,6 +128,10 @@ public:
 
     virtual void initialize(uint64_t seed) = 0;
 
+    /// @brief Create an isolated instance of the script to be used by
+    /// another thread. The instance must be initialized with the same seed
+    virtual std::unique_ptr<GeneratorScript> clone() const = 0;
+
     /// @brief Generate a heightmap with values in range 0..1
     /// @param offset position of the heightmap in the world
     /// @param size size of the heightmap
@@ -198,6 +202,10 @@ struct GeneratorDef {
     /// @brief Generator display name
     std::string caption;
 
+    /// @brief Generator version. Cached chunk prototypes generated by
+    /// other versions are discarded
+    int version = 0;
+
     std::unique_ptr<GeneratorScript> script;
 
     /// @brief Sea level (top of seaLayers)
@@ -232,5 +240,8 @@ struct GeneratorDef {
     GeneratorDef(std::string name);
     GeneratorDef(const GeneratorDef&) = delete;
 
+    /// @brief Resolve content indices and pre-calculate rotated structure
+    /// variants. Called once when content is built, as generators share
+    /// the definition
     void prepare(const Content* content);
 };
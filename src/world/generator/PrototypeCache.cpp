@@ -0,0 +1,246 @@
+#include "PrototypeCache.hpp"
+
+#include <stdexcept>
+
+#include "constants.hpp"
+#include "coders/byte_utils.hpp"
+#include "maths/Heightmap.hpp"
+
+static inline constexpr const char* MAGIC = ".VOXPRT";
+static inline constexpr size_t MAGIC_SIZE = 8;
+
+enum class PlacementType : ubyte {
+    STRUCTURE = 0, LINE
+};
+
+/// @brief FNV-1a hash of names list
+static uint64_t hash_names(
+    uint64_t hash, const std::vector<std::string>& names
+) {
+    for (const auto& name : names) {
+        // terminating zero separates names
+        for (size_t i = 0; i <= name.length(); i++) {
+            hash ^= static_cast<ubyte>(name.c_str()[i]);
+            hash *= 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+PrototypeCache::PrototypeCache(
+    size_t capacity,
+    uint64_t seed,
+    std::string generator,
+    int version,
+    uint biomesCount,
+    const std::vector<std::string>& structures,
+    const std::vector<std::string>& blocks
+)
+    : capacity(capacity),
+      seed(seed),
+      generator(std::move(generator)),
+      version(version),
+      biomesCount(biomesCount),
+      structuresCount(structures.size()),
+      blocksCount(blocks.size()),
+      contentHash(hash_names(
+          hash_names(14695981039346656037ULL, structures), blocks
+      )) {
+}
+
+std::shared_ptr<const CachedPrototype> PrototypeCache::get(int x, int z) {
+    const auto& found = entries.find({x, z});
+    if (found == entries.end()) {
+        return nullptr;
+    }
+    auto& [prototype, position] = found->second;
+    order.splice(order.begin(), order, position);
+    return prototype;
+}
+
+void PrototypeCache::put(
+    int x, int z, std::shared_ptr<const CachedPrototype> prototype
+) {
+    if (capacity == 0) {
+        return;
+    }
+    glm::ivec2 coord {x, z};
+    const auto& found = entries.find(coord);
+    if (found != entries.end()) {
+        found->second.first = std::move(prototype);
+        order.splice(order.begin(), order, found->second.second);
+        return;
+    }
+    while (entries.size() >= capacity) {
+        entries.erase(order.back());
+        order.pop_back();
+    }
+    order.push_front(coord);
+    entries[coord] = Entry {std::move(prototype), order.begin()};
+}
+
+static void write_ivec3(ByteBuilder& builder, const glm::ivec3& vec) {
+    builder.putInt32(vec.x);
+    builder.putInt32(vec.y);
+    builder.putInt32(vec.z);
+}
+
+static glm::ivec3 read_ivec3(ByteReader& reader) {
+    int x = reader.getInt32();
+    int y = reader.getInt32();
+    int z = reader.getInt32();
+    return {x, y, z};
+}
+
+static void write_placements(
+    ByteBuilder& builder, const std::vector<Placement>& placements
+) {
+    builder.putInt32(placements.size());
+    for (const auto& placement : placements) {
+        builder.putInt32(placement.priority);
+        if (auto sp = std::get_if<StructurePlacement>(&placement.placement)) {
+            builder.put(static_cast<ubyte>(PlacementType::STRUCTURE));
+            builder.putInt32(sp->structure);
+            write_ivec3(builder, sp->position);
+            builder.put(sp->rotation);
+        } else {
+            const auto& line = std::get<LinePlacement>(placement.placement);
+            builder.put(static_cast<ubyte>(PlacementType::LINE));
+            builder.putInt16(line.block);
+            write_ivec3(builder, line.a);
+            write_ivec3(builder, line.b);
+            builder.putInt32(line.radius);
+        }
+    }
+}
+
+static std::vector<Placement> read_placements(
+    ByteReader& reader, uint structuresCount, uint blocksCount
+) {
+    int count = reader.getInt32();
+    if (count < 0) {
+        throw std::runtime_error("invalid placements count");
+    }
+    std::vector<Placement> placements;
+    for (int i = 0; i < count; i++) {
+        int priority = reader.getInt32();
+        switch (static_cast<PlacementType>(reader.get())) {
+            case PlacementType::STRUCTURE: {
+                int structure = reader.getInt32();
+                auto position = read_ivec3(reader);
+                uint8_t rotation = reader.get();
+                if (structure < 0 ||
+                    static_cast<uint>(structure) >= structuresCount) {
+                    throw std::runtime_error("invalid structure index");
+                }
+                if (rotation >= 4) {
+                    throw std::runtime_error("invalid structure rotation");
+                }
+                placements.emplace_back(
+                    priority,
+                    StructurePlacement {structure, position, rotation}
+                );
+                break;
+            }
+            case PlacementType::LINE: {
+                blockid_t block = reader.getInt16();
+                auto a = read_ivec3(reader);
+                auto b = read_ivec3(reader);
+                int radius = reader.getInt32();
+                if (block >= blocksCount) {
+                    throw std::runtime_error("invalid block index");
+                }
+                placements.emplace_back(
+                    priority, LinePlacement {block, a, b, radius}
+                );
+                break;
+            }
+            default:
+                throw std::runtime_error("invalid placement type");
+        }
+    }
+    return placements;
+}
+
+std::vector<ubyte> PrototypeCache::serialize() const {
+    ByteBuilder builder;
+    builder.put(reinterpret_cast<const ubyte*>(MAGIC), MAGIC_SIZE);
+    builder.putInt16(FORMAT_VERSION);
+    builder.putInt64(seed);
+    builder.put(generator);
+    builder.putInt32(version);
+    builder.putInt32(biomesCount);
+    builder.putInt64(contentHash);
+    builder.putInt32(entries.size());
+    // least recently used first to restore the same order on load
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        const auto& prototype = *entries.at(*it).first;
+        builder.putInt32(it->x);
+        builder.putInt32(it->y);
+        write_placements(builder, prototype.widePlacements);
+        for (uint i = 0; i < CHUNK_W * CHUNK_D; i++) {
+            builder.putInt16(prototype.biomes[i]);
+        }
+        const auto& heightmap = *prototype.heightmap;
+        builder.putInt32(heightmap.getWidth());
+        builder.putInt32(heightmap.getHeight());
+        const float* values = heightmap.getValues();
+        for (uint i = 0; i < heightmap.getWidth() * heightmap.getHeight(); i++) {
+            builder.putFloat32(values[i]);
+        }
+        write_placements(builder, prototype.placements);
+    }
+    return builder.build();
+}
+
+bool PrototypeCache::deserialize(const std::vector<ubyte>& bytes) {
+    ByteReader reader(bytes);
+    reader.checkMagic(MAGIC, MAGIC_SIZE);
+    if (reader.getInt16() != FORMAT_VERSION ||
+        static_cast<uint64_t>(reader.getInt64()) != seed ||
+        reader.getString() != generator || reader.getInt32() != version ||
+        static_cast<uint>(reader.getInt32()) != biomesCount ||
+        static_cast<uint64_t>(reader.getInt64()) != contentHash) {
+        return false;
+    }
+    int count = reader.getInt32();
+    if (count < 0) {
+        throw std::runtime_error("invalid prototypes count");
+    }
+    // entries are added only if all of them are valid
+    std::vector<std::pair<glm::ivec2, std::shared_ptr<CachedPrototype>>> loaded;
+    for (int i = 0; i < count; i++) {
+        int x = reader.getInt32();
+        int z = reader.getInt32();
+        auto prototype = std::make_shared<CachedPrototype>();
+        prototype->widePlacements =
+            read_placements(reader, structuresCount, blocksCount);
+
+        prototype->biomes = std::make_unique<uint16_t[]>(CHUNK_W * CHUNK_D);
+        for (uint j = 0; j < CHUNK_W * CHUNK_D; j++) {
+            uint16_t index = reader.getInt16();
+            if (index >= biomesCount) {
+                throw std::runtime_error("invalid biome index");
+            }
+            prototype->biomes[j] = index;
+        }
+        uint width = reader.getInt32();
+        uint height = reader.getInt32();
+        if (width != CHUNK_W || height != CHUNK_D) {
+            throw std::runtime_error("invalid heightmap size");
+        }
+        std::vector<float> values(width * height);
+        for (auto& value : values) {
+            value = reader.getFloat32();
+        }
+        prototype->heightmap =
+            std::make_shared<Heightmap>(width, height, std::move(values));
+        prototype->placements =
+            read_placements(reader, structuresCount, blocksCount);
+        loaded.emplace_back(glm::ivec2(x, z), std::move(prototype));
+    }
+    for (auto& [coord, prototype] : loaded) {
+        put(coord.x, coord.y, std::move(prototype));
+    }
+    return true;
+}
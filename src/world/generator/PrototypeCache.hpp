@@ -0,0 +1,95 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+#include "typedefs.hpp"
+#include "StructurePlacement.hpp"
+
+class Heightmap;
+
+/// @brief Results of chunk prototype stages produced by the chunk itself.
+/// Placements received from neighbour chunks are not included, so stages
+/// may be replayed from the cache in the usual order.
+struct CachedPrototype {
+    /// @brief wide structures placed by the chunk
+    std::vector<Placement> widePlacements;
+    /// @brief indices of chunk biomes in GeneratorDef::biomes
+    std::unique_ptr<uint16_t[]> biomes;
+    /// @brief complete chunk heightmap
+    std::shared_ptr<Heightmap> heightmap;
+    /// @brief structures placed by the chunk
+    std::vector<Placement> placements;
+};
+
+/// @brief Bounded LRU cache of generated chunk prototypes.
+/// Entries are valid only for the same seed, generator version and
+/// content indices, as placements refer to structures and blocks by index.
+class PrototypeCache {
+    using Entry = std::pair<
+        std::shared_ptr<const CachedPrototype>,
+        std::list<glm::ivec2>::iterator>;
+
+    size_t capacity;
+    uint64_t seed;
+    std::string generator;
+    int version;
+    uint biomesCount;
+    uint structuresCount;
+    uint blocksCount;
+    /// @brief Hash of structures and blocks names in order of indices
+    uint64_t contentHash;
+    /// @brief Cached prototypes coords, most recently used first
+    std::list<glm::ivec2> order;
+    std::unordered_map<glm::ivec2, Entry> entries;
+public:
+    static inline constexpr int FORMAT_VERSION = 2;
+
+    /// @param capacity max number of cached prototypes
+    /// @param seed world seed
+    /// @param generator generator full name
+    /// @param version generator version
+    /// @param biomesCount number of generator biomes
+    /// @param structures generator structures names in order of indices
+    /// @param blocks content blocks names in order of runtime ids
+    PrototypeCache(
+        size_t capacity,
+        uint64_t seed,
+        std::string generator,
+        int version,
+        uint biomesCount,
+        const std::vector<std::string>& structures,
+        const std::vector<std::string>& blocks
+    );
+
+    /// @return cached prototype or nullptr
+    std::shared_ptr<const CachedPrototype> get(int x, int z);
+
+    /// @brief Add or replace prototype, evicting least recently used one
+    /// if capacity exceeded
+    void put(int x, int z, std::shared_ptr<const CachedPrototype> prototype);
+
+    size_t size() const {
+        return entries.size();
+    }
+
+    size_t getCapacity() const {
+        return capacity;
+    }
+
+    /// @brief Serialize all entries with cache key
+    std::vector<ubyte> serialize() const;
+
+    /// @brief Load entries serialized with the same cache key.
+    /// Nothing is loaded if the data is corrupted
+    /// @return false if data was created for other seed, generator version
+    /// or content
+    /// @throws std::runtime_error if data is corrupted
+    bool deserialize(const std::vector<ubyte>& bytes);
+};
@@ -14,6 +14,16 @@ SurroundMap::SurroundMap(int maxLevelRadius, int8_t maxLevel)
 void SurroundMap::setLevelCallback(int8_t level, LevelCallback callback) {
     auto& wrapper = levelCallbacks.at(level - 1);
     wrapper.callback = callback;
+    wrapper.batchCallback = nullptr;
+    wrapper.active = callback != nullptr;
+}
+
+void SurroundMap::setLevelBatchCallback(
+    int8_t level, LevelBatchCallback callback
+) {
+    auto& wrapper = levelCallbacks.at(level - 1);
+    wrapper.batchCallback = callback;
+    wrapper.callback = nullptr;
     wrapper.active = callback != nullptr;
 }
 
@@ -24,6 +34,7 @@ void SurroundMap::setOutCallback(util::AreaMap2D<int8_t>::OutCallback callback)
 void SurroundMap::upgrade(int x, int y, int8_t level) {
     auto& callback = levelCallbacks[level - 1];
     int size = maxLevel - level + 1;
+    std::vector<glm::ivec2> points;
     for (int ly = -size+1; ly < size; ly++) {
         for (int lx = -size+1; lx < size; lx++) {
             int posX = lx + x;
@@ -36,11 +47,16 @@ void SurroundMap::upgrade(int x, int y, int8_t level) {
                 continue;
             }
             areaMap.set(posX, posY, level);
-            if (callback.active) {
+            if (callback.batchCallback) {
+                points.emplace_back(posX, posY);
+            } else if (callback.active) {
                 callback.callback(posX, posY);
             }
         }
     }
+    if (!points.empty()) {
+        callback.batchCallback(points);
+    }
 }
 
 void SurroundMap::resize(int maxLevelRadius) {
@@ -48,6 +64,10 @@ void SurroundMap::resize(int maxLevelRadius) {
                    (maxLevelRadius + maxLevel) * 2 + 1);
 }
 
+void SurroundMap::clear() {
+    areaMap.clear();
+}
+
 void SurroundMap::completeAt(int x, int y) {
     if (!areaMap.isInside(x - maxLevel + 1, y - maxLevel + 1) ||
         !areaMap.isInside(x + maxLevel - 1, y + maxLevel - 1)) {
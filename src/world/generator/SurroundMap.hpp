@@ -2,6 +2,7 @@
 
 #include <unordered_map>
 #include <functional>
+#include <vector>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
@@ -12,8 +13,11 @@
 class SurroundMap {
 public:
     using LevelCallback = std::function<void(int, int)>;
+    using LevelBatchCallback =
+        std::function<void(const std::vector<glm::ivec2>&)>;
     struct LevelCallbackWrapper {
         LevelCallback callback;
+        LevelBatchCallback batchCallback;
         bool active = false;
     };
 private:
@@ -28,6 +32,10 @@ public:
     /// @brief Callback called on point level increments
     void setLevelCallback(int8_t level, LevelCallback callback);
 
+    /// @brief Callback called once per upgrade with all points
+    /// incremented to the level. Replaces the point callback
+    void setLevelBatchCallback(int8_t level, LevelBatchCallback callback);
+
     /// @brief Callback called when non-zero value moves out of area
     void setOutCallback(util::AreaMap2D<int8_t>::OutCallback callback);   
     
@@ -40,6 +48,9 @@ public:
 
     void resize(int maxLevelRadius);
 
+    /// @brief Reset all points levels, calling out callback
+    void clear();
+
     /// @brief Get level at position
     /// @throws std::invalid_argument - position is out of area
     int8_t at(int x, int y);
@@ -168,26 +168,94 @@ void VoxelFragment::prepare(const Content& content) {
         voxelsRuntime[i].id = content.blocks.require(name).rt.id;
         voxelsRuntime[i].state = voxels[i].state;
     }
+    buildSpans();
 }
 
-void VoxelFragment::place(
-    GlobalChunks& chunks, const glm::ivec3& offset, ubyte rotation
-) {
-    auto& structVoxels = getRuntimeVoxels();
+void VoxelFragment::buildSpans() {
+    spans.clear();
+    rowSpans.resize(size.y * size.z + 1);
+    boundsMin = size;
+    boundsMax = {};
     for (int y = 0; y < size.y; y++) {
-        int sy = y + offset.y;
-        if (sy < 0 || sy >= CHUNK_H) {
-            continue;
-        }
         for (int z = 0; z < size.z; z++) {
-            int sz = z + offset.z;
+            rowSpans[y * size.z + z] = spans.size();
+            uint32_t rowIndex = vox_index(0, y, z, size.x, size.z);
             for (int x = 0; x < size.x; x++) {
-                int sx = x + offset.x;
-                const auto& structVoxel = 
-                    structVoxels[vox_index(x, y, z, size.x, size.z)];
-                if (structVoxel.id) {
+                if (voxelsRuntime[rowIndex + x].id == BLOCK_AIR) {
+                    continue;
+                }
+                int start = x;
+                while (x < size.x &&
+                       voxelsRuntime[rowIndex + x].id != BLOCK_AIR) {
+                    x++;
+                }
+                spans.push_back(VoxelsSpan {
+                    rowIndex + start,
+                    static_cast<uint16_t>(start),
+                    static_cast<uint16_t>(x - start)});
+                boundsMin = glm::min(boundsMin, {start, y, z});
+                boundsMax = glm::max(boundsMax, {x, y + 1, z + 1});
+            }
+        }
+    }
+    rowSpans[size.y * size.z] = spans.size();
+}
+
+void VoxelFragment::paste(voxel* dst, const glm::ivec3& offset) const {
+    assert(!rowSpans.empty());
+    // chunk bounds in fragment coords
+    int minX = -offset.x;
+    int maxX = CHUNK_W - offset.x;
+    int minY = std::max(boundsMin.y, -offset.y);
+    int maxY = std::min(boundsMax.y, CHUNK_H - offset.y);
+    int minZ = std::max(boundsMin.z, -offset.z);
+    int maxZ = std::min(boundsMax.z, CHUNK_D - offset.z);
+    if (std::max(boundsMin.x, minX) >= std::min(boundsMax.x, maxX)) {
+        return;
+    }
+    for (int y = minY; y < maxY; y++) {
+        for (int z = minZ; z < maxZ; z++) {
+            uint32_t row = y * size.z + z;
+            for (uint32_t i = rowSpans[row]; i < rowSpans[row + 1]; i++) {
+                const auto& span = spans[i];
+                int x0 = std::max<int>(span.x, minX);
+                int x1 = std::min<int>(span.x + span.length, maxX);
+                if (x0 >= x1) {
+                    continue;
+                }
+                std::copy_n(
+                    voxelsRuntime.data() + span.index + (x0 - span.x),
+                    x1 - x0,
+                    dst + vox_index(x0 + offset.x, y + offset.y, z + offset.z)
+                );
+            }
+        }
+    }
+}
+
+template <class Storage>
+void VoxelFragment::placeSpans(
+    Storage& chunks, const glm::ivec3& offset
+) const {
+    assert(!rowSpans.empty());
+    int minY = std::max(boundsMin.y, -offset.y);
+    int maxY = std::min(boundsMax.y, CHUNK_H - offset.y);
+    for (int y = minY; y < maxY; y++) {
+        int sy = y + offset.y;
+        for (int z = boundsMin.z; z < boundsMax.z; z++) {
+            int sz = z + offset.z;
+            uint32_t row = y * size.z + z;
+            for (uint32_t i = rowSpans[row]; i < rowSpans[row + 1]; i++) {
+                const auto& span = spans[i];
+                for (int j = 0; j < span.length; j++) {
+                    const auto& structVoxel = voxelsRuntime[span.index + j];
                     blocks_agent::set(
-                        chunks, sx, sy, sz, structVoxel.id, structVoxel.state
+                        chunks,
+                        span.x + j + offset.x,
+                        sy,
+                        sz,
+                        structVoxel.id,
+                        structVoxel.state
                     );
                 }
             }
@@ -195,6 +263,18 @@ void VoxelFragment::place(
     }
 }
 
+void VoxelFragment::place(
+    GlobalChunks& chunks, const glm::ivec3& offset, ubyte rotation
+) {
+    placeSpans(chunks, offset);
+}
+
+void VoxelFragment::place(
+    Chunks& chunks, const glm::ivec3& offset, ubyte rotation
+) {
+    placeSpans(chunks, offset);
+}
+
 std::unique_ptr<VoxelFragment> VoxelFragment::rotated(const Content& content) const {
     std::vector<voxel> newVoxels(voxels.size());
 
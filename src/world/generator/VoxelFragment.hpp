@@ -11,8 +11,18 @@ inline constexpr int STRUCTURE_FORMAT_VERSION = 1;
 
 class Level;
 class Content;
+class Chunks;
 class GlobalChunks;
 
+/// @brief Continuous X-axis run of fragment non-air voxels
+struct VoxelsSpan {
+    /// @brief Index of the first span voxel in runtime voxels
+    uint32_t index;
+    /// @brief X coord of the first span voxel
+    uint16_t x;
+    uint16_t length;
+};
+
 class VoxelFragment : public Serializable {
     glm::ivec3 size;
 
@@ -23,6 +33,20 @@ class VoxelFragment : public Serializable {
 
     /// @brief Structure voxels built on prepare(...) call
     std::vector<voxel> voxelsRuntime;
+    /// @brief Non-air voxels spans built on prepare(...) call
+    std::vector<VoxelsSpan> spans;
+    /// @brief Index of the first span of (y, z) row in spans,
+    /// indexed as y * size.z + z. Last element is spans count
+    std::vector<uint32_t> rowSpans;
+    /// @brief Non-air voxels bounding box min (inclusive)
+    glm::ivec3 boundsMin {};
+    /// @brief Non-air voxels bounding box max (exclusive)
+    glm::ivec3 boundsMax {};
+
+    void buildSpans();
+
+    template <class Storage>
+    void placeSpans(Storage& chunks, const glm::ivec3& offset) const;
 public:
     VoxelFragment() : size() {}
 
@@ -48,6 +72,16 @@ public:
     /// @param rotation rotation index
     void place(GlobalChunks& chunks, const glm::ivec3& offset, ubyte rotation);
 
+    /// @brief Place fragment to the chunks matrix
+    /// @param offset target location
+    /// @param rotation rotation index
+    void place(Chunks& chunks, const glm::ivec3& offset, ubyte rotation);
+
+    /// @brief Copy non-air voxels intersecting the chunk to chunk voxels
+    /// @param dst chunk voxels
+    /// @param offset fragment position relative to the chunk
+    void paste(voxel* dst, const glm::ivec3& offset) const;
+
     /// @brief Create structure copy rotated 90 deg. clockwise
     std::unique_ptr<VoxelFragment> rotated(const Content& content) const;
 
@@ -63,6 +97,16 @@ public:
         return size;
     }
 
+    /// @return non-air voxels bounding box min (valid after prepare)
+    const glm::ivec3& getBoundsMin() const {
+        return boundsMin;
+    }
+
+    /// @return non-air voxels bounding box max, exclusive (valid after prepare)
+    const glm::ivec3& getBoundsMax() const {
+        return boundsMax;
+    }
+
     /// @return Voxels with indices valid to current world content
     const std::vector<voxel>& getRuntimeVoxels() {
         assert(!voxelsRuntime.empty());
@@ -2,6 +2,10 @@
 
 #include <cstring>
 #include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
 
 #include "maths/util.hpp"
 #include "content/Content.hpp"
@@ -13,6 +17,7 @@
 #include "util/listutil.hpp"
 #include "maths/voxmaths.hpp"
 #include "maths/util.hpp"
+#include "util/ThreadPool.hpp"
 #include "debug/Logger.hpp"
 
 static debug::Logger logger("world-generator");
@@ -23,65 +28,207 @@ static inline constexpr uint MAX_PARAMETERS = 4;
 /// @brief Initial + wide_structs + biomes + heightmaps + complete
 static inline constexpr uint BASIC_PROTOTYPE_LAYERS = 5;
 
+struct WorldGenerator::StageTask {
+    const std::vector<glm::ivec2>& points;
+    const std::vector<ChunkPrototype*>& prototypes;
+    const StageFunc& stage;
+    std::atomic<size_t> next = 0;
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    StageTask(
+        const std::vector<glm::ivec2>& points,
+        const std::vector<ChunkPrototype*>& prototypes,
+        const StageFunc& stage
+    )
+        : points(points), prototypes(prototypes), stage(stage) {
+    }
+
+    /// @brief Run stage for the next points until all are taken
+    void work(GeneratorScript& script) {
+        size_t index;
+        while ((index = next++) < points.size()) {
+            try {
+                const auto& point = points[index];
+                stage(script, *prototypes[index], point.x, point.y, index);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (error == nullptr) {
+                    error = std::current_exception();
+                }
+            }
+        }
+    }
+};
+
+class WorldGenerator::Worker
+    : public util::Worker<StageTask*, StageTask*> {
+    std::unique_ptr<GeneratorScript> script;
+public:
+    Worker(const GeneratorScript& source, uint64_t seed)
+        : script(source.clone()) {
+        // scripts are not thread-safe, so each worker thread has its own
+        script->initialize(seed);
+    }
+
+    StageTask* operator()(StageTask* const& task) override {
+        task->work(*script);
+        return task;
+    }
+};
+
 WorldGenerator::WorldGenerator(
-    const GeneratorDef& def, const Content& content, uint64_t seed
+    const GeneratorDef& def, const Content& content, uint64_t seed, uint threads
 )
     : def(def), 
       content(content), 
       seed(seed),
-      surroundMap(0, BASIC_PROTOTYPE_LAYERS + def.wideStructsChunksRadius * 2)
+      script(def.script->clone())
 {
-    def.script->initialize(seed);
+    script->initialize(seed);
+    if (threads == 0) {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    if (threads > 1) {
+        pool = std::make_unique<util::ThreadPool<StageTask*, StageTask*>>(
+            "world-generator",
+            [this]() {
+                return std::make_shared<Worker>(*script, this->seed);
+            },
+            [this](StageTask*&) { stageJobsDone++; },
+            threads - 1
+        );
+    }
+
+    logger.info() << "total number of prototype levels is "
+                  << BASIC_PROTOTYPE_LAYERS + def.wideStructsChunksRadius * 2;
+}
 
+WorldGenerator::~WorldGenerator() = default;
+
+uint WorldGenerator::getThreadsCount() const {
+    return pool ? pool->getWorkersCount() + 1 : 1;
+}
+
+std::unique_ptr<SurroundMap> WorldGenerator::createArea() {
     uint levels = BASIC_PROTOTYPE_LAYERS + def.wideStructsChunksRadius * 2;
+    auto area = std::make_unique<SurroundMap>(0, levels);
 
-    surroundMap = SurroundMap(0, levels);
-    logger.info() << "total number of prototype levels is " << levels;
-    surroundMap.setOutCallback([this](int const x, int const z, int8_t) {
+    area->setOutCallback([this](int const x, int const z, int8_t) {
         const auto& found = prototypes.find({x, z});
         if (found == prototypes.end()) {
             logger.warning() << "unable to remove non-existing chunk prototype";
             return;
         }
-        prototypes.erase({x, z});
-    });
-    surroundMap.setLevelCallback(1, [this](int const x, int const z) {
-        if (prototypes.find({x, z}) != prototypes.end()) {
-            return;
+        // prototype is kept while any other area contains it
+        if (--found->second.areas == 0) {
+            prototypes.erase(found);
         }
-        prototypes[{x, z}] = generatePrototype(x, z);
     });
-    surroundMap.setLevelCallback(def.wideStructsChunksRadius + 1, 
-    [this](int const x, int const z) {
-        generateStructuresWide(requirePrototype(x, z), x, z);
+    area->setLevelBatchCallback(1, [this](const auto& points) {
+        for (const auto& point : points) {
+            auto& entry = prototypes[point];
+            if (entry.prototype == nullptr) {
+                entry.prototype = generatePrototype(point.x, point.y);
+            }
+            entry.areas++;
+        }
     });
-    surroundMap.setLevelCallback(levels-3, [this](int const x, int const z) {
-        generateBiomes(requirePrototype(x, z), x, z);
+    area->setLevelBatchCallback(def.wideStructsChunksRadius + 1, 
+    [this](const auto& points) {
+        std::vector<std::vector<Placement>> placements(points.size());
+        runStage(points, [&](auto& script, auto& prototype, int x, int z,
+                             size_t i) {
+            placements[i] = generateStructuresWide(script, prototype, x, z);
+        });
+        for (size_t i = 0; i < points.size(); i++) {
+            placeStructures(placements[i], points[i].x, points[i].y);
+        }
     });
-    surroundMap.setLevelCallback(levels-2, [this](int const x, int const z) {
-        generateHeightmap(requirePrototype(x, z), x, z);
+    area->setLevelBatchCallback(levels-3, [this](const auto& points) {
+        runStage(points, [this](auto& script, auto& prototype, int x, int z,
+                                size_t) {
+            generateBiomes(script, prototype, x, z);
+        });
     });
-    surroundMap.setLevelCallback(levels-1, [this](int const x, int const z) {
-        generateStructures(requirePrototype(x, z), x, z);
+    area->setLevelBatchCallback(levels-2, [this](const auto& points) {
+        runStage(points, [this](auto& script, auto& prototype, int x, int z,
+                                size_t) {
+            generateHeightmap(script, prototype, x, z);
+        });
     });
-    for (int i = 0; i < def.structures.size(); i++) {
-        // pre-calculate rotated structure variants
-        def.structures[i]->fragments[0]->prepare(content);
-        for (int j = 1; j < 4; j++) {
-            def.structures[i]->fragments[j] = 
-                def.structures[i]->fragments[j-1]->rotated(content);
+    area->setLevelBatchCallback(levels-1, [this](const auto& points) {
+        std::vector<std::vector<Placement>> placements(points.size());
+        runStage(points, [&](auto& script, auto& prototype, int x, int z,
+                             size_t i) {
+            placements[i] = generateStructures(script, prototype, x, z);
+        });
+        for (size_t i = 0; i < points.size(); i++) {
+            placeStructures(placements[i], points[i].x, points[i].y);
         }
-    }
+        cachePrototypes(points);
+    });
+    return area;
 }
 
-WorldGenerator::~WorldGenerator() {}
+SurroundMap& WorldGenerator::requireArea(int64_t areaId) {
+    const auto& found = areas.find(areaId);
+    if (found == areas.end()) {
+        throw std::runtime_error("loading area not found");
+    }
+    return *found->second;
+}
 
 ChunkPrototype& WorldGenerator::requirePrototype(int x, int z) {
     const auto& found = prototypes.find({x, z});
     if (found == prototypes.end()) {
         throw std::runtime_error("prototype not found");
     }
-    return *found->second;
+    return *found->second.prototype;
+}
+
+void WorldGenerator::cachePrototypes(const std::vector<glm::ivec2>& points) {
+    if (cache == nullptr) {
+        return;
+    }
+    for (const auto& point : points) {
+        auto& prototype = requirePrototype(point.x, point.y);
+        if (prototype.record) {
+            cache->put(point.x, point.y, std::move(prototype.record));
+        }
+    }
+}
+
+void WorldGenerator::setCache(std::unique_ptr<PrototypeCache> cache) {
+    this->cache = std::move(cache);
+}
+
+void WorldGenerator::runStage(
+    const std::vector<glm::ivec2>& points, const StageFunc& stage
+) {
+    if (points.empty()) {
+        return;
+    }
+    // prototypes storage is not modified while stage is running
+    std::vector<ChunkPrototype*> stagePrototypes;
+    stagePrototypes.reserve(points.size());
+    for (const auto& point : points) {
+        stagePrototypes.push_back(&requirePrototype(point.x, point.y));
+    }
+    StageTask task {points, stagePrototypes, stage};
+    size_t jobs = std::min<size_t>(points.size(), getThreadsCount()) - 1;
+    stageJobsDone = 0;
+    for (size_t i = 0; i < jobs; i++) {
+        pool->enqueueJob(&task);
+    }
+    task.work(*script);
+    while (stageJobsDone < jobs) {
+        std::this_thread::yield();
+        pool->update();
+    }
+    if (task.error) {
+        std::rethrow_exception(task.error);
+    }
 }
 
 static inline void generate_pole(
@@ -145,7 +292,14 @@ static inline const Biome* choose_biome(
 std::unique_ptr<ChunkPrototype> WorldGenerator::generatePrototype(
     int chunkX, int chunkZ
 ) {
-    return std::make_unique<ChunkPrototype>();
+    auto prototype = std::make_unique<ChunkPrototype>();
+    if (cache) {
+        prototype->cached = cache->get(chunkX, chunkZ);
+        if (prototype->cached == nullptr) {
+            prototype->record = std::make_unique<CachedPrototype>();
+        }
+    }
+    return prototype;
 }
 
 inline AABB gen_chunk_aabb(int chunkX, int chunkZ) {
@@ -161,15 +315,17 @@ void WorldGenerator::placeStructure(
         *def.structures[placement.structure]->fragments[placement.rotation];
     auto position =
         glm::ivec3(chunkX * CHUNK_W, 0, chunkZ * CHUNK_D) + placement.position;
-    auto size = structure.getSize() + glm::ivec3(0, CHUNK_H, 0);
-    AABB aabb(position, position + size);
+    // air margins of the fragment do not affect neighbour chunks
+    auto min = structure.getBoundsMin();
+    auto max = structure.getBoundsMax() + glm::ivec3(0, CHUNK_H, 0);
+    AABB aabb(position + min, position + max);
     for (int lcz = -1; lcz <= 1; lcz++) {
         for (int lcx = -1; lcx <= 1; lcx++) {
             const auto& found = prototypes.find({chunkX + lcx, chunkZ + lcz});
             if (found == prototypes.end()) {
                 continue;
             }
-            auto& otherPrototype = *found->second;
+            auto& otherPrototype = *found->second.prototype;
             auto chunkAABB = gen_chunk_aabb(chunkX + lcx, chunkZ + lcz);
             if (chunkAABB.intersect(aabb)) {
                 otherPrototype.placements.emplace_back(
@@ -198,17 +354,16 @@ void WorldGenerator::placeLine(const LinePlacement& line, int priority) {
         for (int cx = cxa; cx <= cxb; cx++) {
             const auto& found = prototypes.find({cx, cz});
             if (found != prototypes.end()) {
-                found->second->placements.emplace_back(priority, line);
+                found->second.prototype->placements.emplace_back(
+                    priority, line
+                );
             }
         }
     }
 }
 
 void WorldGenerator::placeStructures(
-    const std::vector<Placement>& placements, 
-    ChunkPrototype& prototype, 
-    int chunkX, 
-    int chunkZ
+    const std::vector<Placement>& placements, int chunkX, int chunkZ
 ) {
     for (const auto& placement : placements) {
         if (auto sp = std::get_if<StructurePlacement>(&placement.placement)) {
@@ -224,34 +379,44 @@ void WorldGenerator::placeStructures(
     }
 }
 
-void WorldGenerator::generateStructuresWide(
-    ChunkPrototype& prototype, int chunkX, int chunkZ
+std::vector<Placement> WorldGenerator::generateStructuresWide(
+    GeneratorScript& script, ChunkPrototype& prototype, int chunkX, int chunkZ
 ) {
     if (prototype.level >= ChunkPrototypeLevel::WIDE_STRUCTS) {
-        return;
+        return {};
     }
-    auto placements = def.script->placeStructuresWide(
+    prototype.level = ChunkPrototypeLevel::WIDE_STRUCTS;
+    if (prototype.cached) {
+        return prototype.cached->widePlacements;
+    }
+    auto placements = script.placeStructuresWide(
         {chunkX * CHUNK_W, chunkZ * CHUNK_D}, {CHUNK_W, CHUNK_D}, CHUNK_H
     );
-    placeStructures(placements, prototype, chunkX, chunkZ);
-
-    prototype.level = ChunkPrototypeLevel::WIDE_STRUCTS;
+    if (prototype.record) {
+        prototype.record->widePlacements = placements;
+    }
+    return placements;
 }
 
-void WorldGenerator::generateStructures(
-    ChunkPrototype& prototype, int chunkX, int chunkZ
+std::vector<Placement> WorldGenerator::generateStructures(
+    GeneratorScript& script, ChunkPrototype& prototype, int chunkX, int chunkZ
 ) {
     if (prototype.level >= ChunkPrototypeLevel::STRUCTURES) {
-        return;
+        return {};
+    }
+    if (prototype.cached) {
+        prototype.level = ChunkPrototypeLevel::STRUCTURES;
+        auto placements = prototype.cached->placements;
+        prototype.cached = nullptr;
+        return placements;
     }
     const auto& biomes = prototype.biomes;
     const auto& heightmap = prototype.heightmap;
 
-    auto placements = def.script->placeStructures(
+    auto placements = script.placeStructures(
         {chunkX * CHUNK_W, chunkZ * CHUNK_D}, {CHUNK_W, CHUNK_D},
         heightmap, CHUNK_H
     );
-    placeStructures(placements, prototype, chunkX, chunkZ);
 
     util::PseudoRandom structsRand;
     structsRand.setSeed(chunkX, chunkZ);
@@ -276,29 +441,41 @@ void WorldGenerator::generateStructures(
             glm::ivec3 position {x, height-structure.meta.lowering, z};
             position.x -= fragment.getSize().x / 2;
             position.z -= fragment.getSize().z / 2;
-            placeStructure(
+            placements.emplace_back(
+                1,
                 StructurePlacement {
                     structureId,
                     position,
                     rotation
-                },
-                1,
-                chunkX, 
-                chunkZ
+                }
             );
         }
     }
     prototype.level = ChunkPrototypeLevel::STRUCTURES;
+    if (auto& record = prototype.record) {
+        record->heightmap = prototype.heightmap;
+        record->placements = placements;
+    }
+    return placements;
 }
 
 void WorldGenerator::generateBiomes(
-    ChunkPrototype& prototype, int chunkX, int chunkZ
+    GeneratorScript& script, ChunkPrototype& prototype, int chunkX, int chunkZ
 ) {
     if (prototype.level >= ChunkPrototypeLevel::BIOMES) {
         return;
     }
+    if (prototype.cached) {
+        auto chunkBiomes = std::make_unique<const Biome*[]>(CHUNK_W*CHUNK_D);
+        for (uint i = 0; i < CHUNK_W * CHUNK_D; i++) {
+            chunkBiomes[i] = &def.biomes.at(prototype.cached->biomes[i]);
+        }
+        prototype.biomes = std::move(chunkBiomes);
+        prototype.level = ChunkPrototypeLevel::BIOMES;
+        return;
+    }
     uint bpd = def.biomesBPD;
-    auto biomeParams = def.script->generateParameterMaps(
+    auto biomeParams = script.generateParameterMaps(
         {floordiv(chunkX * CHUNK_W, bpd), floordiv(chunkZ * CHUNK_D, bpd)},
         {floordiv(CHUNK_W, bpd)+1, floordiv(CHUNK_D, bpd)+1},
         bpd
@@ -328,18 +505,31 @@ void WorldGenerator::generateBiomes(
                 choose_biome(biomes, biomeParams, x, z);
         }
     }
+    if (prototype.record) {
+        auto indices = std::make_unique<uint16_t[]>(CHUNK_W*CHUNK_D);
+        for (uint i = 0; i < CHUNK_W * CHUNK_D; i++) {
+            indices[i] =
+                static_cast<uint16_t>(chunkBiomes[i] - biomes.data());
+        }
+        prototype.record->biomes = std::move(indices);
+    }
     prototype.biomes = std::move(chunkBiomes);
     prototype.level = ChunkPrototypeLevel::BIOMES;
 }
 
 void WorldGenerator::generateHeightmap(
-    ChunkPrototype& prototype, int chunkX, int chunkZ
+    GeneratorScript& script, ChunkPrototype& prototype, int chunkX, int chunkZ
 ) {
     if (prototype.level >= ChunkPrototypeLevel::HEIGHTMAP) {
         return;
     }
+    if (prototype.cached) {
+        prototype.heightmap = prototype.cached->heightmap;
+        prototype.level = ChunkPrototypeLevel::HEIGHTMAP;
+        return;
+    }
     uint bpd = def.heightsBPD;
-    prototype.heightmap = def.script->generateHeightmap(
+    prototype.heightmap = script.generateHeightmap(
         {floordiv(chunkX * CHUNK_W, bpd), floordiv(chunkZ * CHUNK_D, bpd)},
         {floordiv(CHUNK_W, bpd)+1, floordiv(CHUNK_D, bpd)+1},
         bpd,
@@ -353,10 +543,33 @@ void WorldGenerator::generateHeightmap(
     prototype.level = ChunkPrototypeLevel::HEIGHTMAP;
 }
 
-void WorldGenerator::update(int centerX, int centerY, int loadDistance) {
-    surroundMap.setCenter(centerX, centerY);
-    surroundMap.resize(loadDistance);
-    surroundMap.setCenter(centerX, centerY);
+void WorldGenerator::update(
+    int64_t areaId, int centerX, int centerY, int loadDistance
+) {
+    auto& area = areas[areaId];
+    if (area == nullptr) {
+        area = createArea();
+    }
+    area->setCenter(centerX, centerY);
+    area->resize(loadDistance);
+    area->setCenter(centerX, centerY);
+}
+
+void WorldGenerator::removeArea(int64_t areaId) {
+    const auto& found = areas.find(areaId);
+    if (found == areas.end()) {
+        return;
+    }
+    found->second->clear();
+    areas.erase(found);
+}
+
+std::vector<int64_t> WorldGenerator::getAreas() const {
+    std::vector<int64_t> ids;
+    for (const auto& [id, _] : areas) {
+        ids.push_back(id);
+    }
+    return ids;
 }
 
 void WorldGenerator::generatePlants(
@@ -426,31 +639,36 @@ void WorldGenerator::generateLand(
     }
 }
 
-void WorldGenerator::generate(voxel* voxels, int chunkX, int chunkZ) {
-    surroundMap.completeAt(chunkX, chunkZ);
+void WorldGenerator::generate(
+    int64_t areaId, voxel* voxels, int chunkX, int chunkZ
+) {
+    generate(areaId, {ChunkGenTarget {voxels, chunkX, chunkZ}});
+}
 
-    const auto& prototype = requirePrototype(chunkX, chunkZ);
-    const auto values = prototype.heightmap->getValues();
+void WorldGenerator::generate(
+    int64_t areaId, const std::vector<ChunkGenTarget>& chunks
+) {
+    auto& area = requireArea(areaId);
+    std::vector<glm::ivec2> points;
+    for (const auto& chunk : chunks) {
+        area.completeAt(chunk.x, chunk.z);
+        points.emplace_back(chunk.x, chunk.z);
+    }
+    runStage(points, [this, &chunks](auto&, auto& prototype, int, int,
+                                     size_t i) {
+        generateChunk(prototype, chunks[i].voxels, chunks[i].x, chunks[i].z);
+    });
+}
 
-    uint seaLevel = def.seaLevel;
+void WorldGenerator::generateChunk(
+    const ChunkPrototype& prototype, voxel* voxels, int chunkX, int chunkZ
+) {
+    const auto values = prototype.heightmap->getValues();
 
     std::memset(voxels, 0, sizeof(voxel) * CHUNK_VOL);
 
     const auto& biomes = prototype.biomes.get();
-    for (uint z = 0; z < CHUNK_D; z++) {
-        for (uint x = 0; x < CHUNK_W; x++) {
-            const Biome* biome = biomes[z * CHUNK_W + x];
-
-            int height = values[z * CHUNK_W + x] * CHUNK_H;
-            height = std::max(0, height);
-
-            const auto& groundLayers = biome->groundLayers;
-            const auto& seaLayers = biome->seaLayers;
-
-            generate_pole(seaLayers, seaLevel, height, seaLevel, voxels, x, z);
-            generate_pole(groundLayers, height, 0, seaLevel, voxels, x, z);
-        }
-    }
+    generateLand(prototype, values, voxels, chunkX, chunkZ, biomes);
     generatePlacements(prototype, voxels, chunkX, chunkZ);
     generatePlants(prototype, values, voxels, chunkX, chunkZ, biomes);
 
@@ -499,35 +717,9 @@ void WorldGenerator::generateStructure(
         logger.error() << "invalid structure index " << placement.structure;
         return;
     }
-    auto& generatingStructure = def.structures[placement.structure];
-    auto& structure = *generatingStructure->fragments[placement.rotation];
-    auto& structVoxels = structure.getRuntimeVoxels();
-    const auto& offset = placement.position;
-    const auto& size = structure.getSize();
-
-    for (int y = 0; y < size.y; y++) {
-        int sy = y + offset.y;
-        if (sy < 0 || sy >= CHUNK_H) {
-            continue;
-        }
-        for (int z = 0; z < size.z; z++) {
-            int sz = z + offset.z;
-            if (sz < 0 || sz >= CHUNK_D) {
-                continue;
-            }
-            for (int x = 0; x < size.x; x++) {
-                int sx = x + offset.x;
-                if (sx < 0 || sx >= CHUNK_W) {
-                    continue;
-                }
-                const auto& structVoxel = 
-                    structVoxels[vox_index(x, y, z, size.x, size.z)];
-                if (structVoxel.id) {
-                    voxels[vox_index(sx, sy, sz)] = structVoxel;
-                }
-            }
-        }
-    }
+    const auto& structure =
+        *def.structures[placement.structure]->fragments[placement.rotation];
+    structure.paste(voxels, placement.position);
 }
 
 void WorldGenerator::generateLine(
@@ -591,8 +783,12 @@ void WorldGenerator::generateLine(
     }
 }
 
-WorldGenDebugInfo WorldGenerator::createDebugInfo() const {
-    const auto& area = surroundMap.getArea();
+WorldGenDebugInfo WorldGenerator::createDebugInfo(int64_t areaId) const {
+    const auto& found = areas.find(areaId);
+    if (found == areas.end()) {
+        return WorldGenDebugInfo {0, 0, 0, 0, nullptr};
+    }
+    const auto& area = found->second->getArea();
     const auto& levels = area.getBuffer();
     auto values = std::make_unique<ubyte[]>(area.getWidth()*area.getHeight());
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <functional>
 #include <string>
 #include <memory>
 #include <vector>
@@ -11,13 +12,20 @@
 #include "voxels/voxel.hpp"
 #include "SurroundMap.hpp"
 #include "StructurePlacement.hpp"
+#include "PrototypeCache.hpp"
 
 class Content;
 struct GeneratorDef;
+class GeneratorScript;
 class Heightmap;
 struct Biome;
 class VoxelFragment;
 
+namespace util {
+    template <class T, class R>
+    class ThreadPool;
+}
+
 enum class ChunkPrototypeLevel {
     VOID=0, WIDE_STRUCTS, BIOMES, HEIGHTMAP, STRUCTURES
 };
@@ -35,6 +43,23 @@ struct ChunkPrototype {
 
     /// @brief biome parameters maps saved until heightmaps generation
     std::vector<std::shared_ptr<Heightmap>> heightmapInputs {};
+
+    /// @brief cached results of the chunk stages replayed instead of
+    /// running the generator script
+    std::shared_ptr<const CachedPrototype> cached;
+
+    /// @brief results of the chunk stages collected for the cache
+    std::unique_ptr<CachedPrototype> record;
+};
+
+/// @brief Chunk voxels generation target
+struct ChunkGenTarget {
+    /// @brief destination chunk voxels buffer
+    voxel* voxels;
+    /// @brief chunk position X divided by CHUNK_W
+    int x;
+    /// @brief chunk position Z divided by CHUNK_D
+    int z;
 };
 
 struct WorldGenDebugInfo {
@@ -45,8 +70,20 @@ struct WorldGenDebugInfo {
     std::unique_ptr<ubyte[]> areaLevels;
 };
 
-/// @brief High-level world generation controller
+/// @brief High-level world generation controller.
+///
+/// Prototypes are shared by loading areas of all players. Each prototype
+/// level stage runs for all chunks reaching the level at once on multiple
+/// threads, placements to neighbour prototypes are applied afterwards in
+/// the main thread in order of chunks, so the result does not depend on
+/// threads count
 class WorldGenerator {
+    /// @brief Chunk prototype with number of areas containing it
+    struct PrototypeEntry {
+        std::unique_ptr<ChunkPrototype> prototype;
+        int areas = 0;
+    };
+
     /// @param def generator definition
     const GeneratorDef& def;
     /// @param content world content
@@ -54,9 +91,41 @@ class WorldGenerator {
     /// @param seed world seed
     uint64_t seed;
     /// @brief Chunk prototypes main storage
-    std::unordered_map<glm::ivec2, std::unique_ptr<ChunkPrototype>> prototypes;
-    /// @brief Chunk prototypes loading surround map
-    SurroundMap surroundMap;
+    std::unordered_map<glm::ivec2, PrototypeEntry> prototypes;
+    /// @brief Chunk prototypes loading surround maps by area id
+    std::unordered_map<int64_t, std::unique_ptr<SurroundMap>> areas;
+    /// @brief Isolated instance of generator script used by the thread
+    /// calling the generator, so generators of the same definition may be
+    /// used by different threads
+    std::unique_ptr<GeneratorScript> script;
+    /// @brief Optional cache of generated prototypes
+    std::unique_ptr<PrototypeCache> cache;
+
+    using StageFunc = std::function<void(
+        GeneratorScript&, ChunkPrototype&, int x, int z, size_t index
+    )>;
+
+    /// @brief Stage state shared by threads running it
+    struct StageTask;
+    /// @brief Pool worker having isolated instance of generator script
+    class Worker;
+
+    /// @brief Persistent stage workers pool (nullptr if single-threaded)
+    std::unique_ptr<util::ThreadPool<StageTask*, StageTask*>> pool;
+    /// @brief Number of pool jobs finished in the current stage
+    size_t stageJobsDone = 0;
+
+    std::unique_ptr<SurroundMap> createArea();
+
+    SurroundMap& requireArea(int64_t areaId);
+
+    /// @brief Run stage for every chunk on multiple threads
+    /// @param points chunks positions
+    /// @param stage stage function taking thread generator script,
+    /// prototype, chunk position and index of the point
+    void runStage(
+        const std::vector<glm::ivec2>& points, const StageFunc& stage
+    );
 
     /// @brief Generate chunk prototype (see ChunkPrototype)
     /// @param x chunk position X divided by CHUNK_W
@@ -65,13 +134,26 @@ class WorldGenerator {
 
     ChunkPrototype& requirePrototype(int x, int z);
 
-    void generateStructuresWide(ChunkPrototype& prototype, int x, int z);
+    /// @brief Move complete prototypes records to the cache
+    void cachePrototypes(const std::vector<glm::ivec2>& points);
 
-    void generateStructures(ChunkPrototype& prototype, int x, int z);
+    /// @return placements to apply with placeStructures
+    std::vector<Placement> generateStructuresWide(
+        GeneratorScript& script, ChunkPrototype& prototype, int x, int z
+    );
 
-    void generateBiomes(ChunkPrototype& prototype, int x, int z);
+    /// @return placements to apply with placeStructures
+    std::vector<Placement> generateStructures(
+        GeneratorScript& script, ChunkPrototype& prototype, int x, int z
+    );
 
-    void generateHeightmap(ChunkPrototype& prototype, int x, int z);
+    void generateBiomes(
+        GeneratorScript& script, ChunkPrototype& prototype, int x, int z
+    );
+
+    void generateHeightmap(
+        GeneratorScript& script, ChunkPrototype& prototype, int x, int z
+    );
 
     void placeStructure(
         const StructurePlacement& placement, int priority, 
@@ -80,6 +162,9 @@ class WorldGenerator {
 
     void placeLine(const LinePlacement& line, int priority);
 
+    void generateChunk(
+        const ChunkPrototype& prototype, voxel* voxels, int x, int z
+    );
     void generatePlacements(
         const ChunkPrototype& prototype, voxel* voxels, int x, int z
     );
@@ -113,27 +198,53 @@ class WorldGenerator {
     );
 
     void placeStructures(
-        const std::vector<Placement>& placements,
-        ChunkPrototype& prototype,
-        int x, int z
+        const std::vector<Placement>& placements, int x, int z
     );
 public:
+    /// @param threads max number of threads running a stage
+    /// (0 - hardware concurrency)
     WorldGenerator(
         const GeneratorDef& def,
         const Content& content,
-        uint64_t seed
+        uint64_t seed,
+        uint threads = 0
     );
     ~WorldGenerator();
 
-    void update(int centerX, int centerY, int loadDistance);
+    /// @brief Move loading area, creating it if not exists
+    /// @param areaId loading area id (player id)
+    void update(int64_t areaId, int centerX, int centerY, int loadDistance);
+
+    /// @brief Remove loading area, releasing its prototypes
+    void removeArea(int64_t areaId);
+
+    /// @return ids of all loading areas
+    std::vector<int64_t> getAreas() const;
 
     /// @brief Generate complete chunk voxels
+    /// @param areaId loading area containing the chunk
     /// @param voxels destinatiopn chunk voxels buffer
     /// @param x chunk position X divided by CHUNK_W
     /// @param z chunk position Y divided by CHUNK_D
-    void generate(voxel* voxels, int x, int z);
+    void generate(int64_t areaId, voxel* voxels, int x, int z);
+
+    /// @brief Generate complete voxels of multiple chunks simultaneously
+    /// @param areaId loading area containing the chunks
+    void generate(int64_t areaId, const std::vector<ChunkGenTarget>& chunks);
+
+    /// @return max number of chunks generated simultaneously
+    uint getThreadsCount() const;
+
+    /// @param areaId loading area id
+    WorldGenDebugInfo createDebugInfo(int64_t areaId) const;
+
+    /// @brief Set generated prototypes cache (nullptr to disable)
+    void setCache(std::unique_ptr<PrototypeCache> cache);
 
-    WorldGenDebugInfo createDebugInfo() const;
+    /// @return generated prototypes cache or nullptr
+    PrototypeCache* getCache() const {
+        return cache.get();
+    }
 
     uint64_t getSeed() const;
 };
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "content/Content.hpp"
+#include "content/ContentBuilder.hpp"
+#include "core_defs.hpp"
+#include "objects/rigging.hpp"
+#include "voxels/Block.hpp"
+
+/// @brief Builder of test content. Core blocks and items required by
+/// content indices are created first, so air has zero index
+class TestContentBuilder {
+    ContentBuilder builder;
+public:
+    TestContentBuilder() {
+        createBlock(CORE_AIR, false);
+        createBlock(CORE_OBSTACLE, true);
+        createBlock(CORE_STRUCT_AIR, false);
+        builder.items.create(CORE_EMPTY);
+    }
+
+    /// @param obstacle block is solid and does not pass light
+    Block& createBlock(const std::string& name, bool obstacle) {
+        auto& block = builder.blocks.create(name);
+        block.obstacle = obstacle;
+        block.lightPassing = !obstacle;
+        block.skyLightPassing = !obstacle;
+        block.pickingItem = CORE_EMPTY;
+        return block;
+    }
+
+    std::unique_ptr<Content> build() {
+        return builder.build();
+    }
+};
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include "typedefs.hpp"
+#include "coders/compression.hpp"
+#include "coders/zstd.hpp"
+
+static std::vector<ubyte> generate_data(size_t size, int dencity) {
+    std::vector<ubyte> data(size);
+    ubyte next = rand();
+    for (size_t i = 0; i < size; i++) {
+        data[i] = next;
+        if (rand() % dencity == 0) {
+            next = rand();
+        }
+    }
+    return data;
+}
+
+static void test_compress_decompress(
+    compression::Method method, const zstd::Dictionary* dictionary = nullptr
+) {
+    auto initial = generate_data(50'000, 13);
+    size_t length;
+    auto compressed = compression::compress(
+        initial.data(), initial.size(), length, method, dictionary
+    );
+    auto decompressed = compression::decompress(
+        compressed.get(), length, initial.size(), method, dictionary
+    );
+    for (size_t i = 0; i < initial.size(); i++) {
+        EXPECT_EQ(decompressed[i], initial[i]);
+    }
+}
+
+TEST(Compression, CompressDecompress) {
+    test_compress_decompress(compression::Method::EXTRLE8);
+    test_compress_decompress(compression::Method::EXTRLE16);
+    test_compress_decompress(compression::Method::GZIP);
+    test_compress_decompress(compression::Method::LZ4);
+    test_compress_decompress(compression::Method::ZSTD);
+}
+
+TEST(Compression, SizeMismatch) {
+    auto initial = generate_data(1'000, 13);
+    size_t length;
+    auto compressed = compression::compress(
+        initial.data(), initial.size(), length, compression::Method::LZ4
+    );
+    EXPECT_THROW(
+        compression::decompress(
+            compressed.get(), length, initial.size() / 2, compression::Method::LZ4
+        ),
+        std::runtime_error
+    );
+}
+
+TEST(Compression, ZstdDictionary) {
+    std::vector<std::vector<ubyte>> samples;
+    for (int i = 0; i < 200; i++) {
+        samples.push_back(generate_data(2'000, 50));
+    }
+    auto dictionary = std::make_shared<zstd::Dictionary>(
+        zstd::train_dictionary(samples, 16 * 1024)
+    );
+    test_compress_decompress(compression::Method::ZSTD, dictionary.get());
+
+    auto initial = generate_data(2'000, 50);
+    size_t length;
+    auto compressed = compression::compress(
+        initial.data(),
+        initial.size(),
+        length,
+        compression::Method::ZSTD,
+        dictionary.get()
+    );
+    // frames compressed with dictionary are not readable without it
+    EXPECT_THROW(
+        compression::decompress(
+            compressed.get(), length, initial.size(), compression::Method::ZSTD
+        ),
+        std::runtime_error
+    );
+}
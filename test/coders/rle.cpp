@@ -1,5 +1,12 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
 #include "typedefs.hpp"
 #include "coders/rle.hpp"
 
@@ -48,3 +55,111 @@ TEST(ExtRLE16, EncodeDecode) {
     test_encode_decode(extrle::encode16, extrle::decode16, 13);
     test_encode_decode(extrle::encode16, extrle::decode16, 90123);
 }
+
+// Original byte by byte encoder, used as reference for the output format
+static size_t reference_extrle_encode16(
+    const ubyte* src8, size_t srclen, ubyte* dst
+) {
+    auto src = reinterpret_cast<const uint16_t*>(src8);
+    size_t offset = 0;
+    uint counter = 0;
+    uint16_t c = src[0];
+    auto put = [&]() {
+        if (counter >= 0x40) {
+            dst[offset++] = 0x80 | ((c > 255) << 6) | (counter & 0x3F);
+            dst[offset++] = counter >> 6;
+        } else {
+            dst[offset++] = counter | ((c > 255) << 6);
+        }
+        if (c > 255) {
+            dst[offset++] = c & 0xFF;
+            dst[offset++] = c >> 8;
+        } else {
+            dst[offset++] = c;
+        }
+    };
+    for (size_t i = 1; i < srclen/2; i++) {
+        uint16_t cnext = src[i];
+        if (cnext != c || counter == extrle::max_sequence16) {
+            put();
+            c = cnext;
+            counter = 0;
+        } else {
+            counter++;
+        }
+    }
+    put();
+    return offset;
+}
+
+static std::vector<uint16_t> generate_chunk_like(size_t length, int dencity) {
+    std::vector<uint16_t> data(length);
+    uint16_t next = 1;
+    for (size_t i = 0; i < length; i++) {
+        data[i] = i > length / 2 ? 0 : next;
+        if (rand() % dencity == 0) {
+            next = rand() % 2 ? 1 : rand() % 600;
+        }
+    }
+    return data;
+}
+
+TEST(ExtRLE16, SameAsReference) {
+    for (int dencity : {1, 3, 13, 1000, 90123}) {
+        auto data = generate_chunk_like(100'000, dencity);
+        auto src = reinterpret_cast<const ubyte*>(data.data());
+        std::vector<ubyte> expected(data.size() * 4);
+        std::vector<ubyte> actual(data.size() * 4);
+        size_t expectedSize = reference_extrle_encode16(
+            src, data.size() * 2, expected.data()
+        );
+        size_t actualSize =
+            extrle::encode16(src, data.size() * 2, actual.data());
+        ASSERT_EQ(actualSize, expectedSize);
+        EXPECT_TRUE(std::equal(
+            actual.begin(), actual.begin() + actualSize, expected.begin()
+        ));
+    }
+}
+
+/// @brief Disabled by default, run with --gtest_also_run_disabled_tests
+/// --gtest_filter=ExtRLE16.DISABLED_Benchmark
+TEST(ExtRLE16, DISABLED_Benchmark) {
+    const int iterations = 200;
+    // 256 * 16 * 16 voxels ids of half-filled chunk
+    auto data = generate_chunk_like(65536, 200);
+    auto src = reinterpret_cast<const ubyte*>(data.data());
+    std::vector<ubyte> encoded(data.size() * 4);
+    std::vector<ubyte> decoded(data.size() * 2);
+    size_t encodedSize = 0;
+
+    using clock = std::chrono::high_resolution_clock;
+    auto start = clock::now();
+    for (int i = 0; i < iterations; i++) {
+        encodedSize = extrle::encode16(src, data.size() * 2, encoded.data());
+    }
+    auto encodeTime = clock::now() - start;
+
+    start = clock::now();
+    for (int i = 0; i < iterations; i++) {
+        reference_extrle_encode16(src, data.size() * 2, encoded.data());
+    }
+    auto referenceTime = clock::now() - start;
+
+    start = clock::now();
+    for (int i = 0; i < iterations; i++) {
+        extrle::decode16(encoded.data(), encodedSize, decoded.data());
+    }
+    auto decodeTime = clock::now() - start;
+    EXPECT_EQ(std::memcmp(decoded.data(), src, decoded.size()), 0);
+
+    auto mbps = [&](auto time) {
+        auto micros =
+            std::chrono::duration_cast<std::chrono::microseconds>(time);
+        double bytes = static_cast<double>(data.size() * 2) * iterations;
+        return bytes / std::max<long long>(micros.count(), 1);
+    };
+    std::cout << "extrle16 encode: " << mbps(encodeTime) << " MB/s, "
+              << "reference: " << mbps(referenceTime) << " MB/s, "
+              << "decode: " << mbps(decodeTime) << " MB/s" << std::endl;
+}
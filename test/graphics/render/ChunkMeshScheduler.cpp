@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include "graphics/render/ChunkMeshScheduler.hpp"
+#include "voxels/Chunk.hpp"
+
+static std::vector<glm::ivec2> pop_keys(
+    ChunkMeshScheduler& scheduler,
+    const glm::vec3& cameraPosition,
+    const ChunkMeshScheduler::VisibilityFunc& isVisible,
+    size_t count
+) {
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    scheduler.pop(cameraPosition, isVisible, count, chunks);
+    std::vector<glm::ivec2> keys;
+    for (const auto& chunk : chunks) {
+        keys.emplace_back(chunk->x, chunk->z);
+    }
+    return keys;
+}
+
+TEST(ChunkMeshScheduler, Coalescing) {
+    ChunkMeshScheduler scheduler;
+    auto chunk = std::make_shared<Chunk>(2, 3);
+    EXPECT_TRUE(scheduler.request(chunk));
+    EXPECT_FALSE(scheduler.request(chunk));
+    EXPECT_FALSE(scheduler.request(std::make_shared<Chunk>(2, 3)));
+    EXPECT_EQ(scheduler.size(), 1);
+
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    scheduler.pop(glm::vec3(), nullptr, 10, chunks);
+    ASSERT_EQ(chunks.size(), 1);
+    // the last requested chunk instance is taken
+    EXPECT_NE(chunks[0], chunk);
+    EXPECT_EQ(scheduler.size(), 0);
+}
+
+TEST(ChunkMeshScheduler, DistanceOrder) {
+    ChunkMeshScheduler scheduler;
+    for (int z = -5; z <= 5; z++) {
+        for (int x = -5; x <= 5; x++) {
+            scheduler.request(std::make_shared<Chunk>(x, z));
+        }
+    }
+    glm::vec3 camera(CHUNK_W * 3.5f, 100.0f, CHUNK_D * -2.5f);
+    auto keys = pop_keys(scheduler, camera, nullptr, 5);
+    ASSERT_EQ(keys.size(), 5);
+    EXPECT_EQ(keys[0], glm::ivec2(3, -3));
+    for (size_t i = 1; i < keys.size(); i++) {
+        EXPECT_EQ(glm::abs(keys[i].x - 3) + glm::abs(keys[i].y + 3), 1);
+    }
+    EXPECT_EQ(scheduler.size(), 11 * 11 - 5);
+
+    // re-prioritized as the camera moves
+    camera = glm::vec3(CHUNK_W * -4.5f, 0.0f, CHUNK_D * 4.5f);
+    keys = pop_keys(scheduler, camera, nullptr, 1);
+    EXPECT_EQ(keys[0], glm::ivec2(-5, 4));
+}
+
+TEST(ChunkMeshScheduler, Visibility) {
+    ChunkMeshScheduler scheduler;
+    for (int x = -4; x <= 4; x++) {
+        scheduler.request(std::make_shared<Chunk>(x, 0));
+    }
+    glm::vec3 camera(CHUNK_W * 0.5f, 0.0f, CHUNK_D * 0.5f);
+    auto isVisible = [](const Chunk& chunk) { return chunk.x >= 0; };
+    auto keys = pop_keys(scheduler, camera, isVisible, 9);
+    std::vector<glm::ivec2> expected {
+        {0, 0}, {1, 0}, {-1, 0}, {2, 0}, {3, 0}, {-2, 0}, {4, 0}, {-3, 0}, {-4, 0}
+    };
+    EXPECT_EQ(keys, expected);
+}
+
+TEST(ChunkMeshScheduler, Cancel) {
+    ChunkMeshScheduler scheduler;
+    scheduler.request(std::make_shared<Chunk>(0, 0));
+    scheduler.request(std::make_shared<Chunk>(1, 0));
+    EXPECT_TRUE(scheduler.cancel(0, 0));
+    EXPECT_FALSE(scheduler.cancel(0, 0));
+    EXPECT_FALSE(scheduler.isRequested(0, 0));
+    EXPECT_TRUE(scheduler.isRequested(1, 0));
+
+    auto keys = pop_keys(scheduler, glm::vec3(), nullptr, 10);
+    EXPECT_EQ(keys, std::vector<glm::ivec2> {glm::ivec2(1, 0)});
+}
+
+TEST(ChunkMeshScheduler, DropRunningJob) {
+    ChunkMeshScheduler scheduler;
+    auto chunk = std::make_shared<Chunk>(0, 0);
+    chunk->modifiedSections = 0b1000;
+    scheduler.request(chunk);
+    auto keys = pop_keys(scheduler, glm::vec3(), nullptr, 1);
+    ASSERT_EQ(keys.size(), 1);
+
+    // job is given to a worker with the chunk modified sections
+    uint64_t id = scheduler.start(0, 0, chunk->modifiedSections);
+    chunk->modifiedSections = 0;
+    EXPECT_TRUE(scheduler.isInWork(0, 0));
+    EXPECT_EQ(scheduler.inWorkCount(), 1);
+
+    // chunk is modified again and rebuilt synchronously, dropping the job
+    chunk->modifiedSections = 0b100000;
+    chunk->modifiedSections |= scheduler.drop(0, 0);
+    EXPECT_EQ(chunk->modifiedSections, 0b101000);
+    EXPECT_FALSE(scheduler.isInWork(0, 0));
+    EXPECT_EQ(scheduler.drop(0, 0), 0);
+
+    // dropped job result is outdated
+    EXPECT_FALSE(scheduler.finish(0, 0, id));
+
+    uint64_t next = scheduler.start(0, 0, 0b1);
+    EXPECT_NE(next, id);
+    EXPECT_FALSE(scheduler.finish(0, 0, id));
+    EXPECT_TRUE(scheduler.finish(0, 0, next));
+    EXPECT_EQ(scheduler.inWorkCount(), 0);
+}
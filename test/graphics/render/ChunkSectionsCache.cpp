@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include "graphics/core/Mesh.hpp"
+#include "graphics/render/ChunkSectionsCache.hpp"
+#include "graphics/render/commons.hpp"
+
+static std::shared_ptr<const ChunkSectionsMesh> make_sections(
+    size_t vertices
+) {
+    auto section = std::make_shared<ChunkSectionMesh>();
+    section->vertices.resize(vertices);
+    section->indices.resize(vertices);
+    auto sections = std::make_shared<ChunkSectionsMesh>();
+    sections->sections[0] = std::move(section);
+    return sections;
+}
+
+TEST(ChunkSectionsCache, Eviction) {
+    auto a = make_sections(100);
+    auto b = make_sections(100);
+    auto c = make_sections(100);
+    size_t size = a->getMemoryUsage();
+    ASSERT_GT(size, 100 * sizeof(ChunkVertex));
+
+    ChunkSectionsCache cache(size * 2);
+    cache.put(0, 0, a);
+    cache.put(1, 0, b);
+    EXPECT_EQ(cache.getMemoryUsage(), size * 2);
+    // a is used recently
+    EXPECT_EQ(cache.get(0, 0), a);
+    cache.put(0, 1, c);
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.get(1, 0), nullptr);
+    EXPECT_EQ(cache.get(0, 0), a);
+    EXPECT_EQ(cache.get(0, 1), c);
+    EXPECT_EQ(cache.getMemoryUsage(), size * 2);
+
+    // larger sections replacing a evict c
+    auto large = make_sections(150);
+    cache.put(0, 0, large);
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(cache.get(0, 0), large);
+    EXPECT_EQ(cache.getMemoryUsage(), large->getMemoryUsage());
+}
+
+TEST(ChunkSectionsCache, Removal) {
+    auto a = make_sections(10);
+    ChunkSectionsCache cache(a->getMemoryUsage() * 4);
+    cache.put(0, 0, a);
+    cache.put(1, 0, make_sections(10));
+    EXPECT_TRUE(cache.remove(0, 0));
+    EXPECT_FALSE(cache.remove(0, 0));
+    EXPECT_EQ(cache.get(0, 0), nullptr);
+    EXPECT_EQ(cache.getMemoryUsage(), a->getMemoryUsage());
+
+    // nullptr removes entry
+    cache.put(1, 0, nullptr);
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_EQ(cache.getMemoryUsage(), 0);
+
+    // sections larger than capacity are not kept
+    cache.put(2, 0, make_sections(1000));
+    EXPECT_EQ(cache.size(), 0);
+
+    cache.put(0, 0, a);
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_EQ(cache.getMemoryUsage(), 0);
+
+    ChunkSectionsCache disabled(0);
+    disabled.put(0, 0, a);
+    EXPECT_EQ(disabled.get(0, 0), nullptr);
+}
@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+
+#include "graphics/core/Mesh.hpp"
+#include "graphics/render/commons.hpp"
+#include "voxels/Chunk.hpp"
+
+namespace {
+    struct RunSpec {
+        SectionIndicesRun::Pass pass;
+        uint8_t order;
+    };
+
+    /// @brief Create section mesh with a triangle per run. Vertex position
+    /// is (section, run index, vertex index in run)
+    std::shared_ptr<ChunkSectionMesh> make_section(
+        int section, const std::vector<RunSpec>& runs
+    ) {
+        auto mesh = std::make_shared<ChunkSectionMesh>();
+        for (size_t i = 0; i < runs.size(); i++) {
+            uint32_t offset = mesh->indices.size();
+            for (int k = 0; k < 3; k++) {
+                ChunkVertex vertex {};
+                vertex.position = glm::vec3(section, i, k);
+                mesh->indices.push_back(mesh->vertices.size());
+                mesh->vertices.push_back(vertex);
+            }
+            mesh->runs.push_back(
+                SectionIndicesRun {runs[i].pass, runs[i].order, offset, 3}
+            );
+        }
+        return mesh;
+    }
+
+    /// @brief Section mesh builder output depending on version
+    std::shared_ptr<const ChunkSectionMesh> build_section(
+        int section, int version
+    ) {
+        if (section % 4 == 1) {
+            return nullptr;
+        }
+        std::vector<RunSpec> runs;
+        for (int i = 0; i < 1 + (section + version) % 3; i++) {
+            runs.push_back({SectionIndicesRun::REGULAR, uint8_t((section + i) % 2)});
+        }
+        runs.push_back({SectionIndicesRun::OPTIONAL_CULLED, uint8_t(version % 2)});
+        runs.push_back({SectionIndicesRun::OPTIONAL_DENSE, 1});
+        return make_section(section, runs);
+    }
+
+    class ChunkSectionsMeshTest : public ::testing::Test {
+    protected:
+        static constexpr size_t GROUPS = 3;
+
+        std::vector<ChunkVertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<uint32_t> denseIndices;
+
+        ChunkMeshBuffers createBuffers(size_t capacity) {
+            vertices.assign(capacity, ChunkVertex {});
+            indices.assign(capacity, 0);
+            denseIndices.assign(capacity, 0);
+            return ChunkMeshBuffers {
+                vertices.data(), indices.data(), denseIndices.data(), capacity};
+        }
+
+        /// @return positions of stitched vertices in order of indices
+        std::vector<glm::vec3> getPositions(
+            const uint32_t* indices, size_t count
+        ) const {
+            std::vector<glm::vec3> positions;
+            for (size_t i = 0; i < count; i++) {
+                positions.push_back(vertices.at(indices[i]).position);
+            }
+            return positions;
+        }
+
+        /// @return expected positions of runs vertices
+        static std::vector<glm::vec3> expected(
+            const std::vector<std::pair<int, int>>& runs
+        ) {
+            std::vector<glm::vec3> positions;
+            for (const auto& [section, run] : runs) {
+                for (int k = 0; k < 3; k++) {
+                    positions.emplace_back(section, run, k);
+                }
+            }
+            return positions;
+        }
+    };
+}
+
+TEST_F(ChunkSectionsMeshTest, StitchingOrder) {
+    ChunkSectionsMesh mesh;
+    mesh.sections[0] = make_section(0, {
+        {SectionIndicesRun::REGULAR, 1},
+        {SectionIndicesRun::REGULAR, 0},
+        {SectionIndicesRun::OPTIONAL_CULLED, 0},
+        {SectionIndicesRun::OPTIONAL_DENSE, 0},
+    });
+    mesh.sections[2] = make_section(2, {
+        {SectionIndicesRun::REGULAR, 0},
+        {SectionIndicesRun::OPTIONAL_CULLED, 2},
+        {SectionIndicesRun::OPTIONAL_DENSE, 1},
+    });
+    auto buffers = createBuffers(100);
+    ASSERT_TRUE(mesh.stitch(GROUPS, buffers));
+    EXPECT_EQ(buffers.vertexCount, 21);
+    // section vertices follow each other
+    EXPECT_EQ(vertices[12].position, glm::vec3(2, 0, 0));
+
+    // regular runs by draw group then by section, then culled optional
+    EXPECT_EQ(
+        getPositions(indices.data(), buffers.indexCount),
+        expected({{0, 1}, {2, 0}, {0, 0}, {0, 2}, {2, 1}})
+    );
+    // regular runs, then dense optional
+    EXPECT_EQ(
+        getPositions(denseIndices.data(), buffers.denseIndexCount),
+        expected({{0, 1}, {2, 0}, {0, 0}, {0, 3}, {2, 2}})
+    );
+}
+
+TEST_F(ChunkSectionsMeshTest, Overflow) {
+    ChunkSectionsMesh mesh;
+    mesh.sections[0] = make_section(0, {{SectionIndicesRun::REGULAR, 0}});
+    mesh.sections[1] = make_section(1, {{SectionIndicesRun::REGULAR, 0}});
+
+    // second section vertices do not fit
+    auto buffers = createBuffers(6);
+    EXPECT_FALSE(mesh.stitch(GROUPS, buffers));
+    EXPECT_EQ(buffers.vertexCount, 3);
+    EXPECT_EQ(buffers.indexCount, 3);
+
+    // indices do not fit, vertices are shared by runs
+    auto section = make_section(3, {{SectionIndicesRun::REGULAR, 0}});
+    for (int i = 0; i < 3; i++) {
+        section->runs.push_back(section->runs[0]);
+    }
+    mesh.sections[1] = section;
+    buffers = createBuffers(10);
+    EXPECT_FALSE(mesh.stitch(GROUPS, buffers));
+    EXPECT_EQ(buffers.vertexCount, 6);
+    EXPECT_EQ(buffers.indexCount, 9);
+    EXPECT_EQ(buffers.denseIndexCount, 9);
+
+    buffers = createBuffers(16);
+    EXPECT_TRUE(mesh.stitch(GROUPS, buffers));
+    EXPECT_EQ(buffers.indexCount, 15);
+}
+
+TEST_F(ChunkSectionsMeshTest, PartialRebuild) {
+    const uint8_t neighbours = 0b1011;
+    int built = 0;
+    auto full = ChunkSectionsMesh::rebuild(
+        nullptr, neighbours, 0b1, [&built](int section) {
+            built++;
+            return build_section(section, 0);
+        }
+    );
+    // no previous build
+    EXPECT_EQ(built, CHUNK_SECTIONS);
+    EXPECT_EQ(full->neighbours, neighbours);
+
+    const int modified = 3;
+    built = 0;
+    auto partial = ChunkSectionsMesh::rebuild(
+        full.get(), neighbours, 1 << modified, [&built](int section) {
+            built++;
+            return build_section(section, 1);
+        }
+    );
+    EXPECT_EQ(built, 1);
+    for (int i = 0; i < CHUNK_SECTIONS; i++) {
+        if (i == modified) {
+            EXPECT_NE(partial->sections[i], full->sections[i]);
+        } else {
+            EXPECT_EQ(partial->sections[i], full->sections[i]);
+        }
+    }
+
+    // partial rebuild is stitched the same as the full one
+    auto reference = ChunkSectionsMesh::rebuild(
+        nullptr, neighbours, ALL_SECTIONS_MASK, [](int section) {
+            return build_section(section, section == modified ? 1 : 0);
+        }
+    );
+    auto buffers = createBuffers(10'000);
+    ASSERT_TRUE(reference->stitch(GROUPS, buffers));
+    auto expectedVertices = getPositions(indices.data(), buffers.indexCount);
+    auto expectedDense =
+        getPositions(denseIndices.data(), buffers.denseIndexCount);
+    ASSERT_TRUE(partial->stitch(GROUPS, buffers));
+    EXPECT_EQ(getPositions(indices.data(), buffers.indexCount), expectedVertices);
+    EXPECT_EQ(
+        getPositions(denseIndices.data(), buffers.denseIndexCount),
+        expectedDense
+    );
+
+    // neighbour chunk appeared
+    built = 0;
+    auto rebuilt = ChunkSectionsMesh::rebuild(
+        partial.get(), neighbours | 0b0100, 1 << modified, [&built](int section) {
+            built++;
+            return build_section(section, 1);
+        }
+    );
+    EXPECT_EQ(built, CHUNK_SECTIONS);
+    EXPECT_EQ(rebuilt->neighbours, 0b1111);
+}
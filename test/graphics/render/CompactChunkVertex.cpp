@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "constants.hpp"
+#include "graphics/core/Mesh.hpp"
+#include "graphics/render/commons.hpp"
+
+static ChunkVertex make_vertex(
+    const glm::vec3& position,
+    const std::array<uint16_t, 2>& uv,
+    const glm::vec3& normal,
+    bool emission
+) {
+    ChunkVertex vertex {};
+    vertex.position = position;
+    vertex.uv = uv;
+    vertex.color = {10, 200, 35, 255};
+    vertex.normal = {
+        static_cast<uint8_t>(normal.x * 127 + 128),
+        static_cast<uint8_t>(normal.y * 127 + 128),
+        static_cast<uint8_t>(normal.z * 127 + 128),
+        static_cast<uint8_t>(emission ? 255 : 0)};
+    return vertex;
+}
+
+static glm::vec3 get_normal(const ChunkVertex& vertex) {
+    return glm::normalize(glm::vec3(
+        vertex.normal[0] - 128, vertex.normal[1] - 128, vertex.normal[2] - 128
+    ));
+}
+
+TEST(CompactChunkVertex, Size) {
+    EXPECT_EQ(sizeof(ChunkVertex), 28);
+    EXPECT_EQ(sizeof(CompactChunkVertex), 20);
+    EXPECT_LT(sizeof(CompactChunkVertex), sizeof(ChunkVertex));
+}
+
+TEST(CompactChunkVertex, AxisNormals) {
+    const glm::vec3 normals[] {
+        {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}
+    };
+    for (const auto& normal : normals) {
+        auto source = make_vertex(
+            {1.5f, 2.5f, 3.5f}, {16384, 32768}, normal, false
+        );
+        auto decoded = CompactChunkVertex::encode(source).decode();
+        EXPECT_EQ(decoded.normal, source.normal);
+    }
+}
+
+TEST(CompactChunkVertex, RandomVertices) {
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> horizontal(-1.0f, CHUNK_W + 1.0f);
+    std::uniform_real_distribution<float> vertical(-1.0f, CHUNK_H + 1.0f);
+    std::uniform_real_distribution<float> coord(-1.0f, 1.0f);
+    for (int i = 0; i < 10'000; i++) {
+        glm::vec3 position(horizontal(random), vertical(random), horizontal(random));
+        std::array<uint16_t, 2> uv {
+            static_cast<uint16_t>(random()), static_cast<uint16_t>(random())};
+        glm::vec3 normal(coord(random), coord(random), coord(random));
+        if (glm::length(normal) < 0.1f) {
+            continue;
+        }
+        normal = glm::normalize(normal);
+        bool emission = random() % 2;
+        auto source = make_vertex(position, uv, normal, emission);
+        source.color = {
+            static_cast<uint8_t>(random()),
+            static_cast<uint8_t>(random()),
+            static_cast<uint8_t>(random()),
+            static_cast<uint8_t>(random())};
+
+        auto decoded = CompactChunkVertex::encode(source).decode();
+        auto positionError = glm::abs(decoded.position - position);
+        float maxPositionError = 0.5f / CompactChunkVertex::POSITION_SCALE + 1e-5f;
+        EXPECT_LE(positionError.x, maxPositionError);
+        EXPECT_LE(positionError.y, maxPositionError);
+        EXPECT_LE(positionError.z, maxPositionError);
+
+        EXPECT_EQ(decoded.uv, uv);
+        EXPECT_GT(glm::dot(get_normal(decoded), get_normal(source)), 0.999f);
+        EXPECT_EQ(decoded.normal[3], source.normal[3]);
+        EXPECT_EQ(decoded.color, source.color);
+        EXPECT_EQ(decoded.regionEnd, source.regionEnd);
+    }
+}
+
+TEST(CompactChunkVertex, MergedFacesQuad) {
+    const std::array<uint16_t, 2> regionStart {1024, 2048};
+    const std::array<uint16_t, 2> regionEnd {1536, 2560};
+    // voxel (3, 10, 5), quad 4x2 voxels (greedy mesher face axes)
+    struct Face {
+        glm::vec3 normal;
+        glm::vec3 axisX;
+        glm::vec3 axisY;
+    } faces[] {
+        {{-1, 0, 0}, {0, 0, 1}, {0, 1, 0}},
+        {{1, 0, 0}, {0, 0, -1}, {0, 1, 0}},
+        {{0, -1, 0}, {1, 0, 0}, {0, 0, 1}},
+        {{0, 1, 0}, {1, 0, 0}, {0, 0, -1}},
+        {{0, 0, -1}, {-1, 0, 0}, {0, 1, 0}},
+        {{0, 0, 1}, {1, 0, 0}, {0, 1, 0}},
+    };
+    for (const auto& face : faces) {
+        glm::vec3 X = face.axisX * 4.0f;
+        glm::vec3 Y = face.axisY * 2.0f;
+        glm::vec3 center = glm::vec3(3, 10, 5) + (X + Y - face.axisX - face.axisY) * 0.5f;
+        const glm::vec2 corners[] {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+        for (const auto& corner : corners) {
+            glm::vec3 position =
+                center + (X * corner.x + Y * corner.y + face.normal) * 0.5f;
+            // texture coord in voxels
+            glm::vec2 uv((corner.x + 1) * 2.0f, corner.y + 1);
+            auto source = make_vertex(position, regionStart, face.normal, false);
+            source.regionEnd = regionEnd;
+
+            auto decoded = CompactChunkVertex::encode(source).decode();
+            EXPECT_EQ(decoded.uv, regionStart);
+            EXPECT_EQ(decoded.regionEnd, regionEnd);
+            EXPECT_EQ(decoded.position, position);
+            // texture coord is restored with an integer offset
+            for (const auto& vertex : {source, decoded}) {
+                auto offset = vertex.getMergedFacesUV() - uv;
+                EXPECT_FLOAT_EQ(offset.x, std::round(offset.x));
+                EXPECT_FLOAT_EQ(offset.y, std::round(offset.y));
+            }
+        }
+    }
+}
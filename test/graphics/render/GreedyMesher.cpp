@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+#include <tuple>
+
+#include "graphics/render/GreedyMesher.hpp"
+
+using FaceId = std::tuple<int, int, int, int>;
+
+static constexpr int W = 16;
+static constexpr int H = 32;
+static constexpr int D = 16;
+
+/// @brief Naive mesher: one face per exposed voxel side
+static std::map<FaceId, uint64_t> build_naive(
+    const std::vector<uint64_t>& blocks, GreedyMesher& mesher
+) {
+    auto at = [&](const glm::ivec3& pos) -> uint64_t {
+        if (pos.x < 0 || pos.y < 0 || pos.z < 0 || pos.x >= W ||
+            pos.y >= H || pos.z >= D) {
+            return 0;
+        }
+        return blocks[(pos.y * D + pos.z) * W + pos.x];
+    };
+    std::map<FaceId, uint64_t> faces;
+    for (int y = 0; y < H; y++) {
+        for (int z = 0; z < D; z++) {
+            for (int x = 0; x < W; x++) {
+                glm::ivec3 pos(x, y, z);
+                uint64_t block = at(pos);
+                if (block == 0) {
+                    continue;
+                }
+                for (int dir = 0; dir < 6; dir++) {
+                    if (at(pos + GreedyMesher::NORMALS[dir])) {
+                        continue;
+                    }
+                    // same block faces of different directions differ
+                    uint64_t key = block * 6 + dir;
+                    faces[{x, y, z, dir}] = key;
+                    mesher.add(pos, dir, key);
+                }
+            }
+        }
+    }
+    return faces;
+}
+
+/// @brief Check quads cover exactly the same faces as the naive mesher
+static void check_coverage(
+    const std::map<FaceId, uint64_t>& faces,
+    const std::vector<GreedyQuad>& quads
+) {
+    std::map<FaceId, uint64_t> covered;
+    for (const auto& quad : quads) {
+        const auto& normal = GreedyMesher::NORMALS[quad.direction];
+        EXPECT_EQ(glm::abs(normal) * quad.size, glm::abs(normal));
+        for (int y = 0; y < quad.size.y; y++) {
+            for (int z = 0; z < quad.size.z; z++) {
+                for (int x = 0; x < quad.size.x; x++) {
+                    auto pos = quad.position + glm::ivec3(x, y, z);
+                    FaceId id {pos.x, pos.y, pos.z, quad.direction};
+                    EXPECT_EQ(covered.count(id), 0) << "overlapping quads";
+                    covered[id] = quad.key;
+                }
+            }
+        }
+    }
+    EXPECT_EQ(covered, faces);
+}
+
+TEST(GreedyMesher, RandomVolume) {
+    std::mt19937 random(42);
+    for (int iteration = 0; iteration < 20; iteration++) {
+        std::vector<uint64_t> blocks(W * H * D);
+        for (auto& block : blocks) {
+            block = random() % 3 ? 0 : 1 + random() % 3;
+        }
+        GreedyMesher mesher;
+        auto faces = build_naive(blocks, mesher);
+        std::vector<GreedyQuad> quads;
+        mesher.merge(quads);
+
+        EXPECT_EQ(mesher.size(), 0);
+        EXPECT_LE(quads.size(), faces.size());
+        check_coverage(faces, quads);
+    }
+}
+
+TEST(GreedyMesher, FlatTerrain) {
+    std::vector<uint64_t> blocks(W * H * D);
+    for (int y = 0; y < 8; y++) {
+        for (int i = 0; i < W * D; i++) {
+            blocks[y * W * D + i] = y == 7 ? 2 : 1;
+        }
+    }
+    // cave
+    for (int y = 2; y < 5; y++) {
+        for (int z = 3; z < 12; z++) {
+            for (int x = 4; x < 10; x++) {
+                blocks[(y * D + z) * W + x] = 0;
+            }
+        }
+    }
+    GreedyMesher mesher;
+    auto faces = build_naive(blocks, mesher);
+    std::vector<GreedyQuad> quads;
+    mesher.merge(quads);
+    check_coverage(faces, quads);
+
+    // top, bottom, 4 sides split by the top layer block, 6 cave walls
+    EXPECT_EQ(quads.size(), 1 + 1 + 4 * 2 + 6);
+    EXPECT_GT(faces.size(), quads.size() * 20);
+}
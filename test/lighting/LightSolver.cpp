@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+
+#include <queue>
+
+#include "lighting/LightSolver.hpp"
+#include "lighting/Lightmap.hpp"
+#include "TestWorld.hpp"
+
+namespace {
+    /// @brief Previous LightSolver design used as the reference: global
+    /// coordinates entries and chunk lookups on every neighbour step
+    class ReferenceLightSolver {
+        std::queue<lightentry> addqueue;
+        std::queue<lightentry> remqueue;
+        const Block* const* blockDefs;
+        Chunks& chunks;
+        int channel;
+    public:
+        ReferenceLightSolver(
+            const ContentIndices& indices, Chunks& chunks, int channel
+        )
+            : blockDefs(indices.blocks.getDefs()),
+              chunks(chunks),
+              channel(channel) {
+        }
+
+        void add(int x, int y, int z, int emission) {
+            if (emission <= 1) return;
+            Chunk* chunk = chunks.getChunkByVoxel(x, y, z);
+            if (chunk == nullptr) return;
+            int lx = x - chunk->x * CHUNK_W;
+            int lz = z - chunk->z * CHUNK_D;
+            ubyte light = chunk->lightmap.get(lx, y, lz, channel);
+            if (emission < light) return;
+            addqueue.push(lightentry {x, y, z, ubyte(emission)});
+            chunk->lightmap.set(lx, y, lz, channel, emission);
+        }
+
+        void add(int x, int y, int z) {
+            add(x, y, z, chunks.getLight(x, y, z, channel));
+        }
+
+        void remove(int x, int y, int z) {
+            Chunk* chunk = chunks.getChunkByVoxel(x, y, z);
+            if (chunk == nullptr) return;
+            int lx = x - chunk->x * CHUNK_W;
+            int lz = z - chunk->z * CHUNK_D;
+            ubyte light = chunk->lightmap.get(lx, y, lz, channel);
+            if (light == 0) return;
+            remqueue.push(lightentry {x, y, z, light});
+            chunk->lightmap.set(lx, y, lz, channel, 0);
+        }
+
+        void solve() {
+            const int coords[] = {
+                0, 0, 1, 0, 0, -1, 0, 1, 0, 0, -1, 0, 1, 0, 0, -1, 0, 0};
+            while (!remqueue.empty()) {
+                const lightentry entry = remqueue.front();
+                remqueue.pop();
+                for (int i = 0; i < 6; i++) {
+                    int x = entry.x + coords[i * 3];
+                    int y = entry.y + coords[i * 3 + 1];
+                    int z = entry.z + coords[i * 3 + 2];
+                    Chunk* chunk = chunks.getChunkByVoxel(x, y, z);
+                    if (chunk == nullptr) continue;
+                    int lx = x - chunk->x * CHUNK_W;
+                    int lz = z - chunk->z * CHUNK_D;
+                    ubyte light = chunk->lightmap.get(lx, y, lz, channel);
+                    if (light != 0 && light == entry.light - 1) {
+                        voxel* vox = chunks.get(x, y, z);
+                        uint8_t emission = 0;
+                        if (vox && vox->id != 0) {
+                            emission = blockDefs[vox->id]->emission[channel];
+                        }
+                        if (emission) {
+                            addqueue.push(lightentry {x, y, z, emission});
+                        }
+                        chunk->lightmap.set(lx, y, lz, channel, emission);
+                        remqueue.push(lightentry {x, y, z, light});
+                    } else if (light >= entry.light) {
+                        addqueue.push(lightentry {x, y, z, light});
+                    }
+                }
+            }
+            while (!addqueue.empty()) {
+                const lightentry entry = addqueue.front();
+                addqueue.pop();
+                for (int i = 0; i < 6; i++) {
+                    int x = entry.x + coords[i * 3];
+                    int y = entry.y + coords[i * 3 + 1];
+                    int z = entry.z + coords[i * 3 + 2];
+                    Chunk* chunk = chunks.getChunkByVoxel(x, y, z);
+                    if (chunk == nullptr) continue;
+                    if (chunk->sections[y / CHUNK_SECTION_H].isOpaque()) {
+                        continue;
+                    }
+                    int lx = x - chunk->x * CHUNK_W;
+                    int lz = z - chunk->z * CHUNK_D;
+                    ubyte light = chunk->lightmap.get(lx, y, lz, channel);
+                    voxel v = chunk->voxels.get(vox_index(lx, y, lz));
+                    if (blockDefs[v.id]->lightPassing &&
+                        light + 2 <= entry.light) {
+                        chunk->lightmap.set(
+                            lx, y, lz, channel, entry.light - 1
+                        );
+                        addqueue.push(
+                            lightentry {x, y, z, ubyte(entry.light - 1)}
+                        );
+                    }
+                }
+            }
+        }
+    };
+
+    /// @brief Runs the same light changes with the solver and the reference
+    /// solver in two identical worlds
+    class LightSolverTest : public ::testing::Test {
+    protected:
+        TestWorld world {1};
+        TestWorld reference {1};
+        std::vector<std::unique_ptr<LightSolver>> solvers;
+        std::vector<std::unique_ptr<ReferenceLightSolver>> referenceSolvers;
+
+        void SetUp() override {
+            for (int channel = 0; channel < 4; channel++) {
+                solvers.push_back(std::make_unique<LightSolver>(
+                    *world.content->getIndices(), *world.chunks, channel
+                ));
+                referenceSolvers.push_back(
+                    std::make_unique<ReferenceLightSolver>(
+                        *reference.content->getIndices(),
+                        *reference.chunks,
+                        channel
+                    )
+                );
+            }
+        }
+
+        template <class Func>
+        void forEach(const Func& func) {
+            for (int channel = 0; channel < 4; channel++) {
+                func(*solvers[channel], world, channel);
+                func(*referenceSolvers[channel], reference, channel);
+            }
+        }
+
+        void solve() {
+            forEach([](auto& solver, auto&, int) { solver.solve(); });
+        }
+
+        void setBlock(int x, int y, int z, blockid_t id) {
+            world.chunks->set(x, y, z, id, {});
+            reference.chunks->set(x, y, z, id, {});
+        }
+    };
+}
+
+TEST_F(LightSolverTest, BordersPropagation) {
+    const int size = TestWorld::SIZE * CHUNK_W;
+    // emitters and sky light columns
+    forEach([size](auto& solver, TestWorld& world, int channel) {
+        for (int z = 0; z < size; z++) {
+            for (int x = 0; x < size; x++) {
+                for (int y = 0; y < CHUNK_H; y++) {
+                    const auto& def = world.content->getIndices()->blocks.require(
+                        world.chunks->get(x, y, z)->id
+                    );
+                    if (channel < 3 && def.emission[channel]) {
+                        solver.add(x, y, z, def.emission[channel]);
+                    } else if (channel == 3 && y >= 70 && y < 72) {
+                        solver.add(x, y, z);
+                    }
+                }
+            }
+        }
+    });
+    solve();
+    ASSERT_EQ(world.compareLights(reference), 0);
+
+    // lamps are placed on chunk borders
+    std::vector<glm::ivec3> lamps;
+    for (int i = 1; i < TestWorld::SIZE; i++) {
+        lamps.emplace_back(i * CHUNK_W, 21, i * 11 + 3);
+        lamps.emplace_back(i * CHUNK_W - 1, 21, (i * 5) % size);
+        lamps.emplace_back(i * 13 + 5, 22, i * CHUNK_D);
+    }
+    for (const auto& pos : lamps) {
+        setBlock(pos.x, pos.y, pos.z, world.lamp);
+        forEach([&pos](auto& solver, TestWorld& world, int channel) {
+            const auto& def =
+                world.content->getIndices()->blocks.require(world.lamp);
+            solver.add(pos.x, pos.y, pos.z, def.emission[channel]);
+        });
+    }
+    solve();
+    ASSERT_EQ(world.compareLights(reference), 0);
+
+    // placed blocks shade lights
+    for (int x = 10; x < 40; x++) {
+        setBlock(x, 70, x, world.stone);
+        forEach([x](auto& solver, auto&, int) { solver.remove(x, 70, x); });
+    }
+    solve();
+    EXPECT_EQ(world.compareLights(reference), 0);
+
+    // lamps removal
+    for (const auto& pos : lamps) {
+        setBlock(pos.x, pos.y, pos.z, BLOCK_AIR);
+        forEach([&pos](auto& solver, auto&, int) {
+            solver.remove(pos.x, pos.y, pos.z);
+        });
+    }
+    solve();
+    EXPECT_EQ(world.compareLights(reference), 0);
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include "lighting/Lighting.hpp"
+#include "TestWorld.hpp"
+
+TEST(Lighting, MultiThreaded) {
+    TestWorld single(1);
+    TestWorld multi(1);
+    Lighting singleLighting(*single.content, *single.chunks, 1);
+    Lighting multiLighting(*multi.content, *multi.chunks, 4);
+    ASSERT_EQ(singleLighting.getThreadsCount(), 1);
+    ASSERT_GT(multiLighting.getThreadsCount(), 1);
+
+    singleLighting.onChunksLoaded(single.getInnerChunks());
+    multiLighting.onChunksLoaded(multi.getInnerChunks());
+    EXPECT_EQ(single.compareLights(multi), 0);
+
+    // lights are not trivial
+    const auto& lightmap = single.chunks->getChunk(3, 3)->lightmap;
+    int lit = 0;
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        lit += Lightmap::extract(lightmap.get(i), 0) > 0;
+    }
+    EXPECT_GT(lit, 0);
+}
+
+TEST(Lighting, Batch) {
+    TestWorld single(2);
+    TestWorld batched(2);
+    Lighting singleLighting(*single.content, *single.chunks, 1);
+    Lighting batchedLighting(*batched.content, *batched.chunks, 1);
+    singleLighting.onChunksLoaded(single.getInnerChunks());
+    batchedLighting.onChunksLoaded(batched.getInnerChunks());
+    ASSERT_EQ(single.compareLights(batched), 0);
+
+    struct Edit {
+        glm::ivec3 pos;
+        blockid_t id;
+    };
+    std::vector<Edit> edits;
+    for (int i = 1; i < TestWorld::SIZE - 1; i++) {
+        int border = i * CHUNK_W;
+        // lamps on chunk borders, one of them is removed later
+        edits.push_back({{border, 21, 40}, single.lamp});
+        edits.push_back({{border - 1, 22, 50}, single.glass_lamp});
+        // shaft dug from the surface to the tunnels
+        for (int y = 50; y >= 20; y--) {
+            edits.push_back({{border + 3, y, 36}, BLOCK_AIR});
+        }
+        // roof above the shaft
+        for (int x = border; x < border + 6; x++) {
+            edits.push_back({{x, 60, 36}, single.stone});
+        }
+    }
+    edits.push_back({{CHUNK_W * 2, 21, 40}, BLOCK_AIR});
+
+    for (const auto& edit : edits) {
+        const auto& pos = edit.pos;
+        single.chunks->set(pos.x, pos.y, pos.z, edit.id, {});
+        singleLighting.onBlockSet(pos.x, pos.y, pos.z, edit.id);
+    }
+    batchedLighting.beginBatch();
+    for (size_t i = 0; i < edits.size(); i++) {
+        const auto& pos = edits[i].pos;
+        // nested batch is resolved by the outer one
+        if (i == edits.size() / 2) {
+            batchedLighting.beginBatch();
+        }
+        batched.chunks->set(pos.x, pos.y, pos.z, edits[i].id, {});
+        batchedLighting.onBlockSet(pos.x, pos.y, pos.z, edits[i].id);
+    }
+    batchedLighting.endBatch();
+    // lights are not updated until the outer batch ends
+    EXPECT_NE(single.compareLights(batched), 0);
+    batchedLighting.endBatch();
+    EXPECT_EQ(single.compareLights(batched), 0);
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include "lighting/Lightmap.hpp"
+
+TEST(Lightmap, Sparse) {
+    Lightmap lightmap;
+    lightmap.fill(70, CHUNK_H, 3, 15);
+    for (int s = 0; s < CHUNK_SECTIONS; s++) {
+        EXPECT_EQ(lightmap.isUniform(s), s != 70 / CHUNK_SECTION_H);
+    }
+    EXPECT_EQ(lightmap.getS(3, 69, 5), 0);
+    EXPECT_EQ(lightmap.getS(3, 70, 5), 15);
+    EXPECT_EQ(lightmap.getS(3, 200, 5), 15);
+
+    // setting the same value does not allocate section lights
+    lightmap.setR(1, 10, 1, 0);
+    EXPECT_TRUE(lightmap.isUniform(0));
+    lightmap.setR(1, 10, 1, 7);
+    EXPECT_FALSE(lightmap.isUniform(0));
+    EXPECT_EQ(lightmap.getR(1, 10, 1), 7);
+    EXPECT_EQ(lightmap.getR(1, 10, 2), 0);
+    EXPECT_LT(lightmap.getMemoryUsage(), CHUNK_VOL * sizeof(light_t) / 4);
+
+    Lightmap copy;
+    copy.set(&lightmap);
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        EXPECT_EQ(copy.get(i), lightmap.get(i));
+    }
+}
+
+static void check_encode_decode(const Lightmap& lightmap) {
+    uint size;
+    auto bytes = lightmap.encode(size);
+    EXPECT_LE(size, LIGHTMAP_DATA_LEN);
+    auto decoded = Lightmap::decode(bytes.get(), size);
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        EXPECT_EQ(
+            Lightmap::extract(decoded[i], 3),
+            Lightmap::extract(lightmap.get(i), 3)
+        );
+    }
+}
+
+TEST(Lightmap, EncodeDecode) {
+    Lightmap lightmap;
+    for (int z = 0; z < CHUNK_D; z++) {
+        for (int x = 0; x < CHUNK_W; x++) {
+            int height = 60 + (x * 3 + z) % 10;
+            lightmap.fill(height, height + 1, 3, 0);
+            for (int y = height + 1; y < CHUNK_H; y++) {
+                lightmap.setS(x, y, z, 15);
+            }
+            // light coming through cave opening
+            for (int y = height - 6; y < height; y++) {
+                lightmap.setS(x, y, z, 14 - (height - y));
+            }
+            lightmap.setR(x, height - 1, z, 12);
+        }
+    }
+    uint size;
+    lightmap.encode(size);
+    EXPECT_LT(size, LIGHTMAP_DATA_LEN / 8);
+    check_encode_decode(lightmap);
+
+    // noisy lights are encoded densely
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        lightmap.setS(i % CHUNK_W, i / (CHUNK_W * CHUNK_D),
+                      (i / CHUNK_W) % CHUNK_D, rand() % 16);
+    }
+    lightmap.encode(size);
+    EXPECT_EQ(size, LIGHTMAP_DATA_LEN);
+    check_encode_decode(lightmap);
+}
+
+TEST(Lightmap, FillColumns) {
+    uint16_t bottoms[CHUNK_W * CHUNK_D];
+    for (uint i = 0; i < CHUNK_W * CHUNK_D; i++) {
+        bottoms[i] = 40 + i % 37;
+    }
+    Lightmap lightmap;
+    lightmap.setR(0, 50, 0, 5);
+    lightmap.fillColumns(bottoms, 3, 15);
+    for (int z = 0; z < CHUNK_D; z++) {
+        for (int x = 0; x < CHUNK_W; x++) {
+            int bottom = bottoms[z * CHUNK_W + x];
+            EXPECT_EQ(lightmap.getS(x, bottom - 1, z), 0);
+            EXPECT_EQ(lightmap.getS(x, bottom, z), 15);
+            EXPECT_EQ(lightmap.getS(x, CHUNK_H - 1, z), 15);
+        }
+    }
+    EXPECT_EQ(lightmap.getR(0, 50, 0), 5);
+    EXPECT_TRUE(lightmap.isUniform(0));
+    EXPECT_TRUE(lightmap.isUniform(CHUNK_SECTIONS - 1));
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <memory>
+#include <random>
+
+#include "../TestContent.hpp"
+#include "lighting/Lighting.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/Chunks.hpp"
+
+/// @brief Content and a matrix of generated chunks used by lighting tests.
+/// Terrain has overhangs shading sky light and lit tunnels crossing chunk
+/// borders
+class TestWorld {
+    static void create_lamp(
+        TestContentBuilder& builder,
+        const std::string& name,
+        bool lightPassing,
+        const uint8_t (&emission)[3]
+    ) {
+        auto& block = builder.createBlock(name, !lightPassing);
+        for (int i = 0; i < 3; i++) {
+            block.emission[i] = emission[i];
+        }
+    }
+
+    void generate(Chunk& chunk, int seed) const {
+        std::mt19937 random(seed ^ (chunk.x * 73856093) ^ (chunk.z * 19349663));
+        for (int z = 0; z < CHUNK_D; z++) {
+            for (int x = 0; x < CHUNK_W; x++) {
+                int gx = chunk.x * CHUNK_W + x;
+                int gz = chunk.z * CHUNK_D + z;
+                int height = 40 + (gx * 7 + gz * 13) % 9;
+                for (int y = 0; y < height; y++) {
+                    chunk.voxels[vox_index(x, y, z)].id = stone;
+                }
+                // overhangs
+                if ((gx / 5 + gz / 7) % 3 == 0) {
+                    chunk.voxels[vox_index(x, 70, z)].id = stone;
+                }
+                // tunnels
+                if (gz % 11 == 3 || gx % 13 == 5) {
+                    for (int y = 20; y < 23; y++) {
+                        chunk.voxels[vox_index(x, y, z)].id = BLOCK_AIR;
+                    }
+                }
+            }
+        }
+        for (int i = 0; i < 8; i++) {
+            int x = random() % CHUNK_W;
+            int y = 20 + random() % 30;
+            int z = random() % CHUNK_D;
+            chunk.voxels[vox_index(x, y, z)].id = i % 2 ? lamp : glass_lamp;
+        }
+    }
+public:
+    static constexpr int SIZE = 8;
+
+    std::unique_ptr<Content> content;
+    std::unique_ptr<Chunks> chunks;
+    blockid_t stone;
+    /// @brief Opaque emissive block
+    blockid_t lamp;
+    /// @brief Light passing emissive block
+    blockid_t glass_lamp;
+
+    /// @brief Generate SIZE x SIZE chunks starting at 0, 0.
+    /// Lights are not built
+    TestWorld(int seed) {
+        TestContentBuilder builder;
+        builder.createBlock("test:stone", true);
+        create_lamp(builder, "test:lamp", false, {15, 10, 4});
+        create_lamp(builder, "test:glass_lamp", true, {6, 13, 15});
+        content = builder.build();
+
+        const auto& indices = *content->getIndices();
+        stone = content->blocks.require("test:stone").rt.id;
+        lamp = content->blocks.require("test:lamp").rt.id;
+        glass_lamp = content->blocks.require("test:glass_lamp").rt.id;
+
+        // matrix offset is 0, 0
+        chunks = std::make_unique<Chunks>(
+            SIZE, SIZE, SIZE, SIZE, nullptr, indices
+        );
+        for (int cz = 0; cz < SIZE; cz++) {
+            for (int cx = 0; cx < SIZE; cx++) {
+                auto chunk = std::make_shared<Chunk>(cx, cz);
+                generate(*chunk, seed);
+                chunk->updateHeights();
+                chunk->updateSections(indices.blocks.getDefs());
+                Lighting::prebuildSkyLight(*chunk, indices);
+                chunk->flags.loaded = true;
+                chunks->putChunk(chunk);
+            }
+        }
+    }
+
+    /// @return chunks having all neighbours loaded
+    std::vector<Chunk*> getInnerChunks() const {
+        std::vector<Chunk*> inner;
+        for (int cz = 1; cz < SIZE - 1; cz++) {
+            for (int cx = 1; cx < SIZE - 1; cx++) {
+                inner.push_back(chunks->getChunk(cx, cz));
+            }
+        }
+        return inner;
+    }
+
+    /// @return number of voxels having different lights
+    size_t compareLights(const TestWorld& other) const {
+        size_t differences = 0;
+        for (int cz = 0; cz < SIZE; cz++) {
+            for (int cx = 0; cx < SIZE; cx++) {
+                const auto& a = chunks->getChunk(cx, cz)->lightmap;
+                const auto& b = other.chunks->getChunk(cx, cz)->lightmap;
+                for (uint i = 0; i < CHUNK_VOL; i++) {
+                    differences += a.get(i) != b.get(i);
+                }
+            }
+        }
+        return differences;
+    }
+};
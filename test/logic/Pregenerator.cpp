@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <map>
+
+#include "logic/Pregenerator.hpp"
+
+TEST(PregenTiles, Iteration) {
+    // corners are swapped, area is not a multiple of tiles
+    PregenTiles tiles({20, 5}, {-17, -30});
+    const int size = PregenTiles::TILE_SIZE;
+    ASSERT_EQ(tiles.getAreaMin(), glm::ivec2(-17, -30));
+    ASSERT_EQ(tiles.getAreaMax(), glm::ivec2(20, 5));
+    // 38 x 36 chunks
+    ASSERT_EQ(tiles.count(), 3 * 3);
+
+    std::map<std::pair<int, int>, int> visits;
+    glm::ivec2 prevMin {};
+    for (int i = 0; i < tiles.count(); i++) {
+        glm::ivec2 min, max;
+        tiles.getTile(i, min, max);
+        EXPECT_LE(max.x - min.x, size - 1);
+        EXPECT_LE(max.y - min.y, size - 1);
+        EXPECT_GE(min.x, -17);
+        EXPECT_GE(min.y, -30);
+        EXPECT_LE(max.x, 20);
+        EXPECT_LE(max.y, 5);
+        if (i > 0) {
+            // tiles go row by row
+            EXPECT_TRUE(
+                min.y > prevMin.y || (min.y == prevMin.y && min.x > prevMin.x)
+            );
+        }
+        prevMin = min;
+        for (int z = min.y; z <= max.y; z++) {
+            for (int x = min.x; x <= max.x; x++) {
+                visits[{x, z}]++;
+            }
+        }
+    }
+    EXPECT_EQ(visits.size(), 38 * 36);
+    for (const auto& [pos, count] : visits) {
+        EXPECT_EQ(count, 1);
+    }
+}
+
+TEST(PregenTiles, Completion) {
+    PregenTiles tiles({0, 0}, {39, 20});
+    ASSERT_EQ(tiles.count(), 3 * 2);
+    EXPECT_EQ(tiles.countChunks(0), 0);
+    // full first row tile
+    EXPECT_EQ(tiles.countChunks(1), 16 * 16);
+    // first row is clipped at x = 39
+    EXPECT_EQ(tiles.countChunks(3), 40 * 16);
+    EXPECT_EQ(tiles.countChunks(tiles.count()), 40 * 21);
+
+    glm::ivec2 min, max;
+    tiles.getTile(tiles.count() - 1, min, max);
+    EXPECT_EQ(min, glm::ivec2(32, 16));
+    EXPECT_EQ(max, glm::ivec2(39, 20));
+
+    PregenTiles single({7, 7}, {7, 7});
+    EXPECT_EQ(single.count(), 1);
+    EXPECT_EQ(single.countChunks(single.count()), 1);
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "maths/noise.hpp"
+#include "maths/FastNoiseLite.h"
+
+static std::vector<float> reference_noise(
+    fnl_state& state,
+    uint w,
+    uint h,
+    const glm::vec2& offset,
+    float scale,
+    int octaves,
+    float multiplier,
+    const float* shiftX
+) {
+    std::vector<float> values(w * h);
+    for (uint y = 0; y < h; y++) {
+        for (uint x = 0; x < w; x++) {
+            uint i = y * w + x;
+            for (int c = 0; c < octaves; c++) {
+                float m = scale * (1 << c);
+                float u = (x + offset.x) * m;
+                float v = (y + offset.y) * m;
+                if (shiftX) {
+                    u += shiftX[i];
+                }
+                values[i] += fnlGetNoise2D(&state, u, v) /
+                             static_cast<float>(1 << c) * multiplier;
+            }
+        }
+    }
+    return values;
+}
+
+TEST(noise, SimplexMatchesScalar) {
+    const uint w = 37;
+    const uint h = 19;
+    fnl_state state = fnlCreateState();
+    state.seed = 1337;
+    state.noise_type = FNL_NOISE_OPENSIMPLEX2;
+
+    std::vector<float> shift(w * h);
+    for (uint i = 0; i < shift.size(); i++) {
+        shift[i] = (i % 11) * 3.5f - 17.0f;
+    }
+    glm::vec2 offset(-513.0f, 2048.0f);
+    for (const float* shiftX : {static_cast<const float*>(nullptr),
+                                static_cast<const float*>(shift.data())}) {
+        auto expected =
+            reference_noise(state, w, h, offset, 0.7f, 4, 2.0f, shiftX);
+        std::vector<float> values(w * h);
+        noise::add_noise2d(
+            values.data(), w, h, state, offset, 0.7f, 4, 2.0f, shiftX, nullptr
+        );
+        for (uint i = 0; i < w * h; i++) {
+            EXPECT_NEAR(values[i], expected[i], 1e-4f) << "sample " << i;
+        }
+    }
+}
+
+TEST(noise, CellularMatchesScalar) {
+    const uint w = 16;
+    const uint h = 16;
+    fnl_state state = fnlCreateState();
+    state.noise_type = FNL_NOISE_CELLULAR;
+
+    glm::vec2 offset(100.0f, -40.0f);
+    auto expected = reference_noise(state, w, h, offset, 1.5f, 2, 1.0f, nullptr);
+    std::vector<float> values(w * h);
+    noise::add_noise2d(
+        values.data(), w, h, state, offset, 1.5f, 2, 1.0f, nullptr, nullptr
+    );
+    EXPECT_EQ(values, expected);
+}
+
+TEST(noise, Remap) {
+    std::vector<float> values {-1.0f, 0.0f, 0.5f, 1.0f, 2.0f};
+    noise::remap(values.data(), values.size(), -1.0f, 1.0f, 0.0f, 10.0f);
+    EXPECT_FLOAT_EQ(values[0], 0.0f);
+    EXPECT_FLOAT_EQ(values[1], 5.0f);
+    EXPECT_FLOAT_EQ(values[2], 7.5f);
+    EXPECT_FLOAT_EQ(values[3], 10.0f);
+    EXPECT_FLOAT_EQ(values[4], 15.0f);
+}
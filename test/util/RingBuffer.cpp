@@ -0,0 +1,26 @@
+#include <gtest/gtest.h>
+
+#include "util/RingBuffer.hpp"
+
+using namespace util;
+
+TEST(RingBuffer, PushPop) {
+    RingBuffer<int> queue(4);
+    EXPECT_TRUE(queue.empty());
+    int next = 0;
+    int expected = 0;
+    // wraps around the storage end and grows in the middle of the queue
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < 3 + round; i++) {
+            queue.push(next++);
+        }
+        for (int i = 0; i < 2 + round; i++) {
+            EXPECT_EQ(queue.pop(), expected++);
+        }
+    }
+    EXPECT_EQ(queue.size(), next - expected);
+    while (!queue.empty()) {
+        EXPECT_EQ(queue.pop(), expected++);
+    }
+    EXPECT_EQ(expected, next);
+}
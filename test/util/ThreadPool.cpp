@@ -0,0 +1,269 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <set>
+
+#include "util/ThreadPool.hpp"
+#include "util/WorkStealingThreadPool.hpp"
+
+using namespace util;
+using namespace std::chrono_literals;
+
+using clock_type = std::chrono::steady_clock;
+
+struct TestJob {
+    int value = 0;
+    int work = 0;
+    clock_type::time_point time {};
+};
+
+struct TestResult {
+    int value;
+    std::thread::id thread;
+    clock_type::time_point time;
+};
+
+class TestWorker : public Worker<TestJob, TestResult> {
+public:
+    TestResult operator()(const TestJob& job) override {
+        uint32_t x = job.value + 1;
+        for (int i = 0; i < job.work; i++) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+        }
+        // keeps the loop from being optimized out
+        int value = job.value + static_cast<int>(x == 0);
+        return TestResult {value, std::this_thread::get_id(), job.time};
+    }
+};
+
+static auto test_workers() {
+    return []() { return std::make_shared<TestWorker>(); };
+}
+
+template <class Pool>
+class ThreadPoolTest : public ::testing::Test {};
+
+using Pools = ::testing::Types<
+    ThreadPool<TestJob, TestResult>,
+    WorkStealingThreadPool<TestJob, TestResult>>;
+TYPED_TEST_SUITE(ThreadPoolTest, Pools);
+
+TEST(ThreadPool, WorkersCount) {
+    uint concurrency = std::max(1U, std::thread::hardware_concurrency());
+    EXPECT_EQ(get_workers_count(ThreadPool<int, int>::UNLIMITED), concurrency);
+    EXPECT_EQ(
+        get_workers_count(ThreadPool<int, int>::HALF),
+        std::max(1U, concurrency / 2)
+    );
+    EXPECT_EQ(
+        get_workers_count(ThreadPool<int, int>::QUARTER),
+        std::max(1U, concurrency / 4)
+    );
+    EXPECT_EQ(get_workers_count(1), 1);
+    EXPECT_EQ(get_workers_count(1'000'000), concurrency);
+}
+
+TEST(WorkStealingThreadPool, AllJobsDone) {
+    const int count = 10'000;
+    long long sum = 0;
+    int results = 0;
+    WorkStealingThreadPool<TestJob, TestResult> pool(
+        "test-pool",
+        test_workers(),
+        [&](TestResult& result) {
+            sum += result.value;
+            results++;
+        },
+        4
+    );
+    for (int i = 0; i < count; i++) {
+        if (i % 3 == 0) {
+            pool.enqueueJob(TestJob {i, 10}, i);
+        } else {
+            pool.enqueueJob(TestJob {i, 10});
+        }
+    }
+    auto start = clock_type::now();
+    while (results < count && clock_type::now() - start < 10s) {
+        std::this_thread::sleep_for(1ms);
+        pool.update();
+    }
+    EXPECT_EQ(results, count);
+    EXPECT_EQ(sum, static_cast<long long>(count) * (count - 1) / 2);
+    EXPECT_EQ(pool.getWorkDone(), count);
+}
+
+TEST(WorkStealingThreadPool, WorkStealing) {
+    std::set<std::thread::id> threads;
+    int results = 0;
+    WorkStealingThreadPool<TestJob, TestResult> pool(
+        "test-pool",
+        test_workers(),
+        [&](TestResult& result) {
+            threads.insert(result.thread);
+            results++;
+        },
+        4
+    );
+    if (pool.getWorkersCount() < 2) {
+        GTEST_SKIP() << "single worker";
+    }
+    // all jobs are added to the first worker deque
+    for (int i = 0; i < 200; i++) {
+        pool.enqueueJob(TestJob {i, 100'000}, 0);
+    }
+    auto start = clock_type::now();
+    while (results < 200 && clock_type::now() - start < 10s) {
+        std::this_thread::sleep_for(1ms);
+        pool.update();
+    }
+    EXPECT_EQ(results, 200);
+    EXPECT_GT(threads.size(), 1);
+}
+
+TYPED_TEST(ThreadPoolTest, OnComplete) {
+    int results = 0;
+    bool complete = false;
+    TypeParam pool(
+        "test-pool",
+        test_workers(),
+        [&](TestResult&) { results++; },
+        4
+    );
+    pool.setStandaloneResults(false);
+    pool.setOnComplete([&]() { complete = true; });
+    for (int i = 0; i < 100; i++) {
+        pool.enqueueJob(TestJob {i, 100});
+    }
+    pool.waitForEnd();
+    EXPECT_TRUE(complete);
+    EXPECT_EQ(results, 100);
+    EXPECT_FALSE(pool.isActive());
+}
+
+TYPED_TEST(ThreadPoolTest, JobFailed) {
+    class FailingWorker : public Worker<TestJob, TestResult> {
+    public:
+        TestResult operator()(const TestJob& job) override {
+            if (job.value == 5) {
+                throw std::runtime_error("job failed");
+            }
+            return TestResult {job.value, {}, {}};
+        }
+    };
+    std::atomic<int> failedJob = -1;
+    TypeParam pool(
+        "test-pool",
+        []() { return std::make_shared<FailingWorker>(); },
+        [](TestResult&) {},
+        2
+    );
+    pool.setOnJobFailed([&](TestJob& job) { failedJob = job.value; });
+    for (int i = 0; i < 10; i++) {
+        pool.enqueueJob(TestJob {i});
+    }
+    EXPECT_THROW(pool.waitForEnd(), std::runtime_error);
+    EXPECT_EQ(failedJob, 5);
+}
+
+struct BenchmarkStats {
+    int workers;
+    double jobsPerSecond;
+    double p50;
+    double p99;
+    double max;
+};
+
+/// @brief Jobs are added in batches between updates like chunk meshes
+/// are requested every frame. Latency is measured from job addition
+/// to the result consumption
+template <class Pool>
+static BenchmarkStats run_benchmark(
+    int jobWork, int batchSize, int batches, int workers
+) {
+    size_t total = static_cast<size_t>(batchSize) * batches;
+    std::vector<double> latencies;
+    latencies.reserve(total);
+    int64_t valuesSum = 0;
+    auto consumer = [&](TestResult& result) {
+        std::chrono::duration<double, std::micro> latency =
+            clock_type::now() - result.time;
+        latencies.push_back(latency.count());
+        valuesSum += result.value;
+    };
+    Pool pool("benchmark-pool", test_workers(), consumer, workers);
+    auto start = clock_type::now();
+    for (int batch = 0; batch < batches; batch++) {
+        for (int i = 0; i < batchSize; i++) {
+            pool.enqueueJob(TestJob {i, jobWork, clock_type::now()});
+        }
+        pool.update();
+    }
+    auto deadline = start + 60s;
+    while (latencies.size() < total && clock_type::now() < deadline) {
+        std::this_thread::yield();
+        pool.update();
+    }
+    std::chrono::duration<double> time = clock_type::now() - start;
+
+    EXPECT_EQ(latencies.size(), total);
+    EXPECT_EQ(valuesSum, int64_t(batchSize) * (batchSize - 1) / 2 * batches);
+    if (latencies.empty()) {
+        return BenchmarkStats {pool.getWorkersCount(), 0.0, 0.0, 0.0, 0.0};
+    }
+    std::sort(latencies.begin(), latencies.end());
+    return BenchmarkStats {
+        pool.getWorkersCount(),
+        latencies.size() / time.count(),
+        latencies[latencies.size() / 2],
+        latencies[latencies.size() * 99 / 100],
+        latencies.back()};
+}
+
+/// @brief Compares the work-stealing pool to the default shared queue one.
+/// Disabled by default, run with --gtest_also_run_disabled_tests
+/// --gtest_filter=ThreadPool.DISABLED_Benchmark
+TEST(ThreadPool, DISABLED_Benchmark) {
+    // pool workers count is limited by hardware concurrency
+    const int maxWorkers = std::max(1U, std::thread::hardware_concurrency());
+    std::set<int> workersCounts;
+    for (int workers : {1, 2, 4, 8, maxWorkers}) {
+        workersCounts.insert(std::min(workers, maxWorkers));
+    }
+    struct Case {
+        const char* name;
+        int jobWork;
+        int batchSize;
+        int batches;
+    } cases[] {
+        {"tiny jobs", 10, 256, 400},
+        {"small jobs", 2'000, 64, 200},
+    };
+    auto print = [](const char* name, const BenchmarkStats& stats) {
+        std::cout << "  " << name << ": " << stats.jobsPerSecond
+                  << " jobs/s, latency p50 " << stats.p50 << " us, p99 "
+                  << stats.p99 << " us, max " << stats.max << " us"
+                  << std::endl;
+    };
+    for (const auto& c : cases) {
+        for (int workers : workersCounts) {
+            auto stats =
+                run_benchmark<WorkStealingThreadPool<TestJob, TestResult>>(
+                    c.jobWork, c.batchSize, c.batches, workers
+                );
+            auto reference = run_benchmark<ThreadPool<TestJob, TestResult>>(
+                c.jobWork, c.batchSize, c.batches, workers
+            );
+            EXPECT_EQ(stats.workers, reference.workers);
+            EXPECT_GT(stats.jobsPerSecond, 0.0);
+            EXPECT_GT(reference.jobsPerSecond, 0.0);
+
+            std::cout << c.name << " (" << stats.workers << " workers)"
+                      << std::endl;
+            print("work-stealing", stats);
+            print("shared queue", reference);
+        }
+    }
+}
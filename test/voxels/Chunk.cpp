@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include "voxels/Block.hpp"
 #include "voxels/Chunk.hpp"
 
 TEST(Chunk, EncodeDecode) {
@@ -23,3 +24,97 @@ TEST(Chunk, EncodeDecode) {
         );
     }
 }
+
+TEST(Chunk, Sections) {
+    Block air("core:air");
+    air.rt.id = BLOCK_AIR;
+    air.lightPassing = true;
+    Block stone("base:stone");
+    stone.rt.id = 1;
+    const Block* defs[] {&air, &stone};
+
+    Chunk chunk(0, 0);
+    for (uint i = 0; i < CHUNK_W * CHUNK_D * 40; i++) {
+        chunk.voxels[i].id = stone.rt.id;
+    }
+    // not counted sections are neither empty nor opaque
+    EXPECT_FALSE(chunk.sections[CHUNK_SECTIONS - 1].isEmpty());
+    EXPECT_FALSE(chunk.sections[0].isOpaque());
+
+    chunk.updateSections(defs);
+    EXPECT_TRUE(chunk.sections[0].isOpaque());
+    EXPECT_TRUE(chunk.sections[1].isOpaque());
+    EXPECT_FALSE(chunk.sections[2].isOpaque());
+    EXPECT_FALSE(chunk.sections[2].isEmpty());
+    EXPECT_TRUE(chunk.sections[3].isEmpty());
+
+    chunk.updateSection(5, stone, air);
+    EXPECT_FALSE(chunk.sections[0].isOpaque());
+    chunk.updateSection(50, air, stone);
+    EXPECT_FALSE(chunk.sections[3].isEmpty());
+
+    chunk.resetSections();
+    EXPECT_FALSE(chunk.sections[4].isEmpty());
+
+    // not counted section is not changed by differences
+    chunk.updateSection(5, stone, air);
+    EXPECT_EQ(chunk.sections[0].opaque, 0);
+    for (uint i = 0; i < CHUNK_SECTION_VOL; i++) {
+        chunk.updateSection(5, air, stone);
+    }
+    EXPECT_FALSE(chunk.sections[0].isOpaque());
+    EXPECT_FALSE(chunk.sections[0].isEmpty());
+}
+
+TEST(Chunk, SkyHeights) {
+    Block air("core:air");
+    air.rt.id = BLOCK_AIR;
+    air.skyLightPassing = true;
+    Block stone("base:stone");
+    stone.rt.id = 1;
+    const Block* defs[] {&air, &stone};
+
+    Chunk chunk(0, 0);
+    for (uint z = 0; z < CHUNK_D; z++) {
+        for (uint x = 0; x < CHUNK_W; x++) {
+            for (uint y = 0; y < 30 + x; y++) {
+                chunk.voxels[vox_index(x, y, z)].id = stone.rt.id;
+            }
+        }
+    }
+    chunk.updateSections(defs);
+    EXPECT_EQ(chunk.skyHeights[0], 30);
+    EXPECT_EQ(chunk.skyHeights[CHUNK_W * 2 + 5], 35);
+
+    chunk.voxels[vox_index(5, 100, 2)].id = stone.rt.id;
+    chunk.updateSkyHeight(5, 100, 2, stone, defs);
+    EXPECT_EQ(chunk.skyHeights[CHUNK_W * 2 + 5], 101);
+
+    chunk.voxels[vox_index(5, 100, 2)].id = BLOCK_AIR;
+    chunk.updateSkyHeight(5, 100, 2, air, defs);
+    EXPECT_EQ(chunk.skyHeights[CHUNK_W * 2 + 5], 35);
+}
+
+TEST(Chunk, ModifiedSections) {
+    Chunk chunk(0, 0);
+    EXPECT_EQ(chunk.modifiedSections, 0);
+
+    chunk.setModified(CHUNK_SECTION_H * 2 + 5);
+    EXPECT_TRUE(chunk.flags.modified);
+    EXPECT_EQ(chunk.modifiedSections, 1 << 2);
+
+    // voxels on section borders affect neighbour sections meshes
+    chunk.modifiedSections = 0;
+    chunk.setModified(CHUNK_SECTION_H * 3);
+    EXPECT_EQ(chunk.modifiedSections, (1 << 2) | (1 << 3));
+    chunk.setModified(CHUNK_SECTION_H * 5 - 1);
+    EXPECT_EQ(chunk.modifiedSections, (1 << 2) | (1 << 3) | (1 << 4) | (1 << 5));
+
+    chunk.modifiedSections = 0;
+    chunk.setModified(0);
+    chunk.setModified(CHUNK_H - 1);
+    EXPECT_EQ(chunk.modifiedSections, 1 | (1 << (CHUNK_SECTIONS - 1)));
+
+    chunk.setModifiedAndUnsaved();
+    EXPECT_EQ(chunk.modifiedSections, ALL_SECTIONS_MASK);
+}
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include "voxels/ChunkVoxels.hpp"
+#include "voxels/PalettedVoxels.hpp"
+
+static void fill_terrain(voxel* voxels, int height, int kinds) {
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        int y = i / (CHUNK_W * CHUNK_D);
+        voxels[i].id = y < height ? 1 + rand() % kinds : 0;
+        voxels[i].state = int2blockstate(y < height ? rand() % 4 : 0);
+    }
+}
+
+static void expect_same(const voxel& a, const voxel& b) {
+    EXPECT_EQ(a.id, b.id);
+    EXPECT_EQ(blockstate2int(a.state), blockstate2int(b.state));
+}
+
+TEST(PalettedVoxels, EncodeDecode) {
+    for (int kinds : {1, 3, 20, 300}) {
+        auto voxels = std::make_unique<voxel[]>(CHUNK_VOL);
+        fill_terrain(voxels.get(), 70, kinds);
+
+        PalettedVoxels paletted(voxels.get());
+        auto decoded = std::make_unique<voxel[]>(CHUNK_VOL);
+        paletted.decode(decoded.get());
+        for (uint i = 0; i < CHUNK_VOL; i++) {
+            expect_same(decoded[i], voxels[i]);
+            expect_same(paletted.get(i), voxels[i]);
+        }
+        // sections above terrain are uniform air
+        EXPECT_FALSE(paletted.isUniform(0));
+        EXPECT_TRUE(paletted.isUniform(CHUNK_SECTIONS - 1));
+        EXPECT_LT(paletted.getMemoryUsage(), CHUNK_VOL * sizeof(voxel));
+    }
+}
+
+TEST(ChunkVoxels, CompactExpand) {
+    ChunkVoxels voxels;
+    fill_terrain(voxels.data(), 40, 5);
+    auto initial = std::make_unique<voxel[]>(CHUNK_VOL);
+    voxels.copyTo(initial.get());
+
+    // not compacted right after been expanded
+    EXPECT_FALSE(voxels.compact());
+    EXPECT_TRUE(voxels.compact());
+    EXPECT_TRUE(voxels.isCompact());
+    EXPECT_LT(voxels.getMemoryUsage(), CHUNK_VOL * sizeof(voxel));
+    {
+        auto view = voxels.view();
+        for (uint i = 0; i < CHUNK_VOL; i++) {
+            expect_same(view[i], initial[i]);
+            expect_same(voxels.get(i), initial[i]);
+        }
+    }
+    voxels[0].id = 42;
+    EXPECT_FALSE(voxels.isCompact());
+    EXPECT_EQ(voxels.get(0).id, 42);
+    for (uint i = 1; i < CHUNK_VOL; i++) {
+        expect_same(voxels[i], initial[i]);
+    }
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "io/io.hpp"
+#include "io/devices/StdfsDevice.hpp"
+#include "world/files/WorldRegions.hpp"
+
+namespace fs = std::filesystem;
+
+static void create_region_file(const io::path& file) {
+    std::vector<ubyte> bytes(REGION_HEADER_SIZE + REGION_CHUNKS_COUNT * 4);
+    std::memcpy(bytes.data(), ".VOXREG", 8);
+    bytes[8] = REGION_FORMAT_VERSION;
+    io::write_bytes(file, bytes.data(), bytes.size());
+}
+
+class RegionFilesCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auto root = fs::temp_directory_path() / "vctest-regions";
+        io::set_device("regions", std::make_shared<io::StdfsDevice>(root));
+        for (int i = 0; i < 4; i++) {
+            create_region_file(filename(i));
+        }
+    }
+
+    void TearDown() override {
+        io::remove_device("regions");
+    }
+
+    static io::path filename(int x) {
+        return "regions:" + std::to_string(x) + "_0.bin";
+    }
+
+    static supplier<std::unique_ptr<regfile>> opener(int x) {
+        return [x]() { return std::make_unique<regfile>(filename(x)); };
+    }
+};
+
+TEST_F(RegionFilesCacheTest, HitsAndMisses) {
+    RegionFilesCache cache(4, 1);
+    cache.acquire({0, 0}, opener(0)).reset();
+    cache.acquire({0, 0}, opener(0)).reset();
+    EXPECT_EQ(cache.acquire({1, 0}, nullptr), nullptr);
+
+    auto stats = cache.getStats();
+    EXPECT_EQ(stats.misses, 1);
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.evictions, 0);
+    EXPECT_EQ(cache.size(), 1);
+}
+
+TEST_F(RegionFilesCacheTest, EvictsLeastRecentlyUsed) {
+    RegionFilesCache cache(2, 1);
+    cache.acquire({0, 0}, opener(0)).reset();
+    cache.acquire({1, 0}, opener(1)).reset();
+    // region 0 becomes most recently used
+    cache.acquire({0, 0}, opener(0)).reset();
+    cache.acquire({2, 0}, opener(2)).reset();
+
+    EXPECT_EQ(cache.getStats().evictions, 1);
+    EXPECT_NE(cache.acquire({0, 0}, nullptr), nullptr);
+    EXPECT_EQ(cache.acquire({1, 0}, nullptr), nullptr);
+}
+
+TEST_F(RegionFilesCacheTest, KeepsFilesInUse) {
+    RegionFilesCache cache(2, 1);
+    auto first = cache.acquire({0, 0}, opener(0));
+    cache.acquire({1, 0}, opener(1)).reset();
+    cache.acquire({2, 0}, opener(2)).reset();
+
+    EXPECT_FALSE(cache.closeIfUnused({0, 0}));
+    first.reset();
+    EXPECT_TRUE(cache.closeIfUnused({0, 0}));
+    EXPECT_EQ(cache.acquire({0, 0}, nullptr), nullptr);
+}
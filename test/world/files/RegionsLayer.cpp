@@ -0,0 +1,258 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <fstream>
+
+#include "io/io.hpp"
+#include "io/devices/StdfsDevice.hpp"
+#include "util/data_io.hpp"
+#include "world/files/WorldRegions.hpp"
+
+namespace fs = std::filesystem;
+
+class RegionsLayerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auto root = fs::temp_directory_path() / "vctest-regions-layer";
+        fs::remove_all(root);
+        io::set_device("regions", std::make_shared<io::StdfsDevice>(root));
+    }
+
+    void TearDown() override {
+        io::remove_device("regions");
+    }
+
+    static void put(RegionsLayer& layer, uint x, uint z, ubyte value, uint size) {
+        auto data = std::make_unique<ubyte[]>(size);
+        std::fill(data.get(), data.get() + size, value);
+        auto region = layer.getOrCreateRegion(0, 0);
+        region->put(x, z, std::move(data), size, size);
+        region->setChunkUnsaved(x, z);
+    }
+
+    static void expect_chunk(
+        RegionsLayer& layer, int x, int z, ubyte value, uint size
+    ) {
+        uint32_t length;
+        uint32_t srcSize;
+        ubyte* data = layer.getData(x, z, length, srcSize);
+        ASSERT_NE(data, nullptr);
+        EXPECT_EQ(length, size);
+        for (uint i = 0; i < size; i++) {
+            EXPECT_EQ(data[i], value);
+        }
+    }
+};
+
+TEST_F(RegionsLayerTest, IncrementalWrite) {
+    size_t fullSize;
+    {
+        RegionsLayer layer {};
+        layer.folder = "regions:";
+        layer.durableWrites = false;
+        for (uint i = 0; i < 8; i++) {
+            put(layer, i, 0, i, 100);
+        }
+        layer.writeAll();
+        fullSize = io::file_size(layer.getRegionFilePath(0, 0));
+
+        put(layer, 3, 0, 42, 50);
+        layer.writeAll();
+    }
+    RegionsLayer layer {};
+    layer.folder = "regions:";
+
+    auto file = layer.getRegionFilePath(0, 0);
+    // only changed chunk and new offsets table are appended
+    EXPECT_EQ(io::file_size(file), fullSize + 8 + 50 + REGION_CHUNKS_COUNT * 4);
+    EXPECT_FALSE(io::exists(file.parent() / (file.name() + ".journal")));
+
+    for (uint i = 0; i < 8; i++) {
+        if (i == 3) {
+            expect_chunk(layer, 3, 0, 42, 50);
+        } else {
+            expect_chunk(layer, i, 0, i, 100);
+        }
+    }
+}
+
+TEST_F(RegionsLayerTest, Compaction) {
+    // previous offsets tables are dead space too
+    const uint size = REGION_CHUNKS_COUNT * 8;
+    RegionsLayer layer {};
+    layer.folder = "regions:";
+    layer.durableWrites = false;
+    put(layer, 0, 0, 1, size);
+    put(layer, 1, 0, 2, size);
+    layer.writeAll();
+
+    put(layer, 0, 0, 3, size);
+    layer.writeAll();
+    EXPECT_TRUE(layer.fragmented.empty());
+
+    put(layer, 0, 0, 4, size);
+    layer.writeAll();
+    EXPECT_FALSE(layer.fragmented.empty());
+
+    layer.compact();
+    EXPECT_TRUE(layer.fragmented.empty());
+    EXPECT_EQ(
+        io::file_size(layer.getRegionFilePath(0, 0)),
+        REGION_HEADER_SIZE + (8 + size) * 2 + REGION_CHUNKS_COUNT * 4
+    );
+    expect_chunk(layer, 0, 0, 4, size);
+    expect_chunk(layer, 1, 0, 2, size);
+}
+
+TEST_F(RegionsLayerTest, InterruptedWrite) {
+    io::path file;
+    size_t length;
+    {
+        RegionsLayer layer {};
+        layer.folder = "regions:";
+        layer.durableWrites = false;
+        put(layer, 0, 0, 1, 100);
+        put(layer, 1, 0, 2, 100);
+        layer.writeAll();
+        file = layer.getRegionFilePath(0, 0);
+        length = io::file_size(file);
+    }
+    // journal is left and the file is partially appended
+    uint64_t journalLength = dataio::h2le(static_cast<uint64_t>(length));
+    io::write_bytes(
+        file.parent() / (file.name() + ".journal"),
+        reinterpret_cast<const ubyte*>(&journalLength),
+        sizeof(journalLength)
+    );
+    {
+        std::ofstream stream(
+            io::resolve(file), std::ios::binary | std::ios::app
+        );
+        std::vector<char> garbage(1000, 7);
+        stream.write(garbage.data(), garbage.size());
+    }
+    RegionsLayer layer {};
+    layer.folder = "regions:";
+    expect_chunk(layer, 0, 0, 1, 100);
+    expect_chunk(layer, 1, 0, 2, 100);
+    EXPECT_EQ(io::file_size(file), length);
+    EXPECT_FALSE(io::exists(file.parent() / (file.name() + ".journal")));
+}
+
+TEST_F(RegionsLayerTest, CompressionChange) {
+    {
+        RegionsLayer layer {};
+        layer.folder = "regions:";
+        put(layer, 0, 0, 1, 100);
+        put(layer, 1, 0, 2, 100);
+        layer.writeAll();
+    }
+    RegionsLayer layer {};
+    layer.folder = "regions:";
+    layer.durableWrites = false;
+    layer.compression = compression::Method::LZ4;
+
+    uint32_t length;
+    uint32_t srcSize;
+    ubyte* data = layer.getData(0, 0, length, srcSize);
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(srcSize, 100);
+    auto decompressed = compression::decompress(
+        data, length, srcSize, compression::Method::LZ4
+    );
+    for (uint i = 0; i < srcSize; i++) {
+        EXPECT_EQ(decompressed[i], 1);
+    }
+
+    // file written with other method is rewritten instead of appending
+    size_t length2;
+    std::vector<ubyte> bytes(100, 3);
+    auto compressed = compression::compress(
+        bytes.data(), bytes.size(), length2, compression::Method::LZ4
+    );
+    auto region = layer.getOrCreateRegion(0, 0);
+    region->put(0, 0, std::move(compressed), length2, bytes.size());
+    region->setChunkUnsaved(0, 0);
+    layer.writeAll();
+    EXPECT_TRUE(layer.fragmented.empty());
+
+    auto regfile = layer.getRegFile({0, 0});
+    ASSERT_NE(regfile, nullptr);
+    EXPECT_EQ(regfile.get()->compression, compression::Method::LZ4);
+    auto chunk = RegionsLayer::readChunkData(
+        1, 0, length, srcSize, regfile.get(), nullptr
+    );
+    ASSERT_NE(chunk, nullptr);
+    for (uint i = 0; i < 100; i++) {
+        EXPECT_EQ(chunk[i], 2);
+    }
+}
+
+TEST_F(RegionsLayerTest, DurableWrite) {
+    RegionsLayer layer {};
+    layer.folder = "regions:";
+    put(layer, 0, 0, 1, 100);
+    put(layer, 1, 0, 2, 100);
+    layer.writeAll();
+
+    auto file = layer.getRegionFilePath(0, 0);
+    size_t initialSize = io::file_size(file);
+    EXPECT_EQ(
+        initialSize,
+        REGION_HEADER_SIZE + (8 + 100) * 2 + REGION_CHUNKS_COUNT * 4
+    );
+
+    put(layer, 0, 0, 3, 100);
+    layer.writeAll();
+    EXPECT_FALSE(layer.getRegion(0, 0)->isUnsaved());
+
+    // changed chunk is appended with a new offsets table,
+    // journal is removed after the append is flushed
+    EXPECT_EQ(
+        io::file_size(file), initialSize + 8 + 100 + REGION_CHUNKS_COUNT * 4
+    );
+    EXPECT_FALSE(io::exists(file.parent() / (file.name() + ".tmp")));
+    EXPECT_FALSE(io::exists(file.parent() / (file.name() + ".journal")));
+
+    RegionsLayer reader {};
+    reader.folder = "regions:";
+    expect_chunk(reader, 0, 0, 3, 100);
+    expect_chunk(reader, 1, 0, 2, 100);
+}
+
+TEST_F(RegionsLayerTest, CorruptedRegion) {
+    io::path file;
+    {
+        RegionsLayer layer {};
+        layer.folder = "regions:";
+        put(layer, 0, 0, 1, 100);
+        layer.writeAll();
+        file = layer.getRegionFilePath(0, 0);
+    }
+    auto bytes = io::read_bytes(file);
+    size_t tableOffset = bytes.size() - REGION_CHUNKS_COUNT * 4;
+    uint32_t offset = dataio::le2h(
+        *reinterpret_cast<const uint32_t*>(bytes.data() + tableOffset)
+    );
+    ASSERT_NE(offset, 0);
+
+    // chunk data size wraps uint32 offset + size
+    auto corrupted = bytes;
+    uint32_t size = dataio::h2le(0xFFFFFFF0U);
+    std::memcpy(corrupted.data() + offset, &size, 4);
+    io::write_bytes(file, corrupted.data(), corrupted.size());
+    for (bool mapped : {true, false}) {
+        regfile reg(file, mapped);
+        uint32_t length;
+        uint32_t srcSize;
+        EXPECT_THROW(reg.read(0, length, srcSize), illegal_region_format);
+    }
+
+    // chunk data offset wraps uint32 offset + 8
+    corrupted = bytes;
+    offset = dataio::h2le(0xFFFFFFFCU);
+    std::memcpy(corrupted.data() + tableOffset, &offset, 4);
+    io::write_bytes(file, corrupted.data(), corrupted.size());
+    EXPECT_THROW(regfile(file, true), illegal_region_format);
+    EXPECT_THROW(regfile(file, false), illegal_region_format);
+}
@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+
+#include "io/io.hpp"
+#include "io/devices/StdfsDevice.hpp"
+#include "world/files/WorldRegions.hpp"
+
+namespace fs = std::filesystem;
+
+class WorldRegionsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auto root = fs::temp_directory_path() / "vctest-world-regions";
+        fs::remove_all(root);
+        io::set_device("world", std::make_shared<io::StdfsDevice>(root));
+    }
+
+    void TearDown() override {
+        io::remove_device("world");
+    }
+
+    /// @brief Voxels data of layered chunk with some noise
+    static std::unique_ptr<ubyte[]> make_voxels(int seed) {
+        std::mt19937 random(seed);
+        auto data = std::make_unique<ubyte[]>(CHUNK_DATA_LEN);
+        for (size_t i = 0; i < CHUNK_DATA_LEN; i++) {
+            size_t y = i / 512;
+            data[i] = y < 60 ? (random() % 8 == 0 ? 3 : 1) : 0;
+        }
+        return data;
+    }
+};
+
+TEST_F(WorldRegionsTest, NoVoxelsCompression) {
+    WorldRegions regions("world:");
+    regions.setCompression(REGION_LAYER_VOXELS, compression::Method::NONE);
+    regions.put(3, 5, REGION_LAYER_VOXELS, make_voxels(1), CHUNK_DATA_LEN);
+    auto voxels = regions.getVoxels(3, 5);
+    ASSERT_NE(voxels, nullptr);
+    auto expected = make_voxels(1);
+    EXPECT_EQ(std::memcmp(voxels.get(), expected.get(), CHUNK_DATA_LEN), 0);
+}
+
+TEST_F(WorldRegionsTest, TrainDictionary) {
+    {
+        WorldRegions regions("world:");
+        regions.setCompression(REGION_LAYER_VOXELS, compression::Method::ZSTD);
+        EXPECT_THROW(
+            regions.trainDictionary(REGION_LAYER_VOXELS, 100),
+            std::runtime_error
+        );
+        for (int i = 0; i < 64; i++) {
+            regions.put(
+                i % 8, i / 8, REGION_LAYER_VOXELS, make_voxels(i), CHUNK_DATA_LEN
+            );
+        }
+        regions.writeAll();
+        EXPECT_GT(regions.trainDictionary(REGION_LAYER_VOXELS, 100), 0);
+        EXPECT_THROW(
+            regions.trainDictionary(REGION_LAYER_VOXELS, 100),
+            std::runtime_error
+        );
+    }
+    // chunks compressed without dictionary are read with it
+    WorldRegions regions("world:");
+    regions.setCompression(REGION_LAYER_VOXELS, compression::Method::ZSTD);
+    regions.put(20, 0, REGION_LAYER_VOXELS, make_voxels(100), CHUNK_DATA_LEN);
+    regions.writeAll();
+    for (int i : {0, 63}) {
+        auto voxels = regions.getVoxels(i % 8, i / 8);
+        ASSERT_NE(voxels, nullptr);
+        auto expected = make_voxels(i);
+        EXPECT_EQ(std::memcmp(voxels.get(), expected.get(), CHUNK_DATA_LEN), 0);
+    }
+    auto voxels = regions.getVoxels(20, 0);
+    ASSERT_NE(voxels, nullptr);
+    auto expected = make_voxels(100);
+    EXPECT_EQ(std::memcmp(voxels.get(), expected.get(), CHUNK_DATA_LEN), 0);
+}
+
+TEST_F(WorldRegionsTest, SnapshotRevisions) {
+    WorldRegions regions("world:");
+    auto make_snapshot = [](int seed, uint64_t revision) {
+        auto snapshot = std::make_unique<ChunkSnapshot>();
+        snapshot->x = 1;
+        snapshot->z = 2;
+        snapshot->revision = revision;
+        snapshot->data[REGION_LAYER_VOXELS] = make_voxels(seed);
+        snapshot->sizes[REGION_LAYER_VOXELS] = CHUNK_DATA_LEN;
+        return snapshot;
+    };
+    auto older = make_snapshot(1, 1);
+    auto newer = make_snapshot(2, 2);
+    EXPECT_FALSE(newer->stored);
+    regions.put(*newer);
+    EXPECT_TRUE(newer->stored);
+
+    // superseded snapshot is considered stored but not written
+    regions.put(*older);
+    EXPECT_TRUE(older->stored);
+
+    auto voxels = regions.getVoxels(1, 2);
+    ASSERT_NE(voxels, nullptr);
+    auto expected = make_voxels(2);
+    EXPECT_EQ(std::memcmp(voxels.get(), expected.get(), CHUNK_DATA_LEN), 0);
+}
+
+TEST_F(WorldRegionsTest, SnapshotNoReplace) {
+    WorldRegions regions("world:");
+    auto make_snapshot = [](int x, int seed, uint64_t revision, bool replace) {
+        auto snapshot = std::make_unique<ChunkSnapshot>();
+        snapshot->x = x;
+        snapshot->z = 0;
+        snapshot->revision = revision;
+        snapshot->replace = replace;
+        snapshot->data[REGION_LAYER_VOXELS] = make_voxels(seed);
+        snapshot->sizes[REGION_LAYER_VOXELS] = CHUNK_DATA_LEN;
+        return snapshot;
+    };
+    auto expect_voxels = [&regions](int x, int seed) {
+        auto voxels = regions.getVoxels(x, 0);
+        ASSERT_NE(voxels, nullptr);
+        auto expected = make_voxels(seed);
+        EXPECT_EQ(std::memcmp(voxels.get(), expected.get(), CHUNK_DATA_LEN), 0);
+    };
+    // older stored snapshot is kept
+    auto stored = make_snapshot(0, 1, 1, true);
+    regions.put(*stored);
+    auto generated = make_snapshot(0, 2, 2, false);
+    regions.put(*generated);
+    EXPECT_TRUE(generated->stored);
+    expect_voxels(0, 1);
+
+    // region written, so the stored revision is not known anymore
+    regions.writeAll();
+    generated = make_snapshot(0, 3, 3, false);
+    regions.put(*generated);
+    expect_voxels(0, 1);
+
+    // snapshot taken before the non-replacing one is put is not superseded
+    auto older = make_snapshot(1, 4, 4, true);
+    generated = make_snapshot(1, 5, 5, false);
+    regions.put(*generated);
+    EXPECT_TRUE(generated->stored);
+    expect_voxels(1, 5);
+    regions.put(*older);
+    expect_voxels(1, 4);
+}
+
+TEST_F(WorldRegionsTest, SnapshotEncoding) {
+    WorldRegions regions("world:");
+    Chunk chunk(-1, 3);
+    auto voxels = make_voxels(3);
+    chunk.decode(voxels.get());
+    chunk.lightmap.setS(1, 2, 3, 15);
+    chunk.lightmap.setS(4, 200, 5, 7);
+    chunk.flags.lighted = true;
+    chunk.flags.unsaved = true;
+
+    auto snapshot = regions.snapshot(&chunk, {});
+    ASSERT_NE(snapshot, nullptr);
+    EXPECT_FALSE(chunk.flags.unsaved);
+    uint lightsSize;
+    auto lights = chunk.lightmap.encode(lightsSize);
+
+    // chunk changes after the snapshot are not stored
+    chunk.voxels[0].id = 100;
+    chunk.lightmap.setS(1, 2, 3, 0);
+    regions.put(*snapshot);
+    EXPECT_TRUE(snapshot->stored);
+
+    auto stored = regions.getVoxels(-1, 3);
+    ASSERT_NE(stored, nullptr);
+    EXPECT_EQ(std::memcmp(stored.get(), voxels.get(), CHUNK_DATA_LEN), 0);
+
+    auto storedLights = regions.getLights(-1, 3);
+    ASSERT_NE(storedLights, nullptr);
+    auto expectedLights = Lightmap::decode(lights.get(), lightsSize);
+    EXPECT_EQ(
+        std::memcmp(
+            storedLights.get(),
+            expectedLights.get(),
+            CHUNK_VOL * sizeof(light_t)
+        ),
+        0
+    );
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include "constants.hpp"
+#include "maths/Heightmap.hpp"
+#include "world/generator/PrototypeCache.hpp"
+
+static const std::vector<std::string> STRUCTURES {
+    "base:tree", "base:tower", "base:boulder", "base:well", "base:ruins"};
+static const std::vector<std::string> BLOCKS {
+    "core:air", "core:obstacle", "core:struct_air", "base:stone",
+    "base:dirt", "base:grass", "base:sand", "base:coal_ore"};
+
+static PrototypeCache create_cache(
+    size_t capacity,
+    uint64_t seed = 42,
+    int version = 1,
+    const std::vector<std::string>& blocks = BLOCKS
+) {
+    return PrototypeCache(
+        capacity, seed, "core:default", version, 3, STRUCTURES, blocks
+    );
+}
+
+static std::shared_ptr<CachedPrototype> create_prototype(float height) {
+    auto prototype = std::make_shared<CachedPrototype>();
+    prototype->biomes = std::make_unique<uint16_t[]>(CHUNK_W * CHUNK_D);
+    prototype->biomes[5] = 2;
+    prototype->heightmap = std::make_shared<Heightmap>(
+        CHUNK_W, CHUNK_D, std::vector<float>(CHUNK_W * CHUNK_D, height)
+    );
+    prototype->widePlacements.emplace_back(
+        3, LinePlacement {7, {0, 10, 0}, {40, 20, -16}, 2}
+    );
+    prototype->placements.emplace_back(
+        1, StructurePlacement {4, {1, 60, -3}, 2}
+    );
+    return prototype;
+}
+
+TEST(PrototypeCache, Eviction) {
+    auto cache = create_cache(2);
+    cache.put(0, 0, create_prototype(0.1f));
+    cache.put(1, 0, create_prototype(0.2f));
+    EXPECT_NE(cache.get(0, 0), nullptr);
+
+    // (1, 0) is least recently used
+    cache.put(2, 0, create_prototype(0.3f));
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.get(1, 0), nullptr);
+    EXPECT_NE(cache.get(0, 0), nullptr);
+    EXPECT_NE(cache.get(2, 0), nullptr);
+}
+
+TEST(PrototypeCache, Serialization) {
+    auto cache = create_cache(8);
+    cache.put(-1, 5, create_prototype(0.5f));
+    cache.put(2, 3, create_prototype(0.25f));
+    auto bytes = cache.serialize();
+
+    auto other = create_cache(8);
+    ASSERT_TRUE(other.deserialize(bytes));
+    EXPECT_EQ(other.size(), 2);
+
+    auto prototype = other.get(-1, 5);
+    ASSERT_NE(prototype, nullptr);
+    EXPECT_EQ(prototype->biomes[5], 2);
+    EXPECT_EQ(prototype->heightmap->getValues()[10], 0.5f);
+    ASSERT_EQ(prototype->widePlacements.size(), 1);
+    const auto& line =
+        std::get<LinePlacement>(prototype->widePlacements[0].placement);
+    EXPECT_EQ(line.block, 7);
+    EXPECT_EQ(line.b, glm::ivec3(40, 20, -16));
+    ASSERT_EQ(prototype->placements.size(), 1);
+    const auto& structure =
+        std::get<StructurePlacement>(prototype->placements[0].placement);
+    EXPECT_EQ(structure.structure, 4);
+    EXPECT_EQ(structure.position, glm::ivec3(1, 60, -3));
+    EXPECT_EQ(structure.rotation, 2);
+
+    // other seed or generator version
+    auto otherSeed = create_cache(8, 43);
+    EXPECT_FALSE(otherSeed.deserialize(bytes));
+    EXPECT_EQ(otherSeed.size(), 0);
+    auto otherVersion = create_cache(8, 42, 2);
+    EXPECT_FALSE(otherVersion.deserialize(bytes));
+
+    // block ids are changed by content packs
+    auto blocks = BLOCKS;
+    std::swap(blocks[3], blocks[4]);
+    auto otherContent = create_cache(8, 42, 1, blocks);
+    EXPECT_FALSE(otherContent.deserialize(bytes));
+    EXPECT_EQ(otherContent.size(), 0);
+}
+
+TEST(PrototypeCache, InvalidIndices) {
+    auto invalid_structure = create_prototype(0.5f);
+    invalid_structure->placements.emplace_back(
+        1, StructurePlacement {static_cast<int>(STRUCTURES.size()), {}, 0}
+    );
+    auto invalid_rotation = create_prototype(0.5f);
+    invalid_rotation->placements.emplace_back(
+        1, StructurePlacement {0, {}, 4}
+    );
+    auto invalid_block = create_prototype(0.5f);
+    invalid_block->widePlacements.emplace_back(
+        1,
+        LinePlacement {static_cast<blockid_t>(BLOCKS.size()), {}, {}, 1}
+    );
+    for (const auto& prototype :
+         {invalid_structure, invalid_rotation, invalid_block}) {
+        auto cache = create_cache(8);
+        cache.put(0, 0, create_prototype(0.1f));
+        cache.put(1, 0, prototype);
+        auto bytes = cache.serialize();
+
+        auto other = create_cache(8);
+        EXPECT_THROW(other.deserialize(bytes), std::runtime_error);
+        // valid entries preceding the corrupted one are not loaded
+        EXPECT_EQ(other.size(), 0);
+    }
+}
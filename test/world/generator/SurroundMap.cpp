@@ -31,6 +31,30 @@ TEST(SurroundMap, InitTest) {
     EXPECT_EQ(affected, maxLevel * 2 - 1);
 }
 
+TEST(SurroundMap, BatchCallback) {
+    int8_t maxLevel = 3;
+    SurroundMap map(10, maxLevel);
+    std::vector<size_t> batches;
+    int removed = 0;
+
+    map.setLevelBatchCallback(2, [&batches](const auto& points) {
+        batches.push_back(points.size());
+    });
+    map.setOutCallback([&removed](auto, auto, auto) {
+        removed++;
+    });
+    map.setCenter(0, 0);
+    map.completeAt(0, 0);
+    ASSERT_EQ(batches.size(), 1);
+    EXPECT_EQ(batches[0], (maxLevel * 2 - 3) * (maxLevel * 2 - 3));
+
+    map.completeAt(0, 0);
+    EXPECT_EQ(batches.size(), 1);
+
+    map.clear();
+    EXPECT_EQ(removed, (maxLevel * 2 - 1) * (maxLevel * 2 - 1));
+}
+
 #define VISUAL_TEST
 #ifdef VISUAL_TEST
 
@@ -0,0 +1,259 @@
+#include <gtest/gtest.h>
+
+#include "../../TestContent.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/Chunks.hpp"
+#include "world/generator/VoxelFragment.hpp"
+
+namespace {
+    /// @brief Content and fragments with air holes, all-air rows and
+    /// all-air layers. Span-based paste and place are compared to
+    /// per-voxel reference implementations
+    class VoxelFragmentTest : public ::testing::Test {
+    protected:
+        static inline const glm::ivec3 SIZE {9, 6, 7};
+        /// @brief Fully air layer of the fragment
+        static constexpr int AIR_LAYER = 2;
+        /// @brief Fully air rows of the fragment
+        static constexpr int AIR_ROWS_Z = 3;
+        /// @brief Matrix side in chunks
+        static constexpr int CHUNKS_SIDE = 4;
+
+        std::unique_ptr<Content> content;
+        blockid_t marker;
+
+        void SetUp() override {
+            TestContentBuilder builder;
+            builder.createBlock("test:stone", true);
+            builder.createBlock("test:dirt", true);
+            builder.createBlock("test:marker", true);
+            content = builder.build();
+            marker = content->blocks.require("test:marker").rt.id;
+        }
+
+        /// @return fragment-indexed block id of the voxel
+        static blockid_t pattern(int x, int y, int z) {
+            if (y == AIR_LAYER || z == AIR_ROWS_Z) {
+                return 0;
+            }
+            // full row touching both X ends
+            if (y == 4 && z == 1) {
+                return 1;
+            }
+            return (x * 3 + y * 5 + z * 7) % 4 % 3;
+        }
+
+        std::unique_ptr<VoxelFragment> createFragment(bool air) const {
+            std::vector<voxel> voxels(SIZE.x * SIZE.y * SIZE.z);
+            for (int y = 0; y < SIZE.y; y++) {
+                for (int z = 0; z < SIZE.z; z++) {
+                    for (int x = 0; x < SIZE.x; x++) {
+                        auto& vox = voxels[vox_index(x, y, z, SIZE.x, SIZE.z)];
+                        vox.id = air ? 0 : pattern(x, y, z);
+                        vox.state = int2blockstate(x % 4);
+                    }
+                }
+            }
+            auto fragment = std::make_unique<VoxelFragment>(
+                SIZE,
+                std::move(voxels),
+                std::vector<std::string> {CORE_AIR, "test:stone", "test:dirt"}
+            );
+            fragment->prepare(*content);
+            return fragment;
+        }
+
+        /// @brief Per-voxel paste
+        static void paste_reference(
+            VoxelFragment& fragment, voxel* dst, const glm::ivec3& offset
+        ) {
+            const auto& voxels = fragment.getRuntimeVoxels();
+            for (int y = 0; y < SIZE.y; y++) {
+                for (int z = 0; z < SIZE.z; z++) {
+                    for (int x = 0; x < SIZE.x; x++) {
+                        glm::ivec3 pos = glm::ivec3(x, y, z) + offset;
+                        const auto& vox =
+                            voxels[vox_index(x, y, z, SIZE.x, SIZE.z)];
+                        if (vox.id == BLOCK_AIR || pos.x < 0 || pos.y < 0 ||
+                            pos.z < 0 || pos.x >= CHUNK_W ||
+                            pos.y >= CHUNK_H || pos.z >= CHUNK_D) {
+                            continue;
+                        }
+                        dst[vox_index(pos.x, pos.y, pos.z)] = vox;
+                    }
+                }
+            }
+        }
+
+        /// @brief Per-voxel place
+        static void place_reference(
+            VoxelFragment& fragment, Chunks& chunks, const glm::ivec3& offset
+        ) {
+            const auto& voxels = fragment.getRuntimeVoxels();
+            for (int y = 0; y < SIZE.y; y++) {
+                for (int z = 0; z < SIZE.z; z++) {
+                    for (int x = 0; x < SIZE.x; x++) {
+                        glm::ivec3 pos = glm::ivec3(x, y, z) + offset;
+                        const auto& vox =
+                            voxels[vox_index(x, y, z, SIZE.x, SIZE.z)];
+                        if (vox.id == BLOCK_AIR || pos.y < 0 ||
+                            pos.y >= CHUNK_H) {
+                            continue;
+                        }
+                        chunks.set(pos.x, pos.y, pos.z, vox.id, vox.state);
+                    }
+                }
+            }
+        }
+
+        /// @brief Create matrix of chunks filled with markers starting
+        /// at 0, 0. Chunk 1, 1 is missing
+        std::unique_ptr<Chunks> createChunks() const {
+            auto chunks = std::make_unique<Chunks>(
+                CHUNKS_SIDE,
+                CHUNKS_SIDE,
+                CHUNKS_SIDE,
+                CHUNKS_SIDE,
+                nullptr,
+                *content->getIndices()
+            );
+            for (int cz = 0; cz < CHUNKS_SIDE; cz++) {
+                for (int cx = 0; cx < CHUNKS_SIDE; cx++) {
+                    if (cx == 1 && cz == 1) {
+                        continue;
+                    }
+                    auto chunk = std::make_shared<Chunk>(cx, cz);
+                    std::fill_n(
+                        chunk->voxels.data(), CHUNK_VOL, voxel {marker, {}}
+                    );
+                    chunk->updateHeights();
+                    chunk->flags.loaded = true;
+                    chunks->putChunk(chunk);
+                }
+            }
+            return chunks;
+        }
+
+        /// @return number of different voxels
+        static size_t compare(const voxel* a, const voxel* b) {
+            size_t differences = 0;
+            for (uint i = 0; i < CHUNK_VOL; i++) {
+                differences += a[i].id != b[i].id ||
+                               blockstate2int(a[i].state) !=
+                                   blockstate2int(b[i].state);
+            }
+            return differences;
+        }
+
+        /// @return number of different voxels of all chunks
+        static size_t compare(const Chunks& a, const Chunks& b) {
+            size_t differences = 0;
+            for (int cz = 0; cz < CHUNKS_SIDE; cz++) {
+                for (int cx = 0; cx < CHUNKS_SIDE; cx++) {
+                    auto chunkA = a.getChunk(cx, cz);
+                    auto chunkB = b.getChunk(cx, cz);
+                    EXPECT_EQ(chunkA == nullptr, chunkB == nullptr);
+                    if (chunkA && chunkB) {
+                        differences += compare(
+                            chunkA->voxels.data(), chunkB->voxels.data()
+                        );
+                    }
+                }
+            }
+            return differences;
+        }
+    };
+}
+
+TEST_F(VoxelFragmentTest, Bounds) {
+    auto fragment = createFragment(false);
+    glm::ivec3 min = SIZE;
+    glm::ivec3 max {};
+    const auto& voxels = fragment->getRuntimeVoxels();
+    for (int y = 0; y < SIZE.y; y++) {
+        for (int z = 0; z < SIZE.z; z++) {
+            for (int x = 0; x < SIZE.x; x++) {
+                if (voxels[vox_index(x, y, z, SIZE.x, SIZE.z)].id) {
+                    min = glm::min(min, glm::ivec3(x, y, z));
+                    max = glm::max(max, glm::ivec3(x + 1, y + 1, z + 1));
+                }
+            }
+        }
+    }
+    EXPECT_EQ(fragment->getBoundsMin(), min);
+    EXPECT_EQ(fragment->getBoundsMax(), max);
+    // full row touches both X ends
+    EXPECT_EQ(min.x, 0);
+    EXPECT_EQ(max.x, SIZE.x);
+
+    auto air = createFragment(true);
+    EXPECT_EQ(air->getBoundsMin(), SIZE);
+    EXPECT_EQ(air->getBoundsMax(), glm::ivec3());
+}
+
+TEST_F(VoxelFragmentTest, PasteClipping) {
+    auto fragment = createFragment(false);
+    const glm::ivec3 offsets[] {
+        {3, 10, 4},
+        // partly outside in negative directions
+        {-3, -2, -4},
+        {-SIZE.x + 1, 5, -SIZE.z + 1},
+        // partly outside in positive directions
+        {CHUNK_W - 4, 20, CHUNK_D - 2},
+        // clipped by the chunk top
+        {5, CHUNK_H - 3, 5},
+        // clipped by the bottom at the all-air layer
+        {0, -AIR_LAYER, 0},
+        // outside
+        {-SIZE.x, 0, 0},
+        {CHUNK_W, 0, 0},
+        {0, CHUNK_H, 0},
+        {0, -SIZE.y, 0},
+        {0, 0, -SIZE.z},
+    };
+    std::vector<voxel> voxels(CHUNK_VOL);
+    std::vector<voxel> expected(CHUNK_VOL);
+    for (const auto& offset : offsets) {
+        std::fill(voxels.begin(), voxels.end(), voxel {marker, {}});
+        std::fill(expected.begin(), expected.end(), voxel {marker, {}});
+        fragment->paste(voxels.data(), offset);
+        paste_reference(*fragment, expected.data(), offset);
+        EXPECT_EQ(compare(voxels.data(), expected.data()), 0)
+            << "offset " << offset.x << " " << offset.y << " " << offset.z;
+    }
+
+    // all-air fragment changes nothing
+    auto air = createFragment(true);
+    std::fill(voxels.begin(), voxels.end(), voxel {marker, {}});
+    std::fill(expected.begin(), expected.end(), voxel {marker, {}});
+    air->paste(voxels.data(), {2, 2, 2});
+    EXPECT_EQ(compare(voxels.data(), expected.data()), 0);
+}
+
+TEST_F(VoxelFragmentTest, PlaceClipping) {
+    auto fragment = createFragment(false);
+    const glm::ivec3 offsets[] {
+        // crosses chunk borders and the missing chunk
+        {CHUNK_W - 4, 30, CHUNK_D - 3},
+        // partly outside of the matrix, clipped by the bottom
+        {-5, -3, 10},
+        // clipped by the top
+        {CHUNK_W * 2 + 7, CHUNK_H - 2, CHUNK_D * 3 - 4},
+        // clipped by the top above the all-air layer
+        {3, CHUNK_H - AIR_LAYER - 1, 3},
+    };
+    for (const auto& offset : offsets) {
+        auto chunks = createChunks();
+        auto expected = createChunks();
+        fragment->place(*chunks, offset, 0);
+        place_reference(*fragment, *expected, offset);
+        EXPECT_EQ(compare(*chunks, *expected), 0)
+            << "offset " << offset.x << " " << offset.y << " " << offset.z;
+    }
+
+    auto air = createFragment(true);
+    auto chunks = createChunks();
+    auto expected = createChunks();
+    air->place(*chunks, {CHUNK_W - 4, 30, CHUNK_D - 3}, 0);
+    EXPECT_EQ(compare(*chunks, *expected), 0);
+}
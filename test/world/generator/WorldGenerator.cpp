@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "../../TestContent.hpp"
+#include "maths/Heightmap.hpp"
+#include "world/generator/GeneratorDef.hpp"
+#include "world/generator/VoxelFragment.hpp"
+#include "world/generator/WorldGenerator.hpp"
+
+namespace {
+    /// @brief Deterministic generator script producing lines crossing
+    /// chunk borders
+    class TestScript : public GeneratorScript {
+        uint64_t seed = 0;
+        blockid_t ore;
+    public:
+        TestScript(blockid_t ore) : ore(ore) {
+        }
+
+        void initialize(uint64_t seed) override {
+            this->seed = seed;
+        }
+
+        std::unique_ptr<GeneratorScript> clone() const override {
+            return std::make_unique<TestScript>(ore);
+        }
+
+        std::shared_ptr<Heightmap> generateHeightmap(
+            const glm::ivec2& offset,
+            const glm::ivec2& size,
+            uint bpd,
+            const std::vector<std::shared_ptr<Heightmap>>& inputs
+        ) override {
+            auto map = std::make_shared<Heightmap>(size.x, size.y);
+            auto values = map->getValues();
+            const auto input = inputs.at(0)->getValues();
+            for (int z = 0; z < size.y; z++) {
+                for (int x = 0; x < size.x; x++) {
+                    float gx = (offset.x + x) * static_cast<int>(bpd);
+                    float gz = (offset.y + z) * static_cast<int>(bpd);
+                    values[z * size.x + x] = 0.25f +
+                        std::sin(gx * 0.05f + seed) * std::cos(gz * 0.07f) *
+                            0.05f +
+                        input[z * size.x + x] * 0.1f;
+                }
+            }
+            return map;
+        }
+
+        std::vector<std::shared_ptr<Heightmap>> generateParameterMaps(
+            const glm::ivec2& offset, const glm::ivec2& size, uint bpd
+        ) override {
+            auto map = std::make_shared<Heightmap>(size.x, size.y);
+            auto values = map->getValues();
+            for (int z = 0; z < size.y; z++) {
+                for (int x = 0; x < size.x; x++) {
+                    float gx = (offset.x + x) * static_cast<int>(bpd);
+                    float gz = (offset.y + z) * static_cast<int>(bpd);
+                    values[z * size.x + x] =
+                        0.5f + std::sin(gx * 0.03f + gz * 0.02f) * 0.5f;
+                }
+            }
+            return {map};
+        }
+
+        std::vector<Placement> placeStructuresWide(
+            const glm::ivec2& offset, const glm::ivec2& size, uint
+        ) override {
+            int cx = offset.x / size.x;
+            int cz = offset.y / size.y;
+            if ((cx + cz + seed) % 3) {
+                return {};
+            }
+            glm::ivec3 a(offset.x, 20 + cx % 5, offset.y);
+            glm::ivec3 b = a + glm::ivec3(40, 15, -24);
+            return {Placement {1, LinePlacement {ore, a, b, 3}}};
+        }
+
+        std::vector<Placement> placeStructures(
+            const glm::ivec2& offset,
+            const glm::ivec2& size,
+            const std::shared_ptr<Heightmap>& heightmap,
+            uint chunkHeight
+        ) override {
+            int y = heightmap->getValues()[0] * chunkHeight;
+            glm::ivec3 a(offset.x, y, offset.y);
+            glm::ivec3 b = a + glm::ivec3(size.x + 4, 0, size.y / 2);
+            return {Placement {2, LinePlacement {BLOCK_AIR, a, b, 2}}};
+        }
+    };
+
+    /// @brief Content and generator definition used by generator tests
+    class GeneratorTest : public ::testing::Test {
+        static BlocksLayer layer(const std::string& block, int height) {
+            return BlocksLayer {block, height, true, {}};
+        }
+    protected:
+        std::unique_ptr<Content> content;
+        std::unique_ptr<GeneratorDef> def;
+
+        void SetUp() override {
+            TestContentBuilder builder;
+            builder.createBlock("test:stone", true);
+            builder.createBlock("test:dirt", true);
+            builder.createBlock("test:water", false);
+            builder.createBlock("test:ore", true);
+            builder.createBlock("test:flower", false);
+            content = builder.build();
+
+            def = std::make_unique<GeneratorDef>("test:generator");
+            def->script = std::make_unique<TestScript>(
+                content->blocks.require("test:ore").rt.id
+            );
+            def->seaLevel = 64;
+            def->biomeParameters = 1;
+            def->heightmapInputs = {0};
+            for (float value : {0.2f, 0.8f}) {
+                Biome biome {};
+                biome.name = "test:biome";
+                biome.parameters = {BiomeParameter {value, 0.5f}};
+                biome.plants = BiomeElementList(
+                    {WeightedEntry {"test:flower", 1.0f, {}}}, value * 0.1f
+                );
+                biome.groundLayers = BlocksLayers {
+                    {layer("test:dirt", 3), layer("test:stone", -1)}, 0};
+                biome.seaLayers = BlocksLayers {{layer("test:water", -1)}, 0};
+                def->biomes.push_back(std::move(biome));
+            }
+            const glm::ivec3 size(3, 2, 1);
+            def->structures.push_back(std::make_unique<VoxelStructure>(
+                VoxelStructureMeta {"test:structure"},
+                std::make_unique<VoxelFragment>(
+                    size,
+                    std::vector<voxel>(size.x * size.y * size.z, voxel {1, {}}),
+                    std::vector<std::string> {CORE_AIR, "test:stone"}
+                )
+            ));
+            def->structuresIndices["test:structure"] = 0;
+            def->prepare(content.get());
+        }
+
+        /// @brief Generate square of chunks around 0, 0 in batches
+        /// @return voxels of all chunks
+        std::vector<voxel> generate(uint64_t seed, uint threads) {
+            const int radius = 3;
+            const int side = radius * 2 + 1;
+            WorldGenerator generator(*def, *content, seed, threads);
+            generator.update(0, 0, 0, radius + 2);
+
+            std::vector<voxel> voxels(CHUNK_VOL * side * side);
+            std::vector<ChunkGenTarget> batch;
+            for (int z = -radius; z <= radius; z++) {
+                for (int x = -radius; x <= radius; x++) {
+                    size_t index = (z + radius) * side + x + radius;
+                    batch.push_back(
+                        ChunkGenTarget {voxels.data() + index * CHUNK_VOL, x, z}
+                    );
+                    if (batch.size() == 5) {
+                        generator.generate(0, batch);
+                        batch.clear();
+                    }
+                }
+            }
+            generator.generate(0, batch);
+            return voxels;
+        }
+    };
+}
+
+TEST_F(GeneratorTest, MultiThreaded) {
+    const uint64_t seed = 42;
+    auto expected = generate(seed, 1);
+    auto voxels = generate(seed, 4);
+    ASSERT_EQ(voxels.size(), expected.size());
+    size_t differences = 0;
+    for (size_t i = 0; i < voxels.size(); i++) {
+        differences += voxels[i].id != expected[i].id ||
+                       blockstate2int(voxels[i].state) !=
+                           blockstate2int(expected[i].state);
+    }
+    EXPECT_EQ(differences, 0);
+}
+
+TEST_F(GeneratorTest, SharedDefinition) {
+    const auto& fragments = def->structures.at(0)->fragments;
+    // rotated variants are prepared with the definition
+    for (const auto& fragment : fragments) {
+        ASSERT_NE(fragment, nullptr);
+    }
+    EXPECT_EQ(fragments[1]->getSize(), glm::ivec3(1, 2, 3));
+    auto rotated = fragments[1].get();
+
+    // generators do not replace fragments used by each other
+    WorldGenerator first(*def, *content, 1, 2);
+    WorldGenerator second(*def, *content, 2, 2);
+    EXPECT_EQ(fragments[1].get(), rotated);
+}